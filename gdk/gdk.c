@@ -145,6 +145,8 @@ static const GdkDebugKey gdk_debug_keys[] = {
   { "default-settings",GDK_DEBUG_DEFAULT_SETTINGS, "Force default values for xsettings" },
   { "high-depth",      GDK_DEBUG_HIGH_DEPTH, "Use high bit depth rendering if possible" },
   { "no-vsync",        GDK_DEBUG_NO_VSYNC, "Repaint instantly (uses 100% CPU with animations)" },
+  { "no-frame-pacing", GDK_DEBUG_NO_FRAME_PACING, "Start frames right away instead of close to the deadline" },
+  { "reader-thread",   GDK_DEBUG_READER_THREAD, "Read Wayland events on a separate thread" },
 };
 
 static const GdkDebugKey gdk_feature_keys[] = {
@@ -77,6 +77,7 @@
 #include <gdk/gdksurface.h>
 #include <gdk/gdktexture.h>
 #include <gdk/gdktexturedownloader.h>
+#include <gdk/gdktiledtexture.h>
 #include <gdk/gdktoplevel.h>
 #include <gdk/gdktoplevellayout.h>
 #include <gdk/gdktoplevelsize.h>
@@ -21,7 +21,11 @@
 
 #include "gdkcontentdeserializer.h"
 
-#include "gdkcontentformats.h"
+#include "gdkcontentformatsprivate.h"
+#include "gdkcolorstateprivate.h"
+#include "gdkcicpparamsprivate.h"
+#include "gdkmemoryformatprivate.h"
+#include "gdkmemorytexturebuilder.h"
 #include "filetransferportalprivate.h"
 #include "gdktexture.h"
 #include "gdkrgbaprivate.h"
@@ -30,6 +34,7 @@
 #include "loaders/gdktiffprivate.h"
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib/gi18n-lib.h>
 
 
 /**
@@ -705,6 +710,173 @@ texture_deserializer (GdkContentDeserializer *deserializer)
   g_object_unref (output);
 }
 
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+static gboolean
+raw_texture_header_validate (const GdkRawTextureHeader  *header,
+                             gsize                      *out_size,
+                             GError                    **error)
+{
+  gsize bpp, row_size, size;
+
+  if (header->magic != GDK_RAW_TEXTURE_MAGIC ||
+      header->version != GDK_RAW_TEXTURE_VERSION)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                           _("Unsupported raw texture data"));
+      return FALSE;
+    }
+
+  if (header->width == 0 || header->height == 0 ||
+      header->width > G_MAXINT || header->height > G_MAXINT ||
+      header->format >= GDK_MEMORY_N_FORMATS)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                           _("Invalid raw texture data"));
+      return FALSE;
+    }
+
+  bpp = gdk_memory_format_bytes_per_pixel (header->format);
+  if (!g_size_checked_mul (&row_size, header->width, bpp) ||
+      header->stride < row_size ||
+      header->stride % gdk_memory_format_alignment (header->format) != 0 ||
+      !g_size_checked_mul (&size, header->stride, header->height - 1) ||
+      !g_size_checked_add (&size, size, row_size))
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                           _("Invalid raw texture data"));
+      return FALSE;
+    }
+
+  *out_size = size;
+  return TRUE;
+}
+
+static void
+deserialize_raw_texture_in_thread (GTask        *task,
+                                   gpointer      source_object,
+                                   gpointer      task_data,
+                                   GCancellable *cancellable)
+{
+  GdkContentDeserializer *deserializer = source_object;
+  GInputStream *stream;
+  GdkRawTextureHeader header;
+  GdkMemoryTextureBuilder *builder;
+  GdkColorState *color_state;
+  GdkTexture *texture;
+  GBytes *bytes;
+  guchar *data;
+  gsize size, n_read;
+  GError *error = NULL;
+
+  stream = gdk_content_deserializer_get_input_stream (deserializer);
+
+  if (!g_input_stream_read_all (stream, &header, sizeof (header), &n_read, cancellable, &error))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  gdk_raw_texture_header_swap_le (&header);
+
+  if (n_read != sizeof (header) ||
+      !raw_texture_header_validate (&header, &size, &error))
+    {
+      if (error == NULL)
+        g_set_error_literal (&error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                             _("Invalid raw texture data"));
+      g_task_return_error (task, error);
+      return;
+    }
+
+  color_state = gdk_color_state_new_for_cicp (&(GdkCicp) {
+                                                .color_primaries = header.color_primaries,
+                                                .transfer_function = header.transfer_function,
+                                                .matrix_coefficients = header.matrix_coefficients,
+                                                .range = header.range,
+                                              },
+                                              &error);
+  if (color_state == NULL)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  /* The header tells us the final size, so read the pixels straight
+   * into the texture's memory instead of growing a buffer as we go.
+   */
+  data = g_try_malloc (size);
+  if (data == NULL)
+    {
+      gdk_color_state_unref (color_state);
+      g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NO_SPACE,
+                               _("Not enough memory for image size %ux%u"),
+                               header.width, header.height);
+      return;
+    }
+
+  if (!g_input_stream_read_all (stream, data, size, &n_read, cancellable, &error) ||
+      n_read != size)
+    {
+      g_free (data);
+      gdk_color_state_unref (color_state);
+      if (error == NULL)
+        g_set_error_literal (&error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+                             _("Raw texture data is truncated"));
+      g_task_return_error (task, error);
+      return;
+    }
+
+  bytes = g_bytes_new_take (data, size);
+  builder = gdk_memory_texture_builder_new ();
+  gdk_memory_texture_builder_set_width (builder, header.width);
+  gdk_memory_texture_builder_set_height (builder, header.height);
+  gdk_memory_texture_builder_set_format (builder, header.format);
+  gdk_memory_texture_builder_set_color_state (builder, color_state);
+  gdk_memory_texture_builder_set_bytes (builder, bytes);
+  gdk_memory_texture_builder_set_stride (builder, header.stride);
+  texture = gdk_memory_texture_builder_build (builder);
+  g_object_unref (builder);
+  g_bytes_unref (bytes);
+  gdk_color_state_unref (color_state);
+
+  g_task_return_pointer (task, texture, g_object_unref);
+}
+
+static void
+raw_texture_deserializer_finish (GObject      *source,
+                                 GAsyncResult *result,
+                                 gpointer      data)
+{
+  GdkContentDeserializer *deserializer = GDK_CONTENT_DESERIALIZER (source);
+  GdkTexture *texture;
+  GError *error = NULL;
+
+  texture = g_task_propagate_pointer (G_TASK (result), &error);
+  if (texture == NULL)
+    {
+      gdk_content_deserializer_return_error (deserializer, error);
+      return;
+    }
+
+  g_value_take_object (gdk_content_deserializer_get_value (deserializer), texture);
+  gdk_content_deserializer_return_success (deserializer);
+}
+
+static void
+raw_texture_deserializer (GdkContentDeserializer *deserializer)
+{
+  GTask *task;
+
+  task = g_task_new (deserializer,
+                     gdk_content_deserializer_get_cancellable (deserializer),
+                     raw_texture_deserializer_finish,
+                     NULL);
+  g_task_set_priority (task, gdk_content_deserializer_get_priority (deserializer));
+  g_task_run_in_thread (task, deserialize_raw_texture_in_thread);
+  g_object_unref (task);
+}
+#endif
+
 static void
 string_deserializer_finish (GObject      *source,
                             GAsyncResult *result,
@@ -913,6 +1085,13 @@ init (void)
 
   initialized = TRUE;
 
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+  gdk_content_register_deserializer (GDK_RAW_TEXTURE_MIME_TYPE,
+                                     GDK_TYPE_TEXTURE,
+                                     raw_texture_deserializer,
+                                     NULL,
+                                     NULL);
+#endif
   gdk_content_register_deserializer ("image/png",
                                      GDK_TYPE_TEXTURE,
                                      texture_deserializer,
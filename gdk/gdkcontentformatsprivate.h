@@ -23,8 +23,52 @@
 
 G_BEGIN_DECLS
 
+/* Textures are exchanged between GTK processes as raw pixels in this
+ * format. It avoids a PNG encode/decode round trip and lets the reader
+ * allocate the final buffer upfront from the header.
+ *
+ * The header fields are stored little-endian. The pixel data is in the
+ * memory layout of the format on a little-endian machine, so big-endian
+ * hosts don't offer or accept this format and use PNG instead.
+ */
+#define GDK_RAW_TEXTURE_MIME_TYPE "application/x-gtk-texture"
+#define GDK_RAW_TEXTURE_MAGIC 0x54584754 /* "GTXT" */
+#define GDK_RAW_TEXTURE_VERSION 1
 
+typedef struct _GdkRawTextureHeader GdkRawTextureHeader;
 
+struct _GdkRawTextureHeader
+{
+  guint32 magic;
+  guint32 version;
+  guint32 width;
+  guint32 height;
+  guint32 format;
+  guint32 stride;
+  /* cicp tuple of the color state */
+  guint32 color_primaries;
+  guint32 transfer_function;
+  guint32 matrix_coefficients;
+  guint32 range;
+};
+
+/* Converts between the on-wire and host byte order of the header.
+ * The conversion is its own inverse, so this works in both directions.
+ */
+static inline void
+gdk_raw_texture_header_swap_le (GdkRawTextureHeader *header)
+{
+  header->magic = GUINT32_TO_LE (header->magic);
+  header->version = GUINT32_TO_LE (header->version);
+  header->width = GUINT32_TO_LE (header->width);
+  header->height = GUINT32_TO_LE (header->height);
+  header->format = GUINT32_TO_LE (header->format);
+  header->stride = GUINT32_TO_LE (header->stride);
+  header->color_primaries = GUINT32_TO_LE (header->color_primaries);
+  header->transfer_function = GUINT32_TO_LE (header->transfer_function);
+  header->matrix_coefficients = GUINT32_TO_LE (header->matrix_coefficients);
+  header->range = GUINT32_TO_LE (header->range);
+}
 
 G_END_DECLS
 
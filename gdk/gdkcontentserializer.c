@@ -21,9 +21,12 @@
 
 #include "gdkcontentserializer.h"
 
-#include "gdkcontentformats.h"
+#include "gdkcontentformatsprivate.h"
+#include "gdkcicpparamsprivate.h"
+#include "gdkcolorstateprivate.h"
 #include "deprecated/gdkpixbuf.h"
 #include "filetransferportalprivate.h"
+#include "gdktexturedownloaderprivate.h"
 #include "gdktextureprivate.h"
 #include "gdkrgba.h"
 #include "loaders/gdkpngprivate.h"
@@ -730,6 +733,99 @@ texture_serializer (GdkContentSerializer *serializer)
   g_object_unref (task);
 }
 
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+static void
+serialize_raw_texture_in_thread (GTask        *task,
+                                 gpointer      source_object,
+                                 gpointer      task_data,
+                                 GCancellable *cancellable)
+{
+  GdkContentSerializer *serializer = source_object;
+  GOutputStream *stream;
+  GdkTexture *texture;
+  GdkTextureDownloader downloader;
+  GdkColorState *color_state;
+  const GdkCicp *cicp;
+  GdkRawTextureHeader header;
+  GdkMemoryFormat format;
+  GBytes *bytes;
+  gsize stride, size;
+  GError *error = NULL;
+  gboolean result;
+
+  texture = g_value_get_object (gdk_content_serializer_get_value (serializer));
+  stream = gdk_content_serializer_get_output_stream (serializer);
+  format = gdk_texture_get_format (texture);
+
+  /* Keep the texture's own color state when the receiver can recreate it,
+   * otherwise fall back to sRGB like the image formats do.
+   */
+  color_state = gdk_texture_get_color_state (texture);
+  cicp = gdk_color_state_get_cicp (color_state);
+  if (cicp == NULL)
+    {
+      color_state = GDK_COLOR_STATE_SRGB;
+      cicp = gdk_color_state_get_cicp (color_state);
+    }
+
+  /* For memory textures in their own format and color state, this
+   * hands out the texture's bytes without copying.
+   */
+  gdk_texture_downloader_init (&downloader, texture);
+  gdk_texture_downloader_set_format (&downloader, format);
+  gdk_texture_downloader_set_color_state (&downloader, color_state);
+  bytes = gdk_texture_downloader_download_bytes (&downloader, &stride);
+  gdk_texture_downloader_finish (&downloader);
+
+  header = (GdkRawTextureHeader) {
+    .magic = GDK_RAW_TEXTURE_MAGIC,
+    .version = GDK_RAW_TEXTURE_VERSION,
+    .width = gdk_texture_get_width (texture),
+    .height = gdk_texture_get_height (texture),
+    .format = format,
+    .stride = stride,
+    .color_primaries = cicp->color_primaries,
+    .transfer_function = cicp->transfer_function,
+    .matrix_coefficients = cicp->matrix_coefficients,
+    .range = cicp->range,
+  };
+  size = gdk_memory_format_min_buffer_size (format, stride, header.width, header.height);
+  gdk_raw_texture_header_swap_le (&header);
+
+  result = g_output_stream_write_all (stream,
+                                      &header,
+                                      sizeof (header),
+                                      NULL,
+                                      cancellable,
+                                      &error) &&
+           g_output_stream_write_all (stream,
+                                      g_bytes_get_data (bytes, NULL),
+                                      size,
+                                      NULL,
+                                      cancellable,
+                                      &error);
+  g_bytes_unref (bytes);
+
+  if (result)
+    g_task_return_boolean (task, result);
+  else
+    g_task_return_error (task, error);
+}
+
+static void
+raw_texture_serializer (GdkContentSerializer *serializer)
+{
+  GTask *task;
+
+  task = g_task_new (serializer,
+                     gdk_content_serializer_get_cancellable (serializer),
+                     texture_serializer_finish,
+                     NULL);
+  g_task_run_in_thread (task, serialize_raw_texture_in_thread);
+  g_object_unref (task);
+}
+#endif
+
 static void
 string_serializer_finish (GObject      *source,
                           GAsyncResult *result,
@@ -965,6 +1061,13 @@ init (void)
 
   initialized = TRUE;
 
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+  gdk_content_register_serializer (GDK_TYPE_TEXTURE,
+                                   GDK_RAW_TEXTURE_MIME_TYPE,
+                                   raw_texture_serializer,
+                                   NULL, NULL);
+#endif
+
   gdk_content_register_serializer (GDK_TYPE_TEXTURE,
                                    "image/png",
                                    texture_serializer,
@@ -51,6 +51,8 @@ typedef enum {
   GDK_DEBUG_DEFAULT_SETTINGS= 1 << 21,
   GDK_DEBUG_HIGH_DEPTH      = 1 << 22,
   GDK_DEBUG_NO_VSYNC        = 1 << 23,
+  GDK_DEBUG_NO_FRAME_PACING = 1 << 24,
+  GDK_DEBUG_READER_THREAD   = 1 << 25,
 } GdkDebugFlags;
 
 typedef enum {
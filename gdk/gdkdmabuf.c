@@ -20,16 +20,20 @@
 
 #include "gdkdmabufprivate.h"
 
+#include "gdkcolorstateprivate.h"
 #include "gdkdebugprivate.h"
 #include "gdkdmabuffourccprivate.h"
 #include "gdkdmabuftextureprivate.h"
 #include "gdkmemoryformatprivate.h"
+#include "gdkparalleltaskprivate.h"
+#include "gdkprofilerprivate.h"
 
 #ifdef HAVE_DMABUF
 #include <sys/mman.h>
 #include <sys/ioctl.h>
 #include <linux/dma-buf.h>
 #include <epoxy/egl.h>
+#include <math.h>
 
 typedef struct _GdkDrmFormatInfo GdkDrmFormatInfo;
 
@@ -41,6 +45,7 @@ struct _GdkDrmFormatInfo
   void (* download) (guchar          *dst_data,
                      gsize            dst_stride,
                      GdkMemoryFormat  dst_format,
+                     GdkColorState   *color_state,
                      gsize            width,
                      gsize            height,
                      const GdkDmabuf *dmabuf,
@@ -58,6 +63,7 @@ static void
 download_memcpy (guchar          *dst_data,
                  gsize            dst_stride,
                  GdkMemoryFormat  dst_format,
+                 GdkColorState   *color_state,
                  gsize            width,
                  gsize            height,
                  const GdkDmabuf *dmabuf,
@@ -88,6 +94,7 @@ static void
 download_memcpy_3_1 (guchar          *dst_data,
                      gsize            dst_stride,
                      GdkMemoryFormat  dst_format,
+                     GdkColorState   *color_state,
                      gsize            width,
                      gsize            height,
                      const GdkDmabuf *dmabuf,
@@ -101,7 +108,7 @@ download_memcpy_3_1 (guchar          *dst_data,
 
   g_assert (dmabuf->n_planes == 2);
 
-  download_memcpy (dst_data, dst_stride, dst_format, width, height, dmabuf, src_datas, sizes);
+  download_memcpy (dst_data, dst_stride, dst_format, color_state, width, height, dmabuf, src_datas, sizes);
 
   switch ((int)dst_format)
     {
@@ -135,59 +142,280 @@ download_memcpy_3_1 (guchar          *dst_data,
 
 typedef struct _YUVCoefficients YUVCoefficients;
 
+/* All values multiplied by 65536 */
 struct _YUVCoefficients
 {
+  int y_scale;
+  int y_offset; /* not scaled, in 8bit units */
   int v_to_r;
   int u_to_g;
   int v_to_g;
   int u_to_b;
 };
 
-/* multiplied by 65536 */
-static const YUVCoefficients itu601_narrow = { 104597, -25675, -53279, 132201 };
-//static const YUVCoefficients itu601_wide = { 74711, -25864, -38050, 133176 };
+static void
+yuv_coefficients_init (YUVCoefficients *self,
+                       double           kr,
+                       double           kb,
+                       gboolean         narrow)
+{
+  double kg = 1.0 - kr - kb;
+  double y_scale = narrow ? 255.0 / 219.0 : 1.0;
+  double uv_scale = narrow ? 255.0 / 224.0 : 1.0;
+
+  self->y_scale = round (y_scale * 65536);
+  self->y_offset = narrow ? 16 : 0;
+  self->v_to_r = round (2 * (1 - kr) * uv_scale * 65536);
+  self->u_to_g = round (-2 * kb * (1 - kb) / kg * uv_scale * 65536);
+  self->v_to_g = round (-2 * kr * (1 - kr) / kg * uv_scale * 65536);
+  self->u_to_b = round (2 * (1 - kb) * uv_scale * 65536);
+}
+
+static void
+yuv_coefficients_init_for_color_state (YUVCoefficients *self,
+                                       GdkColorState   *color_state)
+{
+  const GdkCicp *cicp;
+
+  cicp = gdk_color_state_get_cicp (color_state);
+  if (cicp == NULL)
+    {
+      yuv_coefficients_init (self, 0.299, 0.114, TRUE);
+      return;
+    }
+
+  switch (cicp->matrix_coefficients)
+    {
+    case 1:
+      yuv_coefficients_init (self, 0.2126, 0.0722, cicp->range == GDK_CICP_RANGE_NARROW);
+      break;
+    case 5:
+    case 6:
+      yuv_coefficients_init (self, 0.299, 0.114, cicp->range == GDK_CICP_RANGE_NARROW);
+      break;
+    case 9:
+    case 10:
+      yuv_coefficients_init (self, 0.2627, 0.0593, cicp->range == GDK_CICP_RANGE_NARROW);
+      break;
+    default:
+      /* No YUV matrix given. Do what the GL and Vulkan importers do. */
+      yuv_coefficients_init (self, 0.299, 0.114, TRUE);
+      break;
+    }
+}
 
 static inline void
-get_uv_values (const YUVCoefficients *coeffs,
-               guint8                 u,
-               guint8                 v,
-               int                   *out_r,
-               int                   *out_g,
-               int                   *out_b)
+yuv_convert_pixel (guchar *dst,
+                   int     y,
+                   int     r,
+                   int     g,
+                   int     b)
 {
-  int u2 = (int) u - 127;
-  int v2 = (int) v - 127;
-  *out_r = coeffs->v_to_r * v2;
-  *out_g = coeffs->u_to_g * u2 + coeffs->v_to_g * v2;
-  *out_b = coeffs->u_to_b * u2;
+  dst[0] = CLAMP ((y + r) >> 16, 0, 255);
+  dst[1] = CLAMP ((y + g) >> 16, 0, 255);
+  dst[2] = CLAMP ((y + b) >> 16, 0, 255);
 }
 
+/* The row kernels get specialized for every layout via the macros
+ * below, so that the loops have constant steps and the compiler
+ * can vectorize them.
+ */
 static inline void
-set_rgb_values (guint8 rgb[3],
-                guint8 y,
-                int    r,
-                int    g,
-                int    b)
+yuv_convert_row (const YUVCoefficients *coeffs,
+                 guchar                *dst,
+                 const guchar          *y_row,
+                 gsize                  y_step,
+                 const guchar          *u_row,
+                 const guchar          *v_row,
+                 gsize                  uv_step,
+                 gsize                  x_sub,
+                 gsize                  width)
 {
-  int y2 = y * 65536;
+  /* Copy to locals, dst may alias anything, so they'd be reloaded */
+  const int y_scale = coeffs->y_scale, y_offset = coeffs->y_offset;
+  const int v_to_r = coeffs->v_to_r, u_to_g = coeffs->u_to_g;
+  const int v_to_g = coeffs->v_to_g, u_to_b = coeffs->u_to_b;
+  gsize i, xs, x;
 
-  rgb[0] = CLAMP ((y2 + r) >> 16, 0, 255);
-  rgb[1] = CLAMP ((y2 + g) >> 16, 0, 255);
-  rgb[2] = CLAMP ((y2 + b) >> 16, 0, 255);
+  for (i = 0; i < width / x_sub; i++)
+    {
+      int u = (int) u_row[i * uv_step] - 128;
+      int v = (int) v_row[i * uv_step] - 128;
+      int r = v_to_r * v;
+      int g = u_to_g * u + v_to_g * v;
+      int b = u_to_b * u;
+
+      for (xs = 0; xs < x_sub; xs++)
+        {
+          x = i * x_sub + xs;
+          yuv_convert_pixel (&dst[3 * x],
+                             y_scale * ((int) y_row[x * y_step] - y_offset) + 32768,
+                             r, g, b);
+        }
+    }
+
+  for (x = i * x_sub; x < width; x++)
+    {
+      int u = (int) u_row[i * uv_step] - 128;
+      int v = (int) v_row[i * uv_step] - 128;
+
+      yuv_convert_pixel (&dst[3 * x],
+                         y_scale * ((int) y_row[x * y_step] - y_offset) + 32768,
+                         v_to_r * v,
+                         u_to_g * u + v_to_g * v,
+                         u_to_b * u);
+    }
+}
+
+/* Like yuv_convert_row(), but for 16bit values with the used bits
+ * at the top, as in the P01x formats.
+ */
+static inline void
+yuv_convert_row16 (const YUVCoefficients *coeffs,
+                   guint16               *dst,
+                   const guint16         *y_row,
+                   const guint16         *u_row,
+                   const guint16         *v_row,
+                   guint                  bits,
+                   gsize                  width)
+{
+  const gint64 y_scale = coeffs->y_scale, y_offset = coeffs->y_offset << 8;
+  const gint64 v_to_r = coeffs->v_to_r, u_to_g = coeffs->u_to_g;
+  const gint64 v_to_g = coeffs->v_to_g, u_to_b = coeffs->u_to_b;
+  const guint16 mask = 0xFFFF << (16 - bits);
+  gsize x;
+
+  for (x = 0; x < width; x++)
+    {
+      gint64 y = y_scale * ((gint64) (y_row[x] & mask) - y_offset) + 32768;
+      gint64 u = (gint64) (u_row[(x / 2) * 2] & mask) - 32768;
+      gint64 v = (gint64) (v_row[(x / 2) * 2] & mask) - 32768;
+      gint64 r, g, b;
+
+      /* results are in 8.8 fixed point, make 255.0 map to 65535 */
+      r = CLAMP ((y + v_to_r * v) >> 16, 0, 65280);
+      g = CLAMP ((y + u_to_g * u + v_to_g * v) >> 16, 0, 65280);
+      b = CLAMP ((y + u_to_b * u) >> 16, 0, 65280);
+
+      dst[3 * x + 0] = r + (r >> 8);
+      dst[3 * x + 1] = g + (g >> 8);
+      dst[3 * x + 2] = b + (b >> 8);
+    }
+}
+
+/* Baseline x86-64 lacks the 32bit multiplies the kernels need to
+ * be vectorized, so build an AVX2 version, too, and pick it at
+ * load time. */
+#if defined (__x86_64__) && defined (__GLIBC__) && defined (__has_attribute)
+#if __has_attribute (target_clones)
+#define YUV_ROW_FUNC_ATTRIBUTES __attribute__ ((target_clones ("avx2", "default")))
+#endif
+#endif
+#ifndef YUV_ROW_FUNC_ATTRIBUTES
+#define YUV_ROW_FUNC_ATTRIBUTES
+#endif
+
+typedef void (* YUVRowFunc) (const YUVCoefficients *coeffs,
+                             guchar                *dst,
+                             const guchar          *y_row,
+                             const guchar          *u_row,
+                             const guchar          *v_row,
+                             gsize                  width);
+
+#define YUV_ROW_FUNC(name, Y_STEP, UV_STEP, X_SUB) \
+YUV_ROW_FUNC_ATTRIBUTES static void \
+name (const YUVCoefficients *coeffs, \
+      guchar                *dst, \
+      const guchar          *y_row, \
+      const guchar          *u_row, \
+      const guchar          *v_row, \
+      gsize                  width) \
+{ \
+  yuv_convert_row (coeffs, dst, y_row, Y_STEP, u_row, v_row, UV_STEP, X_SUB, width); \
+}
+
+YUV_ROW_FUNC (yuv_convert_row_interleaved_2, 1, 2, 2)
+YUV_ROW_FUNC (yuv_convert_row_interleaved_1, 1, 2, 1)
+YUV_ROW_FUNC (yuv_convert_row_planar_4, 1, 1, 4)
+YUV_ROW_FUNC (yuv_convert_row_planar_2, 1, 1, 2)
+YUV_ROW_FUNC (yuv_convert_row_planar_1, 1, 1, 1)
+YUV_ROW_FUNC (yuv_convert_row_packed, 2, 4, 2)
+
+#define YUV_ROW16_FUNC(name, BITS) \
+YUV_ROW_FUNC_ATTRIBUTES static void \
+name (const YUVCoefficients *coeffs, \
+      guchar                *dst, \
+      const guchar          *y_row, \
+      const guchar          *u_row, \
+      const guchar          *v_row, \
+      gsize                  width) \
+{ \
+  yuv_convert_row16 (coeffs, (guint16 *) dst, (const guint16 *) y_row, (const guint16 *) u_row, (const guint16 *) v_row, BITS, width); \
+}
+
+YUV_ROW16_FUNC (yuv_convert_row16_10, 10)
+YUV_ROW16_FUNC (yuv_convert_row16_12, 12)
+YUV_ROW16_FUNC (yuv_convert_row16_16, 16)
+
+typedef struct _YUVConvert YUVConvert;
+
+struct _YUVConvert
+{
+  YUVRowFunc row_func;
+  YUVCoefficients coeffs;
+  guchar *dst_data;
+  gsize dst_stride;
+  const guchar *y_data;
+  gsize y_stride;
+  const guchar *u_data;
+  gsize u_stride;
+  const guchar *v_data;
+  gsize v_stride;
+  gsize y_sub;
+  gsize width;
+  gsize height;
+
+  /* atomic */ int rows_done;
+};
+
+static void
+yuv_convert (gpointer data)
+{
+  YUVConvert *yc = data;
+  G_GNUC_UNUSED gint64 before = GDK_PROFILER_CURRENT_TIME;
+  gsize y, rows;
+
+  rows = 0;
+  for (y = g_atomic_int_add (&yc->rows_done, 1);
+       y < yc->height;
+       y = g_atomic_int_add (&yc->rows_done, 1))
+    {
+      yc->row_func (&yc->coeffs,
+                    yc->dst_data + y * yc->dst_stride,
+                    yc->y_data + y * yc->y_stride,
+                    yc->u_data + y / yc->y_sub * yc->u_stride,
+                    yc->v_data + y / yc->y_sub * yc->v_stride,
+                    yc->width);
+      rows++;
+    }
+
+  gdk_profiler_end_markf (before, "YUV convert (thread)", "size %" G_GSIZE_FORMAT "x%" G_GSIZE_FORMAT ", %" G_GSIZE_FORMAT " rows", yc->width, yc->height, rows);
 }
 
 static void
 download_nv12 (guchar          *dst_data,
                gsize            dst_stride,
                GdkMemoryFormat  dst_format,
+               GdkColorState   *color_state,
                gsize            width,
                gsize            height,
                const GdkDmabuf *dmabuf,
                const guchar    *src_data[GDK_DMABUF_MAX_PLANES],
                gsize            sizes[GDK_DMABUF_MAX_PLANES])
 {
+  YUVConvert yc;
   const guchar *y_data, *uv_data;
-  gsize x, y, y_stride, uv_stride;
+  gsize y_stride, uv_stride;
   gsize U, V, X_SUB, Y_SUB;
 
   switch (dmabuf->fourcc)
@@ -222,140 +450,99 @@ download_nv12 (guchar          *dst_data,
   uv_data = src_data[1] + dmabuf->planes[1].offset;
   g_return_if_fail (sizes[1] >= dmabuf->planes[1].offset + (height + Y_SUB - 1) / Y_SUB * uv_stride);
 
-  for (y = 0; y < height; y += Y_SUB)
-    {
-      for (x = 0; x < width; x += X_SUB)
-        {
-          int r, g, b;
-          gsize xs, ys;
-
-          get_uv_values (&itu601_narrow, uv_data[x / X_SUB * 2 + U], uv_data[x / X_SUB * 2 + V], &r, &g, &b);
-
-          for (ys = 0; ys < Y_SUB && y + ys < height; ys++)
-            for (xs = 0; xs < X_SUB && x + xs < width; xs++)
-              set_rgb_values (&dst_data[3 * (x + xs) + dst_stride * ys], y_data[x + xs + y_stride * ys], r, g, b);
-        }
-      dst_data += Y_SUB * dst_stride;
-      y_data += Y_SUB * y_stride;
-      uv_data += uv_stride;
-    }
-}
-
-static inline void
-get_uv_values16 (const YUVCoefficients *coeffs,
-                 guint16                u,
-                 guint16                v,
-                 gint64                *out_r,
-                 gint64                *out_g,
-                 gint64                *out_b)
-{
-  gint64 u2 = (gint64) u - 32767;
-  gint64 v2 = (gint64) v - 32767;
-  *out_r = coeffs->v_to_r * v2;
-  *out_g = coeffs->u_to_g * u2 + coeffs->v_to_g * v2;
-  *out_b = coeffs->u_to_b * u2;
-}
-
-static inline void
-set_rgb_values16 (guint16 rgb[3],
-                  guint16 y,
-                  gint64  r,
-                  gint64  g,
-                  gint64  b)
-{
-  gint64 y2 = (gint64) y * 65536;
+  yc = (YUVConvert) {
+    .row_func = X_SUB == 2 ? yuv_convert_row_interleaved_2 : yuv_convert_row_interleaved_1,
+    .dst_data = dst_data,
+    .dst_stride = dst_stride,
+    .y_data = y_data,
+    .y_stride = y_stride,
+    .u_data = uv_data + U,
+    .u_stride = uv_stride,
+    .v_data = uv_data + V,
+    .v_stride = uv_stride,
+    .y_sub = Y_SUB,
+    .width = width,
+    .height = height,
+  };
+  yuv_coefficients_init_for_color_state (&yc.coeffs, color_state);
 
-  rgb[0] = CLAMP ((y2 + r) >> 16, 0, 65535);
-  rgb[1] = CLAMP ((y2 + g) >> 16, 0, 65535);
-  rgb[2] = CLAMP ((y2 + b) >> 16, 0, 65535);
+  gdk_parallel_task_run (yuv_convert, &yc);
 }
 
 static void
-download_p010 (guchar          *dst,
+download_p010 (guchar          *dst_data,
                gsize            dst_stride,
                GdkMemoryFormat  dst_format,
+               GdkColorState   *color_state,
                gsize            width,
                gsize            height,
                const GdkDmabuf *dmabuf,
                const guchar    *src_data[GDK_DMABUF_MAX_PLANES],
                gsize            sizes[GDK_DMABUF_MAX_PLANES])
 {
-  const guint16 *y_data, *uv_data;
-  guint16 *dst_data;
-  gsize x, y, y_stride, uv_stride;
-  gsize U, V, X_SUB, Y_SUB;
-  guint16 SIZE, MASK;
+  YUVConvert yc;
+  const guchar *y_data, *uv_data;
+  gsize y_stride, uv_stride;
+  YUVRowFunc row_func;
 
   switch (dmabuf->fourcc)
     {
     case DRM_FORMAT_P010:
-      U = 0; V = 1; X_SUB = 2; Y_SUB = 2;
-      SIZE = 10;
+      row_func = yuv_convert_row16_10;
       break;
     case DRM_FORMAT_P012:
-      U = 0; V = 1; X_SUB = 2; Y_SUB = 2;
-      SIZE = 12;
+      row_func = yuv_convert_row16_12;
       break;
     case DRM_FORMAT_P016:
-      U = 0; V = 1; X_SUB = 2; Y_SUB = 2;
-      SIZE = 16;
+      row_func = yuv_convert_row16_16;
       break;
     default:
       g_assert_not_reached ();
       return;
     }
-  MASK = 0xFFFF << (16 - SIZE);
-
-  y_stride = dmabuf->planes[0].stride / 2;
-  y_data = (const guint16 *) (src_data[0] + dmabuf->planes[0].offset);
-  g_return_if_fail (sizes[0] >= dmabuf->planes[0].offset + height * dmabuf->planes[0].stride);
-  uv_stride = dmabuf->planes[1].stride / 2;
-  uv_data = (const guint16 *) (src_data[1] + dmabuf->planes[1].offset);
-  g_return_if_fail (sizes[1] >= dmabuf->planes[1].offset + (height + Y_SUB - 1) / Y_SUB * dmabuf->planes[1].stride);
-  dst_data = (guint16 *) dst;
-  dst_stride /= 2;
-
-  for (y = 0; y < height; y += Y_SUB)
-    {
-      for (x = 0; x < width; x += X_SUB)
-        {
-          gint64 r, g, b;
-          gsize xs, ys;
-          guint16 u, v;
-
-          u = uv_data[x / X_SUB * 2 + U];
-          u = (u & MASK) | (u >> SIZE);
-          v = uv_data[x / X_SUB * 2 + V];
-          v = (v & MASK) | (v >> SIZE);
-          get_uv_values16 (&itu601_narrow, u, v, &r, &g, &b);
-
-          for (ys = 0; ys < Y_SUB && y + ys < height; ys++)
-            for (xs = 0; xs < X_SUB && x + xs < width; xs++)
-              {
-                guint16 y_ = y_data[x + xs + y_stride * ys];
-                y_ = (y_ & MASK) | (y_ >> SIZE);
-                set_rgb_values16 (&dst_data[3 * (x + xs) + dst_stride * ys], y_, r, g, b);
-              }
-        }
-      dst_data += Y_SUB * dst_stride;
-      y_data += Y_SUB * y_stride;
-      uv_data += uv_stride;
-    }
+
+  y_stride = dmabuf->planes[0].stride;
+  y_data = src_data[0] + dmabuf->planes[0].offset;
+  g_return_if_fail (sizes[0] >= dmabuf->planes[0].offset + height * y_stride);
+  uv_stride = dmabuf->planes[1].stride;
+  uv_data = src_data[1] + dmabuf->planes[1].offset;
+  g_return_if_fail (sizes[1] >= dmabuf->planes[1].offset + (height + 1) / 2 * uv_stride);
+
+  yc = (YUVConvert) {
+    .row_func = row_func,
+    .dst_data = dst_data,
+    .dst_stride = dst_stride,
+    .y_data = y_data,
+    .y_stride = y_stride,
+    .u_data = uv_data,
+    .u_stride = uv_stride,
+    .v_data = uv_data + sizeof (guint16),
+    .v_stride = uv_stride,
+    .y_sub = 2,
+    .width = width,
+    .height = height,
+  };
+  yuv_coefficients_init_for_color_state (&yc.coeffs, color_state);
+
+  gdk_parallel_task_run (yuv_convert, &yc);
 }
 
 static void
 download_yuv_3 (guchar          *dst_data,
                 gsize            dst_stride,
                 GdkMemoryFormat  dst_format,
+                GdkColorState   *color_state,
                 gsize            width,
                 gsize            height,
                 const GdkDmabuf *dmabuf,
                 const guchar    *src_data[GDK_DMABUF_MAX_PLANES],
                 gsize            sizes[GDK_DMABUF_MAX_PLANES])
 {
+  YUVConvert yc;
   const guchar *y_data, *u_data, *v_data;
-  gsize x, y, y_stride, u_stride, v_stride;
+  gsize y_stride, u_stride, v_stride;
   gsize U, V, X_SUB, Y_SUB;
+  YUVRowFunc row_func;
 
   switch (dmabuf->fourcc)
     {
@@ -394,6 +581,22 @@ download_yuv_3 (guchar          *dst_data,
       return;
     }
 
+  switch (X_SUB)
+    {
+    case 4:
+      row_func = yuv_convert_row_planar_4;
+      break;
+    case 2:
+      row_func = yuv_convert_row_planar_2;
+      break;
+    case 1:
+      row_func = yuv_convert_row_planar_1;
+      break;
+    default:
+      g_assert_not_reached ();
+      return;
+    }
+
   y_stride = dmabuf->planes[0].stride;
   y_data = src_data[0] + dmabuf->planes[0].offset;
   g_return_if_fail (sizes[0] >= dmabuf->planes[0].offset + height * y_stride);
@@ -404,53 +607,55 @@ download_yuv_3 (guchar          *dst_data,
   v_data = src_data[V] + dmabuf->planes[V].offset;
   g_return_if_fail (sizes[V] >= dmabuf->planes[V].offset + (height + Y_SUB - 1) / Y_SUB * v_stride);
 
-  for (y = 0; y < height; y += Y_SUB)
-    {
-      for (x = 0; x < width; x += X_SUB)
-        {
-          int r, g, b;
-          gsize xs, ys;
-
-          get_uv_values (&itu601_narrow, u_data[x / X_SUB], v_data[x / X_SUB], &r, &g, &b);
+  yc = (YUVConvert) {
+    .row_func = row_func,
+    .dst_data = dst_data,
+    .dst_stride = dst_stride,
+    .y_data = y_data,
+    .y_stride = y_stride,
+    .u_data = u_data,
+    .u_stride = u_stride,
+    .v_data = v_data,
+    .v_stride = v_stride,
+    .y_sub = Y_SUB,
+    .width = width,
+    .height = height,
+  };
+  yuv_coefficients_init_for_color_state (&yc.coeffs, color_state);
 
-          for (ys = 0; ys < Y_SUB && y + ys < height; ys++)
-            for (xs = 0; xs < X_SUB && x + xs < width; xs++)
-              set_rgb_values (&dst_data[3 * (x + xs) + dst_stride * ys], y_data[x + xs + y_stride * ys], r, g, b);
-        }
-      dst_data += Y_SUB * dst_stride;
-      y_data += Y_SUB * y_stride;
-      u_data += u_stride;
-      v_data += v_stride;
-    }
+  gdk_parallel_task_run (yuv_convert, &yc);
 }
 
 static void
 download_yuyv (guchar          *dst_data,
                gsize            dst_stride,
                GdkMemoryFormat  dst_format,
+               GdkColorState   *color_state,
                gsize            width,
                gsize            height,
                const GdkDmabuf *dmabuf,
                const guchar    *src_datas[GDK_DMABUF_MAX_PLANES],
                gsize            sizes[GDK_DMABUF_MAX_PLANES])
 {
+  YUVConvert yc;
   const guchar *src_data;
-  gsize x, y, src_stride;
-  gsize Y1, Y2, U, V;
+  gsize src_stride;
+  gsize Y1, U, V;
 
+  /* The second Y value is always 2 bytes after the first */
   switch (dmabuf->fourcc)
     {
     case DRM_FORMAT_YUYV:
-      Y1 = 0; U = 1; Y2 = 2; V = 3;
+      Y1 = 0; U = 1; V = 3;
       break;
     case DRM_FORMAT_YVYU:
-      Y1 = 0; V = 1; Y2 = 2; U = 3;
+      Y1 = 0; V = 1; U = 3;
       break;
     case DRM_FORMAT_UYVY:
-      U = 0; Y1 = 1; V = 2; Y2 = 3;
+      U = 0; Y1 = 1; V = 2;
       break;
     case DRM_FORMAT_VYUY:
-      V = 0; Y1 = 1; U = 2; Y2 = 3;
+      V = 0; Y1 = 1; U = 2;
       break;
     default:
       g_assert_not_reached ();
@@ -461,20 +666,23 @@ download_yuyv (guchar          *dst_data,
   src_data = src_datas[0] + dmabuf->planes[0].offset;
   g_return_if_fail (sizes[0] >= dmabuf->planes[0].offset + height * src_stride);
 
-  for (y = 0; y < height; y ++)
-    {
-      for (x = 0; x < width; x += 2)
-        {
-          int r, g, b;
+  yc = (YUVConvert) {
+    .row_func = yuv_convert_row_packed,
+    .dst_data = dst_data,
+    .dst_stride = dst_stride,
+    .y_data = src_data + Y1,
+    .y_stride = src_stride,
+    .u_data = src_data + U,
+    .u_stride = src_stride,
+    .v_data = src_data + V,
+    .v_stride = src_stride,
+    .y_sub = 1,
+    .width = width,
+    .height = height,
+  };
+  yuv_coefficients_init_for_color_state (&yc.coeffs, color_state);
 
-          get_uv_values (&itu601_narrow, src_data[2 * x + U], src_data[2 * x + V], &r, &g, &b);
-          set_rgb_values (&dst_data[3 * x], src_data[2 * x + Y1], r, g, b);
-          if (x + 1 < width)
-            set_rgb_values (&dst_data[3 * (x + 1)], src_data[2 * x + Y2], r, g, b);
-        }
-      dst_data += dst_stride;
-      src_data += src_stride;
-    }
+  gdk_parallel_task_run (yuv_convert, &yc);
 }
 
 #define VULKAN_SWIZZLE(_R, _G, _B, _A) { VK_COMPONENT_SWIZZLE_ ## _R, VK_COMPONENT_SWIZZLE_ ## _G, VK_COMPONENT_SWIZZLE_ ## _B, VK_COMPONENT_SWIZZLE_ ## _A }
@@ -2143,6 +2351,7 @@ gdk_dmabuf_do_download_mmap (GdkTexture *texture,
   info->download (data,
                   stride,
                   gdk_texture_get_format (texture),
+                  gdk_texture_get_color_state (texture),
                   gdk_texture_get_width (texture),
                   gdk_texture_get_height (texture),
                   dmabuf,
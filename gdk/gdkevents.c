@@ -32,6 +32,7 @@
 #include "gdkkeysprivate.h"
 #include "gdkkeysyms.h"
 #include "gdkprivate.h"
+#include "gdksurfaceprivate.h"
 
 #include <gobject/gvaluecollector.h>
 
@@ -495,6 +496,29 @@ _gdk_event_emit (GdkEvent *event)
  * Functions for maintaining the event queue *
  *********************************************/
 
+/* Events that are held back until the next frame, so that they
+ * can be merged with later ones of the same kind.
+ */
+static gboolean
+gdk_event_is_coalesced (GdkEvent *event)
+{
+  if (event->surface == NULL || event->surface->no_event_compression)
+    return FALSE;
+
+  switch ((guint) event->event_type)
+    {
+    case GDK_MOTION_NOTIFY:
+    case GDK_TOUCH_UPDATE:
+      return TRUE;
+
+    case GDK_SCROLL:
+      return gdk_scroll_event_get_direction (event) == GDK_SCROLL_SMOOTH;
+
+    default:
+      return FALSE;
+    }
+}
+
 /**
  * _gdk_event_queue_find_first:
  * @display: a `GdkDisplay`
@@ -523,8 +547,7 @@ _gdk_event_queue_find_first (GdkDisplay *display)
           if (pending_motion)
             return pending_motion;
 
-          if ((event->event_type == GDK_MOTION_NOTIFY ||
-               (event->event_type == GDK_SCROLL && gdk_scroll_event_get_direction (event) == GDK_SCROLL_SMOOTH)) &&
+          if (gdk_event_is_coalesced (event) &&
               (event->flags & GDK_EVENT_FLUSHED) == 0)
             pending_motion = tmp_list;
           else
@@ -627,7 +650,7 @@ gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
         break;
 
       if (event->event_type != GDK_SCROLL ||
-          gdk_scroll_event_get_direction (event) != GDK_SCROLL_SMOOTH)
+          !gdk_event_is_coalesced (event))
         break;
 
       if (surface != NULL &&
@@ -729,26 +752,21 @@ gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
     }
 }
 
+/* Appends @history_event, preceded by its own history, to @history */
 static void
-gdk_motion_event_push_history (GdkEvent *event,
-                               GdkEvent *history_event)
+gdk_event_history_push (GArray   **history,
+                        GArray    *event_history,
+                        GdkEvent  *history_event)
 {
-  GdkMotionEvent *self = (GdkMotionEvent *) event;
   GdkDeviceTool *tool;
   GdkTimeCoord hist;
   int i;
 
-  g_assert (GDK_IS_EVENT_TYPE (event, GDK_MOTION_NOTIFY));
-  g_assert (GDK_IS_EVENT_TYPE (history_event, GDK_MOTION_NOTIFY));
-
-  if (G_UNLIKELY (!self->history))
-    self->history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
+  if (G_UNLIKELY (!*history))
+    *history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
 
-  if (((GdkMotionEvent *)history_event)->history)
-    {
-      GArray *history = ((GdkMotionEvent *)history_event)->history;
-      g_array_append_vals (self->history, history->data, history->len);
-    }
+  if (event_history)
+    g_array_append_vals (*history, event_history->data, event_history->len);
 
   tool = gdk_event_get_device_tool (history_event);
 
@@ -772,15 +790,42 @@ gdk_motion_event_push_history (GdkEvent *event,
       gdk_event_get_position (history_event, &hist.axes[GDK_AXIS_X], &hist.axes[GDK_AXIS_Y]);
     }
 
-  g_array_append_val (self->history, hist);
+  g_array_append_val (*history, hist);
+}
+
+static void
+gdk_motion_event_push_history (GdkEvent *event,
+                               GdkEvent *history_event)
+{
+  GdkMotionEvent *self = (GdkMotionEvent *) event;
+
+  g_assert (GDK_IS_EVENT_TYPE (event, GDK_MOTION_NOTIFY));
+  g_assert (GDK_IS_EVENT_TYPE (history_event, GDK_MOTION_NOTIFY));
+
+  gdk_event_history_push (&self->history,
+                          ((GdkMotionEvent *) history_event)->history,
+                          history_event);
+}
+
+static void
+gdk_touch_event_push_history (GdkEvent *event,
+                              GdkEvent *history_event)
+{
+  GdkTouchEvent *self = (GdkTouchEvent *) event;
+
+  g_assert (GDK_IS_EVENT_TYPE (event, GDK_TOUCH_UPDATE));
+  g_assert (GDK_IS_EVENT_TYPE (history_event, GDK_TOUCH_UPDATE));
+
+  gdk_event_history_push (&self->history,
+                          ((GdkTouchEvent *) history_event)->history,
+                          history_event);
 }
 
 /* If the last N events in the event queue are motion notify
  * events for the same surface, drop all but the last.
  *
- * If a button is held down or the device has a tool, then
- * we give the remaining events a history containing the N-1
- * dropped events.
+ * We give the remaining event a history containing the N-1
+ * dropped events, so no samples are lost.
  */
 void
 _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
@@ -800,7 +845,8 @@ _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
       if (event->flags & GDK_EVENT_PENDING)
         break;
 
-      if (event->event_type != GDK_MOTION_NOTIFY)
+      if (event->event_type != GDK_MOTION_NOTIFY ||
+          !gdk_event_is_coalesced (event))
         break;
 
       if (pending_motion_surface != NULL &&
@@ -825,14 +871,7 @@ _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
     {
       GList *next = pending_motions->next;
 
-      if (last_motion != NULL)
-        {
-          if ((gdk_event_get_modifier_state (last_motion) &
-               (GDK_BUTTON1_MASK | GDK_BUTTON2_MASK | GDK_BUTTON3_MASK |
-                GDK_BUTTON4_MASK | GDK_BUTTON5_MASK)) ||
-               gdk_event_get_device_tool (last_motion) != NULL)
-            gdk_motion_event_push_history (last_motion, pending_motions->data);
-        }
+      gdk_motion_event_push_history (last_motion, pending_motions->data);
 
       gdk_event_unref (pending_motions->data);
       g_queue_delete_link (&display->queued_events, pending_motions);
@@ -840,6 +879,73 @@ _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
     }
 }
 
+/* If the last N events in the event queue are touch updates for the
+ * same surface and device, keep only the last update of each touch
+ * sequence and give it a history containing the dropped ones.
+ */
+void
+gdk_event_queue_handle_touch_compression (GdkDisplay *display)
+{
+  GList *l, *first = NULL;
+  GdkSurface *surface = NULL;
+  GdkDevice *device = NULL;
+  GHashTable *last_update;
+
+  l = g_queue_peek_tail_link (&display->queued_events);
+
+  while (l)
+    {
+      GdkEvent *event = l->data;
+
+      if (event->flags & GDK_EVENT_PENDING)
+        break;
+
+      if (event->event_type != GDK_TOUCH_UPDATE ||
+          !gdk_event_is_coalesced (event))
+        break;
+
+      if (surface != NULL &&
+          surface != event->surface)
+        break;
+
+      if (device != NULL &&
+          device != event->device)
+        break;
+
+      surface = event->surface;
+      device = event->device;
+      first = l;
+
+      l = l->prev;
+    }
+
+  if (first == NULL || first->next == NULL)
+    return;
+
+  /* Walk the run front to back, folding each update into the
+   * next one of the same sequence */
+  last_update = g_hash_table_new (NULL, NULL);
+
+  for (l = first; l; )
+    {
+      GList *next = l->next;
+      GdkEventSequence *sequence = gdk_event_get_event_sequence (l->data);
+      GList *prev_link = g_hash_table_lookup (last_update, sequence);
+
+      if (prev_link)
+        {
+          gdk_touch_event_push_history (l->data, prev_link->data);
+          gdk_event_unref (prev_link->data);
+          g_queue_delete_link (&display->queued_events, prev_link);
+        }
+
+      g_hash_table_insert (last_update, sequence, l);
+      l = next;
+    }
+
+  g_hash_table_unref (last_update);
+}
+
 void
 _gdk_event_queue_flush (GdkDisplay *display)
 {
@@ -1998,6 +2104,8 @@ gdk_touch_event_finalize (GdkEvent *event)
   GdkTouchEvent *self = (GdkTouchEvent *) event;
 
   g_clear_pointer (&self->axes, g_free);
+  if (self->history)
+    g_array_free (self->history, TRUE);
 
   GDK_EVENT_SUPER (event)->finalize (event);
 }
@@ -3144,7 +3252,7 @@ gdk_motion_event_new (GdkSurface      *surface,
 
 /**
  * gdk_event_get_history:
- * @event: a motion or scroll event
+ * @event: a motion, scroll or touch update event
  * @out_n_coords: (out): Return location for the length of the returned array
  *
  * Retrieves the history of the device that @event is for, as a list of
@@ -3153,9 +3261,12 @@ gdk_motion_event_new (GdkSurface      *surface,
  * The history includes positions that are not delivered as separate events
  * to the application because they occurred in the same frame as @event.
  *
- * Note that only motion and scroll events record history, and motion
- * events do it only if one of the mouse buttons is down, or the device
- * has a tool.
+ * Note that only motion, scroll and touch update events record history.
+ * For touch update events, the history only contains the positions of
+ * the same touch sequence.
+ *
+ * Before 4.18, motion events only recorded history if one of the mouse
+ * buttons was down, or the device had a tool.
  *
  * Returns: (transfer container) (array length=out_n_coords) (nullable): an
  *   array of time and coordinates
@@ -3168,7 +3279,8 @@ gdk_event_get_history (GdkEvent *event,
 
   g_return_val_if_fail (GDK_IS_EVENT (event), NULL);
   g_return_val_if_fail (GDK_IS_EVENT_TYPE (event, GDK_MOTION_NOTIFY) ||
-                        GDK_IS_EVENT_TYPE (event, GDK_SCROLL), NULL);
+                        GDK_IS_EVENT_TYPE (event, GDK_SCROLL) ||
+                        GDK_IS_EVENT_TYPE (event, GDK_TOUCH_UPDATE), NULL);
   g_return_val_if_fail (out_n_coords != NULL, NULL);
 
   if (GDK_IS_EVENT_TYPE (event, GDK_MOTION_NOTIFY))
@@ -3176,6 +3288,11 @@ gdk_event_get_history (GdkEvent *event,
       GdkMotionEvent *self = (GdkMotionEvent *) event;
       history = self->history;
     }
+  else if (GDK_IS_EVENT_TYPE (event, GDK_TOUCH_UPDATE))
+    {
+      GdkTouchEvent *self = (GdkTouchEvent *) event;
+      history = self->history;
+    }
   else
     {
       GdkScrollEvent *self = (GdkScrollEvent *) event;
@@ -168,6 +168,8 @@ struct _GdkButtonEvent
  *   if @device is the mouse
  * @sequence: the event sequence that the event belongs to
  * @emulated: whether the event is the result of a pointer emulation
+ * @history: (element-type GdkTimeCoord): array of times and coordinates
+ *   for the updates of @sequence that were merged into this event
  *
  * Used for touch events.
  * @type field will be one of %GDK_TOUCH_BEGIN, %GDK_TOUCH_UPDATE,
@@ -191,6 +193,7 @@ struct _GdkTouchEvent
   GdkEventSequence *sequence;
   gboolean touch_emulating;
   gboolean pointer_emulated;
+  GArray *history; /* <GdkTimeCoord> */
 };
 
 /*
@@ -628,6 +631,7 @@ GList*   _gdk_event_queue_append      (GdkDisplay *display,
 
 void     _gdk_event_queue_handle_motion_compression (GdkDisplay *display);
 void     gdk_event_queue_handle_scroll_compression  (GdkDisplay *display);
+void     gdk_event_queue_handle_touch_compression   (GdkDisplay *display);
 void     _gdk_event_queue_flush                     (GdkDisplay       *display);
 
 double * gdk_event_dup_axes (GdkEvent *event);
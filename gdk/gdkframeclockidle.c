@@ -37,6 +37,14 @@
 
 #define FRAME_INTERVAL 16667 /* microseconds */
 
+/* Frame pacing: start a frame as late as the measured cost of recent
+ * frames allows, so it still makes the predicted vblank.
+ */
+#define PACING_HISTORY 8           /* frames to look at for the cost estimate */
+#define PACING_MIN_SAMPLES 4       /* don't pace before we have this many */
+#define PACING_MARGIN 3000         /* microseconds left for the GPU and compositor */
+#define PACING_BACKOFF_FRAMES 120  /* frames to start right away after a miss */
+
 typedef enum {
   SMOOTH_PHASE_STATE_VALID = 0,    /* explicit, since we count on zero-init */
   SMOOTH_PHASE_STATE_AWAIT_FIRST,
@@ -67,6 +75,13 @@ struct _GdkFrameClockIdlePrivate
   GdkFrameClockPhase requested;
   GdkFrameClockPhase phase;
 
+  gint64 paced_start_time;      /* When the pending idles were scheduled to start, or 0 */
+  gint64 paced_target_time;     /* The vblank the next frame start was delayed for, or 0 */
+  gint64 paced_frame_counter;   /* A delayed frame waiting for its presentation time, or 0 */
+  gint64 paced_frame_target;    /* The vblank that frame was meant for */
+  guint pacing_backoff;         /* Frames left to run unpaced after a missed deadline */
+  guint missed_deadlines;
+
   guint in_paint_idle : 1;
   guint paint_is_thaw : 1;
 #ifdef G_OS_WIN32
@@ -79,6 +94,8 @@ static gboolean gdk_frame_clock_paint_idle (void *data);
 
 G_DEFINE_TYPE_WITH_PRIVATE (GdkFrameClockIdle, gdk_frame_clock_idle, GDK_TYPE_FRAME_CLOCK)
 
+static guint missed_deadlines_counter;
+
 static gint64 sleep_serial;
 static gint64 sleep_source_prepare_time;
 static GSource *sleep_source;
@@ -142,6 +159,9 @@ gdk_frame_clock_idle_init (GdkFrameClockIdle *frame_clock_idle)
 
   priv->freeze_count = 0;
   priv->smoothed_frame_time_period = FRAME_INTERVAL;
+
+  if (missed_deadlines_counter == 0)
+    missed_deadlines_counter = gdk_profiler_define_int_counter ("missed deadlines", "Frames that were paced but missed their vblank");
 }
 
 static void
@@ -310,6 +330,126 @@ should_run_paint_idle (GdkFrameClockIdle *self)
           priv->updating_count > 0);
 }
 
+/* Estimates how long a frame takes from the start of the clock cycle
+ * until ::after-paint is done, or returns 0 if there isn't enough
+ * history to tell.
+ *
+ * This uses the wall clock time the paint idle started at, not the
+ * frame time, which is adjusted to the refresh grid.
+ */
+static gint64
+predict_frame_cost (GdkFrameClock *clock)
+{
+  gint64 counter, history_start;
+  gint64 cost = 0;
+  guint n_samples = 0;
+
+  history_start = gdk_frame_clock_get_history_start (clock);
+
+  for (counter = gdk_frame_clock_get_frame_counter (clock);
+       counter >= history_start && counter > 0 && n_samples < PACING_HISTORY;
+       counter--)
+    {
+      GdkFrameTimings *timings = gdk_frame_clock_get_timings (clock, counter);
+
+      if (timings == NULL || timings->cycle_start_time == 0 || timings->frame_end_time == 0)
+        continue;
+
+      cost = MAX (cost, timings->frame_end_time - timings->cycle_start_time);
+      n_samples++;
+    }
+
+  if (n_samples < PACING_MIN_SAMPLES)
+    return 0;
+
+  /* Err on the late side, the worst case of a handful of frames is
+   * only a rough predictor of the next one. */
+  return cost + cost / 4;
+}
+
+/* Returns the latest time the next frame can start and still be
+ * presented at the upcoming vblank, or 0 if the frame should start
+ * right away.
+ */
+static gint64
+compute_paced_start_time (GdkFrameClockIdle *self,
+                          gint64             earliest)
+{
+  GdkFrameClockIdlePrivate *priv = self->priv;
+  GdkFrameClock *clock = GDK_FRAME_CLOCK (self);
+  gint64 refresh_interval, presentation_time;
+  gint64 cost, start_time;
+
+  priv->paced_target_time = 0;
+
+  if (priv->pacing_backoff > 0 ||
+      GDK_DEBUG_CHECK (NO_FRAME_PACING))
+    return 0;
+
+  cost = predict_frame_cost (clock);
+  if (cost == 0)
+    return 0;
+
+  gdk_frame_clock_get_refresh_info (clock, earliest, &refresh_interval, &presentation_time);
+  if (presentation_time == 0)
+    return 0;
+
+  start_time = presentation_time - cost - PACING_MARGIN;
+  if (start_time <= earliest)
+    return 0;
+
+  /* Never wait for more than half a frame, timing information is
+   * too coarse to bet more latency on it. */
+  start_time = MIN (start_time, earliest + refresh_interval / 2);
+
+  priv->paced_target_time = presentation_time;
+
+  return start_time;
+}
+
+/* Looks at the presentation time of the last paced frame once it is
+ * known and stops pacing for a while if it missed its vblank.
+ */
+static void
+check_paced_frame (GdkFrameClockIdle *self)
+{
+  GdkFrameClockIdlePrivate *priv = self->priv;
+  GdkFrameClock *clock = GDK_FRAME_CLOCK (self);
+  GdkFrameTimings *timings;
+
+  if (priv->pacing_backoff > 0)
+    priv->pacing_backoff--;
+
+  if (priv->paced_frame_counter == 0)
+    return;
+
+  timings = gdk_frame_clock_get_timings (clock, priv->paced_frame_counter);
+  if (timings == NULL)
+    {
+      /* Fell out of the history without being presented */
+      priv->paced_frame_counter = 0;
+      return;
+    }
+
+  if (!timings->complete)
+    return;
+
+  if (timings->presentation_time != 0 &&
+      timings->presentation_time > priv->paced_frame_target + priv->smoothed_frame_time_period / 2)
+    {
+      priv->missed_deadlines++;
+      priv->pacing_backoff = PACING_BACKOFF_FRAMES;
+
+      GDK_DEBUG (FRAMES, "Frame %" G_GINT64_FORMAT " missed its deadline by %.1f ms, pausing frame pacing",
+                 timings->frame_counter,
+                 (timings->presentation_time - priv->paced_frame_target) / 1000.);
+
+      gdk_profiler_set_int_counter (missed_deadlines_counter, priv->missed_deadlines);
+    }
+
+  priv->paced_frame_counter = 0;
+}
+
 static void
 maybe_start_idle (GdkFrameClockIdle *self,
                   gboolean           caused_by_thaw)
@@ -320,12 +460,20 @@ maybe_start_idle (GdkFrameClockIdle *self,
     {
       guint min_interval = 0;
 
-      if (priv->min_next_frame_time != 0 &&
-          !GDK_DEBUG_CHECK (NO_VSYNC))
+      if (!GDK_DEBUG_CHECK (NO_VSYNC))
         {
           gint64 now = g_get_monotonic_time ();
-          gint64 min_interval_us = MAX (priv->min_next_frame_time, now) - now;
-          min_interval = (min_interval_us + 500) / 1000;
+          gint64 start_time;
+
+          start_time = MAX (priv->min_next_frame_time, now);
+
+          /* If one of the idles is already pending, the other one must
+           * not start earlier than it. */
+          if (priv->flush_idle_id == 0 && priv->paint_idle_id == 0)
+            priv->paced_start_time = compute_paced_start_time (self, start_time);
+          start_time = MAX (start_time, priv->paced_start_time);
+
+          min_interval = (start_time - now + 500) / 1000;
         }
 
       if (priv->flush_idle_id == 0 && should_run_flush_idle (self))
@@ -430,8 +578,10 @@ gdk_frame_clock_paint_idle (void *data)
   gboolean skip_to_resume_events;
   GdkFrameTimings *timings = NULL;
   gint64 before G_GNUC_UNUSED;
+  gint64 cycle_start_time;
 
   before = GDK_PROFILER_CURRENT_TIME;
+  cycle_start_time = g_get_monotonic_time ();
 
   priv->paint_idle_id = 0;
   priv->in_paint_idle = TRUE;
@@ -548,12 +698,24 @@ gdk_frame_clock_paint_idle (void *data)
               priv->smoothed_frame_time_period = frame_interval;
               priv->smoothed_frame_time_reported = priv->smoothed_frame_time_base;
 
+              check_paced_frame (clock_idle);
+
               _gdk_frame_clock_begin_frame (clock, priv->frame_time);
               /* Note "current" is different now so timings != prev_timings */
               timings = gdk_frame_clock_get_current_timings (clock);
 
+              /* Presentation feedback can lag behind by a frame, so
+               * keep checking the pending one before tracking another. */
+              if (priv->paced_target_time != 0 && priv->paced_frame_counter == 0)
+                {
+                  priv->paced_frame_counter = timings->frame_counter;
+                  priv->paced_frame_target = priv->paced_target_time;
+                }
+              priv->paced_target_time = 0;
+
               timings->frame_time = priv->frame_time;
               timings->smoothed_frame_time = priv->smoothed_frame_time_base;
+              timings->cycle_start_time = cycle_start_time;
               timings->slept_before = priv->sleep_serial != get_sleep_serial ();
 
               priv->phase = GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT;
@@ -645,11 +807,9 @@ gdk_frame_clock_paint_idle (void *data)
                */
               priv->phase = GDK_FRAME_CLOCK_PHASE_NONE;
             }
-          if (GDK_DEBUG_CHECK (FRAMES))
-            {
-              if (timings)
-                timings->frame_end_time = g_get_monotonic_time ();
-            }
+          /* Always recorded, frame pacing predicts costs from it */
+          if (timings)
+            timings->frame_end_time = g_get_monotonic_time ();
           G_GNUC_FALLTHROUGH;
 
         case GDK_FRAME_CLOCK_PHASE_RESUME_EVENTS:
@@ -95,6 +95,7 @@ struct _GdkFrameTimings
   gint64 refresh_interval;
   gint64 predicted_presentation_time;
 
+  gint64 cycle_start_time;
   gint64 layout_start_time;
   gint64 paint_start_time;
   gint64 frame_end_time;
@@ -23,6 +23,20 @@
 
 #include "gdkcolorstateprivate.h"
 #include "gdkmemoryformatprivate.h"
+#include "gdkmemorytexturebuilderprivate.h"
+
+#include <errno.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef G_OS_WIN32
+#include <io.h>
+#endif
+#ifdef HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 /**
  * GdkMemoryTexture:
@@ -36,6 +50,15 @@ struct _GdkMemoryTexture
 
   GBytes *bytes;
   gsize stride;
+
+  /* Set if bytes is a file mapping we made, owned by bytes */
+  GdkMemoryMapping *mapping;
+};
+
+struct _GdkMemoryMapping
+{
+  gpointer start;
+  gsize size;
 };
 
 struct _GdkMemoryTextureClass
@@ -91,6 +114,137 @@ gdk_memory_texture_init (GdkMemoryTexture *self)
 {
 }
 
+static void
+gdk_memory_mapping_free (gpointer data)
+{
+  GdkMemoryMapping *mapping = data;
+
+#ifdef HAVE_MMAP
+  munmap (mapping->start, mapping->size);
+#else
+  g_free (mapping->start);
+#endif
+  g_free (mapping);
+}
+
+/* Maps the whole file, so the builder can check offsets against its
+ * size and the caller can close the fd right away.
+ */
+GBytes *
+gdk_memory_texture_map_fd (int                fd,
+                           GdkMemoryMapping **out_mapping,
+                           GError           **error)
+{
+  GdkMemoryMapping *mapping;
+#ifdef HAVE_MMAP
+  struct stat st;
+#ifdef F_GET_SEALS
+  int seals;
+#endif
+
+  if (fstat (fd, &st) < 0)
+    {
+      int saved_errno = errno;
+      g_set_error_literal (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                           g_strerror (saved_errno));
+      return NULL;
+    }
+
+  /* Pipes and sockets can't be mapped, and mapping past the end
+   * of a file crashes on access, so catch both early.
+   */
+  if (!S_ISREG (st.st_mode))
+    {
+      g_set_error_literal (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                           "Not a regular file");
+      return NULL;
+    }
+  if (st.st_size == 0)
+    {
+      g_set_error_literal (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                           "File is empty");
+      return NULL;
+    }
+
+#ifdef F_GET_SEALS
+  /* A memfd that can still be sealed can also still be truncated or
+   * written to behind our back, so insist on the seals. Files without
+   * sealing support fail this with EINVAL, or report F_SEAL_SEAL.
+   */
+  seals = fcntl (fd, F_GET_SEALS);
+  if (seals >= 0 && !(seals & F_SEAL_SEAL) &&
+      (seals & (F_SEAL_SHRINK | F_SEAL_WRITE)) != (F_SEAL_SHRINK | F_SEAL_WRITE))
+    {
+      g_set_error_literal (error, G_FILE_ERROR, G_FILE_ERROR_PERM,
+                           "Memfd is not sealed against shrinking and writing");
+      return NULL;
+    }
+#endif
+
+  mapping = g_new (GdkMemoryMapping, 1);
+  mapping->size = st.st_size;
+  /* Private and read-only, so the kernel can always drop the
+   * pages and read them from the file again.
+   */
+  mapping->start = mmap (NULL, mapping->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapping->start == MAP_FAILED)
+    {
+      int saved_errno = errno;
+      g_set_error_literal (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                           g_strerror (saved_errno));
+      g_free (mapping);
+      return NULL;
+    }
+#else
+  GByteArray *array;
+  guchar buffer[4096];
+  gssize n_read;
+
+  if (lseek (fd, 0, SEEK_SET) < 0)
+    {
+      int saved_errno = errno;
+      g_set_error_literal (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                           g_strerror (saved_errno));
+      return NULL;
+    }
+
+  array = g_byte_array_new ();
+  while ((n_read = read (fd, buffer, sizeof (buffer))) != 0)
+    {
+      if (n_read < 0)
+        {
+          int saved_errno = errno;
+          if (saved_errno == EINTR)
+            continue;
+          g_set_error_literal (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno),
+                               g_strerror (saved_errno));
+          g_byte_array_unref (array);
+          return NULL;
+        }
+      g_byte_array_append (array, buffer, n_read);
+    }
+
+  if (array->len == 0)
+    {
+      g_set_error_literal (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                           "File is empty");
+      g_byte_array_unref (array);
+      return NULL;
+    }
+
+  mapping = g_new (GdkMemoryMapping, 1);
+  mapping->size = array->len;
+  mapping->start = g_byte_array_free (array, FALSE);
+#endif
+
+  *out_mapping = mapping;
+
+  return g_bytes_new_with_free_func (mapping->start,
+                                     mapping->size,
+                                     gdk_memory_mapping_free,
+                                     mapping);
+}
+
 static GBytes *
 gdk_memory_sanitize (GBytes          *bytes,
                      int              width,
@@ -133,6 +287,10 @@ gdk_memory_texture_new_from_builder (GdkMemoryTextureBuilder *builder)
 {
   GdkMemoryTexture *self;
   GdkTexture *texture, *update_texture;
+  GdkMemoryMapping *mapping;
+  GBytes *bytes;
+
+  bytes = gdk_memory_texture_builder_get_data (builder, &mapping);
 
   self = g_object_new (GDK_TYPE_MEMORY_TEXTURE,
                        "width", gdk_memory_texture_builder_get_width (builder),
@@ -142,12 +300,16 @@ gdk_memory_texture_new_from_builder (GdkMemoryTextureBuilder *builder)
   texture = GDK_TEXTURE (self);
 
   texture->format = gdk_memory_texture_builder_get_format (builder);
-  self->bytes = gdk_memory_sanitize (g_bytes_ref (gdk_memory_texture_builder_get_bytes (builder)),
+  self->bytes = gdk_memory_sanitize (g_bytes_ref (bytes),
                                      texture->width,
                                      texture->height,
                                      texture->format,
                                      gdk_memory_texture_builder_get_stride (builder),
                                      &self->stride);
+  /* If the mapping was misaligned, we now have a copy */
+  if (self->bytes == bytes)
+    self->mapping = mapping;
+  g_bytes_unref (bytes);
 
   update_texture = gdk_memory_texture_builder_get_update_texture (builder);
   if (update_texture)
@@ -274,6 +436,19 @@ gdk_memory_texture_from_texture (GdkTexture *texture)
   return GDK_MEMORY_TEXTURE (result);
 }
 
+/* Called after the pixels have been uploaded to the GPU. If the
+ * texture maps a file, let the kernel drop the pages now instead of
+ * under memory pressure. They are read again if we need them.
+ */
+void
+gdk_memory_texture_release_pages (GdkMemoryTexture *self)
+{
+#if defined (HAVE_MMAP) && defined (HAVE_MADVISE)
+  if (self->mapping)
+    madvise (self->mapping->start, self->mapping->size, MADV_DONTNEED);
+#endif
+}
+
 GBytes *
 gdk_memory_texture_get_bytes (GdkMemoryTexture *self,
                               gsize            *out_stride)
@@ -19,11 +19,10 @@
 
 #include "config.h"
 
-#include "gdkmemorytexturebuilder.h"
+#include "gdkmemorytexturebuilderprivate.h"
 
 #include "gdkcolorstate.h"
 #include "gdkenumtypes.h"
-#include "gdkmemorytextureprivate.h"
 
 #include <cairo-gobject.h>
 
@@ -32,6 +31,10 @@ struct _GdkMemoryTextureBuilder
   GObject parent_instance;
 
   GBytes *bytes;
+  gsize offset;
+  /* the whole file set with set_fd(), mapped into memory */
+  GBytes *fd_bytes;
+  GdkMemoryMapping *mapping;
   gsize stride;
   int width;
   int height;
@@ -59,6 +62,10 @@ struct _GdkMemoryTextureBuilderClass
  * and [property@Gdk.MemoryTextureBuilder:height] are mandatory - and then call
  * [method@Gdk.MemoryTextureBuilder.build] to create the new texture.
  *
+ * Instead of bytes, the data can be given as a file descriptor with
+ * [method@Gdk.MemoryTextureBuilder.set_fd]. The texture then maps the file
+ * instead of copying it, so the kernel can page the pixel data in and out.
+ *
  * `GdkMemoryTextureBuilder` can be used for quick one-shot construction of
  * textures as well as kept around and reused to construct multiple textures.
  *
@@ -72,6 +79,7 @@ enum
   PROP_COLOR_STATE,
   PROP_FORMAT,
   PROP_HEIGHT,
+  PROP_OFFSET,
   PROP_STRIDE,
   PROP_UPDATE_REGION,
   PROP_UPDATE_TEXTURE,
@@ -90,6 +98,7 @@ gdk_memory_texture_builder_dispose (GObject *object)
   GdkMemoryTextureBuilder *self = GDK_MEMORY_TEXTURE_BUILDER (object);
 
   g_clear_pointer (&self->bytes, g_bytes_unref);
+  g_clear_pointer (&self->fd_bytes, g_bytes_unref);
   g_clear_pointer (&self->color_state, gdk_color_state_unref);
 
   g_clear_object (&self->update_texture);
@@ -124,6 +133,10 @@ gdk_memory_texture_builder_get_property (GObject    *object,
       g_value_set_int (value, self->height);
       break;
 
+    case PROP_OFFSET:
+      g_value_set_uint64 (value, self->offset);
+      break;
+
     case PROP_STRIDE:
       g_value_set_uint64 (value, self->stride);
       break;
@@ -252,6 +265,19 @@ gdk_memory_texture_builder_class_init (GdkMemoryTextureBuilderClass *klass)
                       G_MININT, G_MAXINT, 0,
                       G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GdkMemoryTextureBuilder:offset:
+   *
+   * The offset of the data in the file set with
+   * [method@Gdk.MemoryTextureBuilder.set_fd].
+   *
+   * Since: 4.18
+   */
+  properties[PROP_OFFSET] =
+    g_param_spec_uint64 ("offset", NULL, NULL,
+                         0, G_MAXUINT64, 0,
+                         G_PARAM_READABLE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
   /**
    * GdkMemoryTextureBuilder:stride:
    *
@@ -354,7 +380,8 @@ gdk_memory_texture_builder_get_bytes (GdkMemoryTextureBuilder *self)
  *
  * Sets the data to be shown but the texture.
  *
- * The bytes must be set before calling [method@Gdk.MemoryTextureBuilder.build].
+ * The bytes must be set before calling [method@Gdk.MemoryTextureBuilder.build],
+ * unless a file descriptor was set with [method@Gdk.MemoryTextureBuilder.set_fd].
  *
  * Since: 4.16
  */
@@ -376,6 +403,116 @@ gdk_memory_texture_builder_set_bytes (GdkMemoryTextureBuilder *self,
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_BYTES]);
 }
 
+/**
+ * gdk_memory_texture_builder_get_offset:
+ * @self: a `GdkMemoryTextureBuilder`
+ *
+ * Gets the offset previously set via gdk_memory_texture_builder_set_fd().
+ *
+ * Returns: the offset
+ *
+ * Since: 4.18
+ */
+gsize
+gdk_memory_texture_builder_get_offset (GdkMemoryTextureBuilder *self)
+{
+  g_return_val_if_fail (GDK_IS_MEMORY_TEXTURE_BUILDER (self), 0);
+
+  return self->offset;
+}
+
+/**
+ * gdk_memory_texture_builder_set_fd:
+ * @self: a `GdkMemoryTextureBuilder`
+ * @fd: a file descriptor, or -1 to unset
+ * @offset: the offset of the first pixel in the file
+ * @error: return location for an error
+ *
+ * Sets a file or memfd to take the data from, instead of bytes.
+ *
+ * When a file descriptor is set, it takes precedence over
+ * [property@Gdk.MemoryTextureBuilder:bytes]. The file is mapped into
+ * memory by this function, and the kernel is free to page it out again
+ * after the texture has been uploaded to the GPU. This keeps the memory
+ * use of applications with many large images low.
+ *
+ * The builder doesn't keep @fd, it can be closed once this function
+ * returns. The file stays mapped while the builder or any texture
+ * built from it exists, and the contents must not change during that
+ * time: writes to the file show up in the textures, and truncating it
+ * crashes the application with SIGBUS when the pixels are accessed.
+ * Memfds that allow sealing must therefore be sealed with
+ * `F_SEAL_SHRINK` and `F_SEAL_WRITE`, otherwise this function fails.
+ * For other files, the caller has to make sure of it.
+ *
+ * For best results, @offset and the stride should be multiples of
+ * the alignment of the format, otherwise the data is copied.
+ *
+ * If the file can't be mapped or @offset is past its end, @error
+ * is set and the builder is left unchanged.
+ *
+ * Returns: %TRUE if the file descriptor was set
+ *
+ * Since: 4.18
+ */
+gboolean
+gdk_memory_texture_builder_set_fd (GdkMemoryTextureBuilder  *self,
+                                   int                       fd,
+                                   gsize                     offset,
+                                   GError                  **error)
+{
+  GdkMemoryMapping *mapping = NULL;
+  GBytes *fd_bytes = NULL;
+
+  g_return_val_if_fail (GDK_IS_MEMORY_TEXTURE_BUILDER (self), FALSE);
+  g_return_val_if_fail (fd >= -1, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (fd != -1)
+    {
+      fd_bytes = gdk_memory_texture_map_fd (fd, &mapping, error);
+      if (fd_bytes == NULL)
+        return FALSE;
+
+      if (offset >= g_bytes_get_size (fd_bytes))
+        {
+          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                       "Offset %" G_GSIZE_FORMAT " is past the end of the file (%" G_GSIZE_FORMAT " bytes)",
+                       offset, g_bytes_get_size (fd_bytes));
+          g_bytes_unref (fd_bytes);
+          return FALSE;
+        }
+    }
+
+  g_clear_pointer (&self->fd_bytes, g_bytes_unref);
+  self->fd_bytes = fd_bytes;
+  self->mapping = mapping;
+
+  if (self->offset != offset)
+    {
+      self->offset = offset;
+      g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_OFFSET]);
+    }
+
+  return TRUE;
+}
+
+GBytes *
+gdk_memory_texture_builder_get_data (GdkMemoryTextureBuilder  *self,
+                                     GdkMemoryMapping        **out_mapping)
+{
+  if (self->fd_bytes)
+    {
+      *out_mapping = self->mapping;
+      return g_bytes_new_from_bytes (self->fd_bytes,
+                                     self->offset,
+                                     g_bytes_get_size (self->fd_bytes) - self->offset);
+    }
+
+  *out_mapping = NULL;
+  return g_bytes_ref (self->bytes);
+}
+
 /**
  * gdk_memory_texture_builder_get_color_state:
  * @self: a `GdkMemoryTextureBuilder`
@@ -718,10 +855,11 @@ gdk_memory_texture_builder_build (GdkMemoryTextureBuilder *self)
   g_return_val_if_fail (GDK_IS_MEMORY_TEXTURE_BUILDER (self), NULL);
   g_return_val_if_fail (self->width > 0, NULL);
   g_return_val_if_fail (self->height > 0, NULL);
-  g_return_val_if_fail (self->bytes != NULL, NULL);
+  g_return_val_if_fail (self->bytes != NULL || self->fd_bytes != NULL, NULL);
   g_return_val_if_fail (self->stride >= self->width * gdk_memory_format_bytes_per_pixel (self->format), NULL);
   /* needs to be this complex to support subtexture of the bottom right part */
-  g_return_val_if_fail (g_bytes_get_size (self->bytes) >= gdk_memory_format_min_buffer_size (self->format, self->stride, self->width, self->height), NULL);
+  g_return_val_if_fail (self->fd_bytes == NULL || g_bytes_get_size (self->fd_bytes) - self->offset >= gdk_memory_format_min_buffer_size (self->format, self->stride, self->width, self->height), NULL);
+  g_return_val_if_fail (self->fd_bytes != NULL || g_bytes_get_size (self->bytes) >= gdk_memory_format_min_buffer_size (self->format, self->stride, self->width, self->height), NULL);
 
   return gdk_memory_texture_new_from_builder (self);
 }
@@ -40,6 +40,14 @@ GDK_AVAILABLE_IN_4_16
 void                            gdk_memory_texture_builder_set_bytes            (GdkMemoryTextureBuilder        *self,
                                                                                  GBytes                         *bytes);
 
+GDK_AVAILABLE_IN_4_18
+gsize                           gdk_memory_texture_builder_get_offset           (GdkMemoryTextureBuilder        *self) G_GNUC_PURE;
+GDK_AVAILABLE_IN_4_18
+gboolean                        gdk_memory_texture_builder_set_fd               (GdkMemoryTextureBuilder        *self,
+                                                                                 int                             fd,
+                                                                                 gsize                           offset,
+                                                                                 GError                        **error);
+
 GDK_AVAILABLE_IN_4_16
 gsize                           gdk_memory_texture_builder_get_stride           (GdkMemoryTextureBuilder        *self) G_GNUC_PURE;
 GDK_AVAILABLE_IN_4_16
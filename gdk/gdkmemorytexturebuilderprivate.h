@@ -0,0 +1,11 @@
+#pragma once
+
+#include "gdkmemorytexturebuilder.h"
+#include "gdkmemorytextureprivate.h"
+
+G_BEGIN_DECLS
+
+GBytes *                gdk_memory_texture_builder_get_data     (GdkMemoryTextureBuilder *self,
+                                                                 GdkMemoryMapping       **out_mapping);
+
+G_END_DECLS
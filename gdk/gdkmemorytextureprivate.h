@@ -29,6 +29,8 @@ G_BEGIN_DECLS
 #define GDK_MEMORY_GDK_PIXBUF_OPAQUE GDK_MEMORY_R8G8B8
 #define GDK_MEMORY_GDK_PIXBUF_ALPHA GDK_MEMORY_R8G8B8A8
 
+typedef struct _GdkMemoryMapping GdkMemoryMapping;
+
 GdkMemoryTexture *      gdk_memory_texture_from_texture     (GdkTexture        *texture);
 GdkTexture *            gdk_memory_texture_new_subtexture   (GdkMemoryTexture  *texture,
                                                              int                x,
@@ -40,6 +42,11 @@ GdkTexture *            gdk_memory_texture_new_from_builder (GdkMemoryTextureBui
 
 GBytes *                gdk_memory_texture_get_bytes        (GdkMemoryTexture  *self,
                                                              gsize             *out_stride);
+void                    gdk_memory_texture_release_pages    (GdkMemoryTexture  *self);
+
+GBytes *                gdk_memory_texture_map_fd           (int                fd,
+                                                             GdkMemoryMapping **out_mapping,
+                                                             GError           **error);
 
 
 G_END_DECLS
@@ -2346,6 +2346,7 @@ _gdk_windowing_got_event (GdkDisplay *display,
    */
   _gdk_event_queue_handle_motion_compression (display);
   gdk_event_queue_handle_scroll_compression (display);
+  gdk_event_queue_handle_touch_compression (display);
 
   if (event_surface)
     {
@@ -2608,6 +2609,56 @@ gdk_surface_get_frame_clock (GdkSurface *surface)
   return surface->frame_clock;
 }
 
+/**
+ * gdk_surface_set_event_compression:
+ * @surface: a `GdkSurface`
+ * @event_compression: %TRUE to merge motion events per frame
+ *
+ * Determines whether motion, smooth scroll and touch update events
+ * for @surface are merged into one event per frame.
+ *
+ * When events are merged, the positions of the dropped events are
+ * available from [method@Gdk.Event.get_history] of the delivered
+ * event, so applications that need every sample, like drawing
+ * programs, can keep compression on.
+ *
+ * Turning compression off delivers each event as soon as it arrives.
+ * This costs more processing per frame and is rarely needed.
+ *
+ * Event compression is enabled by default.
+ *
+ * Since: 4.18
+ */
+void
+gdk_surface_set_event_compression (GdkSurface *surface,
+                                   gboolean    event_compression)
+{
+  g_return_if_fail (GDK_IS_SURFACE (surface));
+
+  surface->no_event_compression = !event_compression;
+}
+
+/**
+ * gdk_surface_get_event_compression:
+ * @surface: a `GdkSurface`
+ *
+ * Returns whether events for @surface are merged into one
+ * event per frame.
+ *
+ * See [method@Gdk.Surface.set_event_compression].
+ *
+ * Returns: %TRUE if event compression is enabled
+ *
+ * Since: 4.18
+ */
+gboolean
+gdk_surface_get_event_compression (GdkSurface *surface)
+{
+  g_return_val_if_fail (GDK_IS_SURFACE (surface), TRUE);
+
+  return !surface->no_event_compression;
+}
+
 /**
  * gdk_surface_get_scale_factor:
  * @surface: surface to get scale factor for
@@ -125,6 +125,12 @@ void       gdk_surface_request_layout     (GdkSurface       *surface);
 GDK_AVAILABLE_IN_ALL
 GdkFrameClock* gdk_surface_get_frame_clock      (GdkSurface     *surface);
 
+GDK_AVAILABLE_IN_4_18
+void       gdk_surface_set_event_compression    (GdkSurface     *surface,
+                                                 gboolean        event_compression);
+GDK_AVAILABLE_IN_4_18
+gboolean   gdk_surface_get_event_compression    (GdkSurface     *surface);
+
 GDK_DEPRECATED_IN_4_16
 void       gdk_surface_set_opaque_region        (GdkSurface      *surface,
                                                  cairo_region_t *region);
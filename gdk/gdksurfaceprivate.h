@@ -72,6 +72,7 @@ struct _GdkSurface
   guint request_motion : 1;
   guint has_pointer : 1;
   guint is_srgb : 1;
+  guint no_event_compression : 1;
 
   guint request_motion_id;
 
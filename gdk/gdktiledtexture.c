@@ -0,0 +1,356 @@
+/*
+ * Copyright © 2025 GTK Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdktiledtextureprivate.h"
+
+#include "gdkcolorstateprivate.h"
+#include "gdkmemoryformatprivate.h"
+#include "gdkmemorytextureprivate.h"
+
+#include <string.h>
+
+/**
+ * GdkTiledTexture:
+ *
+ * A `GdkTexture` for images that are too large to keep in memory.
+ *
+ * Instead of holding the pixels, a tiled texture asks a
+ * [callback@Gdk.TiledTextureLoadFunc] for the parts it needs.
+ * Next to the full resolution image, the callback can provide smaller
+ * versions of it, the levels of detail. Level 1 is half the size of
+ * the image, level 2 a quarter, and so on.
+ *
+ * When drawing the texture, the GPU renderers only load the tiles that
+ * are visible, from the smallest level that still has enough detail
+ * for the current scale. This makes it possible to show images of
+ * gigapixel size, like maps or microscopy scans.
+ *
+ * If the tiles come from a file, they can be created with
+ * [method@Gdk.MemoryTextureBuilder.set_fd] to avoid copying them.
+ *
+ * The cairo and GL renderers can't draw parts of a texture, so they
+ * draw a smaller level of the image that fits into 4096x4096 pixels.
+ * [method@Gdk.Texture.download] loads the full resolution image piece
+ * by piece into the memory it is given.
+ *
+ * Since: 4.18
+ */
+
+struct _GdkTiledTexture
+{
+  GdkTexture parent_instance;
+
+  guint n_levels;
+
+  GdkTiledTextureLoadFunc load_func;
+  gpointer user_data;
+  GDestroyNotify destroy;
+
+  GMutex preview_lock;
+  GdkTexture *preview;
+  gboolean preview_failed;
+};
+
+struct _GdkTiledTextureClass
+{
+  GdkTextureClass parent_class;
+};
+
+/* The size of the pieces we load when downloading the whole image */
+#define DOWNLOAD_CHUNK_SIZE 1024
+
+/* The largest image we load for users that can't draw tiles */
+#define PREVIEW_MAX_SIZE 4096
+
+G_DEFINE_TYPE (GdkTiledTexture, gdk_tiled_texture, GDK_TYPE_TEXTURE)
+
+static void
+gdk_tiled_texture_dispose (GObject *object)
+{
+  GdkTiledTexture *self = GDK_TILED_TEXTURE (object);
+
+  if (self->destroy)
+    {
+      self->destroy (self->user_data);
+      self->destroy = NULL;
+      self->user_data = NULL;
+    }
+
+  g_clear_object (&self->preview);
+
+  G_OBJECT_CLASS (gdk_tiled_texture_parent_class)->dispose (object);
+}
+
+static void
+gdk_tiled_texture_finalize (GObject *object)
+{
+  GdkTiledTexture *self = GDK_TILED_TEXTURE (object);
+
+  g_mutex_clear (&self->preview_lock);
+
+  G_OBJECT_CLASS (gdk_tiled_texture_parent_class)->finalize (object);
+}
+
+static inline int
+gdk_tiled_texture_level_size (int   size,
+                              guint level)
+{
+  return (size + (1 << level) - 1) >> level;
+}
+
+static void
+gdk_tiled_texture_download_level (GdkTiledTexture *self,
+                                  guint            level,
+                                  GdkMemoryFormat  format,
+                                  GdkColorState   *color_state,
+                                  guchar          *data,
+                                  gsize            stride)
+{
+  GdkTexture *texture = GDK_TEXTURE (self);
+  gsize bpp = gdk_memory_format_bytes_per_pixel (format);
+  int width, height, x, y, row;
+
+  width = gdk_tiled_texture_level_size (texture->width, level);
+  height = gdk_tiled_texture_level_size (texture->height, level);
+
+  for (y = 0; y < height; y += DOWNLOAD_CHUNK_SIZE)
+    {
+      for (x = 0; x < width; x += DOWNLOAD_CHUNK_SIZE)
+        {
+          GdkRectangle area = {
+            x, y,
+            MIN (DOWNLOAD_CHUNK_SIZE, width - x),
+            MIN (DOWNLOAD_CHUNK_SIZE, height - y)
+          };
+          guchar *dest = data + y * stride + x * bpp;
+          GdkTexture *tile;
+
+          tile = gdk_tiled_texture_load (self, level, &area);
+          if (tile == NULL)
+            {
+              for (row = 0; row < area.height; row++)
+                memset (dest + row * stride, 0, area.width * bpp);
+              continue;
+            }
+
+          gdk_texture_do_download (tile, format, color_state, dest, stride);
+          g_object_unref (tile);
+        }
+    }
+}
+
+static void
+gdk_tiled_texture_download (GdkTexture      *texture,
+                            GdkMemoryFormat  format,
+                            GdkColorState   *color_state,
+                            guchar          *data,
+                            gsize            stride)
+{
+  gdk_tiled_texture_download_level (GDK_TILED_TEXTURE (texture), 0, format, color_state, data, stride);
+}
+
+static void
+gdk_tiled_texture_class_init (GdkTiledTextureClass *klass)
+{
+  GdkTextureClass *texture_class = GDK_TEXTURE_CLASS (klass);
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  texture_class->download = gdk_tiled_texture_download;
+
+  gobject_class->dispose = gdk_tiled_texture_dispose;
+  gobject_class->finalize = gdk_tiled_texture_finalize;
+}
+
+static void
+gdk_tiled_texture_init (GdkTiledTexture *self)
+{
+  g_mutex_init (&self->preview_lock);
+}
+
+/**
+ * gdk_tiled_texture_new:
+ * @width: the width of the full resolution image
+ * @height: the height of the full resolution image
+ * @format: the format of the image
+ * @n_levels: the number of levels of detail @load_func provides, at least 1
+ * @load_func: (scope notified) (closure user_data) (destroy destroy): the function
+ *   to load parts of the image
+ * @user_data: data for @load_func
+ * @destroy: destroy notify for @user_data
+ *
+ * Creates a new texture that loads its pixels on demand.
+ *
+ * @load_func is called with levels from 0 to @n_levels - 1, where level
+ * N is the image scaled down by 2^N, rounding up. When drawing at an even
+ * smaller scale, the pixels of the last level are scaled down further.
+ *
+ * @load_func is called from the thread that draws or downloads the texture.
+ *
+ * The @format is used to pick the precision for rendering and as the
+ * default for downloading. The tiles can use different formats.
+ *
+ * Returns: (transfer full) (type GdkTiledTexture): A newly-created `GdkTexture`
+ *
+ * Since: 4.18
+ */
+GdkTexture *
+gdk_tiled_texture_new (int                      width,
+                       int                      height,
+                       GdkMemoryFormat          format,
+                       guint                    n_levels,
+                       GdkTiledTextureLoadFunc  load_func,
+                       gpointer                 user_data,
+                       GDestroyNotify           destroy)
+{
+  GdkTiledTexture *self;
+
+  g_return_val_if_fail (width > 0, NULL);
+  g_return_val_if_fail (height > 0, NULL);
+  g_return_val_if_fail (format < GDK_MEMORY_N_FORMATS, NULL);
+  g_return_val_if_fail (n_levels > 0, NULL);
+  g_return_val_if_fail (load_func != NULL, NULL);
+
+  self = g_object_new (GDK_TYPE_TILED_TEXTURE,
+                       "width", width,
+                       "height", height,
+                       "color-state", GDK_COLOR_STATE_SRGB,
+                       NULL);
+
+  GDK_TEXTURE (self)->format = format;
+  self->n_levels = n_levels;
+  self->load_func = load_func;
+  self->user_data = user_data;
+  self->destroy = destroy;
+
+  return GDK_TEXTURE (self);
+}
+
+/**
+ * gdk_tiled_texture_get_n_levels:
+ * @self: a `GdkTiledTexture`
+ *
+ * Gets the number of levels of detail the texture provides.
+ *
+ * Returns: the number of levels
+ *
+ * Since: 4.18
+ */
+guint
+gdk_tiled_texture_get_n_levels (GdkTiledTexture *self)
+{
+  g_return_val_if_fail (GDK_IS_TILED_TEXTURE (self), 0);
+
+  return self->n_levels;
+}
+
+/*
+ * gdk_tiled_texture_load:
+ * @self: a `GdkTiledTexture`
+ * @level: the level of detail
+ * @area: the area to load, in the coordinates of @level
+ *
+ * Calls the load function and checks what it returns.
+ *
+ * Returns: (transfer full) (nullable): the pixels of @area
+ */
+GdkTexture *
+gdk_tiled_texture_load (GdkTiledTexture    *self,
+                        guint               level,
+                        const GdkRectangle *area)
+{
+  GdkTexture *tile;
+
+  g_return_val_if_fail (level < self->n_levels, NULL);
+
+  tile = self->load_func (self, level, area, self->user_data);
+  if (tile == NULL)
+    return NULL;
+
+  if (gdk_texture_get_width (tile) != area->width ||
+      gdk_texture_get_height (tile) != area->height)
+    {
+      g_warning ("Tile for %dx%d area at level %u is %dx%d",
+                 area->width, area->height, level,
+                 gdk_texture_get_width (tile), gdk_texture_get_height (tile));
+      g_object_unref (tile);
+      return NULL;
+    }
+
+  return tile;
+}
+
+/*
+ * gdk_tiled_texture_get_preview:
+ * @self: a `GdkTiledTexture`
+ *
+ * Gets the texture for renderers that can't draw tiles.
+ *
+ * This is the largest level of detail that fits into 4096x4096
+ * pixels. It is loaded on first use and kept until @self is
+ * disposed, so callers can cache things for it.
+ *
+ * If even the last level is larger than that, a warning is
+ * printed and %NULL is returned.
+ *
+ * Returns: (transfer none) (nullable): the preview texture
+ */
+GdkTexture *
+gdk_tiled_texture_get_preview (GdkTiledTexture *self)
+{
+  GdkTexture *texture = GDK_TEXTURE (self);
+  GBytes *bytes;
+  guchar *data;
+  gsize stride;
+  int width, height;
+  guint level;
+
+  g_mutex_lock (&self->preview_lock);
+
+  if (self->preview || self->preview_failed)
+    goto out;
+
+  for (level = 0; level < self->n_levels; level++)
+    {
+      width = gdk_tiled_texture_level_size (texture->width, level);
+      height = gdk_tiled_texture_level_size (texture->height, level);
+      if (width <= PREVIEW_MAX_SIZE && height <= PREVIEW_MAX_SIZE)
+        break;
+    }
+
+  if (level == self->n_levels)
+    {
+      g_warning ("Tiled texture of %dx%d pixels has no level of detail below %dx%d, "
+                 "it can only be drawn by the GPU renderers",
+                 texture->width, texture->height, PREVIEW_MAX_SIZE, PREVIEW_MAX_SIZE);
+      self->preview_failed = TRUE;
+      goto out;
+    }
+
+  stride = width * gdk_memory_format_bytes_per_pixel (texture->format);
+  data = g_malloc (stride * height);
+  gdk_tiled_texture_download_level (self, level, texture->format, texture->color_state, data, stride);
+  bytes = g_bytes_new_take (data, stride * height);
+  self->preview = gdk_memory_texture_new (width, height, texture->format, bytes, stride);
+  g_bytes_unref (bytes);
+
+out:
+  g_mutex_unlock (&self->preview_lock);
+
+  return self->preview;
+}
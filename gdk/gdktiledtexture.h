@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2025 GTK Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#if !defined (__GDK_H_INSIDE__) && !defined (GTK_COMPILATION)
+#error "Only <gdk/gdk.h> can be included directly."
+#endif
+
+#include <gdk/gdktypes.h>
+#include <gdk/gdktexture.h>
+
+G_BEGIN_DECLS
+
+#define GDK_TYPE_TILED_TEXTURE (gdk_tiled_texture_get_type ())
+
+#define GDK_TILED_TEXTURE(obj)              (G_TYPE_CHECK_INSTANCE_CAST ((obj), GDK_TYPE_TILED_TEXTURE, GdkTiledTexture))
+#define GDK_IS_TILED_TEXTURE(obj)           (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GDK_TYPE_TILED_TEXTURE))
+
+typedef struct _GdkTiledTexture         GdkTiledTexture;
+typedef struct _GdkTiledTextureClass    GdkTiledTextureClass;
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(GdkTiledTexture, g_object_unref)
+
+/**
+ * GdkTiledTextureLoadFunc:
+ * @self: the texture
+ * @level: the level of detail, 0 is the full image, 1 is half its size, and so on
+ * @area: the area to load, in the coordinates of @level
+ * @user_data: the user data passed to gdk_tiled_texture_new()
+ *
+ * The type of the function used by [class@Gdk.TiledTexture] to load
+ * a part of the image.
+ *
+ * The returned texture must have the size of @area.
+ *
+ * Returns: (transfer full) (nullable): a texture with the pixels of
+ *   @area, or %NULL if they can't be loaded
+ *
+ * Since: 4.18
+ */
+typedef GdkTexture * (* GdkTiledTextureLoadFunc) (GdkTiledTexture    *self,
+                                                  guint               level,
+                                                  const GdkRectangle *area,
+                                                  gpointer            user_data);
+
+GDK_AVAILABLE_IN_4_18
+GType                   gdk_tiled_texture_get_type          (void) G_GNUC_CONST;
+
+GDK_AVAILABLE_IN_4_18
+GdkTexture *            gdk_tiled_texture_new               (int                      width,
+                                                             int                      height,
+                                                             GdkMemoryFormat          format,
+                                                             guint                    n_levels,
+                                                             GdkTiledTextureLoadFunc  load_func,
+                                                             gpointer                 user_data,
+                                                             GDestroyNotify           destroy);
+
+GDK_AVAILABLE_IN_4_18
+guint                   gdk_tiled_texture_get_n_levels      (GdkTiledTexture         *self);
+
+G_END_DECLS
+
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "gdktiledtexture.h"
+
+#include "gdktextureprivate.h"
+
+G_BEGIN_DECLS
+
+GdkTexture *            gdk_tiled_texture_load              (GdkTiledTexture    *self,
+                                                             guint               level,
+                                                             const GdkRectangle *area);
+GdkTexture *            gdk_tiled_texture_get_preview       (GdkTiledTexture    *self);
+
+G_END_DECLS
+
@@ -20,9 +20,13 @@
 #include "gdkprivate-wayland.h"
 
 #include "gdkeventsprivate.h"
+#include "gdkprofilerprivate.h"
 
+#include <glib-unix.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 
 typedef struct _GdkWaylandEventSource GdkWaylandEventSource;
 typedef struct _GdkWaylandPollSource GdkWaylandPollSource;
@@ -40,6 +44,16 @@ struct _GdkWaylandPollSource
   GdkWaylandDisplay *display;
   guint reading : 1;
   guint can_dispatch : 1;
+
+  /* With GDK_DEBUG=reader-thread, a thread reads the socket into the
+   * event queues and wakes us up, and we only dispatch.
+   */
+  GThread *reader_thread;
+  struct wl_event_queue *reader_queue;
+  int reader_wakeup[2];
+  int reader_error;
+  GMutex reader_lock;
+  gint64 first_read_time;   /* protected by reader_lock */
 };
 
 /* If we should try wl_display_dispatch_pending() before
@@ -112,6 +126,57 @@ static GSourceFuncs gdk_wayland_event_source_funcs = {
   gdk_wayland_event_source_finalize
 };
 
+static gboolean
+gdk_wayland_display_queues_pending (GdkWaylandDisplay *display)
+{
+  GList *l;
+
+  /* prepare_read() fails if there are events waiting in the queue */
+  if (wl_display_prepare_read (display->wl_display) != 0)
+    return TRUE;
+  wl_display_cancel_read (display->wl_display);
+
+  for (l = display->event_queues; l; l = l->next)
+    {
+      struct wl_event_queue *queue = l->data;
+
+      if (wl_display_prepare_read_queue (display->wl_display, queue) != 0)
+        return TRUE;
+      wl_display_cancel_read (display->wl_display);
+    }
+
+  return FALSE;
+}
+
+/* The reader thread does the reading, so we must not hold a read
+ * across the poll, it would block the reader until we wake up.
+ */
+static gboolean
+gdk_wayland_poll_source_prepare_threaded (GdkWaylandPollSource *source)
+{
+  GdkWaylandDisplay *display = source->display;
+
+  if (g_atomic_int_get (&source->reader_error))
+    {
+      g_message ("Lost connection to Wayland compositor.");
+      _exit (1);
+    }
+
+  if (wl_display_flush (display->wl_display) < 0)
+    {
+      g_message ("Error flushing display: %s", g_strerror (errno));
+      _exit (1);
+    }
+
+  if (gdk_wayland_display_queues_pending (display))
+    {
+      source->can_dispatch = TRUE;
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
 static gboolean
 gdk_wayland_poll_source_prepare (GSource *base,
                                  int     *timeout)
@@ -131,6 +196,9 @@ gdk_wayland_poll_source_prepare (GSource *base,
   if (source->reading)
     return FALSE;
 
+  if (source->reader_thread)
+    return gdk_wayland_poll_source_prepare_threaded (source);
+
   /* if prepare_read() returns non-zero, there are events to be dispatched */
   if (wl_display_prepare_read (display->wl_display) != 0)
     {
@@ -208,11 +276,15 @@ gdk_wayland_poll_source_dispatch (GSource     *base,
   return G_SOURCE_CONTINUE;
 }
 
+static void gdk_wayland_poll_source_stop_reader_thread (GdkWaylandPollSource *source);
+
 static void
 gdk_wayland_poll_source_finalize (GSource *base)
 {
   GdkWaylandPollSource *source = (GdkWaylandPollSource *) base;
 
+  gdk_wayland_poll_source_stop_reader_thread (source);
+
   if (source->reading)
     wl_display_cancel_read (source->display->wl_display);
   source->reading = FALSE;
@@ -225,6 +297,107 @@ static GSourceFuncs gdk_wayland_poll_source_funcs = {
   gdk_wayland_poll_source_finalize
 };
 
+static gpointer
+gdk_wayland_reader_thread (gpointer data)
+{
+  GdkWaylandPollSource *source = data;
+  struct wl_display *wl_display = source->display->wl_display;
+  struct pollfd fds[2];
+
+  fds[0].fd = wl_display_get_fd (wl_display);
+  fds[0].events = POLLIN;
+  fds[1].fd = source->reader_wakeup[0];
+  fds[1].events = POLLIN;
+
+  while (TRUE)
+    {
+      /* Our queue never has any events, so this succeeds even while
+       * the main thread hasn't dispatched the previous batch yet.
+       */
+      if (wl_display_prepare_read_queue (wl_display, source->reader_queue) != 0)
+        {
+          wl_display_dispatch_queue_pending (wl_display, source->reader_queue);
+          continue;
+        }
+
+      if (poll (fds, G_N_ELEMENTS (fds), -1) < 0)
+        {
+          wl_display_cancel_read (wl_display);
+          if (errno == EINTR)
+            continue;
+          g_atomic_int_set (&source->reader_error, TRUE);
+          break;
+        }
+
+      if (fds[1].revents & POLLIN)
+        {
+          wl_display_cancel_read (wl_display);
+          break;
+        }
+
+      if (fds[0].revents & (POLLERR | POLLHUP))
+        {
+          wl_display_cancel_read (wl_display);
+          g_atomic_int_set (&source->reader_error, TRUE);
+          break;
+        }
+
+      if (wl_display_read_events (wl_display) < 0)
+        {
+          g_atomic_int_set (&source->reader_error, TRUE);
+          break;
+        }
+
+      g_mutex_lock (&source->reader_lock);
+      if (source->first_read_time == 0)
+        source->first_read_time = g_get_monotonic_time ();
+      g_mutex_unlock (&source->reader_lock);
+
+      g_main_context_wakeup (g_source_get_context ((GSource *) source));
+    }
+
+  /* Make sure the main thread notices the error */
+  g_main_context_wakeup (g_source_get_context ((GSource *) source));
+
+  return NULL;
+}
+
+static void
+gdk_wayland_poll_source_start_reader_thread (GdkWaylandPollSource *source)
+{
+  GError *error = NULL;
+
+  if (!g_unix_open_pipe (source->reader_wakeup, O_CLOEXEC, &error))
+    {
+      g_warning ("Failed to start the Wayland reader thread: %s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  g_mutex_init (&source->reader_lock);
+  source->reader_queue = wl_display_create_queue (source->display->wl_display);
+  source->reader_thread = g_thread_new ("GDK Wayland Reader", gdk_wayland_reader_thread, source);
+}
+
+static void
+gdk_wayland_poll_source_stop_reader_thread (GdkWaylandPollSource *source)
+{
+  if (source->reader_thread == NULL)
+    return;
+
+  while (write (source->reader_wakeup[1], "x", 1) < 0 && errno == EINTR)
+    ;
+
+  g_thread_join (source->reader_thread);
+  source->reader_thread = NULL;
+
+  close (source->reader_wakeup[0]);
+  close (source->reader_wakeup[1]);
+  wl_event_queue_destroy (source->reader_queue);
+  source->reader_queue = NULL;
+  g_mutex_clear (&source->reader_lock);
+}
+
 void
 _gdk_wayland_display_deliver_event (GdkDisplay *display,
                                     GdkEvent   *event)
@@ -272,9 +445,16 @@ gdk_wayland_display_install_gsources (GdkWaylandDisplay *display_wayland)
   g_free (name);
 
   poll_source->display = display_wayland;
-  poll_source->pfd.fd = wl_display_get_fd (display_wayland->wl_display);
-  poll_source->pfd.events = G_IO_IN | G_IO_ERR | G_IO_HUP;
-  g_source_add_poll (source, &poll_source->pfd);
+
+  if (GDK_DISPLAY_DEBUG_CHECK (display, READER_THREAD))
+    gdk_wayland_poll_source_start_reader_thread (poll_source);
+
+  if (poll_source->reader_thread == NULL)
+    {
+      poll_source->pfd.fd = wl_display_get_fd (display_wayland->wl_display);
+      poll_source->pfd.events = G_IO_IN | G_IO_ERR | G_IO_HUP;
+      g_source_add_poll (source, &poll_source->pfd);
+    }
 
   /* We must guarantee to ALWAYS be called and called FIRST after
    * every poll - or rather: after every prepare().
@@ -311,6 +491,22 @@ _gdk_wayland_display_queue_events (GdkDisplay *display)
   GdkWaylandPollSource *poll_source;
   GList *l;
 
+  poll_source = (GdkWaylandPollSource *) display_wayland->poll_source;
+
+  if (poll_source->reader_thread)
+    {
+      gint64 read_time;
+
+      g_mutex_lock (&poll_source->reader_lock);
+      read_time = poll_source->first_read_time;
+      poll_source->first_read_time = 0;
+      g_mutex_unlock (&poll_source->reader_lock);
+
+      /* How long the events waited for the main thread */
+      if (read_time != 0)
+        gdk_profiler_end_mark (read_time, "Wayland dispatch delay", NULL);
+    }
+
   if (wl_display_dispatch_pending (display_wayland->wl_display) < 0)
     {
       g_message ("Error %d (%s) dispatching to Wayland display.",
@@ -330,6 +526,5 @@ _gdk_wayland_display_queue_events (GdkDisplay *display)
         }
     }
 
-  poll_source = (GdkWaylandPollSource *) display_wayland->poll_source;
   poll_source->can_dispatch = FALSE;
 }
@@ -57,6 +57,8 @@ typedef struct _ListChildrenState ListChildrenState;
 typedef struct _SendEventState SendEventState;
 typedef struct _SetInputFocusState SetInputFocusState;
 typedef struct _RoundtripState RoundtripState;
+typedef struct _GetPropertyState GetPropertyState;
+typedef struct _TranslateCoordinatesState TranslateCoordinatesState;
 
 typedef enum {
   CHILD_INFO_GET_PROPERTY,
@@ -122,6 +124,35 @@ struct _RoundtripState
   gpointer data;
 };
 
+struct _GetPropertyState
+{
+  Display *dpy;
+  _XAsyncHandler async;
+  gulong get_property_req;
+  GdkDisplay *display;
+  GdkGetPropertyCallback callback;
+  gpointer data;
+
+  Atom type;
+  int format;
+  gulong nitems;
+  guchar *value;
+};
+
+struct _TranslateCoordinatesState
+{
+  Display *dpy;
+  _XAsyncHandler async;
+  gulong translate_req;
+  GdkDisplay *display;
+  GdkTranslateCoordinatesCallback callback;
+  gpointer data;
+
+  gboolean success;
+  int x;
+  int y;
+};
+
 static gboolean
 callback_idle (gpointer data)
 {
@@ -756,3 +787,256 @@ _gdk_x11_roundtrip_async (GdkDisplay           *display,
   UnlockDisplay(dpy);
   SyncHandle();
 }
+
+static gboolean
+get_property_callback_idle (gpointer data)
+{
+  GetPropertyState *state = data;
+
+  state->callback (state->display,
+                   state->type, state->format, state->nitems, state->value,
+                   state->data);
+
+  g_free (state->value);
+  g_free (state);
+
+  return G_SOURCE_REMOVE;
+}
+
+static Bool
+get_property_handler (Display *dpy,
+                      xReply  *rep,
+                      char    *buf,
+                      int      len,
+                      XPointer data)
+{
+  GetPropertyState *state = (GetPropertyState *) data;
+  Bool handled = True;
+  guint id;
+
+  if (dpy->last_request_read != state->get_property_req)
+    return False;
+
+  state->type = None;
+
+  if (rep->generic.type == X_Error)
+    {
+      /* The window may be gone by the time the request arrives,
+       * let other errors go to the error handler.
+       */
+      handled = rep->error.errorCode == BadWindow;
+    }
+  else
+    {
+      xGetPropertyReply replbuf;
+      xGetPropertyReply *repl;
+      gsize nbytes;
+
+      repl = (xGetPropertyReply *)
+        _XGetAsyncReply (dpy, (char *) &replbuf, rep, buf, len,
+                         (sizeof (xGetPropertyReply) - sizeof (xReply)) >> 2,
+                         False);
+
+      state->type = repl->propertyType;
+      state->format = repl->format;
+      state->nitems = repl->nItems;
+
+      nbytes = (gsize) repl->nItems * (repl->format / 8);
+      if (repl->propertyType != None && nbytes > 0)
+        {
+          guchar *wire = g_malloc (nbytes);
+
+          _XGetAsyncData (dpy, (char *) wire, buf, len,
+                          sizeof (xGetPropertyReply), nbytes,
+                          repl->length << 2);
+
+          /* Like XGetWindowProperty(), hand out 32-bit items as longs */
+          if (repl->format == 32)
+            {
+              gulong *longs = g_new (gulong, repl->nItems);
+
+              for (gsize i = 0; i < repl->nItems; i++)
+                longs[i] = ((guint32 *) wire)[i];
+
+              g_free (wire);
+              state->value = (guchar *) longs;
+            }
+          else
+            state->value = wire;
+        }
+      else if (repl->length > 0)
+        _XGetAsyncData (dpy, NULL, buf, len, sizeof (xGetPropertyReply), 0, repl->length << 2);
+    }
+
+  DeqAsyncHandler (state->dpy, &state->async);
+
+  /* We are called while Xlib reads replies, so defer the callback
+   * to when it is safe to make requests again. Use the same priority
+   * as events so it runs before the next frame is drawn.
+   */
+  id = g_idle_add_full (G_PRIORITY_DEFAULT, get_property_callback_idle, state, NULL);
+  gdk_source_set_static_name_by_id (id, "[gtk] get_property_callback_idle");
+
+  return handled;
+}
+
+/*
+ * _gdk_x11_get_property_async:
+ * @display: a `GdkDisplay`
+ * @window: the window to read the property from
+ * @property: the property
+ * @req_type: the requested type, or AnyPropertyType
+ * @callback: called with the property contents
+ * @data: data for @callback
+ *
+ * Like XGetWindowProperty(), but doesn't wait for the reply.
+ *
+ * The callback gets a type of None if the property doesn't exist or
+ * the window was destroyed. The data is freed after it returns.
+ */
+void
+_gdk_x11_get_property_async (GdkDisplay             *display,
+                             Window                  window,
+                             Atom                    property,
+                             Atom                    req_type,
+                             GdkGetPropertyCallback  callback,
+                             gpointer                data)
+{
+  Display *dpy;
+  GetPropertyState *state;
+  xGetPropertyReq *req;
+
+  dpy = GDK_DISPLAY_XDISPLAY (display);
+
+  state = g_new0 (GetPropertyState, 1);
+
+  state->dpy = dpy;
+  state->display = display;
+  state->callback = callback;
+  state->data = data;
+
+  LockDisplay (dpy);
+
+  state->async.next = dpy->async_handlers;
+  state->async.handler = get_property_handler;
+  state->async.data = (XPointer) state;
+  dpy->async_handlers = &state->async;
+
+  GetReq (GetProperty, req);
+  req->window = window;
+  req->property = property;
+  req->type = req_type;
+  req->delete = False;
+  req->longOffset = 0;
+  req->longLength = G_MAXINT32 / 4;
+  state->get_property_req = dpy->request;
+
+  UnlockDisplay (dpy);
+  SyncHandle ();
+}
+
+static gboolean
+translate_coordinates_callback_idle (gpointer data)
+{
+  TranslateCoordinatesState *state = data;
+
+  state->callback (state->display, state->success, state->x, state->y, state->data);
+
+  g_free (state);
+
+  return G_SOURCE_REMOVE;
+}
+
+static Bool
+translate_coordinates_handler (Display *dpy,
+                               xReply  *rep,
+                               char    *buf,
+                               int      len,
+                               XPointer data)
+{
+  TranslateCoordinatesState *state = (TranslateCoordinatesState *) data;
+  Bool handled = True;
+  guint id;
+
+  if (dpy->last_request_read != state->translate_req)
+    return False;
+
+  if (rep->generic.type == X_Error)
+    {
+      handled = rep->error.errorCode == BadWindow;
+      state->success = FALSE;
+    }
+  else
+    {
+      xTranslateCoordsReply replbuf;
+      xTranslateCoordsReply *repl;
+
+      repl = (xTranslateCoordsReply *)
+        _XGetAsyncReply (dpy, (char *) &replbuf, rep, buf, len,
+                         (sizeof (xTranslateCoordsReply) - sizeof (xReply)) >> 2,
+                         True);
+
+      state->success = repl->sameScreen;
+      state->x = cvtINT16toInt (repl->dstX);
+      state->y = cvtINT16toInt (repl->dstY);
+    }
+
+  DeqAsyncHandler (state->dpy, &state->async);
+
+  id = g_idle_add_full (G_PRIORITY_DEFAULT, translate_coordinates_callback_idle, state, NULL);
+  gdk_source_set_static_name_by_id (id, "[gtk] translate_coordinates_callback_idle");
+
+  return handled;
+}
+
+/*
+ * _gdk_x11_translate_coordinates_async:
+ * @display: a `GdkDisplay`
+ * @src_window: the window @src_x and @src_y are relative to
+ * @dest_window: the window to translate them to
+ * @src_x: x coordinate
+ * @src_y: y coordinate
+ * @callback: called with the translated coordinates
+ * @data: data for @callback
+ *
+ * Like XTranslateCoordinates(), but doesn't wait for the reply.
+ */
+void
+_gdk_x11_translate_coordinates_async (GdkDisplay                      *display,
+                                      Window                           src_window,
+                                      Window                           dest_window,
+                                      int                              src_x,
+                                      int                              src_y,
+                                      GdkTranslateCoordinatesCallback  callback,
+                                      gpointer                         data)
+{
+  Display *dpy;
+  TranslateCoordinatesState *state;
+  xTranslateCoordsReq *req;
+
+  dpy = GDK_DISPLAY_XDISPLAY (display);
+
+  state = g_new0 (TranslateCoordinatesState, 1);
+
+  state->dpy = dpy;
+  state->display = display;
+  state->callback = callback;
+  state->data = data;
+
+  LockDisplay (dpy);
+
+  state->async.next = dpy->async_handlers;
+  state->async.handler = translate_coordinates_handler;
+  state->async.data = (XPointer) state;
+  dpy->async_handlers = &state->async;
+
+  GetReq (TranslateCoords, req);
+  req->srcWid = src_window;
+  req->dstWid = dest_window;
+  req->srcX = src_x;
+  req->srcY = src_y;
+  state->translate_req = dpy->request;
+
+  UnlockDisplay (dpy);
+  SyncHandle ();
+}
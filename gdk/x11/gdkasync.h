@@ -31,6 +31,17 @@ typedef void (*GdkSendXEventCallback) (Window   window,
 typedef void (*GdkRoundTripCallback)  (GdkDisplay *display,
 				       gpointer data,
 				       gulong serial);
+typedef void (*GdkGetPropertyCallback) (GdkDisplay *display,
+                                        Atom        type,
+                                        int         format,
+                                        gulong      nitems,
+                                        guchar     *data,
+                                        gpointer    user_data);
+typedef void (*GdkTranslateCoordinatesCallback) (GdkDisplay *display,
+                                                 gboolean    success,
+                                                 int         x,
+                                                 int         y,
+                                                 gpointer    user_data);
 
 struct _GdkChildInfoX11
 {
@@ -63,5 +74,20 @@ void _gdk_x11_roundtrip_async           (GdkDisplay           *display,
 					 GdkRoundTripCallback callback,
 					 gpointer              data);
 
+void _gdk_x11_get_property_async        (GdkDisplay             *display,
+                                         Window                  window,
+                                         Atom                    property,
+                                         Atom                    req_type,
+                                         GdkGetPropertyCallback  callback,
+                                         gpointer                data);
+
+void _gdk_x11_translate_coordinates_async (GdkDisplay                      *display,
+                                           Window                           src_window,
+                                           Window                           dest_window,
+                                           int                              src_x,
+                                           int                              src_y,
+                                           GdkTranslateCoordinatesCallback  callback,
+                                           gpointer                         data);
+
 G_END_DECLS
 
@@ -438,70 +438,78 @@ do_net_wm_state_changes (GdkSurface *surface)
   gdk_synthesize_surface_state (surface, unset, set);
 }
 
+/* The _NET_WM_STATE, _NET_WM_DESKTOP and _GTK_EDGE_CONSTRAINTS
+ * properties change whenever the window manager maps, focuses or
+ * tiles us, so we read them without waiting for the reply.
+ */
 static void
-gdk_check_wm_desktop_changed (GdkSurface *surface)
+wm_desktop_received (GdkDisplay *display,
+                     Atom        type,
+                     int         format,
+                     gulong      nitems,
+                     guchar     *data,
+                     gpointer    user_data)
 {
-  GdkToplevelX11 *toplevel = _gdk_x11_surface_get_toplevel (surface);
-  GdkDisplay *display = GDK_SURFACE_DISPLAY (surface);
+  GdkSurface *surface = user_data;
+  GdkToplevelX11 *toplevel;
 
-  Atom type;
-  int format;
-  gulong nitems;
-  gulong bytes_after;
-  guchar *data;
-  gulong *desktop;
+  if (GDK_SURFACE_DESTROYED (surface))
+    goto out;
 
-  type = None;
-  gdk_x11_display_error_trap_push (display);
-  XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display),
-                      GDK_SURFACE_XID (surface),
-                      gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_DESKTOP"),
-                      0, G_MAXLONG, False, XA_CARDINAL, &type,
-                      &format, &nitems,
-                      &bytes_after, &data);
-  gdk_x11_display_error_trap_pop_ignored (display);
+  toplevel = _gdk_x11_surface_get_toplevel (surface);
 
-  if (type != None)
+  if (type != None && nitems > 0)
     {
-      desktop = (gulong *)data;
+      gulong *desktop = (gulong *)data;
       toplevel->on_all_desktops = ((*desktop & 0xFFFFFFFF) == 0xFFFFFFFF);
-      XFree (desktop);
     }
   else
     toplevel->on_all_desktops = FALSE;
 
   do_net_wm_state_changes (surface);
+
+out:
+  g_object_unref (surface);
 }
 
 static void
-gdk_check_wm_state_changed (GdkSurface *surface)
+gdk_check_wm_desktop_changed (GdkSurface *surface)
 {
-  GdkToplevelX11 *toplevel = _gdk_x11_surface_get_toplevel (surface);
   GdkDisplay *display = GDK_SURFACE_DISPLAY (surface);
-  GdkX11Screen *screen = GDK_SURFACE_SCREEN (surface);
-
-  Atom type;
-  int format;
-  gulong nitems;
-  gulong bytes_after;
-  guchar *data;
-  Atom *atoms = NULL;
+
+  _gdk_x11_get_property_async (display,
+                               GDK_SURFACE_XID (surface),
+                               gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_DESKTOP"),
+                               XA_CARDINAL,
+                               wm_desktop_received,
+                               g_object_ref (surface));
+}
+
+static void
+wm_state_received (GdkDisplay *display,
+                   Atom        type,
+                   int         format,
+                   gulong      nitems,
+                   guchar     *data,
+                   gpointer    user_data)
+{
+  GdkSurface *surface = user_data;
+  GdkToplevelX11 *toplevel;
+  GdkX11Screen *screen;
   gulong i;
 
+  if (GDK_SURFACE_DESTROYED (surface))
+    goto out;
+
+  toplevel = _gdk_x11_surface_get_toplevel (surface);
+  screen = GDK_SURFACE_SCREEN (surface);
+
   toplevel->have_maxvert = FALSE;
   toplevel->have_maxhorz = FALSE;
   toplevel->have_fullscreen = FALSE;
   toplevel->have_focused = FALSE;
   toplevel->have_hidden = FALSE;
 
-  type = None;
-  gdk_x11_display_error_trap_push (display);
-  XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), GDK_SURFACE_XID (surface),
-		      gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_STATE"),
-		      0, G_MAXLONG, False, XA_ATOM, &type, &format, &nitems,
-		      &bytes_after, &data);
-  gdk_x11_display_error_trap_pop_ignored (display);
-
   if (type != None)
     {
       Atom maxvert_atom = gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_STATE_MAXIMIZED_VERT");
@@ -509,11 +517,9 @@ gdk_check_wm_state_changed (GdkSurface *surface)
       Atom fullscreen_atom = gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_STATE_FULLSCREEN");
       Atom focused_atom = gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_STATE_FOCUSED");
       Atom hidden_atom = gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_STATE_HIDDEN");
+      Atom *atoms = (Atom *)data;
 
-      atoms = (Atom *)data;
-
-      i = 0;
-      while (i < nitems)
+      for (i = 0; i < nitems; i++)
         {
           if (atoms[i] == maxvert_atom)
             toplevel->have_maxvert = TRUE;
@@ -525,11 +531,7 @@ gdk_check_wm_state_changed (GdkSurface *surface)
             toplevel->have_focused = TRUE;
           else if (atoms[i] == hidden_atom)
             toplevel->have_hidden = TRUE;
-
-          ++i;
         }
-
-      XFree (atoms);
     }
 
   if (!gdk_x11_screen_supports_net_wm_hint (screen,
@@ -537,42 +539,49 @@ gdk_check_wm_state_changed (GdkSurface *surface)
     toplevel->have_focused = TRUE;
 
   do_net_wm_state_changes (surface);
+
+out:
+  g_object_unref (surface);
 }
 
 static void
-gdk_check_edge_constraints_changed (GdkSurface *surface)
+gdk_check_wm_state_changed (GdkSurface *surface)
 {
-  GdkToplevelX11 *toplevel = _gdk_x11_surface_get_toplevel (surface);
   GdkDisplay *display = GDK_SURFACE_DISPLAY (surface);
 
-  Atom type;
-  int format;
-  gulong nitems;
-  gulong bytes_after;
-  guchar *data;
-  gulong *constraints;
+  _gdk_x11_get_property_async (display,
+                               GDK_SURFACE_XID (surface),
+                               gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_STATE"),
+                               XA_ATOM,
+                               wm_state_received,
+                               g_object_ref (surface));
+}
 
-  type = None;
-  gdk_x11_display_error_trap_push (display);
-  XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display),
-                      GDK_SURFACE_XID (surface),
-                      gdk_x11_get_xatom_by_name_for_display (display, "_GTK_EDGE_CONSTRAINTS"),
-                      0, G_MAXLONG, False, XA_CARDINAL, &type,
-                      &format, &nitems,
-                      &bytes_after, &data);
-  gdk_x11_display_error_trap_pop_ignored (display);
+static void
+edge_constraints_received (GdkDisplay *display,
+                           Atom        type,
+                           int         format,
+                           gulong      nitems,
+                           guchar     *data,
+                           gpointer    user_data)
+{
+  GdkSurface *surface = user_data;
+  GdkToplevelX11 *toplevel;
 
-  if (type != None)
+  if (GDK_SURFACE_DESTROYED (surface))
+    goto out;
+
+  toplevel = _gdk_x11_surface_get_toplevel (surface);
+
+  if (type != None && nitems > 0)
     {
-      constraints = (gulong *)data;
+      gulong *constraints = (gulong *)data;
 
       /* The GDK enum for these states does not begin at zero so, to avoid
        * messing around with shifts, just make the passed value and GDK's
        * enum values match by shifting to the first tiled state.
        */
       toplevel->edge_constraints = constraints[0] << 8;
-
-      XFree (constraints);
     }
   else
     {
@@ -580,6 +589,77 @@ gdk_check_edge_constraints_changed (GdkSurface *surface)
     }
 
   do_net_wm_state_changes (surface);
+
+out:
+  g_object_unref (surface);
+}
+
+static void
+gdk_check_edge_constraints_changed (GdkSurface *surface)
+{
+  GdkDisplay *display = GDK_SURFACE_DISPLAY (surface);
+
+  _gdk_x11_get_property_async (display,
+                               GDK_SURFACE_XID (surface),
+                               gdk_x11_get_xatom_by_name_for_display (display, "_GTK_EDGE_CONSTRAINTS"),
+                               XA_CARDINAL,
+                               edge_constraints_received,
+                               g_object_ref (surface));
+}
+
+static void
+surface_position_changed (GdkSurface *surface,
+                          int         x,
+                          int         y)
+{
+  GdkX11Surface *surface_impl = GDK_X11_SURFACE (surface);
+
+  surface_impl->abs_x = x;
+  surface_impl->abs_y = y;
+
+  if (surface->parent)
+    {
+      GdkX11Surface *parent_impl = GDK_X11_SURFACE (surface->parent);
+
+      surface->x = x - parent_impl->abs_x;
+      surface->y = y - parent_impl->abs_y;
+    }
+
+  gdk_x11_surface_update_popups (surface);
+  gdk_x11_surface_enter_leave_monitors (surface);
+}
+
+typedef struct _PositionQuery PositionQuery;
+
+struct _PositionQuery
+{
+  GdkSurface *surface;
+  guint configure_serial;
+};
+
+static void
+surface_position_received (GdkDisplay *display,
+                           gboolean    success,
+                           int         x,
+                           int         y,
+                           gpointer    user_data)
+{
+  PositionQuery *query = user_data;
+  GdkSurface *surface = query->surface;
+
+  /* A later configure has set or queried the position already */
+  if (success && !GDK_SURFACE_DESTROYED (surface) &&
+      GDK_X11_SURFACE (surface)->configure_serial == query->configure_serial)
+    {
+      GdkX11Surface *surface_impl = GDK_X11_SURFACE (surface);
+
+      surface_position_changed (surface,
+                                x / surface_impl->surface_scale,
+                                y / surface_impl->surface_scale);
+    }
+
+  g_object_unref (surface);
+  g_free (query);
 }
 
 static Window
@@ -907,10 +987,8 @@ gdk_x11_display_translate_event (GdkEventTranslator *translator,
     if (surface && 
 	xevent->xconfigure.event == xevent->xconfigure.window)
         {
-          int x, y;
           int configured_width;
           int configured_height;
-          int new_abs_x, new_abs_y;
 
           configured_width =
             (xevent->xconfigure.width + surface_impl->surface_scale - 1) /
@@ -919,49 +997,6 @@ gdk_x11_display_translate_event (GdkEventTranslator *translator,
             (xevent->xconfigure.height + surface_impl->surface_scale - 1) /
             surface_impl->surface_scale;
 
-	  if (!xevent->xconfigure.send_event &&
-	      !xevent->xconfigure.override_redirect &&
-	      !GDK_SURFACE_DESTROYED (surface))
-	    {
-	      int tx = 0;
-	      int ty = 0;
-	      Window child_window = 0;
-
-              x = y = 0;
-	      gdk_x11_display_error_trap_push (display);
-	      if (XTranslateCoordinates (GDK_SURFACE_XDISPLAY (surface),
-					 GDK_SURFACE_XID (surface),
-					 x11_screen->xroot_window,
-					 0, 0,
-					 &tx, &ty,
-					 &child_window))
-		{
-		  x = tx / surface_impl->surface_scale;
-		  y = ty / surface_impl->surface_scale;
-		}
-	      gdk_x11_display_error_trap_pop_ignored (display);
-	    }
-	  else
-	    {
-	      x = xevent->xconfigure.x / surface_impl->surface_scale;
-	      y = xevent->xconfigure.y / surface_impl->surface_scale;
-	    }
-
-          new_abs_x = x;
-          new_abs_y = y;
-
-          surface_impl->abs_x = new_abs_x;
-          surface_impl->abs_y = new_abs_y;
-
-          if (surface->parent)
-            {
-              GdkX11Surface *parent_impl =
-                GDK_X11_SURFACE (surface->parent);
-
-              surface->x = new_abs_x - parent_impl->abs_x;
-              surface->y = new_abs_y - parent_impl->abs_y;
-            }
-
           if (surface_impl->unscaled_width != xevent->xconfigure.width ||
               surface_impl->unscaled_height != xevent->xconfigure.height)
             {
@@ -983,8 +1018,32 @@ gdk_x11_display_translate_event (GdkEventTranslator *translator,
                 _gdk_x11_moveresize_configure_done (display, surface);
             }
 
-          gdk_x11_surface_update_popups (surface);
-          gdk_x11_surface_enter_leave_monitors (surface);
+          surface_impl->configure_serial++;
+
+	  if (!xevent->xconfigure.send_event &&
+	      !xevent->xconfigure.override_redirect &&
+	      !GDK_SURFACE_DESTROYED (surface))
+	    {
+              /* The event is relative to the window manager frame,
+               * ask the server where we are, but don't wait for it
+               * while the user is resizing.
+               */
+              _gdk_x11_translate_coordinates_async (display,
+                                                    GDK_SURFACE_XID (surface),
+                                                    x11_screen->xroot_window,
+                                                    0, 0,
+                                                    surface_position_received,
+                                                    g_memdup2 (&(PositionQuery) {
+                                                        .surface = g_object_ref (surface),
+                                                        .configure_serial = surface_impl->configure_serial,
+                                                    }, sizeof (PositionQuery)));
+	    }
+	  else
+	    {
+              surface_position_changed (surface,
+                                        xevent->xconfigure.x / surface_impl->surface_scale,
+                                        xevent->xconfigure.y / surface_impl->surface_scale);
+	    }
         }
       break;
 
@@ -1525,6 +1584,7 @@ gdk_x11_display_open (const char *display_name)
     unsigned int xmask;
 
     gdk_x11_display_error_trap_push (display);
+    _gdk_x11_display_count_roundtrip (display, "XQueryPointer");
     XQueryPointer (display_x11->xdisplay,
 		   GDK_X11_SCREEN (display_x11->screen)->xroot_window,
 		   &root, &child, &rootx, &rooty, &winx, &winy, &xmask);
@@ -1781,6 +1841,26 @@ _gdk_x11_display_is_root_window (GdkDisplay *display,
   return GDK_SCREEN_XROOTWIN (display_x11->screen) == xroot_window;
 }
 
+/* Call this before every request that waits for a reply from the
+ * server, so that GDK_DEBUG=misc and the profiler show where we
+ * still block on round-trips.
+ */
+void
+_gdk_x11_display_count_roundtrip (GdkDisplay *display,
+                                  const char *what)
+{
+  GdkX11Display *display_x11 = GDK_X11_DISPLAY (display);
+  static guint roundtrips_counter;
+
+  display_x11->n_roundtrips++;
+
+  GDK_DISPLAY_DEBUG (display, MISC, "Round-trip #%u: %s", display_x11->n_roundtrips, what);
+
+  if (roundtrips_counter == 0)
+    roundtrips_counter = gdk_profiler_define_int_counter ("x11 round-trips", "Synchronous requests to the X server");
+  gdk_profiler_set_int_counter (roundtrips_counter, display_x11->n_roundtrips);
+}
+
 static void
 device_grab_update_callback (GdkDisplay *display,
                              gpointer    data,
@@ -1842,6 +1922,7 @@ gdk_x11_display_beep (GdkDisplay *display)
 static void
 gdk_x11_display_sync (GdkDisplay *display)
 {
+  _gdk_x11_display_count_roundtrip (display, "XSync");
   XSync (GDK_DISPLAY_XDISPLAY (display), False);
 }
 
@@ -2596,6 +2677,7 @@ gdk_x11_display_error_trap_pop_internal (GdkDisplay *display,
        */
       if ((next_sequence - 1) != processed_sequence)
         {
+          _gdk_x11_display_count_roundtrip (display, "XSync (error trap)");
           XSync (display_x11->xdisplay, False);
         }
 
@@ -143,6 +143,9 @@ struct _GdkX11Display
 
   guint server_time_is_monotonic_time : 1;
 
+  /* Synchronous requests made so far, see _gdk_x11_display_count_roundtrip() */
+  guint n_roundtrips;
+
   /* GLX extensions we check */
   guint has_glx_sgi_swap_control : 1;
   guint has_glx_swap_control : 1;
@@ -107,6 +107,8 @@ void _gdk_x11_surface_set_frame_still_painting (GdkSurface *surface,
 
 gboolean _gdk_x11_display_is_root_window (GdkDisplay *display,
                                           Window      xroot_window);
+void     _gdk_x11_display_count_roundtrip (GdkDisplay *display,
+                                           const char *what);
 
 void _gdk_x11_display_update_grab_info        (GdkDisplay *display,
                                                GdkDevice  *device,
@@ -2046,6 +2046,7 @@ get_netwm_cardinal_property (GdkSurface   *surface,
   if (!gdk_x11_screen_supports_net_wm_hint (x11_screen, name))
     return 0;
 
+  _gdk_x11_display_count_roundtrip (GDK_SURFACE_DISPLAY (surface), name);
   XGetWindowProperty (x11_screen->xdisplay,
                       GDK_SURFACE_XID (surface),
                       gdk_x11_get_xatom_by_name_for_display (GDK_SURFACE_DISPLAY (surface), name),
@@ -2668,10 +2669,12 @@ gdk_x11_surface_get_geometry (GdkSurface *surface,
     {
       impl = GDK_X11_SURFACE (surface);
 
+      _gdk_x11_display_count_roundtrip (GDK_SURFACE_DISPLAY (surface), "XGetGeometry");
       XGetGeometry (GDK_SURFACE_XDISPLAY (surface),
 		    GDK_SURFACE_XID (surface),
 		    &root, &tx, &ty, &twidth, &theight, &tborder_width, &tdepth);
 
+      _gdk_x11_display_count_roundtrip (GDK_SURFACE_DISPLAY (surface), "XTranslateCoordinates");
       XTranslateCoordinates (GDK_SURFACE_XDISPLAY (surface),
                              GDK_SURFACE_XID (surface),
                              root, 0, 0, &tx, &ty, &child);
@@ -2699,6 +2702,7 @@ gdk_x11_surface_get_root_coords (GdkSurface *surface,
   int tx;
   int ty;
   
+  _gdk_x11_display_count_roundtrip (GDK_SURFACE_DISPLAY (surface), "XTranslateCoordinates");
   XTranslateCoordinates (GDK_SURFACE_XDISPLAY (surface),
                          GDK_SURFACE_XID (surface),
                          GDK_SURFACE_XROOTWIN (surface),
@@ -2767,6 +2771,9 @@ gdk_x11_surface_get_frame_extents (GdkSurface    *surface,
 
   xwindow = GDK_SURFACE_XID (surface);
 
+  /* This is rare enough that we don't bother pipelining the requests */
+  _gdk_x11_display_count_roundtrip (display, "frame extents");
+
   /* first try: use _NET_FRAME_EXTENTS */
   if (gdk_x11_screen_supports_net_wm_hint (GDK_SURFACE_SCREEN (surface),
                                            g_intern_static_string ("_NET_FRAME_EXTENTS")) &&
@@ -3550,84 +3557,46 @@ gdk_x11_surface_set_group (GdkSurface *surface,
   update_wm_hints (surface, FALSE);
 }
 
-static MotifWmHints *
-gdk_surface_get_mwm_hints (GdkSurface *surface)
+static void
+gdk_surface_set_mwm_hints (GdkSurface   *surface,
+                           MotifWmHints *new_hints)
 {
   GdkDisplay *display;
+  GdkToplevelX11 *toplevel;
   Atom hints_atom = None;
-  guchar *data;
-  Atom type;
-  int format;
-  gulong nitems;
-  gulong bytes_after;
-  
+  MotifWmHints hints;
+
   if (GDK_SURFACE_DESTROYED (surface))
-    return NULL;
+    return;
 
   display = gdk_surface_get_display (surface);
-  
-  hints_atom = gdk_x11_get_xatom_by_name_for_display (display, _XA_MOTIF_WM_HINTS);
+  toplevel = _gdk_x11_surface_get_toplevel (surface);
 
-  XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display), GDK_SURFACE_XID (surface),
-		      hints_atom, 0, sizeof (MotifWmHints)/sizeof (long),
-		      False, AnyPropertyType, &type, &format, &nitems,
-		      &bytes_after, &data);
+  /* Merge into the hints we set before instead of reading the
+   * property back from the server, which costs a round-trip.
+   */
+  if (new_hints->flags & MWM_HINTS_FUNCTIONS)
+    {
+      toplevel->mwm_flags |= MWM_HINTS_FUNCTIONS;
+      toplevel->mwm_functions = new_hints->functions;
+    }
+  if (new_hints->flags & MWM_HINTS_DECORATIONS)
+    {
+      toplevel->mwm_flags |= MWM_HINTS_DECORATIONS;
+      toplevel->mwm_decorations = new_hints->decorations;
+    }
 
-  if (type == None)
-    return NULL;
-  
-  return (MotifWmHints *)data;
-}
+  /* initialize to zero to avoid writing uninitialized data to socket */
+  memset (&hints, 0, sizeof (hints));
+  hints.flags = toplevel->mwm_flags;
+  hints.functions = toplevel->mwm_functions;
+  hints.decorations = toplevel->mwm_decorations;
 
-static void
-gdk_surface_set_mwm_hints (GdkSurface *surface,
-			  MotifWmHints *new_hints)
-{
-  GdkDisplay *display;
-  Atom hints_atom = None;
-  guchar *data;
-  MotifWmHints *hints;
-  Atom type;
-  int format;
-  gulong nitems;
-  gulong bytes_after;
-  
-  if (GDK_SURFACE_DESTROYED (surface))
-    return;
-  
-  display = gdk_surface_get_display (surface);
-  
   hints_atom = gdk_x11_get_xatom_by_name_for_display (display, _XA_MOTIF_WM_HINTS);
 
-  XGetWindowProperty (GDK_SURFACE_XDISPLAY (surface), GDK_SURFACE_XID (surface),
-		      hints_atom, 0, sizeof (MotifWmHints)/sizeof (long),
-		      False, AnyPropertyType, &type, &format, &nitems,
-		      &bytes_after, &data);
-  
-  if (type == None)
-    hints = new_hints;
-  else
-    {
-      hints = (MotifWmHints *)data;
-	
-      if (new_hints->flags & MWM_HINTS_FUNCTIONS)
-	{
-	  hints->flags |= MWM_HINTS_FUNCTIONS;
-	  hints->functions = new_hints->functions;
-	}
-      if (new_hints->flags & MWM_HINTS_DECORATIONS)
-	{
-	  hints->flags |= MWM_HINTS_DECORATIONS;
-	  hints->decorations = new_hints->decorations;
-	}
-    }
-  
   XChangeProperty (GDK_SURFACE_XDISPLAY (surface), GDK_SURFACE_XID (surface),
 		   hints_atom, hints_atom, 32, PropModeReplace,
-		   (guchar *)hints, sizeof (MotifWmHints)/sizeof (long));
-  
-  if (hints != new_hints)
-    XFree (hints);
+		   (guchar *)&hints, sizeof (MotifWmHints)/sizeof (long));
 }
 
 typedef enum
@@ -3662,27 +3631,20 @@ static gboolean
 gdk_x11_surface_get_decorations(GdkSurface       *surface,
 			       GdkWMDecoration *decorations)
 {
-  MotifWmHints *hints;
-  gboolean result = FALSE;
+  GdkToplevelX11 *toplevel;
 
   if (GDK_SURFACE_DESTROYED (surface))
     return FALSE;
-  
-  hints = gdk_surface_get_mwm_hints (surface);
-  
-  if (hints)
-    {
-      if (hints->flags & MWM_HINTS_DECORATIONS)
-	{
-	  if (decorations)
-	    *decorations = hints->decorations;
-	  result = TRUE;
-	}
-      
-      XFree (hints);
-    }
 
-  return result;
+  toplevel = _gdk_x11_surface_get_toplevel (surface);
+
+  if (!(toplevel->mwm_flags & MWM_HINTS_DECORATIONS))
+    return FALSE;
+
+  if (decorations)
+    *decorations = toplevel->mwm_decorations;
+
+  return TRUE;
 }
 
 typedef enum
@@ -3718,27 +3680,20 @@ static gboolean
 gdk_x11_surface_get_functions (GdkSurface       *surface,
 			       GdkWMFunction    *functions)
 {
-  MotifWmHints *hints;
-  gboolean result = FALSE;
+  GdkToplevelX11 *toplevel;
 
   if (GDK_SURFACE_DESTROYED (surface))
     return FALSE;
-  
-  hints = gdk_surface_get_mwm_hints (surface);
-  
-  if (hints)
-    {
-      if (hints->flags & MWM_HINTS_DECORATIONS)
-	{
-	  if (functions)
-	    *functions = hints->functions;
-	  result = TRUE;
-	}
-      
-      XFree (hints);
-    }
 
-  return result;
+  toplevel = _gdk_x11_surface_get_toplevel (surface);
+
+  if (!(toplevel->mwm_flags & MWM_HINTS_FUNCTIONS))
+    return FALSE;
+
+  if (functions)
+    *functions = toplevel->mwm_functions;
+
+  return TRUE;
 }
 
 cairo_region_t *
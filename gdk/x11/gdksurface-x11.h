@@ -98,6 +98,9 @@ struct _GdkX11Surface
 
   int abs_x;
   int abs_y;
+  /* bumped by every ConfigureNotify, so outdated position
+   * queries can be ignored */
+  guint configure_serial;
 
   guint64 map_time;
 
@@ -183,6 +186,11 @@ struct _GdkToplevelX11
   /* Constrained edge information */
   guint edge_constraints;
 
+  /* The _MOTIF_WM_HINTS we last set, so we never need to read them back */
+  gulong mwm_flags;
+  gulong mwm_functions;
+  gulong mwm_decorations;
+
 #ifdef HAVE_XSYNC
   XID update_counter;
   XID extended_update_counter;
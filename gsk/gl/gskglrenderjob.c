@@ -31,6 +31,7 @@
 #include <gsk/gskglshaderprivate.h>
 #include <gdk/gdktextureprivate.h>
 #include <gdk/gdkmemorytextureprivate.h>
+#include <gdk/gdktiledtextureprivate.h>
 #include <gdk/gdkdmabuftexture.h>
 #include <gdk/gdksurfaceprivate.h>
 #include <gdk/gdksubsurfaceprivate.h>
@@ -3343,6 +3344,19 @@ gsk_gl_render_job_visit_blend_node (GskGLRenderJob      *job,
     }
 }
 
+/* We can't draw only the visible tiles of a tiled texture and
+ * loading all of them may not even fit into memory, so we draw
+ * a smaller level instead.
+ */
+static inline GdkTexture *
+gsk_gl_render_job_get_texture (GdkTexture *texture)
+{
+  if (GDK_IS_TILED_TEXTURE (texture))
+    return gdk_tiled_texture_get_preview (GDK_TILED_TEXTURE (texture));
+
+  return texture;
+}
+
 static gboolean
 gsk_gl_render_job_texture_mask_for_color (GskGLRenderJob        *job,
                                           const GskRenderNode   *mask,
@@ -3350,11 +3364,11 @@ gsk_gl_render_job_texture_mask_for_color (GskGLRenderJob        *job,
                                           const graphene_rect_t *bounds)
 {
   int max_texture_size = job->command_queue->max_texture_size;
-  GdkTexture *texture = gsk_texture_node_get_texture (mask);
+  GdkTexture *texture = gsk_gl_render_job_get_texture (gsk_texture_node_get_texture (mask));
   GdkRGBA rgba;
 
   get_color_node_color_as_srgb (color, &rgba);
-  if (RGBA_IS_CLEAR (&rgba))
+  if (RGBA_IS_CLEAR (&rgba) || texture == NULL)
     return TRUE;
 
   if G_LIKELY (texture->width <= max_texture_size &&
@@ -3770,9 +3784,12 @@ static inline void
 gsk_gl_render_job_visit_texture_node (GskGLRenderJob      *job,
                                       const GskRenderNode *node)
 {
-  GdkTexture *texture = gsk_texture_node_get_texture (node);
+  GdkTexture *texture = gsk_gl_render_job_get_texture (gsk_texture_node_get_texture (node));
   const graphene_rect_t *bounds = &node->bounds;
 
+  if (texture == NULL)
+    return;
+
   gsk_gl_render_job_visit_texture (job, texture, bounds);
 }
 
@@ -3780,7 +3797,7 @@ static inline void
 gsk_gl_render_job_visit_texture_scale_node (GskGLRenderJob      *job,
                                             const GskRenderNode *node)
 {
-  GdkTexture *texture = gsk_texture_scale_node_get_texture (node);
+  GdkTexture *texture = gsk_gl_render_job_get_texture (gsk_texture_scale_node_get_texture (node));
   const graphene_rect_t *bounds = &node->bounds;
   GskScalingFilter filter = gsk_texture_scale_node_get_filter (node);
   int min_filters[] = { GL_LINEAR, GL_NEAREST, GL_LINEAR_MIPMAP_LINEAR };
@@ -3801,6 +3818,9 @@ gsk_gl_render_job_visit_texture_scale_node (GskGLRenderJob      *job,
   gboolean need_mipmap;
   gboolean has_mipmap;
 
+  if (texture == NULL)
+    return;
+
   gsk_gl_render_job_untransform_bounds (job, &job->current_clip->rect.bounds, &clip_rect);
 
   if (!gsk_rect_intersection (bounds, &clip_rect, &clip_rect))
@@ -4293,9 +4313,13 @@ gsk_gl_render_job_visit_node_with_offscreen (GskGLRenderJob       *job,
   if (GSK_RENDER_NODE_TYPE (node) == GSK_TEXTURE_NODE &&
       !offscreen->force_offscreen)
     {
-      GdkTexture *texture = gsk_texture_node_get_texture (node);
-      gsk_gl_render_job_upload_texture (job, texture, FALSE, offscreen);
-      return TRUE;
+      GdkTexture *texture = gsk_gl_render_job_get_texture (gsk_texture_node_get_texture (node));
+
+      if (texture != NULL)
+        {
+          gsk_gl_render_job_upload_texture (job, texture, FALSE, offscreen);
+          return TRUE;
+        }
     }
 
   key.pointer = node;
@@ -13,6 +13,18 @@
 #include "gdk/gdkprofilerprivate.h"
 
 #include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
+
+#include <errno.h>
+#include <string.h>
+
+typedef struct _GLProgramPreload GLProgramPreload;
+
+struct _GLProgramPreload
+{
+  GMutex mutex;
+  GHashTable *programs; /* cache name => GBytes */
+};
 
 struct _GskGLDevice
 {
@@ -22,6 +34,10 @@ struct _GskGLDevice
   const char *version_string;
   GdkGLAPI api;
 
+  /* NULL if program binaries aren't cached */
+  char *program_cache_dir;
+  GLProgramPreload *preload;
+
   guint sampler_ids[GSK_GPU_SAMPLER_N_SAMPLERS];
 };
 
@@ -66,6 +82,47 @@ gl_program_key_equal (gconstpointer a,
          keya->variation == keyb->variation;
 }
 
+static void
+gl_program_preload_clear (gpointer data)
+{
+  GLProgramPreload *preload = data;
+
+  g_mutex_clear (&preload->mutex);
+  g_hash_table_unref (preload->programs);
+}
+
+static void
+gl_program_preload_unref (GLProgramPreload *preload)
+{
+  g_atomic_rc_box_release_full (preload, gl_program_preload_clear);
+}
+
+static GLProgramPreload *
+gl_program_preload_new (void)
+{
+  GLProgramPreload *preload;
+
+  preload = g_atomic_rc_box_new0 (GLProgramPreload);
+  g_mutex_init (&preload->mutex);
+  preload->programs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_bytes_unref);
+
+  return preload;
+}
+
+static GBytes *
+gl_program_preload_steal (GLProgramPreload *preload,
+                          const char       *cache_name)
+{
+  GBytes *bytes;
+
+  g_mutex_lock (&preload->mutex);
+  if (!g_hash_table_steal_extended (preload->programs, cache_name, NULL, (gpointer *) &bytes))
+    bytes = NULL;
+  g_mutex_unlock (&preload->mutex);
+
+  return bytes;
+}
+
 static GskGpuImage *
 gsk_gl_device_create_offscreen_image (GskGpuDevice   *device,
                                       gboolean        with_mipmap,
@@ -152,6 +209,9 @@ gsk_gl_device_finalize (GObject *object)
   g_hash_table_unref (self->gl_programs);
   glDeleteSamplers (G_N_ELEMENTS (self->sampler_ids), self->sampler_ids);
 
+  g_free (self->program_cache_dir);
+  g_clear_pointer (&self->preload, gl_program_preload_unref);
+
   G_OBJECT_CLASS (gsk_gl_device_parent_class)->finalize (object);
 }
 
@@ -229,6 +289,363 @@ gsk_gl_device_setup_samplers (GskGLDevice *self)
     }
 }
 
+/* Program binaries are stored in the user's cache dir, in a directory
+ * named after the driver and GTK version, with one file per program.
+ * The files contain the binary format followed by the binary.
+ *
+ * Directories of other drivers are removed once they haven't been used
+ * for a while. They aren't removed right away, so that apps running on
+ * different GPUs don't keep throwing away each other's programs.
+ */
+
+#define PROGRAM_CACHE_MAX_AGE (30 * G_TIME_SPAN_DAY / G_TIME_SPAN_SECOND)
+
+typedef struct _GLProgramPreloadData GLProgramPreloadData;
+
+struct _GLProgramPreloadData
+{
+  GLProgramPreload *preload;
+  char *dirname;
+};
+
+static void
+gl_program_preload_data_free (gpointer data)
+{
+  GLProgramPreloadData *preload_data = data;
+
+  gl_program_preload_unref (preload_data->preload);
+  g_free (preload_data->dirname);
+  g_free (preload_data);
+}
+
+static void
+gsk_gl_device_remove_program_cache_dir (const char *dirname)
+{
+  const char *basename;
+  GDir *dir;
+
+  dir = g_dir_open (dirname, 0, NULL);
+  if (dir == NULL)
+    return;
+
+  while ((basename = g_dir_read_name (dir)))
+    {
+      char *path = g_build_filename (dirname, basename, NULL);
+      g_unlink (path);
+      g_free (path);
+    }
+
+  g_dir_close (dir);
+
+  if (g_rmdir (dirname) == 0)
+    GSK_DEBUG (SHADERS, "Removed stale program cache %s", dirname);
+}
+
+/* Marks @dirname as used and removes the cache directories next to it
+ * that haven't been used in PROGRAM_CACHE_MAX_AGE */
+static void
+gsk_gl_device_prune_program_caches (const char *dirname)
+{
+  const char *basename;
+  char *parent, *current;
+  GDir *dir;
+  gint64 now;
+
+  now = g_get_real_time () / G_TIME_SPAN_SECOND;
+  g_utime (dirname, NULL);
+
+  parent = g_path_get_dirname (dirname);
+  current = g_path_get_basename (dirname);
+
+  dir = g_dir_open (parent, 0, NULL);
+  if (dir == NULL)
+    {
+      g_free (current);
+      g_free (parent);
+      return;
+    }
+
+  while ((basename = g_dir_read_name (dir)))
+    {
+      GStatBuf st;
+      char *path;
+
+      if (g_str_equal (basename, current))
+        continue;
+
+      path = g_build_filename (parent, basename, NULL);
+      if (g_file_test (path, G_FILE_TEST_IS_DIR) &&
+          g_stat (path, &st) == 0 &&
+          now - st.st_mtime > PROGRAM_CACHE_MAX_AGE)
+        gsk_gl_device_remove_program_cache_dir (path);
+      g_free (path);
+    }
+
+  g_dir_close (dir);
+  g_free (current);
+  g_free (parent);
+}
+
+static void
+gsk_gl_device_preload_programs_thread (GTask        *task,
+                                       gpointer      source_object,
+                                       gpointer      task_data,
+                                       GCancellable *cancellable)
+{
+  G_GNUC_UNUSED gint64 begin_time = GDK_PROFILER_CURRENT_TIME;
+  GLProgramPreloadData *data = task_data;
+  const char *basename;
+  GDir *dir;
+  guint n_programs = 0;
+
+  gsk_gl_device_prune_program_caches (data->dirname);
+
+  dir = g_dir_open (data->dirname, 0, NULL);
+  if (dir == NULL)
+    {
+      g_task_return_boolean (task, FALSE);
+      return;
+    }
+
+  while ((basename = g_dir_read_name (dir)))
+    {
+      char *path, *contents;
+      gsize size;
+
+      path = g_build_filename (data->dirname, basename, NULL);
+      if (g_file_get_contents (path, &contents, &size, NULL))
+        {
+          /* If the program was compiled in the meantime, this entry
+           * just stays unused */
+          g_mutex_lock (&data->preload->mutex);
+          g_hash_table_insert (data->preload->programs,
+                               g_strdup (basename),
+                               g_bytes_new_take (contents, size));
+          g_mutex_unlock (&data->preload->mutex);
+          n_programs++;
+        }
+      g_free (path);
+    }
+
+  g_dir_close (dir);
+
+  gdk_profiler_end_markf (begin_time, "Preload GL programs", "%u programs", n_programs);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+gsk_gl_device_setup_program_cache (GskGLDevice  *self,
+                                   GdkGLContext *context)
+{
+  GChecksum *checksum;
+  GTask *task;
+  GLint n_formats = 0;
+
+  /* Make sure shaders get compiled so their source can be printed */
+  if (GSK_DEBUG_CHECK (SHADERS))
+    return;
+
+  if (!gdk_gl_context_check_version (context, "4.1", "3.0") &&
+      !epoxy_has_gl_extension ("GL_ARB_get_program_binary"))
+    return;
+
+  glGetIntegerv (GL_NUM_PROGRAM_BINARY_FORMATS, &n_formats);
+  if (n_formats == 0)
+    return;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_checksum_update (checksum, (const guchar *) glGetString (GL_VENDOR), -1);
+  g_checksum_update (checksum, (const guchar *) glGetString (GL_RENDERER), -1);
+  g_checksum_update (checksum, (const guchar *) glGetString (GL_VERSION), -1);
+  g_checksum_update (checksum, (const guchar *) self->version_string, -1);
+  g_checksum_update (checksum, (const guchar *) GTK_VERSION, -1);
+  self->program_cache_dir = g_build_filename (g_get_user_cache_dir (),
+                                              "gtk-4.0",
+                                              "gl-program-cache",
+                                              g_checksum_get_string (checksum),
+                                              NULL);
+  g_checksum_free (checksum);
+
+  /* Read the binaries of previous runs while the application starts up */
+  self->preload = gl_program_preload_new ();
+  task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_source_tag (task, gsk_gl_device_setup_program_cache);
+  g_task_set_task_data (task,
+                        g_memdup2 (&(GLProgramPreloadData) {
+                            .preload = g_atomic_rc_box_acquire (self->preload),
+                            .dirname = g_strdup (self->program_cache_dir),
+                        }, sizeof (GLProgramPreloadData)),
+                        gl_program_preload_data_free);
+  g_task_run_in_thread (task, gsk_gl_device_preload_programs_thread);
+  g_object_unref (task);
+}
+
+static char *
+gsk_gl_device_get_program_cache_name (GskGLDevice               *self,
+                                      const GskGpuShaderOpClass *op_class,
+                                      GskGpuShaderFlags          flags,
+                                      GskGpuColorStates          color_states,
+                                      guint32                    variation)
+{
+  GChecksum *checksum;
+  char *resource_name, *result;
+  GBytes *bytes;
+  guint32 values[3] = { flags, color_states, variation };
+
+  if (self->program_cache_dir == NULL)
+    return NULL;
+
+  resource_name = g_strconcat ("/org/gtk/libgsk/shaders/gl/", op_class->shader_name, ".glsl", NULL);
+  bytes = g_resources_lookup_data (resource_name, 0, NULL);
+  g_free (resource_name);
+  if (bytes == NULL)
+    return NULL;
+
+  /* Include the source, so changed shaders don't use stale binaries */
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_checksum_update (checksum, (const guchar *) op_class->shader_name, -1);
+  g_checksum_update (checksum, (const guchar *) values, sizeof (values));
+  g_checksum_update (checksum, g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes));
+  result = g_strdup (g_checksum_get_string (checksum));
+
+  g_checksum_free (checksum);
+  g_bytes_unref (bytes);
+
+  return result;
+}
+
+static GLuint
+gsk_gl_device_load_program_binary (GskGLDevice *self,
+                                   const char  *cache_name)
+{
+  GBytes *bytes;
+  GLuint program_id;
+  GLint link_status;
+  const guchar *data;
+  gsize size;
+  guint32 format;
+
+  bytes = gl_program_preload_steal (self->preload, cache_name);
+  if (bytes == NULL)
+    {
+      char *path, *contents;
+
+      path = g_build_filename (self->program_cache_dir, cache_name, NULL);
+      if (g_file_get_contents (path, &contents, &size, NULL))
+        bytes = g_bytes_new_take (contents, size);
+      g_free (path);
+
+      if (bytes == NULL)
+        return 0;
+    }
+
+  data = g_bytes_get_data (bytes, &size);
+  if (size <= sizeof (guint32))
+    {
+      g_bytes_unref (bytes);
+      return 0;
+    }
+
+  memcpy (&format, data, sizeof (guint32));
+
+  program_id = glCreateProgram ();
+  glProgramBinary (program_id, format, data + sizeof (guint32), size - sizeof (guint32));
+  g_bytes_unref (bytes);
+
+  /* Drivers reject binaries from other driver versions */
+  glGetProgramiv (program_id, GL_LINK_STATUS, &link_status);
+  if (link_status == GL_FALSE)
+    {
+      GSK_DEBUG (SHADERS, "Program binary %s was rejected", cache_name);
+      glDeleteProgram (program_id);
+      return 0;
+    }
+
+  return program_id;
+}
+
+typedef struct _GLProgramBinaryData GLProgramBinaryData;
+
+struct _GLProgramBinaryData
+{
+  char *path;
+  GBytes *bytes;
+};
+
+static void
+gl_program_binary_data_free (gpointer data)
+{
+  GLProgramBinaryData *binary = data;
+
+  g_free (binary->path);
+  g_bytes_unref (binary->bytes);
+  g_free (binary);
+}
+
+static void
+gsk_gl_device_save_program_binary_thread (GTask        *task,
+                                          gpointer      source_object,
+                                          gpointer      task_data,
+                                          GCancellable *cancellable)
+{
+  GLProgramBinaryData *binary = task_data;
+  GError *error = NULL;
+  char *dirname;
+
+  dirname = g_path_get_dirname (binary->path);
+
+  if (g_mkdir_with_parents (dirname, 0755) != 0)
+    {
+      GSK_DEBUG (SHADERS, "Failed to create program cache directory %s: %s", dirname, g_strerror (errno));
+    }
+  else if (!g_file_set_contents (binary->path,
+                                 g_bytes_get_data (binary->bytes, NULL),
+                                 g_bytes_get_size (binary->bytes),
+                                 &error))
+    {
+      GSK_DEBUG (SHADERS, "Failed to save program binary: %s", error->message);
+      g_clear_error (&error);
+    }
+
+  g_free (dirname);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+gsk_gl_device_save_program_binary (GskGLDevice *self,
+                                   const char  *cache_name,
+                                   GLuint       program_id)
+{
+  GLint length = 0;
+  GLenum format;
+  guint32 format32;
+  guchar *data;
+  GTask *task;
+
+  glGetProgramiv (program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  data = g_malloc (sizeof (guint32) + length);
+  glGetProgramBinary (program_id, length, &length, &format, data + sizeof (guint32));
+  format32 = format;
+  memcpy (data, &format32, sizeof (guint32));
+
+  /* Writing files can take a while, don't block rendering */
+  task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_source_tag (task, gsk_gl_device_save_program_binary);
+  g_task_set_task_data (task,
+                        g_memdup2 (&(GLProgramBinaryData) {
+                            .path = g_build_filename (self->program_cache_dir, cache_name, NULL),
+                            .bytes = g_bytes_new_take (data, sizeof (guint32) + length),
+                        }, sizeof (GLProgramBinaryData)),
+                        gl_program_binary_data_free);
+  g_task_run_in_thread (task, gsk_gl_device_save_program_binary_thread);
+  g_object_unref (task);
+}
+
 GskGpuDevice *
 gsk_gl_device_get_for_display (GdkDisplay  *display,
                                GError     **error)
@@ -267,6 +684,7 @@ gsk_gl_device_get_for_display (GdkDisplay  *display,
   self->version_string = gdk_gl_context_get_glsl_version_string (context);
   self->api = gdk_gl_context_get_api (context);
   gsk_gl_device_setup_samplers (self);
+  gsk_gl_device_setup_program_cache (self, context);
 
   g_object_set_data (G_OBJECT (display), "-gsk-gl-device", self);
 
@@ -477,14 +895,37 @@ gsk_gl_device_load_program (GskGLDevice               *self,
   G_GNUC_UNUSED gint64 begin_time = GDK_PROFILER_CURRENT_TIME;
   GLuint vertex_shader_id, fragment_shader_id, program_id;
   GLint link_status;
+  char *cache_name;
+
+  cache_name = gsk_gl_device_get_program_cache_name (self, op_class, flags, color_states, variation);
+  if (cache_name)
+    {
+      program_id = gsk_gl_device_load_program_binary (self, cache_name);
+      if (program_id)
+        {
+          gdk_profiler_end_markf (begin_time,
+                                  "Load Program Binary",
+                                  "name=%s id=%u",
+                                  op_class->shader_name, program_id);
+          g_free (cache_name);
+          return program_id;
+        }
+    }
 
   vertex_shader_id = gsk_gl_device_load_shader (self, op_class->shader_name, GL_VERTEX_SHADER, flags, color_states, variation, error);
   if (vertex_shader_id == 0)
-    return 0;
+    {
+      g_free (cache_name);
+      return 0;
+    }
 
   fragment_shader_id = gsk_gl_device_load_shader (self, op_class->shader_name, GL_FRAGMENT_SHADER, flags, color_states, variation, error);
   if (fragment_shader_id == 0)
-    return 0;
+    {
+      glDeleteShader (vertex_shader_id);
+      g_free (cache_name);
+      return 0;
+    }
 
   program_id = glCreateProgram ();
 
@@ -493,6 +934,9 @@ gsk_gl_device_load_program (GskGLDevice               *self,
 
   op_class->setup_attrib_locations (program_id);
 
+  if (cache_name)
+    glProgramParameteri (program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
   glLinkProgram (program_id);
 
   glGetProgramiv (program_id, GL_LINK_STATUS, &link_status);
@@ -525,6 +969,7 @@ gsk_gl_device_load_program (GskGLDevice               *self,
       g_free (buffer);
 
       glDeleteProgram (program_id);
+      g_free (cache_name);
 
       return 0;
     }
@@ -534,6 +979,12 @@ gsk_gl_device_load_program (GskGLDevice               *self,
                           "name=%s id=%u frag=%u vert=%u",
                           op_class->shader_name, program_id, fragment_shader_id, vertex_shader_id);
 
+  if (cache_name)
+    {
+      gsk_gl_device_save_program_binary (self, cache_name, program_id);
+      g_free (cache_name);
+    }
+
   return program_id;
 }
 
@@ -13,6 +13,9 @@
 #include "gdkglcontextprivate.h"
 #include "gdkgltextureprivate.h"
 
+/* Timestamp queries per frame, every timed render pass needs 2 */
+#define MAX_TIMESTAMP_QUERIES 256
+
 struct _GskGLFrame
 {
   GskGpuFrame parent_instance;
@@ -20,6 +23,10 @@ struct _GskGLFrame
   guint next_texture_slot;
   GLsync sync;
 
+  GLuint timestamp_queries[MAX_TIMESTAMP_QUERIES];
+  guint n_timestamp_queries;
+  guint n_timestamps;
+
   GHashTable *vaos;
 };
 
@@ -194,20 +201,72 @@ gsk_gl_frame_submit (GskGpuFrame       *frame,
   if (vertex_buffer)
     gsk_gl_buffer_bind (GSK_GL_BUFFER (vertex_buffer));
 
+  self->n_timestamps = 0;
+
   while (op)
     {
       op = gsk_gpu_op_gl_command (op, frame, &state);
     }
 
+  /* Blend ops may have changed it, but GDK expects the default */
+  glBlendEquation (GL_FUNC_ADD);
+
   self->sync = glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 }
 
+static guint
+gsk_gl_frame_write_timestamp (GskGpuFrame *frame)
+{
+  GskGLFrame *self = GSK_GL_FRAME (frame);
+
+  if (self->n_timestamps >= MAX_TIMESTAMP_QUERIES)
+    return G_MAXUINT;
+
+  if (self->n_timestamp_queries == 0)
+    {
+      GdkGLContext *context = GDK_GL_CONTEXT (gsk_gpu_frame_get_context (frame));
+
+      /* GL_TIMESTAMP queries are not part of GLES */
+      if (gdk_gl_context_get_use_es (context) ||
+          !gdk_gl_context_check_version (context, "3.3", "0.0"))
+        return G_MAXUINT;
+
+      glGenQueries (MAX_TIMESTAMP_QUERIES, self->timestamp_queries);
+      self->n_timestamp_queries = MAX_TIMESTAMP_QUERIES;
+    }
+
+  glQueryCounter (self->timestamp_queries[self->n_timestamps], GL_TIMESTAMP);
+
+  return self->n_timestamps++;
+}
+
+static gboolean
+gsk_gl_frame_read_timestamps (GskGpuFrame *frame,
+                              guint64     *timestamps,
+                              guint        n_timestamps)
+{
+  GskGLFrame *self = GSK_GL_FRAME (frame);
+  guint i;
+
+  for (i = 0; i < n_timestamps; i++)
+    {
+      GLuint64 result;
+
+      glGetQueryObjectui64v (self->timestamp_queries[i], GL_QUERY_RESULT, &result);
+      timestamps[i] = result;
+    }
+
+  return TRUE;
+}
+
 static void
 gsk_gl_frame_finalize (GObject *object)
 {
   GskGLFrame *self = GSK_GL_FRAME (object);
 
   g_hash_table_unref (self->vaos);
+  if (self->n_timestamp_queries)
+    glDeleteQueries (self->n_timestamp_queries, self->timestamp_queries);
 
   G_OBJECT_CLASS (gsk_gl_frame_parent_class)->finalize (object);
 }
@@ -227,6 +286,8 @@ gsk_gl_frame_class_init (GskGLFrameClass *klass)
   gpu_frame_class->create_storage_buffer = gsk_gl_frame_create_storage_buffer;
   gpu_frame_class->write_texture_vertex_data = gsk_gl_frame_write_texture_vertex_data;
   gpu_frame_class->submit = gsk_gl_frame_submit;
+  gpu_frame_class->write_timestamp = gsk_gl_frame_write_timestamp;
+  gpu_frame_class->read_timestamps = gsk_gl_frame_read_timestamps;
 
   object_class->finalize = gsk_gl_frame_finalize;
 }
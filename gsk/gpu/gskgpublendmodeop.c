@@ -69,6 +69,8 @@ gsk_gpu_blend_mode_op (GskGpuFrame             *frame,
                            gsk_gpu_color_states_create_equal (TRUE, TRUE),
                            blend_mode,
                            clip,
+                           rect,
+                           offset,
                            (GskGpuImage *[2]) { bottom->image, top->image },
                            (GskGpuSampler[2]) { bottom->sampler, top->sampler },
                            &instance);
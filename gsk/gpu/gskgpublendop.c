@@ -42,6 +42,9 @@ gsk_gpu_blend_op_print (GskGpuOp    *op,
       case GSK_GPU_BLEND_CLEAR:
         gsk_gpu_print_string (string, "clear");
         break;
+      case GSK_GPU_BLEND_MAX:
+        gsk_gpu_print_string (string, "max");
+        break;
       default:
         g_assert_not_reached ();
         break;
@@ -78,19 +81,28 @@ gsk_gpu_blend_op_gl_command (GskGpuOp          *op,
 
       case GSK_GPU_BLEND_OVER:
         glEnable (GL_BLEND);
+        glBlendEquation (GL_FUNC_ADD);
         glBlendFunc (GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
         break;
 
       case GSK_GPU_BLEND_ADD:
         glEnable (GL_BLEND);
+        glBlendEquation (GL_FUNC_ADD);
         glBlendFunc (GL_ONE, GL_ONE);
         break;
 
       case GSK_GPU_BLEND_CLEAR:
         glEnable (GL_BLEND);
+        glBlendEquation (GL_FUNC_ADD);
         glBlendFunc (GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
         break;
 
+      case GSK_GPU_BLEND_MAX:
+        /* The blend factors are ignored for GL_MAX */
+        glEnable (GL_BLEND);
+        glBlendEquation (GL_MAX);
+        break;
+
       default:
         g_assert_not_reached ();
         break;
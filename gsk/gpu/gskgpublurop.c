@@ -71,6 +71,8 @@ gsk_gpu_blur_op (GskGpuFrame             *frame,
                            gsk_gpu_color_states_create_equal (TRUE, TRUE),
                            0,
                            clip,
+                           image->coverage,
+                           offset,
                            (GskGpuImage *[1]) { image->image },
                            (GskGpuSampler[1]) { image->sampler },
                            &instance);
@@ -100,6 +102,8 @@ gsk_gpu_blur_shadow_op (GskGpuFrame             *frame,
                            gsk_gpu_color_states_create (ccs, TRUE, alt, FALSE),
                            VARIATION_COLORIZE,
                            clip,
+                           image->coverage,
+                           offset,
                            (GskGpuImage *[1]) { image->image },
                            (GskGpuSampler[1]) { image->sampler },
                            &instance);
@@ -100,6 +100,8 @@ gsk_gpu_box_shadow_op (GskGpuFrame            *frame,
                            gsk_gpu_color_states_create (ccs, TRUE, alt, FALSE),
                            inset ? VARIATION_INSET : 0,
                            clip,
+                           bounds,
+                           offset,
                            NULL,
                            NULL,
                            &instance);
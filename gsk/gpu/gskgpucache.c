@@ -12,7 +12,9 @@
 #include "gdk/gdktextureprivate.h"
 
 #include "gsk/gskdebugprivate.h"
+#include "gsk/gskpathprivate.h"
 #include "gsk/gskprivate.h"
+#include "gsk/gskstrokeprivate.h"
 
 #define MAX_SLICES_PER_ATLAS 64
 
@@ -24,10 +26,18 @@
 
 #define ATLAS_TIMEOUT_SCALE 4
 
+#define MAX_PATH_SIZE 1024
+
+/* How far outside the glyph the distance field reaches, in pixels
+ * at GSK_GPU_GLYPH_SDF_SIZE */
+#define SDF_GLYPH_RADIUS 8
+
 G_STATIC_ASSERT (MAX_ATLAS_ITEM_SIZE < ATLAS_SIZE);
 G_STATIC_ASSERT (MIN_ALIVE_PIXELS < ATLAS_SIZE * ATLAS_SIZE);
 
 typedef struct _GskGpuCachedGlyph GskGpuCachedGlyph;
+typedef struct _GskGpuCachedPath GskGpuCachedPath;
+typedef struct _GskGpuCachedStaged GskGpuCachedStaged;
 typedef struct _GskGpuCachedTexture GskGpuCachedTexture;
 typedef struct _GskGpuCachedTile GskGpuCachedTile;
 
@@ -45,6 +55,8 @@ struct _GskGpuCache
   GHashTable *ccs_texture_caches[GDK_COLOR_STATE_N_IDS];
   GHashTable *tile_cache;
   GHashTable *glyph_cache;
+  GHashTable *path_cache;
+  GHashTable *staged_cache;
 
   GskGpuCachedAtlas *current_atlas;
 
@@ -737,6 +749,90 @@ gsk_gpu_cache_cache_tile (GskGpuCache      *self,
   gsk_gpu_cached_use (self, (GskGpuCached *) tile);
 }
 
+/* }}} */
+/* {{{ CachedStaged */
+
+struct _GskGpuCachedStaged
+{
+  GskGpuCached parent;
+
+  GdkTexture *texture;
+  GskGpuStagedUpload *upload;
+};
+
+static void
+gsk_gpu_cached_staged_free (GskGpuCache  *cache,
+                            GskGpuCached *cached)
+{
+  GskGpuCachedStaged *self = (GskGpuCachedStaged *) cached;
+
+  g_hash_table_remove (cache->staged_cache, self->texture);
+
+  /* The upload keeps the texture alive */
+  gsk_gpu_staged_upload_unref (self->upload);
+
+  g_free (self);
+}
+
+static gboolean
+gsk_gpu_cached_staged_should_collect (GskGpuCache  *cache,
+                                      GskGpuCached *cached,
+                                      gint64        cache_timeout,
+                                      gint64        timestamp)
+{
+  return gsk_gpu_cached_is_old (cache, cached, cache_timeout, timestamp);
+}
+
+static const GskGpuCachedClass GSK_GPU_CACHED_STAGED_CLASS =
+{
+  sizeof (GskGpuCachedStaged),
+  "Staged",
+  gsk_gpu_cached_staged_free,
+  gsk_gpu_cached_staged_should_collect
+};
+
+GskGpuStagedUpload *
+gsk_gpu_cache_lookup_staged_upload (GskGpuCache *self,
+                                    GdkTexture  *texture)
+{
+  GskGpuCachedStaged *staged;
+
+  staged = g_hash_table_lookup (self->staged_cache, texture);
+  if (staged == NULL)
+    return NULL;
+
+  gsk_gpu_cached_use (self, (GskGpuCached *) staged);
+
+  return staged->upload;
+}
+
+void
+gsk_gpu_cache_cache_staged_upload (GskGpuCache        *self,
+                                   GdkTexture         *texture,
+                                   GskGpuStagedUpload *upload)
+{
+  GskGpuCachedStaged *staged;
+
+  staged = gsk_gpu_cached_new (self, &GSK_GPU_CACHED_STAGED_CLASS);
+  staged->texture = texture;
+  staged->upload = gsk_gpu_staged_upload_ref (upload);
+
+  g_hash_table_insert (self->staged_cache, texture, staged);
+
+  gsk_gpu_cached_use (self, (GskGpuCached *) staged);
+}
+
+void
+gsk_gpu_cache_remove_staged_upload (GskGpuCache *self,
+                                    GdkTexture  *texture)
+{
+  GskGpuCached *staged;
+
+  staged = g_hash_table_lookup (self->staged_cache, texture);
+  if (staged)
+    gsk_gpu_cached_free (self, staged);
+}
+
 /* }}} */
 /* {{{ CachedGlyph */
 
@@ -818,6 +914,159 @@ static const GskGpuCachedClass GSK_GPU_CACHED_GLYPH_CLASS =
   gsk_gpu_cached_glyph_should_collect
 };
 
+/* }}} */
+/* {{{ CachedPath */
+
+struct _GskGpuCachedPath
+{
+  GskGpuCached parent;
+
+  GskPath *path;
+  GskFillRule fill_rule;
+  gboolean is_stroke;
+  GskStroke stroke;
+  float scale_x;
+  float scale_y;
+  GskGpuGlyphLookupFlags flags;
+
+  /* NULL if the path has only been seen, but not drawn yet */
+  GskGpuImage *image;
+  cairo_rectangle_int_t area;
+};
+
+static void
+gsk_gpu_cached_path_free (GskGpuCache  *cache,
+                          GskGpuCached *cached)
+{
+  GskGpuCachedPath *self = (GskGpuCachedPath *) cached;
+
+  g_hash_table_remove (cache->path_cache, self);
+
+  gsk_path_unref (self->path);
+  if (self->is_stroke)
+    gsk_stroke_clear (&self->stroke);
+  g_clear_object (&self->image);
+
+  g_free (self);
+}
+
+static gboolean
+gsk_gpu_cached_path_should_collect (GskGpuCache  *cache,
+                                    GskGpuCached *cached,
+                                    gint64        cache_timeout,
+                                    gint64        timestamp)
+{
+  if (gsk_gpu_cached_is_old (cache, cached, cache_timeout, timestamp))
+    {
+      if (cached->atlas)
+        mark_as_stale (cached, TRUE);
+      else
+        return TRUE;
+    }
+
+  /* Like glyphs, paths in the atlas are collected with their atlas */
+  return FALSE;
+}
+
+static guint
+gsk_gpu_cached_path_hash (gconstpointer data)
+{
+  const GskGpuCachedPath *path = data;
+  guint hash;
+
+  hash = g_direct_hash (path->path) ^
+         (path->flags << 24) ^
+         ((guint) (path->scale_x * 64) << 8) ^
+         (guint) (path->scale_y * 64);
+
+  if (path->is_stroke)
+    hash ^= (guint) (path->stroke.line_width * 64) ^ (path->stroke.line_join << 28) ^ (path->stroke.line_cap << 30);
+  else
+    hash ^= path->fill_rule << 28;
+
+  return hash;
+}
+
+static gboolean
+gsk_gpu_cached_path_equal (gconstpointer v1,
+                           gconstpointer v2)
+{
+  const GskGpuCachedPath *path1 = v1;
+  const GskGpuCachedPath *path2 = v2;
+
+  if (path1->path != path2->path ||
+      path1->is_stroke != path2->is_stroke ||
+      path1->flags != path2->flags ||
+      path1->scale_x != path2->scale_x ||
+      path1->scale_y != path2->scale_y)
+    return FALSE;
+
+  if (path1->is_stroke)
+    return gsk_stroke_equal (&path1->stroke, &path2->stroke);
+  else
+    return path1->fill_rule == path2->fill_rule;
+}
+
+static const GskGpuCachedClass GSK_GPU_CACHED_PATH_CLASS =
+{
+  sizeof (GskGpuCachedPath),
+  "Path",
+  gsk_gpu_cached_path_free,
+  gsk_gpu_cached_path_should_collect
+};
+
+typedef struct _PathDrawData PathDrawData;
+struct _PathDrawData
+{
+  GskPath *path;
+  GskFillRule fill_rule;
+  gboolean is_stroke;
+  GskStroke stroke;
+};
+
+static void
+path_draw_data_free (gpointer data)
+{
+  PathDrawData *draw = data;
+
+  gsk_path_unref (draw->path);
+  if (draw->is_stroke)
+    gsk_stroke_clear (&draw->stroke);
+  g_free (draw);
+}
+
+static void
+path_draw_data_draw (gpointer  data,
+                     cairo_t  *cr)
+{
+  PathDrawData *draw = data;
+
+  gsk_path_to_cairo (draw->path, cr);
+  cairo_set_source_rgba (cr, 1, 1, 1, 1);
+
+  if (draw->is_stroke)
+    {
+      gsk_stroke_to_cairo (&draw->stroke, cr);
+      cairo_stroke (cr);
+    }
+  else
+    {
+      switch (draw->fill_rule)
+        {
+        case GSK_FILL_RULE_WINDING:
+          cairo_set_fill_rule (cr, CAIRO_FILL_RULE_WINDING);
+          break;
+        case GSK_FILL_RULE_EVEN_ODD:
+          cairo_set_fill_rule (cr, CAIRO_FILL_RULE_EVEN_ODD);
+          break;
+        default:
+          g_assert_not_reached ();
+          break;
+        }
+      cairo_fill (cr);
+    }
+}
+
 /* }}} */
 /* {{{ GskGpuCache */
 
@@ -982,6 +1231,8 @@ gsk_gpu_cache_dispose (GObject *object)
 
   gsk_gpu_cache_clear_cache (self);
   g_hash_table_unref (self->glyph_cache);
+  g_hash_table_unref (self->path_cache);
+  g_hash_table_unref (self->staged_cache);
   g_clear_pointer (&self->tile_cache, g_hash_table_unref);
   g_hash_table_unref (self->texture_cache);
 
@@ -1012,6 +1263,10 @@ gsk_gpu_cache_init (GskGpuCache *self)
 {
   self->glyph_cache = g_hash_table_new (gsk_gpu_cached_glyph_hash,
                                         gsk_gpu_cached_glyph_equal);
+  self->path_cache = g_hash_table_new (gsk_gpu_cached_path_hash,
+                                       gsk_gpu_cached_path_equal);
+  self->staged_cache = g_hash_table_new (g_direct_hash,
+                                         g_direct_equal);
   self->texture_cache = g_hash_table_new (g_direct_hash,
                                           g_direct_equal);
 }
@@ -1093,15 +1348,23 @@ gsk_gpu_cache_lookup_glyph_image (GskGpuCache            *self,
       return cache->image;
     }
 
-  /* The combination of hint-style != none and hint-metrics == off
-   * leads to broken rendering with some fonts.
-   */
-  if (gsk_font_get_hint_style (font) != CAIRO_HINT_STYLE_NONE)
-    hint_metrics = CAIRO_HINT_METRICS_ON;
+  if (flags & GSK_GPU_GLYPH_SDF)
+    {
+      /* Distance fields get scaled, so hinting would only hurt */
+      scaled_font = gsk_reload_font (font, scale, CAIRO_HINT_METRICS_OFF, CAIRO_HINT_STYLE_NONE, CAIRO_ANTIALIAS_GRAY);
+    }
   else
-    hint_metrics = CAIRO_HINT_METRICS_DEFAULT;
+    {
+      /* The combination of hint-style != none and hint-metrics == off
+       * leads to broken rendering with some fonts.
+       */
+      if (gsk_font_get_hint_style (font) != CAIRO_HINT_STYLE_NONE)
+        hint_metrics = CAIRO_HINT_METRICS_ON;
+      else
+        hint_metrics = CAIRO_HINT_METRICS_DEFAULT;
 
-  scaled_font = gsk_reload_font (font, scale, hint_metrics, CAIRO_HINT_STYLE_DEFAULT, CAIRO_ANTIALIAS_DEFAULT);
+      scaled_font = gsk_reload_font (font, scale, hint_metrics, CAIRO_HINT_STYLE_DEFAULT, CAIRO_ANTIALIAS_DEFAULT);
+    }
 
   subpixel_x = (flags & 3) / 4.f;
   subpixel_y = ((flags >> 2) & 3) / 4.f;
@@ -1110,7 +1373,17 @@ gsk_gpu_cache_lookup_glyph_image (GskGpuCache            *self,
   origin.y = floor (ink_rect.y * 1.0 / PANGO_SCALE + subpixel_y);
   rect.size.width = ceil ((ink_rect.x + ink_rect.width) * 1.0 / PANGO_SCALE + subpixel_x) - origin.x;
   rect.size.height = ceil ((ink_rect.y + ink_rect.height) * 1.0 / PANGO_SCALE + subpixel_y) - origin.y;
-  padding = 1;
+  if (flags & GSK_GPU_GLYPH_SDF)
+    {
+      /* Leave room for the antialiasing when the glyph gets magnified */
+      origin.x -= 1;
+      origin.y -= 1;
+      rect.size.width += 2;
+      rect.size.height += 2;
+      padding = SDF_GLYPH_RADIUS;
+    }
+  else
+    padding = 1;
 
   image = gsk_gpu_cache_add_atlas_image (self,
                                          rect.size.width + 2 * padding, rect.size.height + 2 * padding,
@@ -1141,18 +1414,33 @@ gsk_gpu_cache_lookup_glyph_image (GskGpuCache            *self,
                                        - origin.y + subpixel_y);
   ((GskGpuCached *) cache)->pixels = (rect.size.width + 2 * padding) * (rect.size.height + 2 * padding);
 
-  gsk_gpu_upload_glyph_op (frame,
-                           cache->image,
-                           scaled_font,
-                           glyph,
-                           &(cairo_rectangle_int_t) {
-                               .x = rect.origin.x - padding,
-                               .y = rect.origin.y - padding,
-                               .width = rect.size.width + 2 * padding,
-                               .height = rect.size.height + 2 * padding,
-                           },
-                           &GRAPHENE_POINT_INIT (cache->origin.x + padding,
-                                                 cache->origin.y + padding));
+  if (flags & GSK_GPU_GLYPH_SDF)
+    gsk_gpu_upload_sdf_glyph_op (frame,
+                                 cache->image,
+                                 scaled_font,
+                                 glyph,
+                                 &(cairo_rectangle_int_t) {
+                                     .x = rect.origin.x - padding,
+                                     .y = rect.origin.y - padding,
+                                     .width = rect.size.width + 2 * padding,
+                                     .height = rect.size.height + 2 * padding,
+                                 },
+                                 &GRAPHENE_POINT_INIT (cache->origin.x + padding,
+                                                       cache->origin.y + padding),
+                                 SDF_GLYPH_RADIUS);
+  else
+    gsk_gpu_upload_glyph_op (frame,
+                             cache->image,
+                             scaled_font,
+                             glyph,
+                             &(cairo_rectangle_int_t) {
+                                 .x = rect.origin.x - padding,
+                                 .y = rect.origin.y - padding,
+                                 .width = rect.size.width + 2 * padding,
+                                 .height = rect.size.height + 2 * padding,
+                             },
+                             &GRAPHENE_POINT_INIT (cache->origin.x + padding,
+                                                   cache->origin.y + padding));
 
   g_hash_table_insert (self->glyph_cache, cache, cache);
   gsk_gpu_cached_use (self, (GskGpuCached *) cache);
@@ -1165,6 +1453,200 @@ gsk_gpu_cache_lookup_glyph_image (GskGpuCache            *self,
   return cache->image;
 }
 
+/* The first pixel of the mask is at quarter_x / 4 - padding in device pixels */
+static void
+gsk_gpu_cache_get_path_rect (int                     quarter_x,
+                             int                     quarter_y,
+                             gsize                   padding,
+                             gsize                   width,
+                             gsize                   height,
+                             float                   scale_x,
+                             float                   scale_y,
+                             const graphene_point_t *offset,
+                             graphene_rect_t        *out_rect)
+{
+  *out_rect = GRAPHENE_RECT_INIT (((quarter_x >> 2) - (float) padding) / scale_x - offset->x,
+                                  ((quarter_y >> 2) - (float) padding) / scale_y - offset->y,
+                                  width / scale_x,
+                                  height / scale_y);
+}
+
+/*
+ * gsk_gpu_cache_lookup_path_image:
+ * @self: a `GskGpuCache`
+ * @frame: the frame to upload the mask with
+ * @path: the path
+ * @fill_rule: the fill rule to use if @stroke is %NULL
+ * @stroke: (nullable): the stroke or %NULL to fill the path
+ * @bounds: the bounds of the filled or stroked path
+ * @scale: the scale the path is drawn with
+ * @offset: the offset the path is drawn with
+ * @draw_func: (nullable): function to draw the mask on the GPU
+ * @draw_data: data to pass to @draw_func
+ * @out_rect: (out): the area of the mask in the coordinate system of @bounds
+ * @out_image_bounds: (out): the bounds of the returned image in the
+ *   coordinate system of @bounds
+ *
+ * Looks up an alpha mask for the filled or stroked path, rasterizing it
+ * if it isn't cached yet.
+ *
+ * If @draw_func is given, the mask is drawn with it, so that cached
+ * paths look the same as paths the GPU draws directly. Those paths are
+ * only cached once they are reused, so animated paths don't fill the
+ * cache. Otherwise the mask is rasterized with cairo.
+ *
+ * Masks are rendered relative to @bounds with the subpixel offset
+ * rounded to quarter pixels, so they are reused when the path is drawn
+ * at a different position. Small masks rasterized with cairo are packed
+ * into the atlas.
+ *
+ * Returns: (transfer none) (nullable): the mask image or %NULL if
+ *   the path is too large to cache, the image could not be created
+ *   or the path has not been used before and @draw_func was given
+ */
+GskGpuImage *
+gsk_gpu_cache_lookup_path_image (GskGpuCache            *self,
+                                 GskGpuFrame            *frame,
+                                 GskPath                *path,
+                                 GskFillRule             fill_rule,
+                                 const GskStroke        *stroke,
+                                 const graphene_rect_t  *bounds,
+                                 const graphene_vec2_t  *scale,
+                                 const graphene_point_t *offset,
+                                 GskGpuPathMaskFunc      draw_func,
+                                 gpointer                draw_data,
+                                 graphene_rect_t        *out_rect,
+                                 graphene_rect_t        *out_image_bounds)
+{
+  GskGpuCachedPath lookup = {
+    .path = path,
+    .fill_rule = fill_rule,
+    .is_stroke = stroke != NULL,
+    .scale_x = graphene_vec2_get_x (scale),
+    .scale_y = graphene_vec2_get_y (scale),
+  };
+  GskGpuCachedPath *cache;
+  GskGpuImage *image;
+  gsize atlas_x, atlas_y, width, height, padding;
+  int quarter_x, quarter_y;
+
+  quarter_x = floorf ((bounds->origin.x + offset->x) * lookup.scale_x * 4 + 0.5f);
+  quarter_y = floorf ((bounds->origin.y + offset->y) * lookup.scale_y * 4 + 0.5f);
+  lookup.flags = (quarter_x & 3) | ((quarter_y & 3) << 2);
+  if (stroke)
+    lookup.stroke = *stroke;
+  padding = 1;
+
+  cache = g_hash_table_lookup (self->path_cache, &lookup);
+  if (cache == NULL || cache->image == NULL)
+    {
+      width = ceilf (bounds->size.width * lookup.scale_x + (quarter_x & 3) / 4.f) + 2 * padding;
+      height = ceilf (bounds->size.height * lookup.scale_y + (quarter_y & 3) / 4.f) + 2 * padding;
+      if (width > MAX_PATH_SIZE || height > MAX_PATH_SIZE)
+        return NULL;
+
+      if (cache)
+        {
+          /* Seen before, so now it's worth rasterizing */
+          gsk_gpu_cached_free (self, (GskGpuCached *) cache);
+          cache = NULL;
+        }
+      else if (draw_func)
+        {
+          cache = gsk_gpu_cached_new (self, &GSK_GPU_CACHED_PATH_CLASS);
+          cache->path = gsk_path_ref (path);
+          cache->fill_rule = fill_rule;
+          cache->is_stroke = stroke != NULL;
+          if (stroke)
+            cache->stroke = GSK_STROKE_INIT_COPY (stroke);
+          cache->scale_x = lookup.scale_x;
+          cache->scale_y = lookup.scale_y;
+          cache->flags = lookup.flags;
+          g_hash_table_insert (self->path_cache, cache, cache);
+          gsk_gpu_cached_use (self, (GskGpuCached *) cache);
+          return NULL;
+        }
+
+      if (draw_func)
+        {
+          graphene_rect_t rect;
+
+          gsk_gpu_cache_get_path_rect (quarter_x, quarter_y, padding, width, height, lookup.scale_x, lookup.scale_y, offset, &rect);
+          image = draw_func (draw_data, &rect);
+          if (image == NULL)
+            return NULL;
+
+          atlas_x = 0;
+          atlas_y = 0;
+          cache = gsk_gpu_cached_new (self, &GSK_GPU_CACHED_PATH_CLASS);
+        }
+      else
+        {
+          image = gsk_gpu_cache_add_atlas_image (self, width, height, &atlas_x, &atlas_y);
+          if (image)
+            {
+              g_object_ref (image);
+              cache = gsk_gpu_cached_new_from_atlas (self, &GSK_GPU_CACHED_PATH_CLASS, self->current_atlas);
+            }
+          else
+            {
+              image = gsk_gpu_device_create_upload_image (self->device, FALSE, GDK_MEMORY_DEFAULT, FALSE, width, height);
+              if (image == NULL)
+                return NULL;
+
+              atlas_x = 0;
+              atlas_y = 0;
+              cache = gsk_gpu_cached_new (self, &GSK_GPU_CACHED_PATH_CLASS);
+            }
+
+          gsk_gpu_upload_cairo_into_op (frame,
+                                        image,
+                                        &(cairo_rectangle_int_t) { atlas_x, atlas_y, width, height },
+                                        scale,
+                                        &GRAPHENE_POINT_INIT (padding + (quarter_x & 3) / 4.f - bounds->origin.x * lookup.scale_x,
+                                                              padding + (quarter_y & 3) / 4.f - bounds->origin.y * lookup.scale_y),
+                                        GSK_GPU_UPLOAD_CAIRO_THREADSAFE,
+                                        path_draw_data_draw,
+                                        g_memdup2 (&(PathDrawData) {
+                                            .path = gsk_path_ref (path),
+                                            .fill_rule = fill_rule,
+                                            .is_stroke = stroke != NULL,
+                                            .stroke = stroke ? GSK_STROKE_INIT_COPY (stroke) : (GskStroke) { 0, },
+                                        }, sizeof (PathDrawData)),
+                                        path_draw_data_free);
+        }
+
+      cache->path = gsk_path_ref (path);
+      cache->fill_rule = fill_rule;
+      cache->is_stroke = stroke != NULL;
+      if (stroke)
+        cache->stroke = GSK_STROKE_INIT_COPY (stroke);
+      cache->scale_x = lookup.scale_x;
+      cache->scale_y = lookup.scale_y;
+      cache->flags = lookup.flags;
+      cache->image = image;
+      cache->area = (cairo_rectangle_int_t) { atlas_x, atlas_y, width, height };
+      ((GskGpuCached *) cache)->pixels = width * height;
+
+      g_hash_table_insert (self->path_cache, cache, cache);
+    }
+
+  gsk_gpu_cached_use (self, (GskGpuCached *) cache);
+
+  gsk_gpu_cache_get_path_rect (quarter_x, quarter_y, padding,
+                               cache->area.width, cache->area.height,
+                               lookup.scale_x, lookup.scale_y,
+                               offset,
+                               out_rect);
+
+  *out_image_bounds = GRAPHENE_RECT_INIT (out_rect->origin.x - cache->area.x / lookup.scale_x,
+                                          out_rect->origin.y - cache->area.y / lookup.scale_y,
+                                          gsk_gpu_image_get_width (cache->image) / lookup.scale_x,
+                                          gsk_gpu_image_get_height (cache->image) / lookup.scale_y);
+
+  return cache->image;
+}
+
 GskGpuCache *
 gsk_gpu_cache_new (GskGpuDevice *device)
 {
@@ -2,6 +2,8 @@
 
 #include "gskgputypesprivate.h"
 
+#include "gsk/gsktypes.h"
+
 #include <graphene.h>
 
 G_BEGIN_DECLS
@@ -10,6 +12,9 @@ typedef struct _GskGpuCached GskGpuCached;
 typedef struct _GskGpuCachedClass GskGpuCachedClass;
 typedef struct _GskGpuCachedAtlas GskGpuCachedAtlas;
 
+typedef GskGpuImage *   (* GskGpuPathMaskFunc)                          (gpointer                user_data,
+                                                                         const graphene_rect_t  *rect);
+
 struct _GskGpuCachedClass
 {
   gsize size;
@@ -88,6 +93,13 @@ void                    gsk_gpu_cache_cache_tile                        (GskGpuC
                                                                          gsize                   tile_id,
                                                                          GskGpuImage            *image,
                                                                          GdkColorState          *color_state);
+GskGpuStagedUpload *    gsk_gpu_cache_lookup_staged_upload              (GskGpuCache            *self,
+                                                                         GdkTexture             *texture);
+void                    gsk_gpu_cache_cache_staged_upload               (GskGpuCache            *self,
+                                                                         GdkTexture             *texture,
+                                                                         GskGpuStagedUpload     *upload);
+void                    gsk_gpu_cache_remove_staged_upload              (GskGpuCache            *self,
+                                                                         GdkTexture             *texture);
 
 typedef enum
 {
@@ -96,9 +108,14 @@ typedef enum
   GSK_GPU_GLYPH_X_OFFSET_3 = 0x3,
   GSK_GPU_GLYPH_Y_OFFSET_1 = 0x4,
   GSK_GPU_GLYPH_Y_OFFSET_2 = 0x8,
-  GSK_GPU_GLYPH_Y_OFFSET_3 = 0xC
+  GSK_GPU_GLYPH_Y_OFFSET_3 = 0xC,
+  GSK_GPU_GLYPH_SDF        = 0x10
 } GskGpuGlyphLookupFlags;
 
+/* Glyphs looked up with GSK_GPU_GLYPH_SDF should use a scale that makes
+ * the font this size, so they can be shared across all scales */
+#define GSK_GPU_GLYPH_SDF_SIZE 64
+
 GskGpuImage *           gsk_gpu_cache_lookup_glyph_image                (GskGpuCache            *self,
                                                                          GskGpuFrame            *frame,
                                                                          PangoFont              *font,
@@ -108,6 +125,18 @@ GskGpuImage *           gsk_gpu_cache_lookup_glyph_image                (GskGpuC
                                                                          graphene_rect_t        *out_bounds,
                                                                          graphene_point_t       *out_origin);
 
+GskGpuImage *           gsk_gpu_cache_lookup_path_image                 (GskGpuCache            *self,
+                                                                         GskGpuFrame            *frame,
+                                                                         GskPath                *path,
+                                                                         GskFillRule             fill_rule,
+                                                                         const GskStroke        *stroke,
+                                                                         const graphene_rect_t  *bounds,
+                                                                         const graphene_vec2_t  *scale,
+                                                                         const graphene_point_t *offset,
+                                                                         GskGpuPathMaskFunc      draw_func,
+                                                                         gpointer                draw_data,
+                                                                         graphene_rect_t        *out_rect,
+                                                                         graphene_rect_t        *out_image_bounds);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GskGpuCache, g_object_unref)
 
@@ -50,22 +50,27 @@ static const GskGpuShaderOpClass GSK_GPU_COLORIZE_OP_CLASS = {
   gsk_gpu_colorize_setup_vao
 };
 
-void
-gsk_gpu_colorize_op2 (GskGpuFrame             *frame,
-                      GskGpuShaderClip         clip,
-                      GskGpuColorStates        color_states,
-                      float                    opacity,
-                      const graphene_point_t  *offset,
-                      const GskGpuShaderImage *image,
-                      const GdkColor          *color)
+#define VARIATION_SDF (1 << 0)
+
+static void
+gsk_gpu_colorize_op_alloc (GskGpuFrame             *frame,
+                           GskGpuShaderClip         clip,
+                           GskGpuColorStates        color_states,
+                           guint32                  variation,
+                           float                    opacity,
+                           const graphene_point_t  *offset,
+                           const GskGpuShaderImage *image,
+                           const GdkColor          *color)
 {
   GskGpuColorizeInstance *instance;
 
   gsk_gpu_shader_op_alloc (frame,
                            &GSK_GPU_COLORIZE_OP_CLASS,
                            color_states,
-                           0,
+                           variation,
                            clip,
+                           image->coverage ? image->coverage : image->bounds,
+                           offset,
                            (GskGpuImage *[1]) { image->image },
                            (GskGpuSampler[1]) { image->sampler },
                            &instance);
@@ -75,6 +80,31 @@ gsk_gpu_colorize_op2 (GskGpuFrame             *frame,
   gsk_gpu_color_to_float (color, gsk_gpu_color_states_get_alt (color_states), opacity, instance->color);
 }
 
+void
+gsk_gpu_colorize_op2 (GskGpuFrame             *frame,
+                      GskGpuShaderClip         clip,
+                      GskGpuColorStates        color_states,
+                      float                    opacity,
+                      const graphene_point_t  *offset,
+                      const GskGpuShaderImage *image,
+                      const GdkColor          *color)
+{
+  gsk_gpu_colorize_op_alloc (frame, clip, color_states, 0, opacity, offset, image, color);
+}
+
+/* Like gsk_gpu_colorize_op2(), but the image is a signed distance field */
+void
+gsk_gpu_colorize_sdf_op (GskGpuFrame             *frame,
+                         GskGpuShaderClip         clip,
+                         GskGpuColorStates        color_states,
+                         float                    opacity,
+                         const graphene_point_t  *offset,
+                         const GskGpuShaderImage *image,
+                         const GdkColor          *color)
+{
+  gsk_gpu_colorize_op_alloc (frame, clip, color_states, VARIATION_SDF, opacity, offset, image, color);
+}
+
 void
 gsk_gpu_colorize_op (GskGpuFrame             *frame,
                      GskGpuShaderClip         clip,
@@ -64,6 +64,8 @@ gsk_gpu_color_matrix_op (GskGpuFrame             *frame,
                            color_states,
                            0,
                            clip,
+                           image->coverage,
+                           offset,
                            (GskGpuImage *[1]) { image->image },
                            (GskGpuSampler[1]) { image->sampler },
                            &instance);
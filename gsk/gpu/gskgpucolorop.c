@@ -69,6 +69,8 @@ gsk_gpu_color_op (GskGpuFrame            *frame,
                            gsk_gpu_color_states_create (ccs, TRUE, alt, FALSE),
                            0,
                            clip,
+                           rect,
+                           offset,
                            NULL,
                            NULL,
                            &instance);
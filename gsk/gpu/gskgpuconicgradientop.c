@@ -77,6 +77,8 @@ gsk_gpu_conic_gradient_op (GskGpuFrame            *frame,
                            gsk_gpu_color_states_create (ccs, TRUE, ics, TRUE),
                            (gsk_gpu_frame_should_optimize (frame, GSK_GPU_OPTIMIZE_GRADIENTS) ? VARIATION_SUPERSAMPLING : 0),
                            clip,
+                           rect,
+                           offset,
                            NULL,
                            NULL,
                            &instance);
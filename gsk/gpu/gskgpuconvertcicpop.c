@@ -79,6 +79,8 @@ gsk_gpu_convert_from_cicp_op (GskGpuFrame             *frame,
                            (opacity < 1.0 ? VARIATION_OPACITY : 0) |
                              (straight_alpha ? VARIATION_STRAIGHT_ALPHA : 0),
                            clip,
+                           image->coverage,
+                           offset,
                            (GskGpuImage *[1]) { image->image },
                            (GskGpuSampler[1]) { image->sampler },
                            &instance);
@@ -109,6 +111,8 @@ gsk_gpu_convert_to_cicp_op (GskGpuFrame             *frame,
                              (straight_alpha ? VARIATION_STRAIGHT_ALPHA : 0) |
                              VARIATION_REVERSE,
                            clip,
+                           image->coverage,
+                           offset,
                            (GskGpuImage *[1]) { image->image },
                            (GskGpuSampler[1]) { image->sampler },
                            &instance);
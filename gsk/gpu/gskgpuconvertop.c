@@ -71,6 +71,8 @@ gsk_gpu_convert_op (GskGpuFrame             *frame,
                            (opacity < 1.0 ? VARIATION_OPACITY : 0) |
                            (straight_alpha ? VARIATION_STRAIGHT_ALPHA : 0),
                            clip,
+                           image->coverage,
+                           offset,
                            (GskGpuImage *[1]) { image->image },
                            (GskGpuSampler[1]) { image->sampler },
                            &instance);
@@ -67,6 +67,8 @@ gsk_gpu_cross_fade_op (GskGpuFrame             *frame,
                            gsk_gpu_color_states_create_equal (TRUE, TRUE),
                            0,
                            clip,
+                           rect,
+                           offset,
                            (GskGpuImage *[2]) { start->image, end->image },
                            (GskGpuSampler[2]) { start->sampler, end->sampler },
                            &instance);
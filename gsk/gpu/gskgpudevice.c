@@ -21,6 +21,8 @@ struct _GskGpuDevicePrivate
   GskGpuCache *cache; /* we don't own a ref, but manage the cache */
   guint cache_gc_source;
   int cache_timeout;  /* in seconds, or -1 to disable gc */
+
+  GRecMutex lock; /* taken while a frame is using the device */
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GskGpuDevice, gsk_gpu_device, G_TYPE_OBJECT)
@@ -37,6 +39,8 @@ gsk_gpu_device_gc (GskGpuDevice *self,
   if (priv->cache == NULL)
     return TRUE;
 
+  gsk_gpu_device_lock (self);
+
   gsk_gpu_device_make_current (self);
 
   result = gsk_gpu_cache_gc (priv->cache,
@@ -45,6 +49,8 @@ gsk_gpu_device_gc (GskGpuDevice *self,
   if (result)
     g_clear_object (&priv->cache);
 
+  gsk_gpu_device_unlock (self);
+
   gdk_profiler_end_mark (before, "Glyph cache GC", NULL);
 
   return result;
@@ -99,6 +105,32 @@ gsk_gpu_device_maybe_gc (GskGpuDevice *self)
     }
 }
 
+/*
+ * gsk_gpu_device_lock:
+ * @self: a device
+ *
+ * Locks the device, its cache and its command submission.
+ *
+ * The device is shared between all renderers of a display, so this
+ * must be held whenever a frame may be recorded or submitted off the
+ * main thread. The lock is recursive.
+ */
+void
+gsk_gpu_device_lock (GskGpuDevice *self)
+{
+  GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
+
+  g_rec_mutex_lock (&priv->lock);
+}
+
+void
+gsk_gpu_device_unlock (GskGpuDevice *self)
+{
+  GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
+
+  g_rec_mutex_unlock (&priv->lock);
+}
+
 void
 gsk_gpu_device_queue_gc (GskGpuDevice *self)
 {
@@ -126,6 +158,7 @@ gsk_gpu_device_finalize (GObject *object)
   GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
 
   g_object_unref (priv->display);
+  g_rec_mutex_clear (&priv->lock);
 
   G_OBJECT_CLASS (gsk_gpu_device_parent_class)->finalize (object);
 }
@@ -142,7 +175,11 @@ gsk_gpu_device_class_init (GskGpuDeviceClass *klass)
 static void
 gsk_gpu_device_init (GskGpuDevice *self)
 {
+  GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
+
+  g_rec_mutex_init (&priv->lock);
 }
+
 void
 gsk_gpu_device_setup (GskGpuDevice *self,
                       GdkDisplay   *display,
@@ -55,6 +55,8 @@ void                    gsk_gpu_device_setup                            (GskGpuD
                                                                          gsize                   tile_size);
 void                    gsk_gpu_device_maybe_gc                         (GskGpuDevice           *self);
 void                    gsk_gpu_device_queue_gc                         (GskGpuDevice           *self);
+void                    gsk_gpu_device_lock                             (GskGpuDevice           *self);
+void                    gsk_gpu_device_unlock                           (GskGpuDevice           *self);
 GdkDisplay *            gsk_gpu_device_get_display                      (GskGpuDevice           *self);
 GskGpuCache *           gsk_gpu_device_get_cache                        (GskGpuDevice           *self);
 gsize                   gsk_gpu_device_get_max_image_size               (GskGpuDevice           *self);
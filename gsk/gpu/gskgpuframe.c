@@ -11,15 +11,21 @@
 #include "gskgpunodeprocessorprivate.h"
 #include "gskgpuopprivate.h"
 #include "gskgpurendererprivate.h"
+#include "gskgpushaderopprivate.h"
 #include "gskgpuuploadopprivate.h"
 
 #include "gskdebugprivate.h"
+#include "gskrectprivate.h"
 #include "gskrendererprivate.h"
+#include "gskrendernodeprivate.h"
 
 #include "gdk/gdkdmabufdownloaderprivate.h"
 #include "gdk/gdkdmabuftextureprivate.h"
 #include "gdk/gdkdrawcontextprivate.h"
+#include "gdk/gdkparalleltaskprivate.h"
+#include "gdk/gdkprofilerprivate.h"
 #include "gdk/gdktexturedownloaderprivate.h"
+#include "gdk/gdktiledtextureprivate.h"
 
 #define DEFAULT_VERTEX_BUFFER_SIZE 128 * 1024
 
@@ -28,12 +34,36 @@
 
 #define DEFAULT_N_GLOBALS (16384 / sizeof (GskGpuGlobalsInstance))
 
+/* How many earlier draws in a row of shader ops to look at when
+ * trying to merge an op into one of them */
+#define MAX_MERGE_DISTANCE 32
+
+/* Textures smaller than this are uploaded right away */
+#define STAGED_UPLOAD_MIN_PIXELS (1024 * 1024)
+
 #define GDK_ARRAY_NAME gsk_gpu_ops
 #define GDK_ARRAY_TYPE_NAME GskGpuOps
 #define GDK_ARRAY_ELEMENT_TYPE guchar
 #define GDK_ARRAY_BY_VALUE 1
 #include "gdk/gdkarrayimpl.c"
 
+typedef struct _GskGpuPassTiming GskGpuPassTiming;
+
+struct _GskGpuPassTiming
+{
+  GskRenderNodeType node_type;
+  guint begin;
+  guint end;
+};
+
+#define GDK_ARRAY_NAME gsk_gpu_pass_timings
+#define GDK_ARRAY_TYPE_NAME GskGpuPassTimings
+#define GDK_ARRAY_ELEMENT_TYPE GskGpuPassTiming
+#define GDK_ARRAY_BY_VALUE 1
+#define GDK_ARRAY_PREALLOC 16
+#define GDK_ARRAY_NO_MEMSET 1
+#include "gdk/gdkarrayimpl.c"
+
 typedef struct _GskGpuFramePrivate GskGpuFramePrivate;
 
 struct _GskGpuFramePrivate
@@ -43,6 +73,7 @@ struct _GskGpuFramePrivate
   GskGpuOptimizations optimizations;
   gsize texture_vertex_size;
   gint64 timestamp;
+  GskRenderPassType pass_type;
 
   GskGpuOps ops;
   GskGpuOp *first_op;
@@ -57,6 +88,15 @@ struct _GskGpuFramePrivate
   GskGpuBuffer *storage_buffer;
   guchar *storage_buffer_data;
   gsize storage_buffer_used;
+
+  guint n_draws_unmerged;
+  guint n_draws;
+
+  GskRenderNodeType current_node_type;
+  gboolean time_passes;
+  gint64 submit_time;
+  GskGpuPassTimings pass_timings;
+  guint n_timestamps;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GskGpuFrame, gsk_gpu_frame, G_TYPE_OBJECT)
@@ -66,6 +106,77 @@ gsk_gpu_frame_default_setup (GskGpuFrame *self)
 {
 }
 
+static const char *
+gsk_gpu_frame_get_node_type_name (GskRenderNodeType node_type)
+{
+  GEnumClass *class;
+  GEnumValue *value;
+  const char *name;
+
+  if (node_type == GSK_NOT_A_RENDER_NODE)
+    return "frame";
+
+  class = g_type_class_ref (GSK_TYPE_RENDER_NODE_TYPE);
+  value = g_enum_get_value (class, node_type);
+  name = value->value_nick;
+  g_type_class_unref (class);
+
+  return name;
+}
+
+/* Reads back the timestamps of the last submit and reports the
+ * time taken by each render pass. The frame must be idle.
+ */
+static void
+gsk_gpu_frame_report_pass_timings (GskGpuFrame *self)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+  gint64 gpu_time[GSK_RENDER_NODE_TYPE_N_TYPES] = { 0, };
+  guint64 *timestamps;
+  gsize i;
+
+  if (gsk_gpu_pass_timings_get_size (&priv->pass_timings) == 0)
+    return;
+
+  timestamps = g_new (guint64, priv->n_timestamps);
+
+  if (GSK_GPU_FRAME_GET_CLASS (self)->read_timestamps (self, timestamps, priv->n_timestamps))
+    {
+      for (i = 0; i < gsk_gpu_pass_timings_get_size (&priv->pass_timings); i++)
+        {
+          const GskGpuPassTiming *timing = gsk_gpu_pass_timings_index (&priv->pass_timings, i);
+          G_GNUC_UNUSED guint64 begin;
+          guint64 duration;
+
+          if (timing->end == G_MAXUINT)
+            continue;
+
+          begin = timestamps[timing->begin] - timestamps[0];
+          duration = timestamps[timing->end] - timestamps[timing->begin];
+          gpu_time[timing->node_type] += duration;
+
+          /* The GPU clock is not the CPU clock, so the marks are
+           * aligned to the time the frame was submitted. */
+          gdk_profiler_add_mark (priv->submit_time + begin,
+                                 duration,
+                                 "GPU render pass",
+                                 gsk_gpu_frame_get_node_type_name (timing->node_type));
+        }
+
+      for (i = 0; i < GSK_RENDER_NODE_TYPE_N_TYPES; i++)
+        {
+          gsk_gpu_renderer_set_gpu_time (priv->renderer,
+                                         i,
+                                         gsk_gpu_frame_get_node_type_name (i),
+                                         gpu_time[i] / 1000);
+        }
+    }
+
+  g_free (timestamps);
+  gsk_gpu_pass_timings_set_size (&priv->pass_timings, 0);
+  priv->n_timestamps = 0;
+}
+
 static void
 gsk_gpu_frame_default_cleanup (GskGpuFrame *self)
 {
@@ -73,6 +184,8 @@ gsk_gpu_frame_default_cleanup (GskGpuFrame *self)
   GskGpuOp *op;
   gsize i;
 
+  gsk_gpu_frame_report_pass_timings (self);
+
   priv->n_globals = 0;
 
   for (i = 0; i < gsk_gpu_ops_get_size (&priv->ops); i += op->op_class->size)
@@ -104,6 +217,20 @@ gsk_gpu_frame_default_end (GskGpuFrame    *self,
   gdk_draw_context_end_frame_full (context);
 }
 
+static guint
+gsk_gpu_frame_default_write_timestamp (GskGpuFrame *self)
+{
+  return G_MAXUINT;
+}
+
+static gboolean
+gsk_gpu_frame_default_read_timestamps (GskGpuFrame *self,
+                                       guint64     *timestamps,
+                                       guint        n_timestamps)
+{
+  return FALSE;
+}
+
 static gboolean
 gsk_gpu_frame_is_clean (GskGpuFrame *self)
 {
@@ -146,6 +273,7 @@ gsk_gpu_frame_finalize (GObject *object)
   GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
 
   gsk_gpu_ops_clear (&priv->ops);
+  gsk_gpu_pass_timings_clear (&priv->pass_timings);
 
   g_clear_object (&priv->vertex_buffer);
   g_clear_object (&priv->globals_buffer);
@@ -166,6 +294,8 @@ gsk_gpu_frame_class_init (GskGpuFrameClass *klass)
   klass->begin = gsk_gpu_frame_default_begin;
   klass->end = gsk_gpu_frame_default_end;
   klass->upload_texture = gsk_gpu_frame_default_upload_texture;
+  klass->write_timestamp = gsk_gpu_frame_default_write_timestamp;
+  klass->read_timestamps = gsk_gpu_frame_default_read_timestamps;
 
   object_class->dispose = gsk_gpu_frame_dispose;
   object_class->finalize = gsk_gpu_frame_finalize;
@@ -177,6 +307,7 @@ gsk_gpu_frame_init (GskGpuFrame *self)
   GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
 
   gsk_gpu_ops_init (&priv->ops);
+  gsk_gpu_pass_timings_init (&priv->pass_timings);
 }
 
 void
@@ -316,6 +447,62 @@ gsk_gpu_frame_seal_ops (GskGpuFrame *self)
     }
 }
 
+typedef struct
+{
+  GskGpuOp **ops;
+  guint n_ops;
+  int next_op; /* atomic */
+} PrepareData;
+
+static void
+gsk_gpu_frame_prepare_ops_thread (gpointer data)
+{
+  PrepareData *prepare = data;
+  guint i;
+
+  for (i = g_atomic_int_add (&prepare->next_op, 1);
+       i < prepare->n_ops;
+       i = g_atomic_int_add (&prepare->next_op, 1))
+    {
+      GskGpuOp *op = prepare->ops[i];
+
+      op->op_class->prepare (op);
+    }
+}
+
+/* Runs the CPU-heavy parts of ops, like rasterizing with cairo,
+ * in parallel before commands get recorded.
+ */
+static void
+gsk_gpu_frame_prepare_ops (GskGpuFrame *self)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+  G_GNUC_UNUSED gint64 begin_time = GDK_PROFILER_CURRENT_TIME;
+  PrepareData prepare = { NULL, 0, 0 };
+  GPtrArray *ops;
+  GskGpuOp *op;
+
+  ops = g_ptr_array_new ();
+  for (op = priv->first_op; op; op = op->next)
+    {
+      if (op->op_class->prepare)
+        g_ptr_array_add (ops, op);
+    }
+
+  prepare.ops = (GskGpuOp **) ops->pdata;
+  prepare.n_ops = ops->len;
+
+  if (prepare.n_ops > 1 && gsk_gpu_frame_should_optimize (self, GSK_GPU_OPTIMIZE_THREADS))
+    gdk_parallel_task_run (gsk_gpu_frame_prepare_ops_thread, &prepare);
+  else if (prepare.n_ops > 0)
+    gsk_gpu_frame_prepare_ops_thread (&prepare);
+
+  if (prepare.n_ops > 0)
+    gdk_profiler_end_markf (begin_time, "Prepare ops", "%u ops", prepare.n_ops);
+
+  g_ptr_array_unref (ops);
+}
+
 typedef struct 
 {
   struct {
@@ -489,6 +676,11 @@ gsk_gpu_frame_do_upload_texture (GskGpuFrame  *self,
   GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
   GskGpuImage *image;
 
+  /* Tiled textures are only ever drawn tile by tile, so only the
+   * visible parts get loaded */
+  if (GDK_IS_TILED_TEXTURE (texture))
+    return NULL;
+
   image = GSK_GPU_FRAME_GET_CLASS (self)->upload_texture (self, with_mipmap, texture);
 
   if (image == NULL && !dmabuf_import)
@@ -508,6 +700,89 @@ gsk_gpu_frame_upload_texture (GskGpuFrame  *self,
   return gsk_gpu_frame_do_upload_texture (self, FALSE, with_mipmap, texture);
 }
 
+static gboolean
+gsk_gpu_frame_should_stage_texture (GskGpuFrame *self,
+                                    GdkTexture  *texture)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+
+  /* Exported frames must be complete, so only presented frames can
+   * skip textures and redraw when they are ready */
+  if (priv->pass_type != GSK_RENDER_PASS_PRESENT ||
+      !gsk_gpu_frame_should_optimize (self, GSK_GPU_OPTIMIZE_ASYNC_UPLOAD))
+    return FALSE;
+
+  /* Other textures need the GPU context for the upload */
+  if (!GDK_IS_MEMORY_TEXTURE (texture))
+    return FALSE;
+
+  return (gsize) gdk_texture_get_width (texture) * gdk_texture_get_height (texture) >= STAGED_UPLOAD_MIN_PIXELS;
+}
+
+/*
+ * gsk_gpu_frame_upload_texture_async:
+ * @self: a frame
+ * @with_mipmap: if the image should be able to mipmap
+ * @texture: the texture to upload
+ * @out_pending: (out): set to %TRUE if the texture is still
+ *   being converted
+ *
+ * Like gsk_gpu_frame_upload_texture(), but large textures are converted
+ * on a worker thread instead of stalling the frame.
+ *
+ * While that is happening, %NULL is returned, @out_pending is set and
+ * the caller is expected to draw a placeholder. Once the texture is
+ * ready, the surface is invalidated so a new frame gets drawn.
+ *
+ * Returns: (nullable): the image for the texture
+ **/
+GskGpuImage *
+gsk_gpu_frame_upload_texture_async (GskGpuFrame  *self,
+                                    gboolean      with_mipmap,
+                                    GdkTexture   *texture,
+                                    gboolean     *out_pending)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+  GskGpuCache *cache;
+  GskGpuStagedUpload *upload;
+  GskGpuImage *image;
+
+  *out_pending = FALSE;
+
+  if (!gsk_gpu_frame_should_stage_texture (self, texture))
+    return gsk_gpu_frame_upload_texture (self, with_mipmap, texture);
+
+  cache = gsk_gpu_device_get_cache (priv->device);
+  upload = gsk_gpu_cache_lookup_staged_upload (cache, texture);
+  if (upload == NULL)
+    {
+      upload = gsk_gpu_staged_upload_new (self,
+                                          with_mipmap,
+                                          texture,
+                                          gsk_renderer_get_surface (GSK_RENDERER (priv->renderer)));
+      /* Happens ie for oversized textures */
+      if (upload == NULL)
+        return NULL;
+
+      gsk_gpu_cache_cache_staged_upload (cache, texture, upload);
+      gsk_gpu_staged_upload_unref (upload);
+      *out_pending = TRUE;
+      return NULL;
+    }
+
+  if (!gsk_gpu_staged_upload_is_ready (upload))
+    {
+      *out_pending = TRUE;
+      return NULL;
+    }
+
+  image = gsk_gpu_upload_staged_op (self, upload);
+  gsk_gpu_cache_cache_texture_image (cache, texture, image, NULL);
+  gsk_gpu_cache_remove_staged_upload (cache, texture);
+
+  return image;
+}
+
 static GskGpuBuffer *
 gsk_gpu_frame_create_vertex_buffer (GskGpuFrame *self,
                                     gsize        size)
@@ -544,9 +819,10 @@ gsk_gpu_frame_get_texture_vertex_size (GskGpuFrame *self,
   return priv->texture_vertex_size * n_textures;
 }
 
-gsize
-gsk_gpu_frame_reserve_vertex_data (GskGpuFrame *self,
-                                   gsize        size)
+static gsize
+gsk_gpu_frame_reserve_vertex_data_aligned (GskGpuFrame *self,
+                                           gsize        size,
+                                           gsize        alignment)
 {
   GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
   gsize size_needed;
@@ -554,12 +830,17 @@ gsk_gpu_frame_reserve_vertex_data (GskGpuFrame *self,
   if (priv->vertex_buffer == NULL)
     priv->vertex_buffer = gsk_gpu_frame_create_vertex_buffer (self, DEFAULT_VERTEX_BUFFER_SIZE);
 
-  size_needed = round_up (priv->vertex_buffer_used, size) + size;
+  size_needed = round_up (priv->vertex_buffer_used, alignment) + size;
 
   if (gsk_gpu_buffer_get_size (priv->vertex_buffer) < size_needed)
     {
       gsize old_size = gsk_gpu_buffer_get_size (priv->vertex_buffer);
-      GskGpuBuffer *new_buffer = gsk_gpu_frame_create_vertex_buffer (self, old_size * 2);
+      gsize new_size = old_size * 2;
+      GskGpuBuffer *new_buffer;
+
+      while (new_size < size_needed)
+        new_size *= 2;
+      new_buffer = gsk_gpu_frame_create_vertex_buffer (self, new_size);
       guchar *new_data = gsk_gpu_buffer_map (new_buffer);
 
       if (priv->vertex_buffer_data)
@@ -577,6 +858,302 @@ gsk_gpu_frame_reserve_vertex_data (GskGpuFrame *self,
   return size_needed - size;
 }
 
+gsize
+gsk_gpu_frame_reserve_vertex_data (GskGpuFrame *self,
+                                   gsize        size)
+{
+  return gsk_gpu_frame_reserve_vertex_data_aligned (self, size, size);
+}
+
+typedef struct _GskGpuMergeGroup GskGpuMergeGroup;
+
+struct _GskGpuMergeGroup
+{
+  GskGpuShaderOp *leader;
+  GskGpuShaderOp *first_member;         /* chained via parent_op.next */
+  GskGpuShaderOp *last_member;
+  graphene_rect_t bounds;
+};
+
+static gboolean
+gsk_gpu_merge_bounds_intersect (const graphene_rect_t *a,
+                                const graphene_rect_t *b,
+                                const graphene_vec2_t *scale)
+{
+  cairo_rectangle_int_t ia, ib;
+  graphene_rect_t tmp;
+
+  /* Shaders round their area out to full pixels in the scaled
+   * coordinate system, so only ops that don't touch the same pixel
+   * are independent. */
+  gsk_rect_scale (a, graphene_vec2_get_x (scale), graphene_vec2_get_y (scale), &tmp);
+  gsk_rect_to_cairo_grow (&tmp, &ia);
+  gsk_rect_scale (b, graphene_vec2_get_x (scale), graphene_vec2_get_y (scale), &tmp);
+  gsk_rect_to_cairo_grow (&tmp, &ib);
+
+  return gdk_rectangle_intersect (&ia, &ib, NULL);
+}
+
+/* Appends the groups to the op list and copies the vertex data of
+ * every group with more than one op next to each other, so that the
+ * leader can draw all of it with a single draw call.
+ */
+static GskGpuOp *
+gsk_gpu_frame_flush_merge_groups (GskGpuFrame *self,
+                                  GArray      *groups,
+                                  GskGpuOp    *last)
+{
+  guint i;
+
+  for (i = 0; i < groups->len; i++)
+    {
+      GskGpuMergeGroup *group = &g_array_index (groups, GskGpuMergeGroup, i);
+      GskGpuShaderOp *leader = group->leader;
+
+      if (group->first_member)
+        {
+          const GskGpuShaderOpClass *shader_op_class = (const GskGpuShaderOpClass *) leader->parent_op.op_class;
+          GskGpuShaderOp *member;
+          gsize vertex_size, n_ops, offset;
+          guchar *data;
+
+          vertex_size = gsk_gpu_frame_get_texture_vertex_size (self, shader_op_class->n_textures) + shader_op_class->vertex_size;
+          n_ops = leader->n_ops;
+          for (member = group->first_member; member; member = (GskGpuShaderOp *) member->parent_op.next)
+            n_ops += member->n_ops;
+
+          offset = gsk_gpu_frame_reserve_vertex_data_aligned (self, n_ops * vertex_size, vertex_size);
+          data = gsk_gpu_frame_get_vertex_data (self, offset);
+
+          memcpy (data,
+                  gsk_gpu_frame_get_vertex_data (self, leader->vertex_offset),
+                  leader->n_ops * vertex_size);
+          data += leader->n_ops * vertex_size;
+          for (member = group->first_member; member; member = (GskGpuShaderOp *) member->parent_op.next)
+            {
+              memcpy (data,
+                      gsk_gpu_frame_get_vertex_data (self, member->vertex_offset),
+                      member->n_ops * vertex_size);
+              data += member->n_ops * vertex_size;
+            }
+
+          leader->vertex_offset = offset;
+          leader->n_ops = n_ops;
+          leader->bounds = group->bounds;
+        }
+
+      last->next = (GskGpuOp *) leader;
+      last = (GskGpuOp *) leader;
+    }
+
+  g_array_set_size (groups, 0);
+
+  return last;
+}
+
+/*
+ * Ops only get merged into a single draw call at record time when
+ * they are recorded right after each other. But offscreens get
+ * sorted out of the pass and unrelated ops get recorded in between,
+ * so after sorting there are often compatible ops close to each
+ * other.
+ *
+ * In every row of shader ops between two command ops (which change
+ * the scissor, blend mode or globals) this moves ops to an earlier
+ * compatible op when no op drawn in between touches the same pixels
+ * and then merges their vertex data.
+ */
+static void
+gsk_gpu_frame_merge_ops (GskGpuFrame *self)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+  GskGpuOp start = { NULL, priv->first_op };
+  GskGpuOp *op, *next, *last;
+  graphene_vec2_t scale;
+  gboolean has_scale, axis_aligned;
+  GArray *groups;
+
+  priv->n_draws_unmerged = 0;
+  priv->n_draws = 0;
+
+  groups = g_array_new (FALSE, FALSE, sizeof (GskGpuMergeGroup));
+  has_scale = FALSE;
+  last = &start;
+
+  for (op = priv->first_op; op; op = next)
+    {
+      GskGpuShaderOp *shader;
+      GskGpuMergeGroup *group;
+      int i;
+
+      next = op->next;
+
+      if (op->op_class->stage != GSK_GPU_STAGE_SHADER)
+        {
+          last = gsk_gpu_frame_flush_merge_groups (self, groups, last);
+          last->next = op;
+          last = op;
+          /* Bounds can only be compared if they map to pixels by scaling */
+          if (gsk_gpu_globals_op_get_scale (op, &scale, &axis_aligned))
+            has_scale = axis_aligned;
+          continue;
+        }
+
+      shader = (GskGpuShaderOp *) op;
+      priv->n_draws_unmerged++;
+
+      group = NULL;
+      if (has_scale && gsk_gpu_frame_should_optimize (self, GSK_GPU_OPTIMIZE_MERGE))
+        {
+          for (i = (int) groups->len - 1; i >= 0 && i >= (int) groups->len - MAX_MERGE_DISTANCE; i--)
+            {
+              GskGpuMergeGroup *candidate = &g_array_index (groups, GskGpuMergeGroup, i);
+
+              if (gsk_gpu_shader_op_can_merge (candidate->leader, shader))
+                {
+                  group = candidate;
+                  break;
+                }
+
+              if (gsk_gpu_merge_bounds_intersect (&candidate->bounds, &shader->bounds, &scale))
+                break;
+            }
+        }
+
+      op->next = NULL;
+      if (group)
+        {
+          if (group->last_member)
+            group->last_member->parent_op.next = op;
+          else
+            group->first_member = shader;
+          group->last_member = shader;
+          graphene_rect_union (&group->bounds, &shader->bounds, &group->bounds);
+        }
+      else
+        {
+          g_array_append_vals (groups,
+                               &(GskGpuMergeGroup) {
+                                   .leader = shader,
+                                   .bounds = shader->bounds,
+                               },
+                               1);
+          priv->n_draws++;
+        }
+    }
+
+  last = gsk_gpu_frame_flush_merge_groups (self, groups, last);
+  last->next = NULL;
+  priv->first_op = start.next;
+
+  g_array_unref (groups);
+}
+
+/*
+ * gsk_gpu_frame_get_n_draws:
+ * @self: a frame
+ * @out_unmerged: (out) (optional): the number of draws before merging
+ *
+ * Gets the number of draw calls issued by the last submitted frame.
+ *
+ * Every shader op is counted as one draw, ignoring the splitting of
+ * huge merged ops.
+ *
+ * Returns: the number of draws
+ **/
+guint
+gsk_gpu_frame_get_n_draws (GskGpuFrame *self,
+                           guint       *out_unmerged)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+
+  if (out_unmerged)
+    *out_unmerged = priv->n_draws_unmerged;
+
+  return priv->n_draws;
+}
+
+/*
+ * gsk_gpu_frame_get_current_node_type:
+ * @self: the frame
+ *
+ * Gets the type of the node that is currently being recorded.
+ * Render passes get attributed to it when timing them.
+ *
+ * Returns: the node type or GSK_NOT_A_RENDER_NODE while
+ *   recording the main pass
+ */
+GskRenderNodeType
+gsk_gpu_frame_get_current_node_type (GskGpuFrame *self)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+
+  return priv->current_node_type;
+}
+
+void
+gsk_gpu_frame_set_current_node_type (GskGpuFrame       *self,
+                                     GskRenderNodeType  node_type)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+
+  priv->current_node_type = node_type;
+}
+
+/*
+ * gsk_gpu_frame_begin_pass_timing:
+ * @self: the frame
+ * @node_type: the node type to attribute the pass to
+ *
+ * Writes a timestamp before a render pass if timing is enabled for
+ * this submit. Must be called outside of a render pass while
+ * executing commands.
+ *
+ * Returns: An id to pass to gsk_gpu_frame_end_pass_timing()
+ */
+guint
+gsk_gpu_frame_begin_pass_timing (GskGpuFrame       *self,
+                                 GskRenderNodeType  node_type)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+  guint begin;
+
+  if (!priv->time_passes)
+    return G_MAXUINT;
+
+  begin = GSK_GPU_FRAME_GET_CLASS (self)->write_timestamp (self);
+  if (begin == G_MAXUINT)
+    return G_MAXUINT;
+
+  priv->n_timestamps = MAX (priv->n_timestamps, begin + 1);
+  gsk_gpu_pass_timings_append (&priv->pass_timings,
+                               &(GskGpuPassTiming) {
+                                   .node_type = node_type,
+                                   .begin = begin,
+                                   .end = G_MAXUINT,
+                               });
+
+  return gsk_gpu_pass_timings_get_size (&priv->pass_timings) - 1;
+}
+
+void
+gsk_gpu_frame_end_pass_timing (GskGpuFrame *self,
+                               guint        timing)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+  guint end;
+
+  if (timing == G_MAXUINT)
+    return;
+
+  end = GSK_GPU_FRAME_GET_CLASS (self)->write_timestamp (self);
+  if (end == G_MAXUINT)
+    return;
+
+  priv->n_timestamps = MAX (priv->n_timestamps, end + 1);
+  gsk_gpu_pass_timings_get (&priv->pass_timings, timing)->end = end;
+}
+
 gsize
 gsk_gpu_frame_add_globals (GskGpuFrame                 *self,
                            const GskGpuGlobalsInstance *globals)
@@ -721,12 +1298,12 @@ gsk_gpu_frame_record (GskGpuFrame            *self,
                       GdkTexture            **texture)
 {
   GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
-  GskRenderPassType pass_type = texture ? GSK_RENDER_PASS_EXPORT : GSK_RENDER_PASS_PRESENT;
 
   priv->timestamp = timestamp;
+  priv->pass_type = texture ? GSK_RENDER_PASS_EXPORT : GSK_RENDER_PASS_PRESENT;
   gsk_gpu_cache_set_time (gsk_gpu_device_get_cache (priv->device), timestamp);
 
-  gsk_gpu_node_processor_process (self, target, target_color_state, clip, node, viewport, pass_type);
+  gsk_gpu_node_processor_process (self, target, target_color_state, clip, node, viewport, priv->pass_type);
 
   if (texture)
     gsk_gpu_download_op (self, target, target_color_state, texture);
@@ -739,8 +1316,10 @@ gsk_gpu_frame_submit (GskGpuFrame       *self,
   GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
 
   gsk_gpu_frame_seal_ops (self);
+  gsk_gpu_frame_prepare_ops (self);
   gsk_gpu_frame_verbose_print (self, "start of frame");
   gsk_gpu_frame_sort_ops (self);
+  gsk_gpu_frame_merge_ops (self);
   gsk_gpu_frame_verbose_print (self, "after sort");
 
   if (priv->vertex_buffer)
@@ -763,6 +1342,10 @@ gsk_gpu_frame_submit (GskGpuFrame       *self,
       priv->storage_buffer_used = 0;
     }
 
+  priv->time_passes = GDK_PROFILER_IS_RUNNING ||
+                      GSK_RENDERER_DEBUG_CHECK (GSK_RENDERER (priv->renderer), GPU_TIMING);
+  priv->submit_time = GDK_PROFILER_CURRENT_TIME;
+
   GSK_GPU_FRAME_GET_CLASS (self)->submit (self,
                                           pass_type,
                                           priv->vertex_buffer,
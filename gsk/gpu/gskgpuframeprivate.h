@@ -53,6 +53,10 @@ struct _GskGpuFrameClass
                                                                          GskGpuBuffer           *vertex_buffer,
                                                                          GskGpuBuffer           *globals_buffer,
                                                                          GskGpuOp               *op);
+  guint                 (* write_timestamp)                             (GskGpuFrame            *self);
+  gboolean              (* read_timestamps)                             (GskGpuFrame            *self,
+                                                                         guint64                *timestamps,
+                                                                         guint                   n_timestamps);
 };
 
 GType                   gsk_gpu_frame_get_type                          (void) G_GNUC_CONST;
@@ -86,6 +90,10 @@ gpointer                gsk_gpu_frame_alloc_op                          (GskGpuF
 GskGpuImage *           gsk_gpu_frame_upload_texture                    (GskGpuFrame            *self,
                                                                          gboolean                with_mipmap,
                                                                          GdkTexture             *texture);
+GskGpuImage *           gsk_gpu_frame_upload_texture_async              (GskGpuFrame            *self,
+                                                                         gboolean                with_mipmap,
+                                                                         GdkTexture             *texture,
+                                                                         gboolean               *out_pending);
 gsize                   gsk_gpu_frame_reserve_vertex_data               (GskGpuFrame            *self,
                                                                          gsize                   size);
 guchar *                gsk_gpu_frame_get_vertex_data                   (GskGpuFrame            *self,
@@ -104,6 +112,16 @@ GskGpuBuffer *          gsk_gpu_frame_write_storage_buffer              (GskGpuF
 
 gboolean                gsk_gpu_frame_is_busy                           (GskGpuFrame            *self);
 void                    gsk_gpu_frame_wait                              (GskGpuFrame            *self);
+guint                   gsk_gpu_frame_get_n_draws                       (GskGpuFrame            *self,
+                                                                         guint                  *out_unmerged);
+
+GskRenderNodeType       gsk_gpu_frame_get_current_node_type             (GskGpuFrame            *self);
+void                    gsk_gpu_frame_set_current_node_type             (GskGpuFrame            *self,
+                                                                         GskRenderNodeType       node_type);
+guint                   gsk_gpu_frame_begin_pass_timing                 (GskGpuFrame            *self,
+                                                                         GskRenderNodeType       node_type);
+void                    gsk_gpu_frame_end_pass_timing                   (GskGpuFrame            *self,
+                                                                         guint                   timing);
 
 void                    gsk_gpu_frame_render                            (GskGpuFrame            *self,
                                                                          gint64                  timestamp,
@@ -102,3 +102,41 @@ gsk_gpu_globals_op (GskGpuFrame             *frame,
   graphene_vec2_to_float (scale, self->instance.scale);
   self->id = gsk_gpu_frame_add_globals (frame, &self->instance);
 }
+
+/*
+ * gsk_gpu_globals_op_get_scale:
+ * @op: an op
+ * @scale: (out): the scale set by the op
+ * @axis_aligned: (out): %TRUE if the transform set by the op only
+ *   scales and translates
+ *
+ * Queries the scale if @op is a globals op.
+ *
+ * When the transform is not axis-aligned, rectangles in the basic
+ * coordinate system don't map to the pixels they cover by just
+ * scaling them.
+ *
+ * Returns: %TRUE if @op is a globals op
+ */
+gboolean
+gsk_gpu_globals_op_get_scale (GskGpuOp        *op,
+                              graphene_vec2_t *scale,
+                              gboolean        *axis_aligned)
+{
+  GskGpuGlobalsOp *self = (GskGpuGlobalsOp *) op;
+  graphene_matrix_t mvp;
+
+  if (op->op_class != &GSK_GPU_GLOBALS_OP_CLASS)
+    return FALSE;
+
+  graphene_vec2_init (scale, self->instance.scale[0], self->instance.scale[1]);
+
+  /* No rotation, skew or perspective in the x/y plane */
+  graphene_matrix_init_from_float (&mvp, self->instance.mvp);
+  *axis_aligned = graphene_matrix_get_value (&mvp, 0, 1) == 0 &&
+                  graphene_matrix_get_value (&mvp, 1, 0) == 0 &&
+                  graphene_matrix_get_value (&mvp, 0, 3) == 0 &&
+                  graphene_matrix_get_value (&mvp, 1, 3) == 0;
+
+  return TRUE;
+}
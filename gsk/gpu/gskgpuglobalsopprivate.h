@@ -23,6 +23,10 @@ void                    gsk_gpu_globals_op                              (GskGpuF
                                                                          const graphene_matrix_t        *mvp,
                                                                          const GskRoundedRect           *clip);
 
+gboolean                gsk_gpu_globals_op_get_scale                    (GskGpuOp                       *op,
+                                                                         graphene_vec2_t                *scale,
+                                                                         gboolean                       *axis_aligned);
+
 
 G_END_DECLS
 
@@ -153,6 +153,8 @@ gsk_gpu_linear_gradient_op (GskGpuFrame            *frame,
                            (repeating ? VARIATION_REPEATING : 0) |
                            (gsk_gpu_frame_should_optimize (frame, GSK_GPU_OPTIMIZE_GRADIENTS) ? VARIATION_SUPERSAMPLING : 0),
                            clip,
+                           rect,
+                           offset,
                            NULL,
                            NULL,
                            &instance);
@@ -68,6 +68,8 @@ gsk_gpu_mask_op (GskGpuFrame             *frame,
                            gsk_gpu_color_states_create_equal (TRUE, TRUE),
                            mask_mode,
                            clip,
+                           rect,
+                           offset,
                            (GskGpuImage *[2]) { source->image, mask->image },
                            (GskGpuSampler[2]) { source->sampler, mask->sampler },
                            &instance);
@@ -25,6 +25,8 @@
 #include "gskgpulineargradientopprivate.h"
 #include "gskgpumaskopprivate.h"
 #include "gskgpumipmapopprivate.h"
+#include "gskgpupathcoveropprivate.h"
+#include "gskgpupathopprivate.h"
 #include "gskgpuradialgradientopprivate.h"
 #include "gskgpurenderpassopprivate.h"
 #include "gskgpuroundedcoloropprivate.h"
@@ -34,7 +36,7 @@
 
 #include "gskcairoblurprivate.h"
 #include "gskdebugprivate.h"
-#include "gskpath.h"
+#include "gskpathprivate.h"
 #include "gskrectprivate.h"
 #include "gskrendernodeprivate.h"
 #include "gskroundedrectprivate.h"
@@ -48,6 +50,7 @@
 #include "gdk/gdkrgbaprivate.h"
 #include "gdk/gdksubsurfaceprivate.h"
 #include "gdk/gdktextureprivate.h"
+#include "gdk/gdktiledtextureprivate.h"
 
 /* the epsilon we allow pixels to be off due to rounding errors.
  * Chosen rather randomly.
@@ -64,6 +67,13 @@
  */
 #define MIN_PERCENTAGE_FOR_OCCLUSION_PASS 10
 
+/* the range of font sizes, in device pixels, where we draw glyphs
+ * from distance fields. Smaller text needs exact rasterization to
+ * look crisp, and bigger text makes the corners visibly round.
+ */
+#define MIN_SDF_GLYPH_SIZE 48
+#define MAX_SDF_GLYPH_SIZE (8 * GSK_GPU_GLYPH_SDF_SIZE)
+
 /* A note about coordinate systems
  *
  * The rendering code keeps track of multiple coordinate systems to optimize rendering as
@@ -111,6 +121,7 @@
 
 
 typedef struct _GskGpuNodeProcessor GskGpuNodeProcessor;
+typedef struct _GskGpuOcclusionStats GskGpuOcclusionStats;
 
 typedef enum {
   /* The returned image will be sampled outside the bounds, so it is
@@ -141,10 +152,19 @@ struct _GskGpuNodeProcessor
   GskTransform                  *modelview;
   GskGpuClip                     clip;
   float                          opacity;
+  cairo_region_t                *occluded;      /* device pixels drawn opaquely later in this pass or NULL */
+  GskGpuOcclusionStats          *stats;         /* only set for GSK_DEBUG=occlusion */
 
   GskGpuGlobals                  pending_globals;
 };
 
+struct _GskGpuOcclusionStats
+{
+  gsize drawn_pixels;
+  gsize culled_pixels;
+  guint culled_nodes;
+};
+
 typedef struct _GskGpuFirstNodeInfo GskGpuFirstNodeInfo;
 
 struct _GskGpuFirstNodeInfo
@@ -172,6 +192,11 @@ static GskGpuImage *    gsk_gpu_get_node_as_image                       (GskGpuF
                                                                          const graphene_vec2_t          *scale,
                                                                          GskRenderNode                  *node,
                                                                          graphene_rect_t                *out_bounds);
+static GskGpuImage *    gsk_gpu_node_processor_get_path_mask            (GskGpuNodeProcessor            *self,
+                                                                         const graphene_rect_t          *clip_bounds,
+                                                                         GskPath                        *path,
+                                                                         GskFillRule                     fill_rule,
+                                                                         const GskStroke                *stroke);
 
 static void
 gsk_gpu_node_processor_finish (GskGpuNodeProcessor *self)
@@ -222,6 +247,8 @@ gsk_gpu_node_processor_init (GskGpuNodeProcessor         *self,
   self->offset = GRAPHENE_POINT_INIT (-viewport->origin.x,
                                       -viewport->origin.y);
   self->opacity = 1.0;
+  self->occluded = NULL;
+  self->stats = NULL;
   self->pending_globals = GSK_GPU_GLOBAL_MATRIX | GSK_GPU_GLOBAL_SCALE | GSK_GPU_GLOBAL_CLIP | GSK_GPU_GLOBAL_SCISSOR | GSK_GPU_GLOBAL_BLEND;
 }
 
@@ -502,6 +529,23 @@ gsk_gpu_node_processor_rect_to_device_shrink (GskGpuNodeProcessor   *self,
   return int_rect->width > 0 && int_rect->height > 0;
 }
 
+static gboolean
+gsk_gpu_node_processor_rect_to_device_grow (GskGpuNodeProcessor   *self,
+                                            const graphene_rect_t *rect,
+                                            cairo_rectangle_int_t *int_rect)
+{
+  graphene_rect_t tmp;
+
+  gsk_rect_init_offset (&tmp, rect, &self->offset);
+
+  if (!gsk_gpu_node_processor_rect_clip_to_device (self, &tmp, &tmp))
+    return FALSE;
+
+  gsk_rect_to_cairo_grow (&tmp, int_rect);
+
+  return TRUE;
+}
+
 static gboolean
 gsk_gpu_node_processor_rect_is_integer (GskGpuNodeProcessor   *self,
                                         const graphene_rect_t *rect,
@@ -934,6 +978,7 @@ gsk_gpu_node_processor_add_cairo_node (GskGpuNodeProcessor *self,
   image = gsk_gpu_upload_cairo_op (self->frame,
                                    &self->scale,
                                    &clipped_bounds,
+                                   GSK_GPU_UPLOAD_CAIRO_DEFAULT,
                                    (GskGpuCairoFunc) gsk_render_node_draw_fallback,
                                    gsk_render_node_ref (node),
                                    (GDestroyNotify) gsk_render_node_unref);
@@ -1911,6 +1956,7 @@ gsk_gpu_lookup_texture (GskGpuFrame    *frame,
                         GdkColorState  *ccs,
                         GdkTexture     *texture,
                         gboolean        try_mipmap,
+                        gboolean       *out_pending,
                         GdkColorState **out_image_cs)
 {
   GskGpuCache *cache;
@@ -1928,7 +1974,12 @@ gsk_gpu_lookup_texture (GskGpuFrame    *frame,
 
   image = gsk_gpu_cache_lookup_texture_image (cache, texture, NULL);
   if (image == NULL)
-    image = gsk_gpu_frame_upload_texture (frame, try_mipmap, texture);
+    {
+      if (out_pending)
+        image = gsk_gpu_frame_upload_texture_async (frame, try_mipmap, texture, out_pending);
+      else
+        image = gsk_gpu_frame_upload_texture (frame, try_mipmap, texture);
+    }
 
   /* Happens ie for oversized textures */
   if (image == NULL)
@@ -1966,6 +2017,37 @@ gsk_gpu_sampler_for_scaling_filter (GskScalingFilter scaling_filter)
     }
 }
 
+/* Loads the part of a tiled texture that covers the given square of
+ * the full resolution image. It uses the smallest level of detail that
+ * is not smaller than @lod_level and returns how many levels still need
+ * to be scaled away in @out_lod_level.
+ */
+static GdkTexture *
+gsk_gpu_load_texture_tile (GdkTiledTexture *texture,
+                           guint            lod_level,
+                           gsize            x,
+                           gsize            y,
+                           gsize            size,
+                           guint           *out_lod_level)
+{
+  GdkRectangle area;
+  gsize level_width, level_height;
+  guint level;
+
+  level = MIN (lod_level, gdk_tiled_texture_get_n_levels (texture) - 1);
+  level_width = (gdk_texture_get_width (GDK_TEXTURE (texture)) + (1 << level) - 1) >> level;
+  level_height = (gdk_texture_get_height (GDK_TEXTURE (texture)) + (1 << level) - 1) >> level;
+
+  area.x = x >> level;
+  area.y = y >> level;
+  area.width = MIN (size >> level, level_width - area.x);
+  area.height = MIN (size >> level, level_height - area.y);
+
+  *out_lod_level = lod_level - level;
+
+  return gdk_tiled_texture_load (texture, level, &area);
+}
+
 /* must be set up with BLEND_ADD to avoid seams */
 static void
 gsk_gpu_node_processor_draw_texture_tiles (GskGpuNodeProcessor    *self,
@@ -1981,10 +2063,10 @@ gsk_gpu_node_processor_draw_texture_tiles (GskGpuNodeProcessor    *self,
   gboolean need_mipmap;
   GdkMemoryTexture *memtex;
   GdkTexture *subtex;
-  float scale_factor, scaled_tile_width, scaled_tile_height;
+  float scale_factor, scaled_tile_width, scaled_tile_height, bounds_width, bounds_height;
   gsize tile_size, width, height, n_width, n_height, x, y;
   graphene_rect_t clip_bounds;
-  guint lod_level;
+  guint lod_level, tile_lod_level;
 
   device = gsk_gpu_frame_get_device (self->frame);
   cache = gsk_gpu_device_get_cache (device);
@@ -1994,8 +2076,17 @@ gsk_gpu_node_processor_draw_texture_tiles (GskGpuNodeProcessor    *self,
   width = gdk_texture_get_width (texture);
   height = gdk_texture_get_height (texture);
   tile_size = gsk_gpu_device_get_tile_size (device);
-  scale_factor = MIN (width / MAX (tile_size, texture_bounds->size.width),
-                      height / MAX (tile_size, texture_bounds->size.height));
+  bounds_width = texture_bounds->size.width;
+  bounds_height = texture_bounds->size.height;
+  /* Tiled textures provide smaller levels for free, so pick the level
+   * for the size on screen */
+  if (GDK_IS_TILED_TEXTURE (texture))
+    {
+      bounds_width *= graphene_vec2_get_x (&self->scale);
+      bounds_height *= graphene_vec2_get_y (&self->scale);
+    }
+  scale_factor = MIN (width / MAX (tile_size, bounds_width),
+                      height / MAX (tile_size, bounds_height));
   if (scale_factor <= 1.0)
     lod_level = 0;
   else
@@ -2023,23 +2114,39 @@ gsk_gpu_node_processor_draw_texture_tiles (GskGpuNodeProcessor    *self,
 
           if (tile == NULL)
             {
-              if (memtex == NULL)
-                memtex = gdk_memory_texture_from_texture (texture);
-              subtex = gdk_memory_texture_new_subtexture (memtex,
-                                                          x * tile_size,
-                                                          y * tile_size,
-                                                          MIN (tile_size, width - x * tile_size),
-                                                          MIN (tile_size, height - y * tile_size));
-              tile = gsk_gpu_upload_texture_op_try (self->frame, need_mipmap, lod_level, scaling_filter, subtex);
-              g_object_unref (subtex);
+              if (GDK_IS_TILED_TEXTURE (texture))
+                {
+                  /* Only load what is visible, from the matching level */
+                  subtex = gsk_gpu_load_texture_tile (GDK_TILED_TEXTURE (texture),
+                                                      lod_level,
+                                                      x * tile_size,
+                                                      y * tile_size,
+                                                      tile_size,
+                                                      &tile_lod_level);
+                  if (subtex == NULL)
+                    continue;
+                }
+              else
+                {
+                  if (memtex == NULL)
+                    memtex = gdk_memory_texture_from_texture (texture);
+                  subtex = gdk_memory_texture_new_subtexture (memtex,
+                                                              x * tile_size,
+                                                              y * tile_size,
+                                                              MIN (tile_size, width - x * tile_size),
+                                                              MIN (tile_size, height - y * tile_size));
+                  tile_lod_level = lod_level;
+                }
+              tile = gsk_gpu_upload_texture_op_try (self->frame, need_mipmap, tile_lod_level, scaling_filter, subtex);
               if (tile == NULL)
                 {
+                  g_object_unref (subtex);
                   g_warning ("failed to create %zux%zu tile for %zux%zu texture. Out of memory?",
                              tile_size, tile_size, width, height);
                   goto out;
                 }
 
-              tile_cs = gdk_texture_get_color_state (texture);
+              tile_cs = gdk_texture_get_color_state (subtex);
               if (gsk_gpu_image_get_flags (tile) & GSK_GPU_IMAGE_SRGB)
                 {
                   tile_cs = gdk_color_state_get_no_srgb_tf (tile_cs);
@@ -2047,6 +2154,7 @@ gsk_gpu_node_processor_draw_texture_tiles (GskGpuNodeProcessor    *self,
                 }
 
               gsk_gpu_cache_cache_tile (cache, texture, lod_level, scaling_filter, y * n_width + x, tile, tile_cs);
+              g_object_unref (subtex);
             }
 
           if (need_mipmap &&
@@ -2116,17 +2224,40 @@ gsk_gpu_node_processor_add_texture_node (GskGpuNodeProcessor *self,
   GdkColorState *image_cs;
   GskGpuImage *image;
   GdkTexture *texture;
-  gboolean should_mipmap;
+  gboolean should_mipmap, pending = FALSE;
 
   texture = gsk_texture_node_get_texture (node);
   should_mipmap = texture_node_should_mipmap (node, self->frame, &self->scale);
 
-  image = gsk_gpu_lookup_texture (self->frame, self->ccs, texture, should_mipmap, &image_cs);
+  image = gsk_gpu_lookup_texture (self->frame, self->ccs, texture, should_mipmap, &pending, &image_cs);
 
   if (image == NULL)
     {
       graphene_rect_t clip, rounded_clip;
 
+      /* The texture is still being converted. Culling and the first
+       * node treat it as opaque, so the pixels below may not have been
+       * drawn. Cover them with a placeholder. */
+      if (pending)
+        {
+          graphene_rect_t opaque;
+          GdkColor placeholder;
+
+          if (gsk_render_node_get_opaque_rect (node, &opaque))
+            {
+              gdk_color_init (&placeholder, GDK_COLOR_STATE_SRGB, (float[]) { 0.5, 0.5, 0.5, 1 });
+              gsk_gpu_color_op (self->frame,
+                                gsk_gpu_clip_get_shader_clip (&self->clip, &self->offset, &opaque),
+                                self->ccs,
+                                self->opacity,
+                                &self->offset,
+                                &opaque,
+                                &placeholder);
+              gdk_color_finish (&placeholder);
+            }
+          return;
+        }
+
       if (!gsk_gpu_node_processor_clip_node_bounds (self, node, &clip))
         return;
       gsk_rect_snap_to_grid (&clip, &self->scale, &self->offset, &rounded_clip);
@@ -2199,7 +2330,7 @@ gsk_gpu_get_texture_node_as_image (GskGpuFrame           *frame,
   gboolean should_mipmap;
 
   should_mipmap = texture_node_should_mipmap (node, frame, scale);
-  image = gsk_gpu_lookup_texture (frame, ccs, texture, FALSE, &image_cs);
+  image = gsk_gpu_lookup_texture (frame, ccs, texture, FALSE, NULL, &image_cs);
 
   if (image == NULL)
     {
@@ -2246,7 +2377,7 @@ gsk_gpu_node_processor_add_texture_scale_node (GskGpuNodeProcessor *self,
   texture = gsk_texture_scale_node_get_texture (node);
   scaling_filter = gsk_texture_scale_node_get_filter (node);
   need_mipmap = scaling_filter == GSK_SCALING_FILTER_TRILINEAR;
-  image = gsk_gpu_lookup_texture (self->frame, self->ccs, texture, need_mipmap, &image_cs);
+  image = gsk_gpu_lookup_texture (self->frame, self->ccs, texture, need_mipmap, NULL, &image_cs);
 
   need_offscreen = image == NULL ||
                    self->modelview != NULL ||
@@ -2350,6 +2481,7 @@ gsk_gpu_get_cairo_node_as_image (GskGpuFrame           *frame,
   result = gsk_gpu_upload_cairo_op (frame,
                                     scale,
                                     clip_bounds,
+                                    GSK_GPU_UPLOAD_CAIRO_DEFAULT,
                                     (GskGpuCairoFunc) gsk_render_node_draw_fallback,
                                     gsk_render_node_ref (node),
                                     (GDestroyNotify) gsk_render_node_unref);
@@ -3060,6 +3192,18 @@ gsk_gpu_node_processor_add_mask_node (GskGpuNodeProcessor *self,
   g_object_unref (mask_image);
 }
 
+static float
+gsk_gpu_font_get_size (PangoFont *font)
+{
+  cairo_scaled_font_t *scaled_font;
+  cairo_matrix_t matrix;
+
+  scaled_font = pango_cairo_font_get_scaled_font (PANGO_CAIRO_FONT (font));
+  cairo_scaled_font_get_font_matrix (scaled_font, &matrix);
+
+  return sqrt (fabs (matrix.xx * matrix.yy - matrix.xy * matrix.yx));
+}
+
 static void
 gsk_gpu_node_processor_add_glyph_node (GskGpuNodeProcessor *self,
                                        GskRenderNode       *node)
@@ -3080,6 +3224,7 @@ gsk_gpu_node_processor_add_glyph_node (GskGpuNodeProcessor *self,
   GskGpuColorStates color_states;
   GdkColor color2;
   GskGpuShaderClip node_clip;
+  float font_size, sdf_scale;
 
   if (self->opacity < 1.0 &&
       gsk_text_node_has_color_glyphs (node))
@@ -3123,6 +3268,16 @@ gsk_gpu_node_processor_add_glyph_node (GskGpuNodeProcessor *self,
   inv_align_scale_x = 1 / align_scale_x;
   inv_align_scale_y = 1 / align_scale_y;
 
+  /* Zooming text would rasterize every glyph at every scale,
+   * so big text uses one distance field for all of them */
+  font_size = gsk_gpu_font_get_size (font);
+  if (gsk_gpu_frame_should_optimize (self->frame, GSK_GPU_OPTIMIZE_SDF_GLYPHS) &&
+      font_size * scale >= MIN_SDF_GLYPH_SIZE &&
+      font_size * scale <= MAX_SDF_GLYPH_SIZE)
+    sdf_scale = GSK_GPU_GLYPH_SDF_SIZE / font_size;
+  else
+    sdf_scale = 0;
+
   for (i = 0; i < num_glyphs; i++)
     {
       GskGpuImage *image;
@@ -3130,6 +3285,8 @@ gsk_gpu_node_processor_add_glyph_node (GskGpuNodeProcessor *self,
       graphene_point_t glyph_offset, glyph_origin;
       GskGpuGlyphLookupFlags flags;
       GskGpuShaderClip glyph_clip;
+      gboolean use_sdf;
+      float glyph_scale;
 
       glyph_origin = GRAPHENE_POINT_INIT (offset.x + glyphs[i].geometry.x_offset * inv_pango_scale,
                                           offset.y + glyphs[i].geometry.y_offset * inv_pango_scale);
@@ -3140,25 +3297,35 @@ gsk_gpu_node_processor_add_glyph_node (GskGpuNodeProcessor *self,
       glyph_origin.x *= inv_align_scale_x;
       glyph_origin.y *= inv_align_scale_y;
 
+      /* Distance fields can't do color */
+      use_sdf = sdf_scale > 0 && !glyphs[i].attr.is_color;
+      if (use_sdf)
+        {
+          flags = GSK_GPU_GLYPH_SDF;
+          glyph_scale = sdf_scale;
+        }
+      else
+        glyph_scale = scale;
+
       image = gsk_gpu_cache_lookup_glyph_image (cache,
                                                  self->frame,
                                                  font,
                                                  glyphs[i].glyph,
                                                  flags,
-                                                 scale,
+                                                 glyph_scale,
                                                  &glyph_bounds,
                                                  &glyph_offset);
 
-      glyph_tex_rect = GRAPHENE_RECT_INIT (-glyph_bounds.origin.x / scale,
-                                           -glyph_bounds.origin.y / scale,
-                                           gsk_gpu_image_get_width (image) / scale,
-                                           gsk_gpu_image_get_height (image) / scale);
+      glyph_tex_rect = GRAPHENE_RECT_INIT (-glyph_bounds.origin.x / glyph_scale,
+                                           -glyph_bounds.origin.y / glyph_scale,
+                                           gsk_gpu_image_get_width (image) / glyph_scale,
+                                           gsk_gpu_image_get_height (image) / glyph_scale);
       glyph_bounds = GRAPHENE_RECT_INIT (0,
                                          0,
-                                         glyph_bounds.size.width / scale,
-                                         glyph_bounds.size.height / scale);
-      glyph_origin = GRAPHENE_POINT_INIT (glyph_origin.x - glyph_offset.x / scale,
-                                          glyph_origin.y - glyph_offset.y / scale);
+                                         glyph_bounds.size.width / glyph_scale,
+                                         glyph_bounds.size.height / glyph_scale);
+      glyph_origin = GRAPHENE_POINT_INIT (glyph_origin.x - glyph_offset.x / glyph_scale,
+                                          glyph_origin.y - glyph_offset.y / glyph_scale);
 
       if (node_clip == GSK_GPU_SHADER_CLIP_NONE)
         glyph_clip = GSK_GPU_SHADER_CLIP_NONE;
@@ -3175,6 +3342,19 @@ gsk_gpu_node_processor_add_glyph_node (GskGpuNodeProcessor *self,
                                 &glyph_bounds,
                                 &glyph_tex_rect
                             });
+      else if (use_sdf)
+        gsk_gpu_colorize_sdf_op (self->frame,
+                                 glyph_clip,
+                                 color_states,
+                                 self->opacity,
+                                 &glyph_origin,
+                                 &(GskGpuShaderImage) {
+                                     image,
+                                     GSK_GPU_SAMPLER_DEFAULT,
+                                     &glyph_bounds,
+                                     &glyph_tex_rect
+                                 },
+                                 &color2);
       else
         gsk_gpu_colorize_op2 (self->frame,
                               glyph_clip,
@@ -3416,6 +3596,491 @@ gsk_gpu_node_processor_add_repeat_node (GskGpuNodeProcessor *self,
     }
 }
 
+static void
+gsk_gpu_node_processor_add_masked_child (GskGpuNodeProcessor   *self,
+                                         const graphene_rect_t *clip_bounds,
+                                         GskRenderNode         *child,
+                                         GskGpuImage           *mask_image,
+                                         const graphene_rect_t *mask_bounds)
+{
+  graphene_rect_t source_rect;
+  GskGpuImage *source_image;
+
+  source_image = gsk_gpu_node_processor_get_node_as_image (self,
+                                                           0,
+                                                           clip_bounds,
+                                                           child,
+                                                           &source_rect);
+  if (source_image == NULL)
+    return;
+
+  gsk_gpu_mask_op (self->frame,
+                   gsk_gpu_clip_get_shader_clip (&self->clip, &self->offset, clip_bounds),
+                   clip_bounds,
+                   &self->offset,
+                   self->opacity,
+                   GSK_MASK_MODE_ALPHA,
+                   &(GskGpuShaderImage) {
+                       source_image,
+                       GSK_GPU_SAMPLER_DEFAULT,
+                       NULL,
+                       &source_rect,
+                   },
+                   &(GskGpuShaderImage) {
+                       mask_image,
+                       GSK_GPU_SAMPLER_DEFAULT,
+                       NULL,
+                       mask_bounds,
+                   });
+
+  g_object_unref (source_image);
+}
+
+typedef struct _PathMaskData PathMaskData;
+struct _PathMaskData
+{
+  GskGpuNodeProcessor *self;
+  GskPath *path;
+  GskFillRule fill_rule;
+  const GskStroke *stroke;
+};
+
+static GskGpuImage *
+gsk_gpu_node_processor_draw_path_mask (gpointer               user_data,
+                                       const graphene_rect_t *rect)
+{
+  PathMaskData *data = user_data;
+
+  return gsk_gpu_node_processor_get_path_mask (data->self, rect, data->path, data->fill_rule, data->stroke);
+}
+
+/* Draws the path with a mask from the cache. If @can_draw_path is set,
+ * the mask is drawn on the GPU, so it matches the uncached rendering.
+ *
+ * Returns: %FALSE if the path isn't cached
+ */
+static gboolean
+gsk_gpu_node_processor_add_cached_path (GskGpuNodeProcessor   *self,
+                                        GskRenderNode         *node,
+                                        const graphene_rect_t *clip_bounds,
+                                        GskRenderNode         *child,
+                                        GskPath               *path,
+                                        GskFillRule            fill_rule,
+                                        const GskStroke       *stroke,
+                                        gboolean               can_draw_path)
+{
+  PathMaskData data = { self, path, fill_rule, stroke };
+  GskGpuCache *cache;
+  GskGpuImage *image;
+  graphene_rect_t mask_rect, image_bounds, rect;
+
+  if (!gsk_gpu_frame_should_optimize (self->frame, GSK_GPU_OPTIMIZE_PATH_CACHE))
+    return FALSE;
+
+  cache = gsk_gpu_device_get_cache (gsk_gpu_frame_get_device (self->frame));
+  image = gsk_gpu_cache_lookup_path_image (cache,
+                                           self->frame,
+                                           path,
+                                           fill_rule,
+                                           stroke,
+                                           &node->bounds,
+                                           &self->scale,
+                                           &self->offset,
+                                           can_draw_path ? gsk_gpu_node_processor_draw_path_mask : NULL,
+                                           &data,
+                                           &mask_rect,
+                                           &image_bounds);
+  if (image == NULL)
+    return FALSE;
+
+  if (!gsk_rect_intersection (clip_bounds, &mask_rect, &rect))
+    return TRUE;
+
+  if (GSK_RENDER_NODE_TYPE (child) == GSK_COLOR_NODE)
+    {
+      gsk_gpu_colorize_op (self->frame,
+                           gsk_gpu_clip_get_shader_clip (&self->clip, &self->offset, &rect),
+                           self->ccs,
+                           self->opacity,
+                           &self->offset,
+                           &(GskGpuShaderImage) {
+                               image,
+                               GSK_GPU_SAMPLER_DEFAULT,
+                               &rect,
+                               &image_bounds,
+                           },
+                           gsk_color_node_get_color2 (child));
+    }
+  else
+    {
+      gsk_gpu_node_processor_add_masked_child (self, &rect, child, image, &image_bounds);
+    }
+
+  return TRUE;
+}
+
+typedef struct _PathAccumulation PathAccumulation;
+struct _PathAccumulation
+{
+  GskGpuNodeProcessor *self;
+  graphene_rect_t bounds;
+  float line_width;
+  float pixel_size;
+  graphene_point_t start;
+  graphene_point_t current;
+  /* dashing, n_dashes is 0 for undashed strokes */
+  const GskStroke *stroke;
+  gsize n_dashes;
+  gsize dash;
+  float dash_remaining;
+};
+
+static void
+path_accumulation_add_edge (PathAccumulation       *acc,
+                            const graphene_point_t *start,
+                            const graphene_point_t *end)
+{
+  float left, top, right, bottom;
+
+  /* Everything to the right of the edge is affected, and so
+   * are the pixels that the edge only touches partially */
+  right = acc->bounds.origin.x + acc->bounds.size.width;
+  left = MAX (MIN (start->x, end->x) - acc->pixel_size, acc->bounds.origin.x);
+  top = MAX (MIN (start->y, end->y) - acc->pixel_size, acc->bounds.origin.y);
+  bottom = MIN (MAX (start->y, end->y) + acc->pixel_size, acc->bounds.origin.y + acc->bounds.size.height);
+  if (left >= right || top >= bottom)
+    return;
+
+  gsk_gpu_path_fill_edge_op (acc->self->frame,
+                             &GRAPHENE_RECT_INIT (left, top, right - left, bottom - top),
+                             &acc->self->offset,
+                             start,
+                             end);
+}
+
+static gboolean
+path_accumulation_fill_func (GskPathOperation        op,
+                             const graphene_point_t *pts,
+                             gsize                   n_pts,
+                             float                   weight,
+                             gpointer                user_data)
+{
+  PathAccumulation *acc = user_data;
+
+  switch (op)
+    {
+    case GSK_PATH_MOVE:
+      /* fills implicitly close every contour */
+      path_accumulation_add_edge (acc, &acc->current, &acc->start);
+      acc->start = pts[0];
+      acc->current = pts[0];
+      break;
+
+    case GSK_PATH_CLOSE:
+    case GSK_PATH_LINE:
+      path_accumulation_add_edge (acc, &pts[0], &pts[1]);
+      acc->current = pts[1];
+      break;
+
+    case GSK_PATH_QUAD:
+    case GSK_PATH_CUBIC:
+    case GSK_PATH_CONIC:
+    default:
+      g_assert_not_reached ();
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+path_accumulation_add_segment (PathAccumulation       *acc,
+                               const graphene_point_t *start,
+                               const graphene_point_t *end)
+{
+  graphene_rect_t rect;
+  float extents;
+
+  extents = acc->line_width / 2 + acc->pixel_size;
+  rect = GRAPHENE_RECT_INIT (MIN (start->x, end->x) - extents,
+                             MIN (start->y, end->y) - extents,
+                             fabsf (start->x - end->x) + 2 * extents,
+                             fabsf (start->y - end->y) + 2 * extents);
+  if (gsk_rect_intersection (&rect, &acc->bounds, &rect))
+    gsk_gpu_path_stroke_segment_op (acc->self->frame,
+                                    &rect,
+                                    &acc->self->offset,
+                                    start,
+                                    end,
+                                    acc->line_width);
+}
+
+/* Like cairo, an odd number of dashes is repeated to get
+ * alternating on and off dashes */
+static float
+path_accumulation_get_dash (PathAccumulation *acc,
+                            gsize             i)
+{
+  return acc->stroke->dash[i % acc->stroke->n_dash];
+}
+
+/* Every contour starts at the dash offset */
+static void
+path_accumulation_reset_dash (PathAccumulation *acc)
+{
+  float offset;
+
+  if (acc->n_dashes == 0)
+    return;
+
+  offset = fmodf (acc->stroke->dash_offset, acc->stroke->dash_length * (acc->n_dashes / acc->stroke->n_dash));
+  if (offset < 0)
+    offset += acc->stroke->dash_length * (acc->n_dashes / acc->stroke->n_dash);
+
+  acc->dash = 0;
+  while (offset >= path_accumulation_get_dash (acc, acc->dash))
+    {
+      offset -= path_accumulation_get_dash (acc, acc->dash);
+      acc->dash = (acc->dash + 1) % acc->n_dashes;
+    }
+  acc->dash_remaining = path_accumulation_get_dash (acc, acc->dash) - offset;
+}
+
+/* Draws the "on" parts of the line. Every part gets round caps, so
+ * consecutive parts of the same dash are joined with round joins.
+ */
+static void
+path_accumulation_add_dashed_segment (PathAccumulation       *acc,
+                                      const graphene_point_t *start,
+                                      const graphene_point_t *end)
+{
+  float length, t, step;
+
+  length = graphene_point_distance (start, end, NULL, NULL);
+
+  for (t = 0; ; )
+    {
+      step = MIN (acc->dash_remaining, length - t);
+
+      if (acc->dash % 2 == 0)
+        {
+          graphene_point_t p0, p1;
+
+          graphene_point_interpolate (start, end, length > 0 ? t / length : 0, &p0);
+          graphene_point_interpolate (start, end, length > 0 ? (t + step) / length : 0, &p1);
+          path_accumulation_add_segment (acc, &p0, &p1);
+        }
+
+      t += step;
+      acc->dash_remaining -= step;
+      if (acc->dash_remaining > 0)
+        break;
+
+      acc->dash = (acc->dash + 1) % acc->n_dashes;
+      acc->dash_remaining = path_accumulation_get_dash (acc, acc->dash);
+      if (t >= length && acc->dash_remaining > 0)
+        break;
+    }
+}
+
+static gboolean
+path_accumulation_stroke_func (GskPathOperation        op,
+                               const graphene_point_t *pts,
+                               gsize                   n_pts,
+                               float                   weight,
+                               gpointer                user_data)
+{
+  PathAccumulation *acc = user_data;
+
+  switch (op)
+    {
+    case GSK_PATH_MOVE:
+      path_accumulation_reset_dash (acc);
+      break;
+
+    case GSK_PATH_CLOSE:
+    case GSK_PATH_LINE:
+      if (acc->n_dashes)
+        path_accumulation_add_dashed_segment (acc, &pts[0], &pts[1]);
+      else
+        path_accumulation_add_segment (acc, &pts[0], &pts[1]);
+      break;
+
+    case GSK_PATH_QUAD:
+    case GSK_PATH_CUBIC:
+    case GSK_PATH_CONIC:
+    default:
+      g_assert_not_reached ();
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Whether the path can be drawn with gsk_gpu_node_processor_draw_path().
+ * Strokes are drawn as the union of round-capped segments, so only
+ * strokes with round joins and caps are supported.
+ */
+static gboolean
+gsk_gpu_node_processor_can_draw_path (GskGpuNodeProcessor *self,
+                                      const GskStroke     *stroke)
+{
+  if (!gsk_gpu_frame_should_optimize (self->frame, GSK_GPU_OPTIMIZE_PATHS))
+    return FALSE;
+
+  if (stroke == NULL)
+    return TRUE;
+
+  return stroke->line_join == GSK_LINE_JOIN_ROUND &&
+         stroke->line_cap == GSK_LINE_CAP_ROUND &&
+         graphene_vec2_get_x (&self->scale) == graphene_vec2_get_y (&self->scale);
+}
+
+/* Draws the path on the GPU: first the winding number of every pixel
+ * is accumulated into a float offscreen, then the color is drawn
+ * with the coverage derived from that winding number.
+ *
+ * For strokes, the offscreen holds the maximum coverage of all the
+ * segments instead. Summing them up would saturate the antialiased
+ * edges where flattened curves produce many overlapping segments.
+ *
+ * Returns: %FALSE if the GPU can't render float offscreens
+ */
+static gboolean
+gsk_gpu_node_processor_draw_path (GskGpuNodeProcessor   *self,
+                                  const graphene_rect_t *clip_bounds,
+                                  GskPath               *path,
+                                  GskFillRule            fill_rule,
+                                  const GskStroke       *stroke,
+                                  const GdkColor        *color)
+{
+  GskGpuNodeProcessor other;
+  GskGpuImage *image;
+  cairo_rectangle_int_t area;
+  PathAccumulation acc;
+  float pixel_size;
+
+  area.x = 0;
+  area.y = 0;
+  area.width = MAX (1, ceilf (graphene_vec2_get_x (&self->scale) * clip_bounds->size.width - EPSILON));
+  area.height = MAX (1, ceilf (graphene_vec2_get_y (&self->scale) * clip_bounds->size.height - EPSILON));
+
+  image = gsk_gpu_device_create_offscreen_image (gsk_gpu_frame_get_device (self->frame),
+                                                 FALSE,
+                                                 gdk_memory_depth_get_format (GDK_MEMORY_FLOAT16),
+                                                 FALSE,
+                                                 area.width, area.height);
+  if (image == NULL)
+    return FALSE;
+  /* The winding number can be negative or larger than 1 */
+  if (gdk_memory_format_get_depth (gsk_gpu_image_get_format (image), FALSE) != GDK_MEMORY_FLOAT16 &&
+      gdk_memory_format_get_depth (gsk_gpu_image_get_format (image), FALSE) != GDK_MEMORY_FLOAT32)
+    {
+      g_object_unref (image);
+      return FALSE;
+    }
+
+  gsk_gpu_node_processor_init (&other,
+                               self->frame,
+                               image,
+                               self->ccs,
+                               &area,
+                               clip_bounds);
+  gsk_gpu_render_pass_begin_op (self->frame,
+                                image,
+                                &area,
+                                GSK_GPU_LOAD_OP_CLEAR,
+                                GSK_VEC4_TRANSPARENT,
+                                GSK_RENDER_PASS_OFFSCREEN);
+
+  other.blend = stroke ? GSK_GPU_BLEND_MAX : GSK_GPU_BLEND_ADD;
+  other.pending_globals |= GSK_GPU_GLOBAL_BLEND;
+  gsk_gpu_node_processor_sync_globals (&other, 0);
+
+  pixel_size = 1.0f / MIN (graphene_vec2_get_x (&self->scale), graphene_vec2_get_y (&self->scale));
+  acc = (PathAccumulation) {
+    .self = &other,
+    .bounds = *clip_bounds,
+    .line_width = stroke ? stroke->line_width : 0,
+    .pixel_size = pixel_size,
+    .stroke = stroke,
+    .n_dashes = stroke == NULL || stroke->dash_length <= 0 ? 0 : stroke->n_dash % 2 ? 2 * stroke->n_dash : stroke->n_dash,
+  };
+  if (stroke)
+    {
+      gsk_path_foreach_with_tolerance (path,
+                                       0,
+                                       pixel_size / 4,
+                                       path_accumulation_stroke_func,
+                                       &acc);
+    }
+  else
+    {
+      gsk_path_foreach_with_tolerance (path,
+                                       0,
+                                       pixel_size / 4,
+                                       path_accumulation_fill_func,
+                                       &acc);
+      path_accumulation_add_edge (&acc, &acc.current, &acc.start);
+    }
+
+  gsk_gpu_node_processor_finish_draw (&other, image);
+
+  gsk_gpu_path_cover_op (self->frame,
+                         gsk_gpu_clip_get_shader_clip (&self->clip, &self->offset, clip_bounds),
+                         self->ccs,
+                         self->opacity,
+                         &self->offset,
+                         stroke ? GSK_FILL_RULE_WINDING : fill_rule,
+                         &(GskGpuShaderImage) {
+                             image,
+                             GSK_GPU_SAMPLER_NEAREST,
+                             NULL,
+                             clip_bounds,
+                         },
+                         color);
+
+  g_object_unref (image);
+
+  return TRUE;
+}
+
+/* Like gsk_gpu_node_processor_draw_path(), but returns an alpha mask
+ * that can be used with a mask op.
+ */
+static GskGpuImage *
+gsk_gpu_node_processor_get_path_mask (GskGpuNodeProcessor   *self,
+                                      const graphene_rect_t *clip_bounds,
+                                      GskPath               *path,
+                                      GskFillRule            fill_rule,
+                                      const GskStroke       *stroke)
+{
+  GskGpuNodeProcessor other;
+  GskGpuImage *image;
+  GdkColor white;
+  gboolean success;
+
+  image = gsk_gpu_node_processor_init_draw (&other,
+                                            self->frame,
+                                            self->ccs,
+                                            GDK_MEMORY_U8,
+                                            &self->scale,
+                                            clip_bounds);
+  if (image == NULL)
+    return NULL;
+
+  gdk_color_init (&white, GDK_COLOR_STATE_SRGB, (float[]) { 1, 1, 1, 1 });
+  success = gsk_gpu_node_processor_draw_path (&other, clip_bounds, path, fill_rule, stroke, &white);
+  gdk_color_finish (&white);
+
+  gsk_gpu_node_processor_finish_draw (&other, image);
+
+  if (!success)
+    g_clear_object (&image);
+
+  return image;
+}
+
 typedef struct _FillData FillData;
 struct _FillData
 {
@@ -3461,9 +4126,10 @@ static void
 gsk_gpu_node_processor_add_fill_node (GskGpuNodeProcessor *self,
                                       GskRenderNode       *node)
 {
-  graphene_rect_t clip_bounds, source_rect;
-  GskGpuImage *mask_image, *source_image;
+  graphene_rect_t clip_bounds;
+  GskGpuImage *mask_image;
   GskRenderNode *child;
+  gboolean can_draw_path;
   GdkColor color;
 
   if (!gsk_gpu_node_processor_clip_node_bounds (self, node, &clip_bounds))
@@ -3471,6 +4137,48 @@ gsk_gpu_node_processor_add_fill_node (GskGpuNodeProcessor *self,
   gsk_rect_snap_to_grid (&clip_bounds, &self->scale, &self->offset, &clip_bounds);
 
   child = gsk_fill_node_get_child (node);
+  can_draw_path = gsk_gpu_node_processor_can_draw_path (self, NULL);
+
+  /* Paths that the GPU can draw are only cached once they are reused,
+   * so animated paths don't fill the cache.
+   */
+  if (gsk_gpu_node_processor_add_cached_path (self,
+                                              node,
+                                              &clip_bounds,
+                                              child,
+                                              gsk_fill_node_get_path (node),
+                                              gsk_fill_node_get_fill_rule (node),
+                                              NULL,
+                                              can_draw_path))
+    return;
+
+  if (can_draw_path)
+    {
+      if (GSK_RENDER_NODE_TYPE (child) == GSK_COLOR_NODE)
+        {
+          if (gsk_gpu_node_processor_draw_path (self,
+                                                &clip_bounds,
+                                                gsk_fill_node_get_path (node),
+                                                gsk_fill_node_get_fill_rule (node),
+                                                NULL,
+                                                gsk_color_node_get_color2 (child)))
+            return;
+        }
+      else
+        {
+          mask_image = gsk_gpu_node_processor_get_path_mask (self,
+                                                             &clip_bounds,
+                                                             gsk_fill_node_get_path (node),
+                                                             gsk_fill_node_get_fill_rule (node),
+                                                             NULL);
+          if (mask_image)
+            {
+              gsk_gpu_node_processor_add_masked_child (self, &clip_bounds, child, mask_image, &clip_bounds);
+              g_object_unref (mask_image);
+              return;
+            }
+        }
+    }
 
   if (GSK_RENDER_NODE_TYPE (child) == GSK_COLOR_NODE)
     gdk_color_init_copy (&color, gsk_color_node_get_color2 (child));
@@ -3480,6 +4188,7 @@ gsk_gpu_node_processor_add_fill_node (GskGpuNodeProcessor *self,
   mask_image = gsk_gpu_upload_cairo_op (self->frame,
                                         &self->scale,
                                         &clip_bounds,
+                                        GSK_GPU_UPLOAD_CAIRO_THREADSAFE,
                                         gsk_gpu_node_processor_fill_path,
                                         g_memdup2 (&(FillData) {
                                             .path = gsk_path_ref (gsk_fill_node_get_path (node)),
@@ -3499,34 +4208,7 @@ gsk_gpu_node_processor_add_fill_node (GskGpuNodeProcessor *self,
       return;
     }
 
-  source_image = gsk_gpu_node_processor_get_node_as_image (self,
-                                                           0,
-                                                           &clip_bounds,
-                                                           child,
-                                                           &source_rect);
-  if (source_image == NULL)
-    return;
-
-  gsk_gpu_mask_op (self->frame,
-                   gsk_gpu_clip_get_shader_clip (&self->clip, &self->offset, &clip_bounds),
-                   &clip_bounds,
-                   &self->offset,
-                   self->opacity,
-                   GSK_MASK_MODE_ALPHA,
-                   &(GskGpuShaderImage) {
-                       source_image,
-                       GSK_GPU_SAMPLER_DEFAULT,
-                       NULL,
-                       &source_rect,
-                   },
-                   &(GskGpuShaderImage) {
-                       mask_image,
-                       GSK_GPU_SAMPLER_DEFAULT,
-                       NULL,
-                       &clip_bounds,
-                   });
-
-  g_object_unref (source_image);
+  gsk_gpu_node_processor_add_masked_child (self, &clip_bounds, child, mask_image, &clip_bounds);
 }
 
 typedef struct _StrokeData StrokeData;
@@ -3564,9 +4246,10 @@ static void
 gsk_gpu_node_processor_add_stroke_node (GskGpuNodeProcessor *self,
                                         GskRenderNode       *node)
 {
-  graphene_rect_t clip_bounds, source_rect;
-  GskGpuImage *mask_image, *source_image;
+  graphene_rect_t clip_bounds;
+  GskGpuImage *mask_image;
   GskRenderNode *child;
+  gboolean can_draw_path;
   GdkColor color;
 
   if (!gsk_gpu_node_processor_clip_node_bounds (self, node, &clip_bounds))
@@ -3574,6 +4257,45 @@ gsk_gpu_node_processor_add_stroke_node (GskGpuNodeProcessor *self,
   gsk_rect_snap_to_grid (&clip_bounds, &self->scale, &self->offset, &clip_bounds);
 
   child = gsk_stroke_node_get_child (node);
+  can_draw_path = gsk_gpu_node_processor_can_draw_path (self, gsk_stroke_node_get_stroke (node));
+
+  if (gsk_gpu_node_processor_add_cached_path (self,
+                                              node,
+                                              &clip_bounds,
+                                              child,
+                                              gsk_stroke_node_get_path (node),
+                                              GSK_FILL_RULE_WINDING,
+                                              gsk_stroke_node_get_stroke (node),
+                                              can_draw_path))
+    return;
+
+  if (can_draw_path)
+    {
+      if (GSK_RENDER_NODE_TYPE (child) == GSK_COLOR_NODE)
+        {
+          if (gsk_gpu_node_processor_draw_path (self,
+                                                &clip_bounds,
+                                                gsk_stroke_node_get_path (node),
+                                                GSK_FILL_RULE_WINDING,
+                                                gsk_stroke_node_get_stroke (node),
+                                                gsk_color_node_get_color2 (child)))
+            return;
+        }
+      else
+        {
+          mask_image = gsk_gpu_node_processor_get_path_mask (self,
+                                                             &clip_bounds,
+                                                             gsk_stroke_node_get_path (node),
+                                                             GSK_FILL_RULE_WINDING,
+                                                             gsk_stroke_node_get_stroke (node));
+          if (mask_image)
+            {
+              gsk_gpu_node_processor_add_masked_child (self, &clip_bounds, child, mask_image, &clip_bounds);
+              g_object_unref (mask_image);
+              return;
+            }
+        }
+    }
 
   if (GSK_RENDER_NODE_TYPE (child) == GSK_COLOR_NODE)
     gdk_color_init_copy (&color, gsk_color_node_get_color2 (child));
@@ -3583,6 +4305,7 @@ gsk_gpu_node_processor_add_stroke_node (GskGpuNodeProcessor *self,
   mask_image = gsk_gpu_upload_cairo_op (self->frame,
                                         &self->scale,
                                         &clip_bounds,
+                                        GSK_GPU_UPLOAD_CAIRO_THREADSAFE,
                                         gsk_gpu_node_processor_stroke_path,
                                         g_memdup2 (&(StrokeData) {
                                             .path = gsk_path_ref (gsk_stroke_node_get_path (node)),
@@ -3602,34 +4325,7 @@ gsk_gpu_node_processor_add_stroke_node (GskGpuNodeProcessor *self,
       return;
     }
 
-  source_image = gsk_gpu_node_processor_get_node_as_image (self,
-                                                           0,
-                                                           &clip_bounds,
-                                                           child,
-                                                           &source_rect);
-  if (source_image == NULL)
-    return;
-
-  gsk_gpu_mask_op (self->frame,
-                   gsk_gpu_clip_get_shader_clip (&self->clip, &self->offset, &clip_bounds),
-                   &clip_bounds,
-                   &self->offset,
-                   self->opacity,
-                   GSK_MASK_MODE_ALPHA,
-                   &(GskGpuShaderImage) {
-                       source_image,
-                       GSK_GPU_SAMPLER_DEFAULT,
-                       NULL,
-                       &source_rect,
-                   },
-                   &(GskGpuShaderImage) {
-                       mask_image,
-                       GSK_GPU_SAMPLER_DEFAULT,
-                       NULL,
-                       &clip_bounds,
-                   });
-
-  g_object_unref (source_image);
+  gsk_gpu_node_processor_add_masked_child (self, &clip_bounds, child, mask_image, &clip_bounds);
 }
 
 static void
@@ -3745,6 +4441,117 @@ gsk_gpu_get_subsurface_node_as_image (GskGpuFrame           *frame,
                                     out_bounds);
 }
 
+static gboolean
+gsk_render_node_type_is_leaf (GskRenderNodeType node_type)
+{
+  switch (node_type)
+    {
+    case GSK_COLOR_NODE:
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+    case GSK_RADIAL_GRADIENT_NODE:
+    case GSK_REPEATING_RADIAL_GRADIENT_NODE:
+    case GSK_CONIC_GRADIENT_NODE:
+    case GSK_BORDER_NODE:
+    case GSK_TEXTURE_NODE:
+    case GSK_TEXTURE_SCALE_NODE:
+    case GSK_INSET_SHADOW_NODE:
+    case GSK_OUTSET_SHADOW_NODE:
+    case GSK_TEXT_NODE:
+    case GSK_CAIRO_NODE:
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+/* Walks the children front to back and collects the device pixels
+ * that the opaque parts of later children will cover. Then draws the
+ * children back to front, with each child knowing which of its pixels
+ * are going to be overdrawn, so that gsk_gpu_node_processor_add_node()
+ * can skip nodes that are completely hidden.
+ *
+ * The opaque rects are unioned into a single region in place. Hidden
+ * children get that region, which only grows, so they stay hidden.
+ * Only partially covered children that have children of their own get
+ * a copy, so they can cull those.
+ */
+static void
+gsk_gpu_node_processor_add_children_culled (GskGpuNodeProcessor  *self,
+                                            GskRenderNode       **children,
+                                            guint                 n_children)
+{
+  cairo_region_t **occluded, *region, *saved;
+  gboolean owns_region;
+  guint i;
+
+  occluded = g_new0 (cairo_region_t *, n_children);
+  region = self->occluded;
+  owns_region = FALSE;
+
+  for (i = n_children; i-- > 0; )
+    {
+      cairo_rectangle_int_t device;
+      graphene_rect_t opaque;
+
+      if (region && gsk_gpu_node_processor_rect_to_device_grow (self, &children[i]->bounds, &device))
+        {
+          switch (cairo_region_contains_rectangle (region, &device))
+            {
+            case CAIRO_REGION_OVERLAP_IN:
+              occluded[i] = cairo_region_reference (region);
+              /* Its opaque rect can't add anything */
+              continue;
+
+            case CAIRO_REGION_OVERLAP_PART:
+              if (!gsk_render_node_type_is_leaf (gsk_render_node_get_node_type (children[i])))
+                occluded[i] = cairo_region_copy (region);
+              break;
+
+            case CAIRO_REGION_OVERLAP_OUT:
+            default:
+              break;
+            }
+        }
+
+      if (!gsk_render_node_get_opaque_rect (children[i], &opaque) ||
+          !gsk_gpu_node_processor_rect_to_device_shrink (self, &opaque, &device))
+        continue;
+
+      if (region == NULL)
+        {
+          region = cairo_region_create_rectangle (&device);
+          owns_region = TRUE;
+        }
+      else if (!owns_region)
+        {
+          /* Don't modify the region of our parent */
+          region = cairo_region_copy (region);
+          cairo_region_union_rectangle (region, &device);
+          owns_region = TRUE;
+        }
+      else
+        {
+          cairo_region_union_rectangle (region, &device);
+        }
+    }
+
+  if (owns_region)
+    cairo_region_destroy (region);
+
+  saved = self->occluded;
+  for (i = 0; i < n_children; i++)
+    {
+      self->occluded = occluded[i];
+      gsk_gpu_node_processor_add_node (self, children[i]);
+      g_clear_pointer (&occluded[i], cairo_region_destroy);
+    }
+  self->occluded = saved;
+
+  g_free (occluded);
+}
+
 static void
 gsk_gpu_node_processor_add_container_node (GskGpuNodeProcessor *self,
                                            GskRenderNode       *node)
@@ -3759,6 +4566,16 @@ gsk_gpu_node_processor_add_container_node (GskGpuNodeProcessor *self,
     }
 
   children = gsk_container_node_get_children (node, &n_children);
+
+  if (n_children > 1 &&
+      self->opacity >= 1.0 &&
+      self->blend == GSK_GPU_BLEND_OVER &&
+      gsk_gpu_frame_should_optimize (self->frame, GSK_GPU_OPTIMIZE_OCCLUSION_CULLING))
+    {
+      gsk_gpu_node_processor_add_children_culled (self, children, n_children);
+      return;
+    }
+
   for (guint i = 0; i < n_children; i++)
     gsk_gpu_node_processor_add_node (self, children[i]);
 }
@@ -4071,11 +4888,49 @@ static const struct
   },
 };
 
+static gsize
+gsk_gpu_node_processor_count_pixels (GskGpuNodeProcessor *self,
+                                     GskRenderNode       *node)
+{
+  cairo_rectangle_int_t device;
+
+  if (!gsk_gpu_node_processor_rect_to_device_grow (self, &node->bounds, &device) ||
+      !gdk_rectangle_intersect (&device, &self->scissor, &device))
+    return 0;
+
+  return (gsize) device.width * device.height;
+}
+
+/* Checks if the node will be completely covered by opaque
+ * content that is drawn later in the same pass.
+ */
+static gboolean
+gsk_gpu_node_processor_is_occluded (GskGpuNodeProcessor *self,
+                                    GskRenderNode       *node)
+{
+  cairo_rectangle_int_t device;
+
+  if (self->occluded == NULL)
+    return FALSE;
+
+  if (!gsk_gpu_node_processor_rect_to_device_grow (self, &node->bounds, &device) ||
+      cairo_region_contains_rectangle (self->occluded, &device) != CAIRO_REGION_OVERLAP_IN)
+    return FALSE;
+
+  if (self->stats)
+    {
+      self->stats->culled_nodes++;
+      self->stats->culled_pixels += (gsize) device.width * device.height;
+    }
+
+  return TRUE;
+}
+
 static void
 gsk_gpu_node_processor_add_node (GskGpuNodeProcessor *self,
                                  GskRenderNode       *node)
 {
-  GskRenderNodeType node_type;
+  GskRenderNodeType node_type, parent_type;
 
   /* This catches the corner cases of empty nodes, so after this check
    * there's quaranteed to be at least 1 pixel that needs to be drawn
@@ -4093,26 +4948,39 @@ gsk_gpu_node_processor_add_node (GskGpuNodeProcessor *self,
       return;
     }
 
-  if (self->opacity < 1.0 && (nodes_vtable[node_type].features & GSK_GPU_HANDLE_OPACITY) == 0)
-    {
-      gsk_gpu_node_processor_add_without_opacity (self, node);
-      return;
-    }
+  if (gsk_gpu_node_processor_is_occluded (self, node))
+    return;
+
+  if (self->stats && gsk_render_node_type_is_leaf (node_type))
+    self->stats->drawn_pixels += gsk_gpu_node_processor_count_pixels (self, node);
 
-  gsk_gpu_node_processor_sync_globals (self, nodes_vtable[node_type].ignored_globals);
-  g_assert ((self->pending_globals & ~nodes_vtable[node_type].ignored_globals) == 0);
+  /* Attribute offscreens created for this node to it */
+  parent_type = gsk_gpu_frame_get_current_node_type (self->frame);
+  gsk_gpu_frame_set_current_node_type (self->frame, node_type);
 
-  if (nodes_vtable[node_type].process_node)
+  if (self->opacity < 1.0 && (nodes_vtable[node_type].features & GSK_GPU_HANDLE_OPACITY) == 0)
     {
-      nodes_vtable[node_type].process_node (self, node);
+      gsk_gpu_node_processor_add_without_opacity (self, node);
     }
   else
     {
-      g_warning_once ("Unimplemented node '%s'",
-                      g_type_name_from_instance ((GTypeInstance *) node));
-      /* Maybe it's implemented in the Cairo renderer? */
-      gsk_gpu_node_processor_add_cairo_node (self, node);
+      gsk_gpu_node_processor_sync_globals (self, nodes_vtable[node_type].ignored_globals);
+      g_assert ((self->pending_globals & ~nodes_vtable[node_type].ignored_globals) == 0);
+
+      if (nodes_vtable[node_type].process_node)
+        {
+          nodes_vtable[node_type].process_node (self, node);
+        }
+      else
+        {
+          g_warning_once ("Unimplemented node '%s'",
+                          g_type_name_from_instance ((GTypeInstance *) node));
+          /* Maybe it's implemented in the Cairo renderer? */
+          gsk_gpu_node_processor_add_cairo_node (self, node);
+        }
     }
+
+  gsk_gpu_frame_set_current_node_type (self->frame, parent_type);
 }
 
 static gboolean
@@ -4383,10 +5251,12 @@ gsk_gpu_node_processor_process (GskGpuFrame           *frame,
                                 GskRenderPassType      pass_type)
 {
   GskGpuNodeProcessor self;
+  GskGpuOcclusionStats stats = { 0, };
   GdkColorState *ccs;
   GskGpuImage *image;
   graphene_rect_t clip_bounds, tex_rect;
   cairo_rectangle_int_t extents;
+  gsize clip_pixels = 0;
   int i;
 
   ccs = gdk_color_state_get_rendering_color_state (target_color_state);
@@ -4400,6 +5270,18 @@ gsk_gpu_node_processor_process (GskGpuFrame           *frame,
                                &extents,
                                viewport);
 
+  if (GSK_DEBUG_CHECK (OCCLUSION))
+    {
+      for (i = 0; i < cairo_region_num_rectangles (clip); i++)
+        {
+          cairo_rectangle_int_t rect;
+
+          cairo_region_get_rectangle (clip, i, &rect);
+          clip_pixels += (gsize) rect.width * rect.height;
+        }
+      self.stats = &stats;
+    }
+
   if (gdk_color_state_equal (ccs, target_color_state))
     {
       gsk_gpu_node_processor_render (&self, target, clip, node, pass_type);
@@ -4452,6 +5334,12 @@ gsk_gpu_node_processor_process (GskGpuFrame           *frame,
         }
     }
 
+  if (self.stats && clip_pixels > 0)
+    GSK_DEBUG (OCCLUSION, "Overdraw %.2fx, culled %u nodes (%" G_GSIZE_FORMAT " pixels)",
+               (double) stats.drawn_pixels / clip_pixels,
+               stats.culled_nodes,
+               stats.culled_pixels);
+
   gsk_gpu_node_processor_finish (&self);
 
   cairo_region_destroy (clip);
@@ -75,6 +75,9 @@ struct _GskGpuOpClass
   GskGpuOp *            (* gl_command)                                  (GskGpuOp               *op,
                                                                          GskGpuFrame            *frame,
                                                                          GskGLCommandState      *state);
+  /* optional, called on a worker thread before commands are recorded.
+   * Must only access the op itself. */
+  void                  (* prepare)                                     (GskGpuOp               *op);
 };
 
 /* ensures alignment of ops to multiples of 16 bytes - and that makes graphene happy */
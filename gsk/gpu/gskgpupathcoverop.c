@@ -0,0 +1,86 @@
+#include "config.h"
+
+#include "gskgpupathcoveropprivate.h"
+
+#include "gskgpuframeprivate.h"
+#include "gskgpuprintprivate.h"
+#include "gskrectprivate.h"
+#include "gskenumtypes.h"
+
+#include "gpu/shaders/gskgpupathcoverinstance.h"
+
+typedef struct _GskGpuPathCoverOp GskGpuPathCoverOp;
+
+struct _GskGpuPathCoverOp
+{
+  GskGpuShaderOp op;
+};
+
+static void
+gsk_gpu_path_cover_op_print_instance (GskGpuShaderOp *shader,
+                                      gpointer        instance_,
+                                      GString        *string)
+{
+  GskGpuPathcoverInstance *instance = (GskGpuPathcoverInstance *) instance_;
+
+  gsk_gpu_print_enum (string, GSK_TYPE_FILL_RULE, shader->variation);
+  gsk_gpu_print_rect (string, instance->rect);
+  gsk_gpu_print_rgba (string, instance->color);
+  gsk_gpu_print_image (string, shader->images[0]);
+}
+
+static const GskGpuShaderOpClass GSK_GPU_PATH_COVER_OP_CLASS = {
+  {
+    GSK_GPU_OP_SIZE (GskGpuPathCoverOp),
+    GSK_GPU_STAGE_SHADER,
+    gsk_gpu_shader_op_finish,
+    gsk_gpu_shader_op_print,
+#ifdef GDK_RENDERING_VULKAN
+    gsk_gpu_shader_op_vk_command,
+#endif
+    gsk_gpu_shader_op_gl_command
+  },
+  "gskgpupathcover",
+  gsk_gpu_pathcover_n_textures,
+  sizeof (GskGpuPathcoverInstance),
+#ifdef GDK_RENDERING_VULKAN
+  &gsk_gpu_pathcover_info,
+#endif
+  gsk_gpu_path_cover_op_print_instance,
+  gsk_gpu_pathcover_setup_attrib_locations,
+  gsk_gpu_pathcover_setup_vao
+};
+
+/* Draws @color, using the winding numbers accumulated into
+ * @mask by the path op to compute the coverage.
+ */
+void
+gsk_gpu_path_cover_op (GskGpuFrame             *frame,
+                       GskGpuShaderClip         clip,
+                       GdkColorState           *ccs,
+                       float                    opacity,
+                       const graphene_point_t  *offset,
+                       GskFillRule              fill_rule,
+                       const GskGpuShaderImage *mask,
+                       const GdkColor          *color)
+{
+  GskGpuPathcoverInstance *instance;
+  GdkColorState *alt;
+
+  alt = gsk_gpu_color_states_find (ccs, color);
+
+  gsk_gpu_shader_op_alloc (frame,
+                           &GSK_GPU_PATH_COVER_OP_CLASS,
+                           gsk_gpu_color_states_create (ccs, TRUE, alt, FALSE),
+                           fill_rule,
+                           clip,
+                           mask->coverage ? mask->coverage : mask->bounds,
+                           offset,
+                           (GskGpuImage *[1]) { mask->image },
+                           (GskGpuSampler[1]) { mask->sampler },
+                           &instance);
+
+  gsk_gpu_rect_to_float (mask->coverage ? mask->coverage : mask->bounds, offset, instance->rect);
+  gsk_gpu_rect_to_float (mask->bounds, offset, instance->mask_rect);
+  gsk_gpu_color_to_float (color, alt, opacity, instance->color);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "gskgpushaderopprivate.h"
+
+#include <graphene.h>
+
+G_BEGIN_DECLS
+
+void                    gsk_gpu_path_cover_op                           (GskGpuFrame                    *frame,
+                                                                         GskGpuShaderClip                clip,
+                                                                         GdkColorState                  *ccs,
+                                                                         float                           opacity,
+                                                                         const graphene_point_t         *offset,
+                                                                         GskFillRule                     fill_rule,
+                                                                         const GskGpuShaderImage        *mask,
+                                                                         const GdkColor                 *color);
+
+
+G_END_DECLS
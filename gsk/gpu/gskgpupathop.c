@@ -0,0 +1,113 @@
+#include "config.h"
+
+#include "gskgpupathopprivate.h"
+
+#include "gskgpuframeprivate.h"
+#include "gskgpuprintprivate.h"
+#include "gskrectprivate.h"
+
+#include "gpu/shaders/gskgpupathinstance.h"
+
+/* keep in sync with shaders/enums.glsl */
+#define GSK_GPU_PATH_FILL_EDGE 0
+#define GSK_GPU_PATH_STROKE_SEGMENT 1
+
+typedef struct _GskGpuPathOp GskGpuPathOp;
+
+struct _GskGpuPathOp
+{
+  GskGpuShaderOp op;
+};
+
+static void
+gsk_gpu_path_op_print_instance (GskGpuShaderOp *shader,
+                                gpointer        instance_,
+                                GString        *string)
+{
+  GskGpuPathInstance *instance = (GskGpuPathInstance *) instance_;
+
+  gsk_gpu_print_string (string, shader->variation == GSK_GPU_PATH_FILL_EDGE ? "edge" : "segment");
+  gsk_gpu_print_rect (string, instance->rect);
+  g_string_append_printf (string, "%g %g -> %g %g ",
+                          instance->line[0], instance->line[1],
+                          instance->line[2], instance->line[3]);
+}
+
+static const GskGpuShaderOpClass GSK_GPU_PATH_OP_CLASS = {
+  {
+    GSK_GPU_OP_SIZE (GskGpuPathOp),
+    GSK_GPU_STAGE_SHADER,
+    gsk_gpu_shader_op_finish,
+    gsk_gpu_shader_op_print,
+#ifdef GDK_RENDERING_VULKAN
+    gsk_gpu_shader_op_vk_command,
+#endif
+    gsk_gpu_shader_op_gl_command
+  },
+  "gskgpupath",
+  gsk_gpu_path_n_textures,
+  sizeof (GskGpuPathInstance),
+#ifdef GDK_RENDERING_VULKAN
+  &gsk_gpu_path_info,
+#endif
+  gsk_gpu_path_op_print_instance,
+  gsk_gpu_path_setup_attrib_locations,
+  gsk_gpu_path_setup_vao
+};
+
+static void
+gsk_gpu_path_op (GskGpuFrame            *frame,
+                 guint32                 variation,
+                 const graphene_rect_t  *rect,
+                 const graphene_point_t *offset,
+                 const graphene_point_t *start,
+                 const graphene_point_t *end,
+                 float                   line_width)
+{
+  GskGpuPathInstance *instance;
+
+  gsk_gpu_shader_op_alloc (frame,
+                           &GSK_GPU_PATH_OP_CLASS,
+                           gsk_gpu_color_states_create_equal (TRUE, TRUE),
+                           variation,
+                           GSK_GPU_SHADER_CLIP_NONE,
+                           rect,
+                           offset,
+                           NULL,
+                           NULL,
+                           &instance);
+
+  gsk_gpu_rect_to_float (rect, offset, instance->rect);
+  gsk_gpu_point_to_float (start, offset, &instance->line[0]);
+  gsk_gpu_point_to_float (end, offset, &instance->line[2]);
+  instance->line_width = line_width;
+}
+
+/* Accumulates the signed area to the right of the edge into the
+ * target, which must be a float format using additive blending.
+ * @rect must extend to the right edge of the target.
+ */
+void
+gsk_gpu_path_fill_edge_op (GskGpuFrame            *frame,
+                           const graphene_rect_t  *rect,
+                           const graphene_point_t *offset,
+                           const graphene_point_t *start,
+                           const graphene_point_t *end)
+{
+  gsk_gpu_path_op (frame, GSK_GPU_PATH_FILL_EDGE, rect, offset, start, end, 0);
+}
+
+/* Accumulates the coverage of a line segment with round caps into
+ * the target, which must use max blending so that overlapping
+ * segments form a union.
+ */
+void
+gsk_gpu_path_stroke_segment_op (GskGpuFrame            *frame,
+                                const graphene_rect_t  *rect,
+                                const graphene_point_t *offset,
+                                const graphene_point_t *start,
+                                const graphene_point_t *end,
+                                float                   line_width)
+{
+  gsk_gpu_path_op (frame, GSK_GPU_PATH_STROKE_SEGMENT, rect, offset, start, end, line_width);
+}
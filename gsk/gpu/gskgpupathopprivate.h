@@ -0,0 +1,22 @@
+#pragma once
+
+#include "gskgpushaderopprivate.h"
+
+#include <graphene.h>
+
+G_BEGIN_DECLS
+
+void                    gsk_gpu_path_fill_edge_op                       (GskGpuFrame                    *frame,
+                                                                         const graphene_rect_t          *rect,
+                                                                         const graphene_point_t         *offset,
+                                                                         const graphene_point_t         *start,
+                                                                         const graphene_point_t         *end);
+void                    gsk_gpu_path_stroke_segment_op                  (GskGpuFrame                    *frame,
+                                                                         const graphene_rect_t          *rect,
+                                                                         const graphene_point_t         *offset,
+                                                                         const graphene_point_t         *start,
+                                                                         const graphene_point_t         *end,
+                                                                         float                           line_width);
+
+
+G_END_DECLS
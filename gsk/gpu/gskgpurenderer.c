@@ -6,6 +6,7 @@
 #include "gskgpudeviceprivate.h"
 #include "gskgpuframeprivate.h"
 #include "gskprivate.h"
+#include "gskprofilerprivate.h"
 #include "gskrendererprivate.h"
 #include "gskrendernodeprivate.h"
 #include "gskgpuimageprivate.h"
@@ -33,10 +34,40 @@ static const GdkDebugKey gsk_gpu_optimization_keys[] = {
   { "to-image",  GSK_GPU_OPTIMIZE_TO_IMAGE,          "Don't fast-path creation of images for nodes" },
   { "occlusion", GSK_GPU_OPTIMIZE_OCCLUSION_CULLING, "Disable occlusion culling via opaque node tracking" },
   { "repeat",    GSK_GPU_OPTIMIZE_REPEAT,            "Repeat drawing operations instead of using offscreen and GL_REPEAT" },
+  { "paths",     GSK_GPU_OPTIMIZE_PATHS,             "Rasterize fills and strokes with cairo instead of on the GPU" },
+  { "path-cache", GSK_GPU_OPTIMIZE_PATH_CACHE,       "Don't cache rasterized fills and strokes" },
+  { "threads",   GSK_GPU_OPTIMIZE_THREADS,           "Rasterize with cairo on the render thread only" },
+  { "async-upload", GSK_GPU_OPTIMIZE_ASYNC_UPLOAD,    "Convert large textures while drawing the frame instead of on a worker thread" },
+  { "sdf-glyphs", GSK_GPU_OPTIMIZE_SDF_GLYPHS,       "Rasterize large glyphs for every scale instead of using distance fields" },
 };
 
+typedef struct _GskGpuRenderJob GskGpuRenderJob;
 typedef struct _GskGpuRendererPrivate GskGpuRendererPrivate;
 
+/* A frame that was begun on the main thread and gets recorded and
+ * submitted on the render thread. The main thread ends it once the
+ * render thread is done with it.
+ */
+struct _GskGpuRenderJob
+{
+  GskGpuFrame *frame;
+  GskRenderNode *root;
+  GskGpuImage *backbuffer;
+  GdkColorState *color_state;
+  cairo_region_t *render_region; /* consumed by gsk_gpu_frame_render() */
+  graphene_rect_t viewport;
+  gint64 timestamp;
+  guint serial;
+};
+
+/* The idle that presents a job once the render thread is done */
+typedef struct _GskGpuPresent GskGpuPresent;
+struct _GskGpuPresent
+{
+  GskGpuRenderer *renderer;
+  guint serial;
+};
+
 struct _GskGpuRendererPrivate
 {
   GskGpuDevice *device;
@@ -44,8 +75,26 @@ struct _GskGpuRendererPrivate
   GskGpuOptimizations optimizations;
 
   GskGpuFrame *frames[GSK_GPU_MAX_FRAMES];
+
+  GQuark gpu_time_counters[GSK_RENDER_NODE_TYPE_N_TYPES];
+
+  /* draw calls of the last frame, only used on the main thread */
+  guint n_draws;
+  guint n_draws_unmerged;
+
+  /* render thread, protected by render_mutex */
+  GThread *render_thread;
+  GMutex render_mutex;
+  GCond render_cond;
+  GskGpuRenderJob *render_job;
+  guint render_job_serial; /* only used on the main thread */
+  guint render_job_queued : 1;
+  guint render_job_done : 1;
+  guint render_thread_quit : 1;
 };
 
+static guint render_wait_counter;
+
 static void     gsk_gpu_renderer_dmabuf_downloader_init         (GdkDmabufDownloaderInterface   *iface);
 
 G_DEFINE_TYPE_EXTENDED (GskGpuRenderer, gsk_gpu_renderer, GSK_TYPE_RENDERER, 0,
@@ -122,6 +171,203 @@ gsk_gpu_renderer_get_frame (GskGpuRenderer *self)
   return earliest_frame;
 }
 
+static void
+gsk_gpu_render_job_free (GskGpuRenderJob *job)
+{
+  g_object_unref (job->frame);
+  gsk_render_node_unref (job->root);
+  g_object_unref (job->backbuffer);
+  gdk_color_state_unref (job->color_state);
+  g_free (job);
+}
+
+static void
+gsk_gpu_renderer_record_draws (GskGpuRenderer *self,
+                               GskGpuFrame    *frame)
+{
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
+
+  priv->n_draws = gsk_gpu_frame_get_n_draws (frame, &priv->n_draws_unmerged);
+}
+
+/* Waits for the render thread to finish the frame it is working
+ * on and presents it. Must be called before the draw context or the
+ * frames are touched again from the main thread.
+ */
+static void
+gsk_gpu_renderer_finish_render_job (GskGpuRenderer *self)
+{
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
+  GskGpuRenderJob *job;
+  G_GNUC_UNUSED gint64 start_time = GDK_PROFILER_CURRENT_TIME;
+
+  if (priv->render_job == NULL)
+    return;
+
+  g_mutex_lock (&priv->render_mutex);
+  while (!priv->render_job_done)
+    g_cond_wait (&priv->render_cond, &priv->render_mutex);
+  job = g_steal_pointer (&priv->render_job);
+  priv->render_job_done = FALSE;
+  g_mutex_unlock (&priv->render_mutex);
+
+  if (GDK_PROFILER_IS_RUNNING)
+    {
+      gdk_profiler_end_mark (start_time, "Wait for render thread", NULL);
+      gdk_profiler_set_int_counter (render_wait_counter, GDK_PROFILER_CURRENT_TIME - start_time);
+    }
+
+  gsk_gpu_device_lock (priv->device);
+  gsk_gpu_renderer_record_draws (self, job->frame);
+  gsk_gpu_frame_end (job->frame, priv->context);
+  gsk_gpu_device_unlock (priv->device);
+
+  gsk_gpu_device_queue_gc (priv->device);
+
+  gsk_gpu_render_job_free (job);
+}
+
+static void
+gsk_gpu_present_free (gpointer data)
+{
+  GskGpuPresent *present = data;
+
+  g_object_unref (present->renderer);
+  g_free (present);
+}
+
+static gboolean
+gsk_gpu_renderer_present_cb (gpointer data)
+{
+  GskGpuPresent *present = data;
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (present->renderer);
+
+  /* The main thread may have presented the job itself already and
+   * queued the next one, which must not be waited for here */
+  if (priv->render_job && priv->render_job->serial == present->serial)
+    gsk_gpu_renderer_finish_render_job (present->renderer);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gsk_gpu_renderer_finish_render (GskRenderer *renderer)
+{
+  gsk_gpu_renderer_finish_render_job (GSK_GPU_RENDERER (renderer));
+}
+
+static gpointer
+gsk_gpu_renderer_render_thread (gpointer data)
+{
+  GskGpuRenderer *self = data;
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
+  GskGpuRenderJob *job;
+
+  g_mutex_lock (&priv->render_mutex);
+
+  while (TRUE)
+    {
+      G_GNUC_UNUSED gint64 start_time;
+
+      while (!priv->render_job_queued && !priv->render_thread_quit)
+        g_cond_wait (&priv->render_cond, &priv->render_mutex);
+
+      if (priv->render_thread_quit)
+        break;
+
+      job = priv->render_job;
+      priv->render_job_queued = FALSE;
+      g_mutex_unlock (&priv->render_mutex);
+
+      start_time = GDK_PROFILER_CURRENT_TIME;
+
+      gsk_gpu_device_lock (priv->device);
+      gsk_gpu_frame_render (job->frame,
+                            job->timestamp,
+                            job->backbuffer,
+                            job->color_state,
+                            job->render_region,
+                            job->root,
+                            &job->viewport,
+                            NULL);
+      gsk_gpu_device_unlock (priv->device);
+
+      gdk_profiler_end_mark (start_time, "Render thread", NULL);
+
+      g_mutex_lock (&priv->render_mutex);
+      priv->render_job_done = TRUE;
+      g_cond_broadcast (&priv->render_cond);
+
+      /* present from the main thread, unless it needs the frame
+       * earlier and does it itself */
+      g_idle_add_full (G_PRIORITY_DEFAULT,
+                       gsk_gpu_renderer_present_cb,
+                       g_memdup2 (&(GskGpuPresent) {
+                           .renderer = g_object_ref (self),
+                           .serial = job->serial,
+                       }, sizeof (GskGpuPresent)),
+                       gsk_gpu_present_free);
+    }
+
+  g_mutex_unlock (&priv->render_mutex);
+
+  return NULL;
+}
+
+static void
+gsk_gpu_renderer_queue_render_job (GskGpuRenderer  *self,
+                                   GskGpuRenderJob *job)
+{
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
+
+  g_assert (priv->render_job == NULL);
+
+  if (priv->render_thread == NULL)
+    {
+      if (render_wait_counter == 0)
+        render_wait_counter = gdk_profiler_define_int_counter ("render thread wait",
+                                                               "Microseconds the main thread waited for the render thread");
+      priv->render_thread = g_thread_new ("gsk-render", gsk_gpu_renderer_render_thread, self);
+    }
+
+  job->serial = ++priv->render_job_serial;
+
+  g_mutex_lock (&priv->render_mutex);
+  priv->render_job = job;
+  priv->render_job_queued = TRUE;
+  g_cond_broadcast (&priv->render_cond);
+  g_mutex_unlock (&priv->render_mutex);
+}
+
+/*
+ * gsk_gpu_renderer_stop_render_thread:
+ * @self: a renderer
+ *
+ * Presents the frame the render thread is working on, if any, and
+ * shuts the thread down.
+ *
+ * Subclasses must call this in their unrealize implementation before
+ * they release anything the last frame may still use.
+ */
+void
+gsk_gpu_renderer_stop_render_thread (GskGpuRenderer *self)
+{
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
+
+  if (priv->render_thread == NULL)
+    return;
+
+  gsk_gpu_renderer_finish_render_job (self);
+
+  g_mutex_lock (&priv->render_mutex);
+  priv->render_thread_quit = TRUE;
+  g_cond_broadcast (&priv->render_cond);
+  g_mutex_unlock (&priv->render_mutex);
+
+  g_clear_pointer (&priv->render_thread, g_thread_join);
+  priv->render_thread_quit = FALSE;
+}
+
 static void
 gsk_gpu_renderer_dmabuf_downloader_close (GdkDmabufDownloader *downloader)
 {
@@ -137,14 +383,19 @@ gsk_gpu_renderer_dmabuf_downloader_download (GdkDmabufDownloader *downloader,
                                              gsize                stride)
 {
   GskGpuRenderer *self = GSK_GPU_RENDERER (downloader);
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
   GskGpuFrame *frame;
   gpointer previous;
   gboolean retval = FALSE;
 
+  gsk_gpu_renderer_finish_render_job (self);
+
   previous = gsk_gpu_renderer_save_current (self);
 
   gsk_gpu_renderer_make_current (self);
 
+  gsk_gpu_device_lock (priv->device);
+
   frame = gsk_gpu_renderer_get_frame (self);
 
   if (gsk_gpu_frame_download_texture (frame,
@@ -168,6 +419,8 @@ gsk_gpu_renderer_dmabuf_downloader_download (GdkDmabufDownloader *downloader,
       gsk_gpu_frame_wait (frame);
     }
 
+  gsk_gpu_device_unlock (priv->device);
+
   gsk_gpu_renderer_restore_current (self, previous);
 
   return retval;
@@ -243,6 +496,8 @@ gsk_gpu_renderer_unrealize (GskRenderer *renderer)
   GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
   gsize i;
 
+  gsk_gpu_renderer_stop_render_thread (self);
+
   gsk_gpu_renderer_make_current (self);
 
   for (i = 0; i < G_N_ELEMENTS (priv->frames); i++)
@@ -370,10 +625,14 @@ gsk_gpu_renderer_render_texture (GskRenderer           *renderer,
   GdkColorState *color_state;
   cairo_region_t *clip_region;
 
+  gsk_gpu_renderer_finish_render_job (self);
+
   gsk_gpu_device_maybe_gc (priv->device);
 
   gsk_gpu_renderer_make_current (self);
 
+  gsk_gpu_device_lock (priv->device);
+
   rounded_viewport = GRAPHENE_RECT_INIT (viewport->origin.x,
                                          viewport->origin.y,
                                          ceil (viewport->size.width),
@@ -384,7 +643,11 @@ gsk_gpu_renderer_render_texture (GskRenderer           *renderer,
                                                 rounded_viewport.size.height);
 
   if (image == NULL)
-    return gsk_gpu_renderer_fallback_render_texture (self, root, &rounded_viewport);
+    {
+      texture = gsk_gpu_renderer_fallback_render_texture (self, root, &rounded_viewport);
+      gsk_gpu_device_unlock (priv->device);
+      return texture;
+    }
 
   if (gsk_gpu_image_get_flags (image) & GSK_GPU_IMAGE_SRGB)
     color_state = GDK_COLOR_STATE_SRGB_LINEAR;
@@ -409,9 +672,12 @@ gsk_gpu_renderer_render_texture (GskRenderer           *renderer,
                         &rounded_viewport,
                         &texture);
 
+  gsk_gpu_renderer_record_draws (self, frame);
   gsk_gpu_frame_wait (frame);
   g_object_unref (image);
 
+  gsk_gpu_device_unlock (priv->device);
+
   gsk_gpu_device_queue_gc (priv->device);
 
   /* check that callback setting texture was actually called, as its technically async */
@@ -430,11 +696,13 @@ gsk_gpu_renderer_render (GskRenderer          *renderer,
   GskGpuFrame *frame;
   GskGpuImage *backbuffer;
   cairo_region_t *render_region;
-  graphene_rect_t opaque_tmp;
+  graphene_rect_t opaque_tmp, viewport;
   const graphene_rect_t *opaque;
   double scale;
   GdkMemoryDepth depth;
 
+  gsk_gpu_renderer_finish_render_job (self);
+
   if (cairo_region_is_empty (region))
     {
       gdk_draw_context_empty_frame (priv->context);
@@ -445,6 +713,8 @@ gsk_gpu_renderer_render (GskRenderer          *renderer,
 
   gsk_gpu_renderer_make_current (self);
 
+  gsk_gpu_device_lock (priv->device);
+
   depth = gsk_render_node_get_preferred_depth (root);
   frame = gsk_gpu_renderer_get_frame (self);
   scale = gsk_gpu_renderer_get_scale (self);
@@ -459,21 +729,48 @@ gsk_gpu_renderer_render (GskRenderer          *renderer,
 
   render_region = get_render_region (self);
 
+  viewport = GRAPHENE_RECT_INIT (0, 0,
+                                 gsk_gpu_image_get_width (backbuffer) / scale,
+                                 gsk_gpu_image_get_height (backbuffer) / scale);
+
+  /* GL textures need the display's GL context to upload. That context
+   * is used on the main thread, so frames with them are rendered here.
+   */
+  if (GSK_GPU_RENDERER_GET_CLASS (self)->supports_render_thread &&
+      GSK_RENDERER_DEBUG_CHECK (renderer, RENDER_THREAD) &&
+      !gsk_render_node_uses_gl_texture (root))
+    {
+      GskGpuRenderJob *job;
+
+      gsk_gpu_device_unlock (priv->device);
+
+      job = g_new (GskGpuRenderJob, 1);
+      job->frame = g_object_ref (frame);
+      job->root = gsk_render_node_ref (root);
+      job->backbuffer = g_object_ref (backbuffer);
+      job->color_state = gdk_color_state_ref (gdk_draw_context_get_color_state (priv->context));
+      job->render_region = render_region;
+      job->viewport = viewport;
+      job->timestamp = g_get_monotonic_time ();
+
+      gsk_gpu_renderer_queue_render_job (self, job);
+      return;
+    }
+
   gsk_gpu_frame_render (frame,
                         g_get_monotonic_time (),
                         backbuffer,
                         gdk_draw_context_get_color_state (priv->context),
                         render_region,
                         root,
-                        &GRAPHENE_RECT_INIT (
-                          0, 0,
-                          gsk_gpu_image_get_width (backbuffer) / scale,
-                          gsk_gpu_image_get_height (backbuffer) / scale
-                        ),
+                        &viewport,
                         NULL);
 
+  gsk_gpu_renderer_record_draws (self, frame);
   gsk_gpu_frame_end (frame, priv->context);
 
+  gsk_gpu_device_unlock (priv->device);
+
   gsk_gpu_device_queue_gc (priv->device);
 }
 
@@ -488,17 +785,33 @@ gsk_gpu_renderer_real_get_scale (GskGpuRenderer *self)
   return gdk_surface_get_scale (surface);
 }
 
+static void
+gsk_gpu_renderer_finalize (GObject *object)
+{
+  GskGpuRenderer *self = GSK_GPU_RENDERER (object);
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
+
+  g_mutex_clear (&priv->render_mutex);
+  g_cond_clear (&priv->render_cond);
+
+  G_OBJECT_CLASS (gsk_gpu_renderer_parent_class)->finalize (object);
+}
+
 static void
 gsk_gpu_renderer_class_init (GskGpuRendererClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GskRendererClass *renderer_class = GSK_RENDERER_CLASS (klass);
 
+  object_class->finalize = gsk_gpu_renderer_finalize;
+
   renderer_class->supports_offload = TRUE;
 
   renderer_class->realize = gsk_gpu_renderer_realize;
   renderer_class->unrealize = gsk_gpu_renderer_unrealize;
   renderer_class->render = gsk_gpu_renderer_render;
   renderer_class->render_texture = gsk_gpu_renderer_render_texture;
+  renderer_class->finish_render = gsk_gpu_renderer_finish_render;
 
   gsk_ensure_resources ();
 
@@ -517,6 +830,9 @@ gsk_gpu_renderer_init (GskGpuRenderer *self)
   GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
 
   priv->optimizations = GSK_GPU_RENDERER_GET_CLASS (self)->optimizations;
+
+  g_mutex_init (&priv->render_mutex);
+  g_cond_init (&priv->render_cond);
 }
 
 GdkDrawContext *
@@ -540,3 +856,70 @@ gsk_gpu_renderer_get_scale (GskGpuRenderer *self)
 {
   return GSK_GPU_RENDERER_GET_CLASS (self)->get_scale (self);
 }
+
+/*
+ * gsk_gpu_renderer_get_n_draws:
+ * @self: a `GskGpuRenderer`
+ * @out_unmerged: (out) (optional): return location for the number
+ *   of draw calls before merging
+ *
+ * Gets the number of draw calls of the last rendered frame, for
+ * `gtk4-rendernode-tool benchmark`.
+ *
+ * Returns: the number of draw calls
+ */
+guint
+gsk_gpu_renderer_get_n_draws (GskGpuRenderer *self,
+                              guint          *out_unmerged)
+{
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
+
+  if (out_unmerged)
+    *out_unmerged = priv->n_draws_unmerged;
+
+  return priv->n_draws;
+}
+
+/*
+ * gsk_gpu_renderer_set_gpu_time:
+ * @self: the renderer
+ * @node_type: the node type that caused the render passes or
+ *   GSK_NOT_A_RENDER_NODE for the main pass
+ * @name: name of the node type
+ * @gpu_time_us: GPU time spent in those passes
+ *
+ * Reports the GPU time of a frame's render passes to the renderer's
+ * profiler, so the inspector recorder can show it.
+ *
+ * Counters are only created once a node type took time, so node
+ * types that never caused a render pass don't show up.
+ */
+void
+gsk_gpu_renderer_set_gpu_time (GskGpuRenderer    *self,
+                               GskRenderNodeType  node_type,
+                               const char        *name,
+                               gint64             gpu_time_us)
+{
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
+  GskProfiler *profiler;
+
+  g_return_if_fail (node_type < GSK_RENDER_NODE_TYPE_N_TYPES);
+
+  profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
+
+  if (priv->gpu_time_counters[node_type] == 0)
+    {
+      char *counter_name, *description;
+
+      if (gpu_time_us == 0)
+        return;
+
+      counter_name = g_strdup_printf ("gpu-time-%s", name);
+      description = g_strdup_printf ("GPU time of %s passes (usec)", name);
+      priv->gpu_time_counters[node_type] = gsk_profiler_add_counter (profiler, counter_name, description, FALSE);
+      g_free (description);
+      g_free (counter_name);
+    }
+
+  gsk_profiler_counter_set (profiler, priv->gpu_time_counters[node_type], gpu_time_us);
+}
@@ -24,6 +24,7 @@ struct _GskGpuRendererClass
 
   GType frame_type;
   GskGpuOptimizations optimizations; /* subclasses cannot override this */
+  gboolean supports_render_thread; /* frames can be recorded without make_current() */
 
   GskGpuDevice *        (* get_device)                                  (GdkDisplay             *display,
                                                                          GError                **error);
@@ -45,6 +46,13 @@ struct _GskGpuRendererClass
 GdkDrawContext *        gsk_gpu_renderer_get_context                    (GskGpuRenderer         *self);
 GskGpuDevice *          gsk_gpu_renderer_get_device                     (GskGpuRenderer         *self);
 double                  gsk_gpu_renderer_get_scale                      (GskGpuRenderer         *self);
+guint                   gsk_gpu_renderer_get_n_draws                    (GskGpuRenderer         *self,
+                                                                         guint                  *out_unmerged);
+void                    gsk_gpu_renderer_stop_render_thread             (GskGpuRenderer         *self);
+void                    gsk_gpu_renderer_set_gpu_time                   (GskGpuRenderer         *self,
+                                                                         GskRenderNodeType       node_type,
+                                                                         const char             *name,
+                                                                         gint64                  gpu_time_us);
 
 G_END_DECLS
 
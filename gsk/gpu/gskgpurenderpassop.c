@@ -24,6 +24,7 @@ struct _GskGpuRenderPassOp
   GskGpuLoadOp load_op;
   float clear_color[4];
   GskRenderPassType pass_type;
+  GskRenderNodeType node_type;
 };
 
 static void
@@ -134,10 +135,13 @@ gsk_gpu_render_pass_op_vk_command (GskGpuOp              *op,
                                    GskVulkanCommandState *state)
 {
   GskGpuRenderPassOp *self = (GskGpuRenderPassOp *) op;
+  guint timing;
 
   /* nesting frame passes not allowed */
   g_assert (state->vk_render_pass == VK_NULL_HANDLE);
 
+  timing = gsk_gpu_frame_begin_pass_timing (frame, self->node_type);
+
   gsk_gpu_render_pass_op_do_barriers (self, state);
 
   state->vk_format = gsk_vulkan_image_get_vk_format (GSK_VULKAN_IMAGE (self->target));
@@ -194,6 +198,8 @@ gsk_gpu_render_pass_op_vk_command (GskGpuOp              *op,
 
   op = gsk_gpu_op_vk_command (op, frame, state);
 
+  gsk_gpu_frame_end_pass_timing (frame, timing);
+
   return op;
 }
 #endif
@@ -204,10 +210,13 @@ gsk_gpu_render_pass_op_gl_command (GskGpuOp          *op,
                                    GskGLCommandState *state)
 {
   GskGpuRenderPassOp *self = (GskGpuRenderPassOp *) op;
+  guint timing;
 
   /* nesting frame passes not allowed */
   g_assert (state->flip_y == 0);
 
+  timing = gsk_gpu_frame_begin_pass_timing (frame, self->node_type);
+
   gsk_gl_image_bind_framebuffer (GSK_GL_IMAGE (self->target));
 
   if (gsk_gl_image_is_flipped (GSK_GL_IMAGE (self->target)))
@@ -237,6 +246,8 @@ gsk_gpu_render_pass_op_gl_command (GskGpuOp          *op,
 
   op = gsk_gpu_op_gl_command (op, frame, state);
 
+  gsk_gpu_frame_end_pass_timing (frame, timing);
+
   return op;
 }
 
@@ -374,6 +385,7 @@ gsk_gpu_render_pass_begin_op (GskGpuFrame                 *frame,
   if (self->load_op == GSK_GPU_LOAD_OP_CLEAR)
     gsk_gpu_vec4_to_float (clear_color, self->clear_color);
   self->pass_type = pass_type;
+  self->node_type = gsk_gpu_frame_get_current_node_type (frame);
 }
 
 void
@@ -68,6 +68,8 @@ gsk_gpu_rounded_color_op (GskGpuFrame            *frame,
                            gsk_gpu_color_states_create (ccs, TRUE, alt, FALSE),
                            0,
                            clip,
+                           &outline->bounds,
+                           offset,
                            NULL,
                            NULL,
                            &instance);
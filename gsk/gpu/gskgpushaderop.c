@@ -14,6 +14,7 @@
 #endif
 
 #include "gdkglcontextprivate.h"
+#include "gskrectprivate.h"
 
 /* maximum number of ops to merge into one call
  * If this number is too high, the command may take too long
@@ -21,6 +22,30 @@
  */
 #define MAX_MERGE_OPS (10 * 1000)
 
+/*
+ * gsk_gpu_shader_op_can_merge:
+ * @self: a shader op
+ * @other: another shader op
+ *
+ * Checks if the instances of both ops can be drawn with a single
+ * draw call, provided their vertex data is adjacent.
+ *
+ * Returns: %TRUE if the ops use the same shader and state
+ */
+gboolean
+gsk_gpu_shader_op_can_merge (const GskGpuShaderOp *self,
+                             const GskGpuShaderOp *other)
+{
+  const GskGpuShaderOpClass *shader_op_class = (const GskGpuShaderOpClass *) self->parent_op.op_class;
+
+  return other->parent_op.op_class == self->parent_op.op_class &&
+         other->flags == self->flags &&
+         other->color_states == self->color_states &&
+         other->variation == self->variation &&
+         (shader_op_class->n_textures < 1 || (other->images[0] == self->images[0] && other->samplers[0] == self->samplers[0])) &&
+         (shader_op_class->n_textures < 2 || (other->images[1] == self->images[1] && other->samplers[1] == self->samplers[1]));
+}
+
 void
 gsk_gpu_shader_op_finish (GskGpuOp *op)
 {
@@ -85,12 +110,8 @@ gsk_gpu_shader_op_vk_command_n (GskGpuOp              *op,
       GskGpuShaderOp *next_shader = (GskGpuShaderOp *) next;
   
       if (next->op_class != op->op_class ||
-          next_shader->flags != self->flags ||
-          next_shader->color_states != self->color_states ||
-          next_shader->variation != self->variation ||
           next_shader->vertex_offset != self->vertex_offset + n_ops * shader_op_class->vertex_size ||
-          (shader_op_class->n_textures > 0 && (next_shader->images[0] != self->images[0] || next_shader->samplers[0] != self->samplers[0])) ||
-          (shader_op_class->n_textures > 1 && (next_shader->images[1] != self->images[1] || next_shader->samplers[1] != self->samplers[1])))
+          !gsk_gpu_shader_op_can_merge (self, next_shader))
         break;
 
       n_ops += next_shader->n_ops;
@@ -205,12 +226,8 @@ gsk_gpu_shader_op_gl_command_n (GskGpuOp          *op,
       GskGpuShaderOp *next_shader = (GskGpuShaderOp *) next;
 
       if (next->op_class != op->op_class ||
-          next_shader->flags != self->flags ||
-          next_shader->color_states != self->color_states ||
-          next_shader->variation != self->variation ||
           next_shader->vertex_offset != self->vertex_offset + n_ops * shader_op_class->vertex_size ||
-          (shader_op_class->n_textures > 0 && (next_shader->images[0] != self->images[0] || next_shader->samplers[0] != self->samplers[0])) ||
-          (shader_op_class->n_textures > 1 && (next_shader->images[1] != self->images[1] || next_shader->samplers[1] != self->samplers[1])))
+          !gsk_gpu_shader_op_can_merge (self, next_shader))
         break;
 
       n_ops += next_shader->n_ops;
@@ -255,6 +272,8 @@ gsk_gpu_shader_op_alloc (GskGpuFrame               *frame,
                          GskGpuColorStates          color_states,
                          guint32                    variation,
                          GskGpuShaderClip           clip,
+                         const graphene_rect_t     *bounds,
+                         const graphene_point_t    *offset,
                          GskGpuImage              **images,
                          GskGpuSampler             *samplers,
                          gpointer                   out_vertex_data)
@@ -264,7 +283,9 @@ gsk_gpu_shader_op_alloc (GskGpuFrame               *frame,
   gsize i, vertex_offset, vertex_size, texture_vertex_size;
   guchar *vertex_data;
   GskGpuShaderFlags flags;
+  graphene_rect_t op_bounds;
 
+  gsk_rect_init_offset (&op_bounds, bounds, offset);
   flags = gsk_gpu_shader_flags_create (clip,
                                        op_class->n_textures > 0 && (gsk_gpu_image_get_flags (images[0]) & GSK_GPU_IMAGE_EXTERNAL),
                                        op_class->n_textures > 1 && (gsk_gpu_image_get_flags (images[1]) & GSK_GPU_IMAGE_EXTERNAL));
@@ -292,6 +313,7 @@ gsk_gpu_shader_op_alloc (GskGpuFrame               *frame,
       (op_class->n_textures < 2 || (last_shader->images[1] == images[1] && last_shader->samplers[1] == samplers[1])))
     {
       last_shader->n_ops++;
+      graphene_rect_union (&last_shader->bounds, &op_bounds, &last_shader->bounds);
     }
   else
     {
@@ -303,6 +325,7 @@ gsk_gpu_shader_op_alloc (GskGpuFrame               *frame,
       self->variation = variation;
       self->vertex_offset = vertex_offset;
       self->n_ops = 1;
+      self->bounds = op_bounds;
       for (i = 0; i < op_class->n_textures; i++)
         {
           self->images[i] = g_object_ref (images[i]);
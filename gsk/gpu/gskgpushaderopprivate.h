@@ -29,6 +29,7 @@ struct _GskGpuShaderOp
   guint32 variation;
   gsize vertex_offset;
   gsize n_ops;
+  graphene_rect_t bounds;       /* area drawn by all instances, in the basic coordinate system */
 };
 
 struct _GskGpuShaderOpClass
@@ -53,10 +54,15 @@ void                    gsk_gpu_shader_op_alloc                         (GskGpuF
                                                                          GskGpuColorStates       color_states,
                                                                          guint32                 variation,
                                                                          GskGpuShaderClip        clip,
+                                                                         const graphene_rect_t  *bounds,
+                                                                         const graphene_point_t *offset,
                                                                          GskGpuImage           **images,
                                                                          GskGpuSampler          *samplers,
                                                                          gpointer                out_vertex_data);
 
+gboolean                gsk_gpu_shader_op_can_merge                     (const GskGpuShaderOp   *self,
+                                                                         const GskGpuShaderOp   *other);
+
 void                    gsk_gpu_shader_op_finish                        (GskGpuOp               *op);
 
 void                    gsk_gpu_shader_op_print                         (GskGpuOp               *op,
@@ -62,6 +62,8 @@ gsk_gpu_texture_op (GskGpuFrame             *frame,
                            gsk_gpu_color_states_create_equal (TRUE, TRUE),
                            0,
                            clip,
+                           image->coverage ? image->coverage : image->bounds,
+                           offset,
                            (GskGpuImage *[1]) { image->image },
                            (GskGpuSampler[1]) { image->sampler },
                            &instance);
@@ -19,6 +19,7 @@ typedef guint32                         GskGpuShaderFlags;
 typedef struct _GskGpuShaderImage       GskGpuShaderImage;
 typedef struct _GskGpuShaderOp          GskGpuShaderOp;
 typedef struct _GskGpuShaderOpClass     GskGpuShaderOpClass;
+typedef struct _GskGpuStagedUpload      GskGpuStagedUpload;
 typedef struct _GskVulkanSemaphores     GskVulkanSemaphores;
 
 typedef enum {
@@ -55,7 +56,8 @@ typedef enum {
   GSK_GPU_BLEND_NONE,
   GSK_GPU_BLEND_OVER,
   GSK_GPU_BLEND_ADD,
-  GSK_GPU_BLEND_CLEAR
+  GSK_GPU_BLEND_CLEAR,
+  GSK_GPU_BLEND_MAX
 } GskGpuBlend;
 
 /* We only need this for the final VkImageLayout, but don't tell anyone */
@@ -140,5 +142,10 @@ typedef enum {
   GSK_GPU_OPTIMIZE_TO_IMAGE             = 1 <<  5,
   GSK_GPU_OPTIMIZE_OCCLUSION_CULLING    = 1 <<  6,
   GSK_GPU_OPTIMIZE_REPEAT               = 1 <<  7,
+  GSK_GPU_OPTIMIZE_PATHS                = 1 <<  8,
+  GSK_GPU_OPTIMIZE_PATH_CACHE           = 1 <<  9,
+  GSK_GPU_OPTIMIZE_THREADS              = 1 << 10,
+  GSK_GPU_OPTIMIZE_ASYNC_UPLOAD         = 1 << 11,
+  GSK_GPU_OPTIMIZE_SDF_GLYPHS           = 1 << 12,
 } GskGpuOptimizations;
 
@@ -14,27 +14,26 @@
 
 #include "gdk/gdkcolorstateprivate.h"
 #include "gdk/gdkglcontextprivate.h"
+#include "gdk/gdkmemorytextureprivate.h"
+#include "gdk/gdkprofilerprivate.h"
+#include "gdk/gdksurfaceprivate.h"
 #include "gsk/gskdebugprivate.h"
 
-static GskGpuOp *
-gsk_gpu_upload_op_gl_command_with_area (GskGpuOp                    *op,
-                                        GskGpuFrame                 *frame,
-                                        GskGpuImage                 *image,
-                                        const cairo_rectangle_int_t *area,
-                                        void           (* draw_func) (GskGpuOp *, guchar *, gsize))
+#include <math.h>
+
+static void
+gsk_gpu_upload_op_gl_upload (GskGpuImage                 *image,
+                             const cairo_rectangle_int_t *area,
+                             const guchar                *data,
+                             gsize                        stride)
 {
   GskGLImage *gl_image = GSK_GL_IMAGE (image);
   GdkMemoryFormat format;
-  gsize stride, bpp;
-  guchar *data;
+  gsize bpp;
   guint gl_format, gl_type;
 
   format = gsk_gpu_image_get_format (image);
   bpp = gdk_memory_format_bytes_per_pixel (format);
-  stride = area->width * bpp;
-  data = g_malloc (area->height * stride);
-
-  draw_func (op, data, stride);
 
   gl_format = gsk_gl_image_get_gl_format (gl_image);
   gl_type = gsk_gl_image_get_gl_type (gl_image);
@@ -67,6 +66,24 @@ gsk_gpu_upload_op_gl_command_with_area (GskGpuOp                    *op,
     }
 
   glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
+}
+
+static GskGpuOp *
+gsk_gpu_upload_op_gl_command_with_area (GskGpuOp                    *op,
+                                        GskGpuFrame                 *frame,
+                                        GskGpuImage                 *image,
+                                        const cairo_rectangle_int_t *area,
+                                        void           (* draw_func) (GskGpuOp *, guchar *, gsize))
+{
+  gsize stride;
+  guchar *data;
+
+  stride = area->width * gdk_memory_format_bytes_per_pixel (gsk_gpu_image_get_format (image));
+  data = g_malloc (area->height * stride);
+
+  draw_func (op, data, stride);
+
+  gsk_gpu_upload_op_gl_upload (image, area, data, stride);
 
   g_free (data);
 
@@ -91,27 +108,13 @@ gsk_gpu_upload_op_gl_command (GskGpuOp          *op,
 }
 
 #ifdef GDK_RENDERING_VULKAN
-static GskGpuOp *
-gsk_gpu_upload_op_vk_command_with_area (GskGpuOp                    *op,
-                                        GskGpuFrame                 *frame,
-                                        GskVulkanCommandState       *state,
-                                        GskVulkanImage              *image,
-                                        const cairo_rectangle_int_t *area,
-                                        void           (* draw_func) (GskGpuOp *, guchar *, gsize),
-                                        GskGpuBuffer               **buffer)
+/* The buffer must contain the area tightly packed */
+static void
+gsk_gpu_upload_op_vk_copy_buffer (GskVulkanCommandState       *state,
+                                  GskVulkanImage              *image,
+                                  const cairo_rectangle_int_t *area,
+                                  GskGpuBuffer                *buffer)
 {
-  gsize stride;
-  guchar *data;
-
-  stride = area->width * gdk_memory_format_bytes_per_pixel (gsk_gpu_image_get_format (GSK_GPU_IMAGE (image)));
-  *buffer = gsk_vulkan_buffer_new_write (GSK_VULKAN_DEVICE (gsk_gpu_frame_get_device (frame)),
-                                         area->height * stride);
-  data = gsk_gpu_buffer_map (*buffer);
-
-  draw_func (op, data, stride);
-
-  gsk_gpu_buffer_unmap (*buffer, area->height * stride);
-
   vkCmdPipelineBarrier (state->vk_command_buffer,
                         VK_PIPELINE_STAGE_HOST_BIT,
                         VK_PIPELINE_STAGE_TRANSFER_BIT,
@@ -123,7 +126,7 @@ gsk_gpu_upload_op_vk_command_with_area (GskGpuOp                    *op,
                             .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
                             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
                             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                            .buffer = gsk_vulkan_buffer_get_vk_buffer (GSK_VULKAN_BUFFER (*buffer)),
+                            .buffer = gsk_vulkan_buffer_get_vk_buffer (GSK_VULKAN_BUFFER (buffer)),
                             .offset = 0,
                             .size = VK_WHOLE_SIZE,
                         },
@@ -136,7 +139,7 @@ gsk_gpu_upload_op_vk_command_with_area (GskGpuOp                    *op,
                                VK_ACCESS_TRANSFER_WRITE_BIT);
 
   vkCmdCopyBufferToImage (state->vk_command_buffer,
-                          gsk_vulkan_buffer_get_vk_buffer (GSK_VULKAN_BUFFER (*buffer)),
+                          gsk_vulkan_buffer_get_vk_buffer (GSK_VULKAN_BUFFER (buffer)),
                           gsk_vulkan_image_get_vk_image (image),
                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                           1,
@@ -163,6 +166,30 @@ gsk_gpu_upload_op_vk_command_with_area (GskGpuOp                    *op,
                                    }
                                }
                           });
+}
+
+static GskGpuOp *
+gsk_gpu_upload_op_vk_command_with_area (GskGpuOp                    *op,
+                                        GskGpuFrame                 *frame,
+                                        GskVulkanCommandState       *state,
+                                        GskVulkanImage              *image,
+                                        const cairo_rectangle_int_t *area,
+                                        void           (* draw_func) (GskGpuOp *, guchar *, gsize),
+                                        GskGpuBuffer               **buffer)
+{
+  gsize stride;
+  guchar *data;
+
+  stride = area->width * gdk_memory_format_bytes_per_pixel (gsk_gpu_image_get_format (GSK_GPU_IMAGE (image)));
+  *buffer = gsk_vulkan_buffer_new_write (GSK_VULKAN_DEVICE (gsk_gpu_frame_get_device (frame)),
+                                         area->height * stride);
+  data = gsk_gpu_buffer_map (*buffer);
+
+  draw_func (op, data, stride);
+
+  gsk_gpu_buffer_unmap (*buffer, area->height * stride);
+
+  gsk_gpu_upload_op_vk_copy_buffer (state, image, area, *buffer);
 
   return op->next;
 }
@@ -278,6 +305,10 @@ gsk_gpu_upload_texture_op_draw (GskGpuOp *op,
       g_bytes_unref (bytes);
     }
   gdk_texture_downloader_free (downloader);
+
+  /* The GPU has its own copy now */
+  if (GDK_IS_MEMORY_TEXTURE (self->texture))
+    gdk_memory_texture_release_pages (GDK_MEMORY_TEXTURE (self->texture));
 }
 
 #ifdef GDK_RENDERING_VULKAN
@@ -321,14 +352,12 @@ static const GskGpuOpClass GSK_GPU_UPLOAD_TEXTURE_OP_CLASS = {
   gsk_gpu_upload_texture_op_gl_command
 };
 
-GskGpuImage *
-gsk_gpu_upload_texture_op_try (GskGpuFrame      *frame,
-                               gboolean          with_mipmap,
-                               guint             lod_level,
-                               GskScalingFilter  lod_filter,
-                               GdkTexture       *texture)
+static GskGpuImage *
+gsk_gpu_upload_texture_create_image (GskGpuFrame *frame,
+                                     gboolean     with_mipmap,
+                                     guint        lod_level,
+                                     GdkTexture  *texture)
 {
-  GskGpuUploadTextureOp *self;
   GskGpuImage *image;
   GdkMemoryFormat format;
 
@@ -368,6 +397,23 @@ gsk_gpu_upload_texture_op_try (GskGpuFrame      *frame,
       g_type_class_unref (enum_class);
     }
 
+  return image;
+}
+
+GskGpuImage *
+gsk_gpu_upload_texture_op_try (GskGpuFrame      *frame,
+                               gboolean          with_mipmap,
+                               guint             lod_level,
+                               GskScalingFilter  lod_filter,
+                               GdkTexture       *texture)
+{
+  GskGpuUploadTextureOp *self;
+  GskGpuImage *image;
+
+  image = gsk_gpu_upload_texture_create_image (frame, with_mipmap, lod_level, texture);
+  if (image == NULL)
+    return NULL;
+
   self = (GskGpuUploadTextureOp *) gsk_gpu_op_alloc (frame, &GSK_GPU_UPLOAD_TEXTURE_OP_CLASS);
 
   self->texture = g_object_ref (texture);
@@ -378,6 +424,264 @@ gsk_gpu_upload_texture_op_try (GskGpuFrame      *frame,
   return g_object_ref (self->image);
 }
 
+/* A staged upload converts the texture's pixels into the image's format
+ * on a worker thread, writing them straight into a persistently mapped
+ * buffer. Once that is done, the upload op is just a copy.
+ */
+struct _GskGpuStagedUpload
+{
+  GskGpuImage *image;
+  GdkTexture *texture;
+  GskGpuBuffer *buffer;
+  guchar *data;
+  gsize stride;
+
+  /* The upload may be created on the render thread, so this
+   * needs a thread-safe weak ref rather than a weak pointer */
+  GWeakRef surface;
+  gint64 start_time;
+  G_GNUC_UNUSED gint64 profiler_time;
+
+  /* set in the main thread, read by the thread doing the rendering */
+  int ready;
+};
+
+static void
+gsk_gpu_staged_upload_free (gpointer data)
+{
+  GskGpuStagedUpload *self = data;
+
+  if (self->buffer)
+    g_object_unref (self->buffer);
+  else
+    g_free (self->data);
+
+  g_weak_ref_clear (&self->surface);
+  g_object_unref (self->texture);
+  g_object_unref (self->image);
+}
+
+GskGpuStagedUpload *
+gsk_gpu_staged_upload_ref (GskGpuStagedUpload *self)
+{
+  return g_rc_box_acquire (self);
+}
+
+void
+gsk_gpu_staged_upload_unref (GskGpuStagedUpload *self)
+{
+  g_rc_box_release_full (self, gsk_gpu_staged_upload_free);
+}
+
+gboolean
+gsk_gpu_staged_upload_is_ready (GskGpuStagedUpload *self)
+{
+  return g_atomic_int_get (&self->ready);
+}
+
+static void
+gsk_gpu_staged_upload_thread (GTask        *task,
+                              gpointer      source_object,
+                              gpointer      task_data,
+                              GCancellable *cancellable)
+{
+  GskGpuStagedUpload *self = task_data;
+  GdkTextureDownloader *downloader;
+
+  /* The upload is kept alive by the callback, and we only
+   * touch the fields that don't change after creation. */
+  downloader = gdk_texture_downloader_new (self->texture);
+  gdk_texture_downloader_set_format (downloader, gsk_gpu_image_get_format (self->image));
+  gdk_texture_downloader_set_color_state (downloader, gdk_texture_get_color_state (self->texture));
+  gdk_texture_downloader_download_into (downloader, self->data, self->stride);
+  gdk_texture_downloader_free (downloader);
+
+  if (GDK_IS_MEMORY_TEXTURE (self->texture))
+    gdk_memory_texture_release_pages (GDK_MEMORY_TEXTURE (self->texture));
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+gsk_gpu_staged_upload_done (GObject      *source,
+                            GAsyncResult *result,
+                            gpointer      data)
+{
+  GskGpuStagedUpload *self = data;
+  GdkSurface *surface;
+
+  g_atomic_int_set (&self->ready, TRUE);
+
+  gdk_profiler_end_markf (self->profiler_time,
+                          "Staged texture upload", "%" G_GSIZE_FORMAT "x%" G_GSIZE_FORMAT,
+                          gsk_gpu_image_get_width (self->image),
+                          gsk_gpu_image_get_height (self->image));
+  GSK_DEBUG (CACHE, "Staged upload of %" G_GSIZE_FORMAT "x%" G_GSIZE_FORMAT " texture converted after %.1fms",
+             gsk_gpu_image_get_width (self->image),
+             gsk_gpu_image_get_height (self->image),
+             (g_get_monotonic_time () - self->start_time) / 1000.0);
+
+  /* We can't know where the texture is drawn, so redraw everything */
+  surface = g_weak_ref_get (&self->surface);
+  if (surface)
+    {
+      gdk_surface_invalidate_rect (surface, NULL);
+      g_object_unref (surface);
+    }
+
+  gsk_gpu_staged_upload_unref (self);
+}
+
+GskGpuStagedUpload *
+gsk_gpu_staged_upload_new (GskGpuFrame *frame,
+                           gboolean     with_mipmap,
+                           GdkTexture  *texture,
+                           GdkSurface  *surface)
+{
+  GskGpuStagedUpload *self;
+  GskGpuImage *image;
+  GTask *task;
+  gsize size;
+
+  image = gsk_gpu_upload_texture_create_image (frame, with_mipmap, 0, texture);
+  if (image == NULL)
+    return NULL;
+
+  self = g_rc_box_new0 (GskGpuStagedUpload);
+  self->image = image;
+  self->texture = g_object_ref (texture);
+  self->stride = gsk_gpu_image_get_width (image) * gdk_memory_format_bytes_per_pixel (gsk_gpu_image_get_format (image));
+  size = self->stride * gsk_gpu_image_get_height (image);
+#ifdef GDK_RENDERING_VULKAN
+  if (GSK_IS_VULKAN_DEVICE (gsk_gpu_frame_get_device (frame)))
+    {
+      self->buffer = gsk_vulkan_buffer_new_write (GSK_VULKAN_DEVICE (gsk_gpu_frame_get_device (frame)), size);
+      self->data = gsk_gpu_buffer_map (self->buffer);
+    }
+  else
+#endif
+    self->data = g_malloc (size);
+  g_weak_ref_init (&self->surface, surface);
+  self->start_time = g_get_monotonic_time ();
+  self->profiler_time = GDK_PROFILER_CURRENT_TIME;
+
+  /* The render thread has no main context of its own, so the
+   * callback always runs on the main thread */
+  task = g_task_new (NULL, NULL, gsk_gpu_staged_upload_done, gsk_gpu_staged_upload_ref (self));
+  g_task_set_source_tag (task, gsk_gpu_staged_upload_new);
+  g_task_set_task_data (task, self, NULL);
+  g_task_run_in_thread (task, gsk_gpu_staged_upload_thread);
+  g_object_unref (task);
+
+  return self;
+}
+
+typedef struct _GskGpuUploadStagedOp GskGpuUploadStagedOp;
+
+struct _GskGpuUploadStagedOp
+{
+  GskGpuOp op;
+
+  GskGpuStagedUpload *upload;
+};
+
+static void
+gsk_gpu_upload_staged_op_finish (GskGpuOp *op)
+{
+  GskGpuUploadStagedOp *self = (GskGpuUploadStagedOp *) op;
+
+  gsk_gpu_staged_upload_unref (self->upload);
+}
+
+static void
+gsk_gpu_upload_staged_op_print (GskGpuOp    *op,
+                                GskGpuFrame *frame,
+                                GString     *string,
+                                guint        indent)
+{
+  GskGpuUploadStagedOp *self = (GskGpuUploadStagedOp *) op;
+
+  gsk_gpu_print_op (string, indent, "upload-staged");
+  gsk_gpu_print_image (string, self->upload->image);
+  gsk_gpu_print_newline (string);
+}
+
+#ifdef GDK_RENDERING_VULKAN
+static GskGpuOp *
+gsk_gpu_upload_staged_op_vk_command (GskGpuOp              *op,
+                                     GskGpuFrame           *frame,
+                                     GskVulkanCommandState *state)
+{
+  GskGpuUploadStagedOp *self = (GskGpuUploadStagedOp *) op;
+  GskGpuStagedUpload *upload = self->upload;
+  gsize height = gsk_gpu_image_get_height (upload->image);
+
+  gsk_gpu_buffer_unmap (upload->buffer, upload->stride * height);
+
+  gsk_gpu_upload_op_vk_copy_buffer (state,
+                                    GSK_VULKAN_IMAGE (upload->image),
+                                    &(cairo_rectangle_int_t) {
+                                        0, 0,
+                                        gsk_gpu_image_get_width (upload->image),
+                                        height
+                                    },
+                                    upload->buffer);
+
+  return op->next;
+}
+#endif
+
+static GskGpuOp *
+gsk_gpu_upload_staged_op_gl_command (GskGpuOp          *op,
+                                     GskGpuFrame       *frame,
+                                     GskGLCommandState *state)
+{
+  GskGpuUploadStagedOp *self = (GskGpuUploadStagedOp *) op;
+  GskGpuStagedUpload *upload = self->upload;
+
+  gsk_gpu_upload_op_gl_upload (upload->image,
+                               &(cairo_rectangle_int_t) {
+                                   0, 0,
+                                   gsk_gpu_image_get_width (upload->image),
+                                   gsk_gpu_image_get_height (upload->image)
+                               },
+                               upload->data,
+                               upload->stride);
+
+  return op->next;
+}
+
+static const GskGpuOpClass GSK_GPU_UPLOAD_STAGED_OP_CLASS = {
+  GSK_GPU_OP_SIZE (GskGpuUploadStagedOp),
+  GSK_GPU_STAGE_UPLOAD,
+  gsk_gpu_upload_staged_op_finish,
+  gsk_gpu_upload_staged_op_print,
+#ifdef GDK_RENDERING_VULKAN
+  gsk_gpu_upload_staged_op_vk_command,
+#endif
+  gsk_gpu_upload_staged_op_gl_command
+};
+
+GskGpuImage *
+gsk_gpu_upload_staged_op (GskGpuFrame        *frame,
+                          GskGpuStagedUpload *upload)
+{
+  GskGpuUploadStagedOp *self;
+
+  g_return_val_if_fail (gsk_gpu_staged_upload_is_ready (upload), NULL);
+
+  self = (GskGpuUploadStagedOp *) gsk_gpu_op_alloc (frame, &GSK_GPU_UPLOAD_STAGED_OP_CLASS);
+
+  self->upload = gsk_gpu_staged_upload_ref (upload);
+
+  GSK_DEBUG (CACHE, "Staged upload of %" G_GSIZE_FORMAT "x%" G_GSIZE_FORMAT " texture uploaded after %.1fms",
+             gsk_gpu_image_get_width (upload->image),
+             gsk_gpu_image_get_height (upload->image),
+             (g_get_monotonic_time () - upload->start_time) / 1000.0);
+
+  return g_object_ref (upload->image);
+}
+
 typedef struct _GskGpuUploadCairoOp GskGpuUploadCairoOp;
 
 struct _GskGpuUploadCairoOp
@@ -385,11 +689,17 @@ struct _GskGpuUploadCairoOp
   GskGpuOp op;
 
   GskGpuImage *image;
-  graphene_rect_t viewport;
+  cairo_rectangle_int_t area;
+  graphene_vec2_t scale;
+  graphene_point_t origin;
   GskGpuCairoFunc func;
   gpointer user_data;
   GDestroyNotify user_destroy;
 
+  /* set if the op was prepared on a thread */
+  guchar *pixels;
+  gsize pixels_stride;
+
   GskGpuBuffer *buffer;
 };
 
@@ -401,6 +711,7 @@ gsk_gpu_upload_cairo_op_finish (GskGpuOp *op)
   g_object_unref (self->image);
   if (self->user_destroy)
     self->user_destroy (self->user_data);
+  g_clear_pointer (&self->pixels, g_free);
   g_clear_object (&self->buffer);
 }
 
@@ -414,34 +725,31 @@ gsk_gpu_upload_cairo_op_print (GskGpuOp    *op,
 
   gsk_gpu_print_op (string, indent, "upload-cairo");
   gsk_gpu_print_image (string, self->image);
+  gsk_gpu_print_int_rect (string, &self->area);
   gsk_gpu_print_newline (string);
 }
 
 static void
-gsk_gpu_upload_cairo_op_draw (GskGpuOp *op,
-                              guchar   *data,
-                              gsize     stride)
+gsk_gpu_upload_cairo_op_render (GskGpuUploadCairoOp *self,
+                                guchar              *data,
+                                gsize                stride)
 {
-  GskGpuUploadCairoOp *self = (GskGpuUploadCairoOp *) op;
   cairo_surface_t *surface;
   cairo_t *cr;
-  int width, height;
-
-  width = gsk_gpu_image_get_width (self->image);
-  height = gsk_gpu_image_get_height (self->image);
 
   surface = cairo_image_surface_create_for_data (data,
                                                  CAIRO_FORMAT_ARGB32,
-                                                 width, height,
+                                                 self->area.width,
+                                                 self->area.height,
                                                  stride);
   cairo_surface_set_device_scale (surface,
-                                  width / self->viewport.size.width,
-                                  height / self->viewport.size.height);
+                                  graphene_vec2_get_x (&self->scale),
+                                  graphene_vec2_get_y (&self->scale));
+  cairo_surface_set_device_offset (surface, self->origin.x, self->origin.y);
   cr = cairo_create (surface);
   cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
   cairo_paint (cr);
   cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
-  cairo_translate (cr, -self->viewport.origin.x, -self->viewport.origin.y);
 
   self->func (self->user_data, cr);
 
@@ -451,6 +759,39 @@ gsk_gpu_upload_cairo_op_draw (GskGpuOp *op,
   cairo_surface_destroy (surface);
 }
 
+static void
+gsk_gpu_upload_cairo_op_draw (GskGpuOp *op,
+                              guchar   *data,
+                              gsize     stride)
+{
+  GskGpuUploadCairoOp *self = (GskGpuUploadCairoOp *) op;
+  gsize y;
+
+  if (self->pixels == NULL)
+    {
+      gsk_gpu_upload_cairo_op_render (self, data, stride);
+      return;
+    }
+
+  for (y = 0; y < self->area.height; y++)
+    {
+      memcpy (data + y * stride,
+              self->pixels + y * self->pixels_stride,
+              self->area.width * 4);
+    }
+}
+
+static void
+gsk_gpu_upload_cairo_op_prepare (GskGpuOp *op)
+{
+  GskGpuUploadCairoOp *self = (GskGpuUploadCairoOp *) op;
+
+  self->pixels_stride = self->area.width * 4;
+  self->pixels = g_malloc (self->pixels_stride * self->area.height);
+
+  gsk_gpu_upload_cairo_op_render (self, self->pixels, self->pixels_stride);
+}
+
 #ifdef GDK_RENDERING_VULKAN
 static GskGpuOp *
 gsk_gpu_upload_cairo_op_vk_command (GskGpuOp              *op,
@@ -459,12 +800,23 @@ gsk_gpu_upload_cairo_op_vk_command (GskGpuOp              *op,
 {
   GskGpuUploadCairoOp *self = (GskGpuUploadCairoOp *) op;
 
-  return gsk_gpu_upload_op_vk_command (op,
-                                       frame,
-                                       state,
-                                       GSK_VULKAN_IMAGE (self->image),
-                                       gsk_gpu_upload_cairo_op_draw,
-                                       &self->buffer);
+  if (self->area.x == 0 && self->area.y == 0 &&
+      self->area.width == gsk_gpu_image_get_width (self->image) &&
+      self->area.height == gsk_gpu_image_get_height (self->image))
+    return gsk_gpu_upload_op_vk_command (op,
+                                         frame,
+                                         state,
+                                         GSK_VULKAN_IMAGE (self->image),
+                                         gsk_gpu_upload_cairo_op_draw,
+                                         &self->buffer);
+
+  return gsk_gpu_upload_op_vk_command_with_area (op,
+                                                 frame,
+                                                 state,
+                                                 GSK_VULKAN_IMAGE (self->image),
+                                                 &self->area,
+                                                 gsk_gpu_upload_cairo_op_draw,
+                                                 &self->buffer);
 }
 #endif
 
@@ -475,10 +827,11 @@ gsk_gpu_upload_cairo_op_gl_command (GskGpuOp          *op,
 {
   GskGpuUploadCairoOp *self = (GskGpuUploadCairoOp *) op;
 
-  return gsk_gpu_upload_op_gl_command (op,
-                                       frame,
-                                       self->image,
-                                       gsk_gpu_upload_cairo_op_draw);
+  return gsk_gpu_upload_op_gl_command_with_area (op,
+                                                 frame,
+                                                 self->image,
+                                                 &self->area,
+                                                 gsk_gpu_upload_cairo_op_draw);
 }
 
 static const GskGpuOpClass GSK_GPU_UPLOAD_CAIRO_OP_CLASS = {
@@ -492,25 +845,56 @@ static const GskGpuOpClass GSK_GPU_UPLOAD_CAIRO_OP_CLASS = {
   gsk_gpu_upload_cairo_op_gl_command
 };
 
+static const GskGpuOpClass GSK_GPU_UPLOAD_CAIRO_THREADSAFE_OP_CLASS = {
+  GSK_GPU_OP_SIZE (GskGpuUploadCairoOp),
+  GSK_GPU_STAGE_UPLOAD,
+  gsk_gpu_upload_cairo_op_finish,
+  gsk_gpu_upload_cairo_op_print,
+#ifdef GDK_RENDERING_VULKAN
+  gsk_gpu_upload_cairo_op_vk_command,
+#endif
+  gsk_gpu_upload_cairo_op_gl_command,
+  gsk_gpu_upload_cairo_op_prepare,
+};
+
+static const GskGpuOpClass *
+gsk_gpu_upload_cairo_op_get_class (GskGpuUploadCairoFlags flags)
+{
+  if (flags & GSK_GPU_UPLOAD_CAIRO_THREADSAFE)
+    return &GSK_GPU_UPLOAD_CAIRO_THREADSAFE_OP_CLASS;
+  else
+    return &GSK_GPU_UPLOAD_CAIRO_OP_CLASS;
+}
+
 GskGpuImage *
 gsk_gpu_upload_cairo_op (GskGpuFrame           *frame,
                          const graphene_vec2_t *scale,
                          const graphene_rect_t *viewport,
+                         GskGpuUploadCairoFlags flags,
                          GskGpuCairoFunc        func,
                          gpointer               user_data,
                          GDestroyNotify         user_destroy)
 {
   GskGpuUploadCairoOp *self;
+  GskGpuImage *image;
+  gsize width, height;
+
+  width = ceil (graphene_vec2_get_x (scale) * viewport->size.width);
+  height = ceil (graphene_vec2_get_y (scale) * viewport->size.height);
+  image = gsk_gpu_device_create_upload_image (gsk_gpu_frame_get_device (frame),
+                                              FALSE,
+                                              GDK_MEMORY_DEFAULT,
+                                              gdk_color_state_get_no_srgb_tf (GDK_COLOR_STATE_SRGB) != NULL,
+                                              width,
+                                              height);
 
-  self = (GskGpuUploadCairoOp *) gsk_gpu_op_alloc (frame, &GSK_GPU_UPLOAD_CAIRO_OP_CLASS);
+  self = (GskGpuUploadCairoOp *) gsk_gpu_op_alloc (frame, gsk_gpu_upload_cairo_op_get_class (flags));
 
-  self->image = gsk_gpu_device_create_upload_image (gsk_gpu_frame_get_device (frame),
-                                                    FALSE,
-                                                    GDK_MEMORY_DEFAULT,
-                                                    gdk_color_state_get_no_srgb_tf (GDK_COLOR_STATE_SRGB) != NULL,
-                                                    ceil (graphene_vec2_get_x (scale) * viewport->size.width),
-                                                    ceil (graphene_vec2_get_y (scale) * viewport->size.height));
-  self->viewport = *viewport;
+  self->image = image;
+  self->area = (cairo_rectangle_int_t) { 0, 0, width, height };
+  graphene_vec2_init (&self->scale, width / viewport->size.width, height / viewport->size.height);
+  self->origin = GRAPHENE_POINT_INIT (- viewport->origin.x * graphene_vec2_get_x (&self->scale),
+                                      - viewport->origin.y * graphene_vec2_get_y (&self->scale));
   self->func = func;
   self->user_data = user_data;
   self->user_destroy = user_destroy;
@@ -518,6 +902,45 @@ gsk_gpu_upload_cairo_op (GskGpuFrame           *frame,
   return self->image;
 }
 
+/*
+ * gsk_gpu_upload_cairo_into_op:
+ * @frame: the frame
+ * @image: the image to draw into
+ * @area: the area of the image to draw into
+ * @scale: the scale to draw with
+ * @origin: position of the user space origin in @area, in pixels
+ * @flags: flags for calling @func
+ * @func: the function drawing the contents
+ * @user_data: data to pass to @func
+ * @user_destroy: function to free @user_data
+ *
+ * Like gsk_gpu_upload_cairo_op(), but draws into an area of an existing
+ * image, like an atlas.
+ */
+void
+gsk_gpu_upload_cairo_into_op (GskGpuFrame                 *frame,
+                              GskGpuImage                 *image,
+                              const cairo_rectangle_int_t *area,
+                              const graphene_vec2_t       *scale,
+                              const graphene_point_t      *origin,
+                              GskGpuUploadCairoFlags       flags,
+                              GskGpuCairoFunc              func,
+                              gpointer                     user_data,
+                              GDestroyNotify               user_destroy)
+{
+  GskGpuUploadCairoOp *self;
+
+  self = (GskGpuUploadCairoOp *) gsk_gpu_op_alloc (frame, gsk_gpu_upload_cairo_op_get_class (flags));
+
+  self->image = g_object_ref (image);
+  self->area = *area;
+  self->scale = *scale;
+  self->origin = *origin;
+  self->func = func;
+  self->user_data = user_data;
+  self->user_destroy = user_destroy;
+}
+
 typedef struct _GskGpuUploadGlyphOp GskGpuUploadGlyphOp;
 
 struct _GskGpuUploadGlyphOp
@@ -679,3 +1102,292 @@ gsk_gpu_upload_glyph_op (GskGpuFrame                 *frame,
   self->glyph = glyph;
   self->origin = *origin;
 }
+
+/* Computes the squared distance transform of a row or column in place,
+ * see "Distance Transforms of Sampled Functions" by Felzenszwalb and
+ * Huttenlocher.
+ */
+static void
+sdf_transform_1d (float *grid,
+                  gsize  offset,
+                  gsize  grid_stride,
+                  gsize  length,
+                  float *f,
+                  int   *v,
+                  float *z)
+{
+  gsize q;
+  int k;
+
+  v[0] = 0;
+  z[0] = -G_MAXFLOAT;
+  z[1] = G_MAXFLOAT;
+  f[0] = grid[offset];
+
+  for (q = 1, k = 0; q < length; q++)
+    {
+      float s;
+
+      f[q] = grid[offset + q * grid_stride];
+      do
+        {
+          int r = v[k];
+          s = (f[q] - f[r] + (float) q * q - (float) r * r) / (q - r) / 2;
+        }
+      while (s <= z[k] && --k > -1);
+
+      k++;
+      v[k] = q;
+      z[k] = s;
+      z[k + 1] = G_MAXFLOAT;
+    }
+
+  for (q = 0, k = 0; q < length; q++)
+    {
+      float qr;
+
+      while (z[k + 1] < q)
+        k++;
+
+      qr = (float) q - v[k];
+      grid[offset + q * grid_stride] = f[v[k]] + qr * qr;
+    }
+}
+
+static void
+sdf_transform (float *grid,
+               gsize  width,
+               gsize  height,
+               float *f,
+               int   *v,
+               float *z)
+{
+  gsize x, y;
+
+  for (x = 0; x < width; x++)
+    sdf_transform_1d (grid, x, width, height, f, v, z);
+  for (y = 0; y < height; y++)
+    sdf_transform_1d (grid, y * width, 1, width, f, v, z);
+}
+
+/* Turns antialiased coverage into a signed distance field where 0.5 is
+ * the edge and 0 and 1 are @radius pixels outside and inside. The
+ * coverage is used to place the edge inside the border pixels, which
+ * gets much better results than thresholding.
+ *
+ * Two squared distance transforms are computed: the distance to the
+ * nearest pixel inside the glyph and the distance to the nearest pixel
+ * outside of it. Border pixels are seeded with their estimated distance
+ * to the edge, 0.5 - coverage, which is positive outside the edge.
+ */
+static void
+sdf_from_coverage (const guchar *coverage,
+                   gsize         coverage_stride,
+                   guchar       *data,
+                   gsize         stride,
+                   gsize         width,
+                   gsize         height,
+                   float         radius)
+{
+  float *to_inside, *to_outside, *f, *z;
+  int *v;
+  gsize x, y, n;
+
+  n = MAX (width, height);
+  to_inside = g_new (float, width * height);
+  to_outside = g_new (float, width * height);
+  f = g_new (float, n);
+  z = g_new (float, n + 1);
+  v = g_new (int, n);
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++)
+        {
+          float a = coverage[y * coverage_stride + x] / 255.f;
+          gsize i = y * width + x;
+
+          if (a >= 1.0f)
+            {
+              to_inside[i] = 0;
+              to_outside[i] = G_MAXFLOAT / 4;
+            }
+          else if (a <= 0.0f)
+            {
+              to_inside[i] = G_MAXFLOAT / 4;
+              to_outside[i] = 0;
+            }
+          else
+            {
+              float d = 0.5f - a;
+
+              to_inside[i] = d > 0 ? d * d : 0;
+              to_outside[i] = d < 0 ? d * d : 0;
+            }
+        }
+    }
+
+  sdf_transform (to_inside, width, height, f, v, z);
+  sdf_transform (to_outside, width, height, f, v, z);
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++)
+        {
+          gsize i = y * width + x;
+          /* positive outside the glyph */
+          float d = sqrtf (to_inside[i]) - sqrtf (to_outside[i]);
+          guchar value = CLAMP (0.5f - d / (2 * radius), 0.f, 1.f) * 255.f + 0.5f;
+
+          /* Premultiplied white, so it works like a regular glyph mask */
+          memset (data + y * stride + 4 * x, value, 4);
+        }
+    }
+
+  g_free (to_inside);
+  g_free (to_outside);
+  g_free (f);
+  g_free (z);
+  g_free (v);
+}
+
+typedef struct _GskGpuUploadSdfGlyphOp GskGpuUploadSdfGlyphOp;
+
+struct _GskGpuUploadSdfGlyphOp
+{
+  GskGpuUploadGlyphOp glyph;
+
+  float radius;
+};
+
+static void
+gsk_gpu_upload_sdf_glyph_op_print (GskGpuOp    *op,
+                                   GskGpuFrame *frame,
+                                   GString     *string,
+                                   guint        indent)
+{
+  GskGpuUploadGlyphOp *self = (GskGpuUploadGlyphOp *) op;
+  PangoFontDescription *desc;
+  char *str;
+
+  desc = pango_font_describe_with_absolute_size (self->font);
+  str = pango_font_description_to_string (desc);
+
+  gsk_gpu_print_op (string, indent, "upload-sdf-glyph");
+  gsk_gpu_print_int_rect (string, &self->area);
+  g_string_append_printf (string, "glyph %u font %s ", self->glyph, str);
+  gsk_gpu_print_newline (string);
+
+  g_free (str);
+  pango_font_description_free (desc);
+}
+
+static void
+gsk_gpu_upload_sdf_glyph_op_draw (GskGpuOp *op,
+                                  guchar   *data,
+                                  gsize     stride)
+{
+  GskGpuUploadSdfGlyphOp *self = (GskGpuUploadSdfGlyphOp *) op;
+  GskGpuUploadGlyphOp *glyph = &self->glyph;
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  PangoRectangle ink_rect = { 0, };
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_A8, glyph->area.width, glyph->area.height);
+  cairo_surface_set_device_offset (surface, glyph->origin.x, glyph->origin.y);
+
+  cr = cairo_create (surface);
+
+  /* The pango code for drawing hex boxes uses the glyph width */
+  if (glyph->glyph & PANGO_GLYPH_UNKNOWN_FLAG)
+    pango_font_get_glyph_extents (glyph->font, glyph->glyph, &ink_rect, NULL);
+
+  pango_cairo_show_glyph_string (cr,
+                                 glyph->font,
+                                 &(PangoGlyphString) {
+                                     .num_glyphs = 1,
+                                     .glyphs = (PangoGlyphInfo[1]) { {
+                                         .glyph = glyph->glyph,
+                                         .geometry = {
+                                           .width = ink_rect.width,
+                                         }
+                                     } }
+                                 });
+
+  cairo_destroy (cr);
+
+  cairo_surface_flush (surface);
+  sdf_from_coverage (cairo_image_surface_get_data (surface),
+                     cairo_image_surface_get_stride (surface),
+                     data,
+                     stride,
+                     glyph->area.width,
+                     glyph->area.height,
+                     self->radius);
+
+  cairo_surface_destroy (surface);
+}
+
+#ifdef GDK_RENDERING_VULKAN
+static GskGpuOp *
+gsk_gpu_upload_sdf_glyph_op_vk_command (GskGpuOp              *op,
+                                        GskGpuFrame           *frame,
+                                        GskVulkanCommandState *state)
+{
+  GskGpuUploadGlyphOp *self = (GskGpuUploadGlyphOp *) op;
+
+  return gsk_gpu_upload_op_vk_command_with_area (op,
+                                                 frame,
+                                                 state,
+                                                 GSK_VULKAN_IMAGE (self->image),
+                                                 &self->area,
+                                                 gsk_gpu_upload_sdf_glyph_op_draw,
+                                                 &self->buffer);
+}
+#endif
+
+static GskGpuOp *
+gsk_gpu_upload_sdf_glyph_op_gl_command (GskGpuOp          *op,
+                                        GskGpuFrame       *frame,
+                                        GskGLCommandState *state)
+{
+  GskGpuUploadGlyphOp *self = (GskGpuUploadGlyphOp *) op;
+
+  return gsk_gpu_upload_op_gl_command_with_area (op,
+                                                 frame,
+                                                 self->image,
+                                                 &self->area,
+                                                 gsk_gpu_upload_sdf_glyph_op_draw);
+}
+
+static const GskGpuOpClass GSK_GPU_UPLOAD_SDF_GLYPH_OP_CLASS = {
+  GSK_GPU_OP_SIZE (GskGpuUploadSdfGlyphOp),
+  GSK_GPU_STAGE_UPLOAD,
+  gsk_gpu_upload_glyph_op_finish,
+  gsk_gpu_upload_sdf_glyph_op_print,
+#ifdef GDK_RENDERING_VULKAN
+  gsk_gpu_upload_sdf_glyph_op_vk_command,
+#endif
+  gsk_gpu_upload_sdf_glyph_op_gl_command,
+};
+
+void
+gsk_gpu_upload_sdf_glyph_op (GskGpuFrame                 *frame,
+                             GskGpuImage                 *image,
+                             PangoFont                   *font,
+                             PangoGlyph                   glyph,
+                             const cairo_rectangle_int_t *area,
+                             const graphene_point_t      *origin,
+                             float                        radius)
+{
+  GskGpuUploadSdfGlyphOp *self;
+
+  self = (GskGpuUploadSdfGlyphOp *) gsk_gpu_op_alloc (frame, &GSK_GPU_UPLOAD_SDF_GLYPH_OP_CLASS);
+
+  self->glyph.image = g_object_ref (image);
+  self->glyph.area = *area;
+  self->glyph.font = g_object_ref (font);
+  self->glyph.glyph = glyph;
+  self->glyph.origin = *origin;
+  self->radius = radius;
+}
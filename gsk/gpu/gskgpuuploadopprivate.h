@@ -6,6 +6,12 @@
 
 G_BEGIN_DECLS
 
+typedef enum {
+  GSK_GPU_UPLOAD_CAIRO_DEFAULT    = 0,
+  /* the func may be called from a worker thread */
+  GSK_GPU_UPLOAD_CAIRO_THREADSAFE = (1 << 0),
+} GskGpuUploadCairoFlags;
+
 typedef void            (* GskGpuCairoFunc)                             (gpointer                        user_data,
                                                                          cairo_t                        *cr);
 
@@ -15,9 +21,31 @@ GskGpuImage *           gsk_gpu_upload_texture_op_try                   (GskGpuF
                                                                          GskScalingFilter                lod_filter,
                                                                          GdkTexture                     *texture);
 
+GskGpuStagedUpload *    gsk_gpu_staged_upload_new                       (GskGpuFrame                    *frame,
+                                                                         gboolean                        with_mipmap,
+                                                                         GdkTexture                     *texture,
+                                                                         GdkSurface                     *surface);
+GskGpuStagedUpload *    gsk_gpu_staged_upload_ref                       (GskGpuStagedUpload             *self);
+void                    gsk_gpu_staged_upload_unref                     (GskGpuStagedUpload             *self);
+gboolean                gsk_gpu_staged_upload_is_ready                  (GskGpuStagedUpload             *self);
+
+GskGpuImage *           gsk_gpu_upload_staged_op                        (GskGpuFrame                    *frame,
+                                                                         GskGpuStagedUpload             *upload);
+
 GskGpuImage *           gsk_gpu_upload_cairo_op                         (GskGpuFrame                    *frame,
                                                                          const graphene_vec2_t          *scale,
                                                                          const graphene_rect_t          *viewport,
+                                                                         GskGpuUploadCairoFlags          flags,
+                                                                         GskGpuCairoFunc                 func,
+                                                                         gpointer                        user_data,
+                                                                         GDestroyNotify                  user_destroy);
+
+void                    gsk_gpu_upload_cairo_into_op                    (GskGpuFrame                    *frame,
+                                                                         GskGpuImage                    *image,
+                                                                         const cairo_rectangle_int_t    *area,
+                                                                         const graphene_vec2_t          *scale,
+                                                                         const graphene_point_t         *origin,
+                                                                         GskGpuUploadCairoFlags          flags,
                                                                          GskGpuCairoFunc                 func,
                                                                          gpointer                        user_data,
                                                                          GDestroyNotify                  user_destroy);
@@ -28,6 +56,13 @@ void                    gsk_gpu_upload_glyph_op                         (GskGpuF
                                                                          PangoGlyph                      glyph,
                                                                          const cairo_rectangle_int_t    *area,
                                                                          const graphene_point_t         *origin);
+void                    gsk_gpu_upload_sdf_glyph_op                     (GskGpuFrame                    *frame,
+                                                                         GskGpuImage                    *image,
+                                                                         PangoFont                      *font,
+                                                                         PangoGlyph                      glyph,
+                                                                         const cairo_rectangle_int_t    *area,
+                                                                         const graphene_point_t         *origin,
+                                                                         float                           radius);
 
 G_END_DECLS
 
@@ -789,7 +789,7 @@ struct _GskVulkanShaderSpecialization
   guint32 variation;
 };
 
-static VkPipelineColorBlendAttachmentState blend_attachment_states[4] = {
+static VkPipelineColorBlendAttachmentState blend_attachment_states[5] = {
   [GSK_GPU_BLEND_NONE] = {
     .blendEnable = VK_FALSE,
     .colorWriteMask = VK_COLOR_COMPONENT_A_BIT
@@ -836,6 +836,19 @@ static VkPipelineColorBlendAttachmentState blend_attachment_states[4] = {
                     | VK_COLOR_COMPONENT_G_BIT
                     | VK_COLOR_COMPONENT_B_BIT
   },
+  [GSK_GPU_BLEND_MAX] = {
+    .blendEnable = VK_TRUE,
+    .colorBlendOp = VK_BLEND_OP_MAX,
+    .srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
+    .dstColorBlendFactor = VK_BLEND_FACTOR_ONE,
+    .alphaBlendOp = VK_BLEND_OP_MAX,
+    .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+    .dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+    .colorWriteMask = VK_COLOR_COMPONENT_A_BIT
+                    | VK_COLOR_COMPONENT_R_BIT
+                    | VK_COLOR_COMPONENT_G_BIT
+                    | VK_COLOR_COMPONENT_B_BIT
+  },
 };
 
 VkPipeline
@@ -855,7 +868,7 @@ gsk_vulkan_device_get_vk_pipeline (GskVulkanDevice           *self,
   GdkDisplay *display;
   char *vertex_shader_name, *fragment_shader_name;
   G_GNUC_UNUSED gint64 begin_time = GDK_PROFILER_CURRENT_TIME;
-  const char *blend_name[] = { "NONE", "OVER", "ADD", "CLEAR" };
+  const char *blend_name[] = { "NONE", "OVER", "ADD", "CLEAR", "MAX" };
 
   cache_key = (PipelineCacheKey) {
     .vk_layout = vk_layout,
@@ -25,6 +25,9 @@
 #define GDK_ARRAY_NO_MEMSET 1
 #include "gdk/gdkarrayimpl.c"
 
+/* Timestamp queries per frame, every timed render pass needs 2 */
+#define MAX_TIMESTAMP_QUERIES 256
+
 struct _GskVulkanSemaphores
 {
   GskSemaphores wait_semaphores;
@@ -39,6 +42,10 @@ struct _GskVulkanFrame
   VkSemaphore vk_acquire_semaphore;
   VkFence vk_fence;
   VkCommandBuffer vk_command_buffer;
+  VkQueryPool vk_query_pool;
+  float timestamp_period;
+  guint64 timestamp_mask;
+  guint n_timestamps;
 
   gsize pool_n_sets;
   gsize pool_n_images;
@@ -84,6 +91,37 @@ gsk_vulkan_frame_wait (GskGpuFrame *frame)
                                  INT64_MAX);
 }
 
+static gboolean
+gsk_vulkan_frame_supports_timestamps (GskVulkanFrame *self)
+{
+  GskVulkanDevice *device = GSK_VULKAN_DEVICE (gsk_gpu_frame_get_device (GSK_GPU_FRAME (self)));
+  VkPhysicalDevice vk_physical_device;
+  VkPhysicalDeviceProperties props;
+  VkQueueFamilyProperties *queue_props;
+  uint32_t n_queue_props, valid_bits;
+
+  vk_physical_device = gsk_vulkan_device_get_vk_physical_device (device);
+  vkGetPhysicalDeviceProperties (vk_physical_device, &props);
+
+  /* timestampComputeAndGraphics guarantees support on our queue */
+  if (!props.limits.timestampComputeAndGraphics ||
+      props.limits.timestampPeriod <= 0)
+    return FALSE;
+
+  /* Timestamps may have fewer than 64 bits and then wrap around */
+  vkGetPhysicalDeviceQueueFamilyProperties (vk_physical_device, &n_queue_props, NULL);
+  queue_props = g_newa (VkQueueFamilyProperties, n_queue_props);
+  vkGetPhysicalDeviceQueueFamilyProperties (vk_physical_device, &n_queue_props, queue_props);
+  valid_bits = queue_props[gsk_vulkan_device_get_vk_queue_family_index (device)].timestampValidBits;
+  if (valid_bits == 0)
+    return FALSE;
+
+  self->timestamp_period = props.limits.timestampPeriod;
+  self->timestamp_mask = valid_bits >= 64 ? G_MAXUINT64 : (G_GUINT64_CONSTANT (1) << valid_bits) - 1;
+
+  return TRUE;
+}
+
 static void
 gsk_vulkan_frame_setup (GskGpuFrame *frame)
 {
@@ -118,6 +156,18 @@ gsk_vulkan_frame_setup (GskGpuFrame *frame)
                                },
                                NULL,
                                &self->vk_fence);
+
+  if (gsk_vulkan_frame_supports_timestamps (self))
+    {
+      GSK_VK_CHECK (vkCreateQueryPool, vk_device,
+                                       &(VkQueryPoolCreateInfo) {
+                                           .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                           .queryType = VK_QUERY_TYPE_TIMESTAMP,
+                                           .queryCount = MAX_TIMESTAMP_QUERIES,
+                                       },
+                                       NULL,
+                                       &self->vk_query_pool);
+    }
 }
 
 static void
@@ -289,6 +339,8 @@ gsk_vulkan_frame_submit (GskGpuFrame       *frame,
                                       VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
     }
 
+  self->n_timestamps = 0;
+
   state.vk_command_buffer = self->vk_command_buffer;
   state.vk_render_pass = VK_NULL_HANDLE;
   state.vk_format = VK_FORMAT_UNDEFINED;
@@ -321,6 +373,61 @@ gsk_vulkan_frame_submit (GskGpuFrame       *frame,
   gsk_semaphores_clear (&semaphores.signal_semaphores);
 }
 
+static guint
+gsk_vulkan_frame_write_timestamp (GskGpuFrame *frame)
+{
+  GskVulkanFrame *self = GSK_VULKAN_FRAME (frame);
+
+  if (self->vk_query_pool == VK_NULL_HANDLE ||
+      self->n_timestamps >= MAX_TIMESTAMP_QUERIES)
+    return G_MAXUINT;
+
+  /* Resetting must happen outside of render passes, and so do
+   * timestamps around them */
+  if (self->n_timestamps == 0)
+    vkCmdResetQueryPool (self->vk_command_buffer, self->vk_query_pool, 0, MAX_TIMESTAMP_QUERIES);
+
+  vkCmdWriteTimestamp (self->vk_command_buffer,
+                       VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                       self->vk_query_pool,
+                       self->n_timestamps);
+
+  return self->n_timestamps++;
+}
+
+static gboolean
+gsk_vulkan_frame_read_timestamps (GskGpuFrame *frame,
+                                  guint64     *timestamps,
+                                  guint        n_timestamps)
+{
+  GskVulkanFrame *self = GSK_VULKAN_FRAME (frame);
+  VkDevice vk_device;
+  VkResult res;
+  guint64 first;
+  guint i;
+
+  vk_device = gsk_vulkan_device_get_vk_device (GSK_VULKAN_DEVICE (gsk_gpu_frame_get_device (frame)));
+
+  res = vkGetQueryPoolResults (vk_device,
+                               self->vk_query_pool,
+                               0,
+                               n_timestamps,
+                               n_timestamps * sizeof (guint64),
+                               timestamps,
+                               sizeof (guint64),
+                               VK_QUERY_RESULT_64_BIT);
+  if (res != VK_SUCCESS)
+    return FALSE;
+
+  /* Make the timestamps relative to the first one, so the differences
+   * the caller computes are right even if the counter wrapped */
+  first = timestamps[0] & self->timestamp_mask;
+  for (i = 0; i < n_timestamps; i++)
+    timestamps[i] = (((timestamps[i] & self->timestamp_mask) - first) & self->timestamp_mask) * self->timestamp_period;
+
+  return TRUE;
+}
+
 static void
 gsk_vulkan_frame_finalize (GObject *object)
 {
@@ -342,6 +449,10 @@ gsk_vulkan_frame_finalize (GObject *object)
   vkDestroyFence (vk_device,
                   self->vk_fence,
                   NULL);
+  if (self->vk_query_pool != VK_NULL_HANDLE)
+    vkDestroyQueryPool (vk_device,
+                        self->vk_query_pool,
+                        NULL);
 
   G_OBJECT_CLASS (gsk_vulkan_frame_parent_class)->finalize (object);
 }
@@ -363,6 +474,8 @@ gsk_vulkan_frame_class_init (GskVulkanFrameClass *klass)
   gpu_frame_class->create_storage_buffer = gsk_vulkan_frame_create_storage_buffer;
   gpu_frame_class->write_texture_vertex_data = gsk_vulkan_frame_write_texture_vertex_data;
   gpu_frame_class->submit = gsk_vulkan_frame_submit;
+  gpu_frame_class->write_timestamp = gsk_vulkan_frame_write_timestamp;
+  gpu_frame_class->read_timestamps = gsk_vulkan_frame_read_timestamps;
 
   object_class->finalize = gsk_vulkan_frame_finalize;
 }
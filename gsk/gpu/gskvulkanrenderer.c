@@ -139,6 +139,8 @@ gsk_vulkan_renderer_unrealize (GskRenderer *renderer)
 {
   GskVulkanRenderer *self = GSK_VULKAN_RENDERER (renderer);
 
+  gsk_gpu_renderer_stop_render_thread (GSK_GPU_RENDERER (self));
+
   gsk_vulkan_renderer_free_targets (self);
   g_signal_handlers_disconnect_by_func (gsk_gpu_renderer_get_context (GSK_GPU_RENDERER (self)),
                                         gsk_vulkan_renderer_update_images_cb,
@@ -156,6 +158,7 @@ gsk_vulkan_renderer_class_init (GskVulkanRendererClass *klass)
   GskRendererClass *renderer_class = GSK_RENDERER_CLASS (klass);
 
   gpu_renderer_class->frame_type = GSK_TYPE_VULKAN_FRAME;
+  gpu_renderer_class->supports_render_thread = TRUE;
 
   gpu_renderer_class->get_device = gsk_vulkan_device_get_for_display;
   gpu_renderer_class->create_context = gsk_vulkan_renderer_create_context;
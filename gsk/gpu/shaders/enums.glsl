@@ -52,6 +52,12 @@
 #define GSK_MASK_MODE_LUMINANCE 2u
 #define GSK_MASK_MODE_INVERTED_LUMINANCE 3u
 
+#define GSK_FILL_RULE_WINDING 0u
+#define GSK_FILL_RULE_EVEN_ODD 1u
+
+#define GSK_GPU_PATH_FILL_EDGE 0u
+#define GSK_GPU_PATH_STROKE_SEGMENT 1u
+
 #define GDK_COLOR_STATE_ID_SRGB 0u
 #define GDK_COLOR_STATE_ID_SRGB_LINEAR 1u
 #define GDK_COLOR_STATE_ID_REC2100_PQ 2u
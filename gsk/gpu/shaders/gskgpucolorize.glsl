@@ -2,6 +2,8 @@
 
 #include "common.glsl"
 
+#define VARIATION_SDF ((GSK_VARIATION & 1u) == 1u)
+
 PASS(0) vec2 _pos;
 PASS_FLAT(1) Rect _rect;
 PASS_FLAT(2) vec4 _color;
@@ -37,7 +39,17 @@ void
 run (out vec4 color,
      out vec2 position)
 {
-  float alpha = texture (GSK_TEXTURE0, _tex_coord).a * rect_coverage (_rect, _pos);
+  float alpha = texture (GSK_TEXTURE0, _tex_coord).a;
+
+  if (VARIATION_SDF)
+    {
+      /* The texture is a distance field with the edge at 0.5,
+       * antialias it across one pixel */
+      float width = max (fwidth (alpha), 1.0 / 1024.0);
+      alpha = clamp ((alpha - 0.5) / width + 0.5, 0.0, 1.0);
+    }
+
+  alpha *= rect_coverage (_rect, _pos);
   color = output_color_alpha (_color, alpha);
   position = _pos;
 }
@@ -0,0 +1,95 @@
+#define GSK_N_TEXTURES 0
+
+#include "common.glsl"
+
+#define VARIATION_PATH_MODE GSK_VARIATION
+
+PASS(0) vec2 _pos;
+PASS_FLAT(1) vec4 _line;
+PASS_FLAT(2) float _half_width;
+
+
+#ifdef GSK_VERTEX_SHADER
+
+IN(0) vec4 in_rect;
+IN(1) vec4 in_line;
+IN(2) float in_line_width;
+
+void
+run (out vec2 pos)
+{
+  Rect r = rect_from_gsk (in_rect);
+
+  pos = rect_get_position (r);
+
+  _pos = pos;
+  _line = in_line * GSK_GLOBAL_SCALE.xyxy;
+  _half_width = 0.5 * in_line_width * GSK_GLOBAL_SCALE.x;
+}
+
+#endif
+
+
+
+#ifdef GSK_FRAGMENT_SHADER
+
+/* The part of the pixel that is to the right of the x coordinate */
+float
+right_of (float x)
+{
+  return clamp (_pos.x + 0.5 - x, 0.0, 1.0);
+}
+
+/* Signed area of the pixel that is to the right of the line.
+ * Summing this up for all edges of a closed contour yields the
+ * (antialiased) winding number of the pixel.
+ */
+float
+fill_edge_coverage (vec2 p0,
+                    vec2 p1)
+{
+  float y0 = clamp (p0.y, _pos.y - 0.5, _pos.y + 0.5);
+  float y1 = clamp (p1.y, _pos.y - 0.5, _pos.y + 0.5);
+  float dy = y1 - y0;
+
+  if (dy == 0.0)
+    return 0.0;
+
+  float x0 = mix (p0.x, p1.x, (y0 - p0.y) / (p1.y - p0.y));
+  float x1 = mix (p0.x, p1.x, (y1 - p0.y) / (p1.y - p0.y));
+
+  /* Simpson's rule, exact unless the edge crosses the pixel's sides */
+  return dy * (right_of (x0) + 4.0 * right_of (0.5 * (x0 + x1)) + right_of (x1)) / 6.0;
+}
+
+/* Coverage of the pixel by a line segment with round caps,
+ * box-filtered across the segment.
+ */
+float
+stroke_segment_coverage (vec2 p0,
+                         vec2 p1)
+{
+  vec2 d = p1 - p0;
+  float len2 = dot (d, d);
+  float t = len2 > 0.0 ? clamp (dot (_pos - p0, d) / len2, 0.0, 1.0) : 0.0;
+  float dist = distance (_pos, p0 + t * d);
+
+  return max (min (dist + 0.5, _half_width) - max (dist - 0.5, -_half_width), 0.0);
+}
+
+void
+run (out vec4 color,
+     out vec2 position)
+{
+  float coverage;
+
+  if (VARIATION_PATH_MODE == GSK_GPU_PATH_FILL_EDGE)
+    coverage = fill_edge_coverage (_line.xy, _line.zw);
+  else
+    coverage = stroke_segment_coverage (_line.xy, _line.zw);
+
+  color = vec4 (coverage);
+  position = _pos;
+}
+
+#endif
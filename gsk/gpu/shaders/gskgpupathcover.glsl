@@ -0,0 +1,57 @@
+#define GSK_N_TEXTURES 1
+
+#include "common.glsl"
+
+#define VARIATION_FILL_RULE GSK_VARIATION
+
+PASS(0) vec2 _pos;
+PASS_FLAT(1) Rect _mask_rect;
+PASS(2) vec2 _mask_coord;
+PASS_FLAT(3) vec4 _color;
+
+
+#ifdef GSK_VERTEX_SHADER
+
+IN(0) vec4 in_rect;
+IN(1) vec4 in_mask_rect;
+IN(2) vec4 in_color;
+
+void
+run (out vec2 pos)
+{
+  Rect r = rect_from_gsk (in_rect);
+
+  pos = rect_get_position (r);
+
+  _pos = pos;
+  Rect mask_rect = rect_from_gsk (in_mask_rect);
+  _mask_rect = mask_rect;
+  _mask_coord = rect_get_coord (mask_rect, pos);
+  _color = output_color_from_alt (in_color);
+}
+
+#endif
+
+
+
+#ifdef GSK_FRAGMENT_SHADER
+
+void
+run (out vec4 color,
+     out vec2 position)
+{
+  /* The mask contains the accumulated winding number, or the
+   * coverage for strokes, which are drawn with the nonzero rule */
+  float winding = abs (texture (GSK_TEXTURE0, _mask_coord).r);
+  float alpha;
+
+  if (VARIATION_FILL_RULE == GSK_FILL_RULE_EVEN_ODD)
+    alpha = 1.0 - abs (1.0 - mod (winding, 2.0));
+  else
+    alpha = min (winding, 1.0);
+
+  color = output_color_alpha (_color, alpha * rect_coverage (_mask_rect, _pos));
+  position = _pos;
+}
+
+#endif
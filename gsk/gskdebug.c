@@ -14,7 +14,9 @@ static const GdkDebugKey gsk_debug_keys[] = {
   { "full-redraw", GSK_DEBUG_FULL_REDRAW, "Force full redraws" },
   { "staging", GSK_DEBUG_STAGING, "Use a staging image for texture upload (Vulkan only)" },
   { "cairo", GSK_DEBUG_CAIRO, "Overlay error pattern over Cairo drawing (finds fallbacks)" },
-  { "occlusion", GSK_DEBUG_OCCLUSION, "Overlay highlight over areas optimized via occlusion culling" },
+  { "occlusion", GSK_DEBUG_OCCLUSION, "Overlay highlight over areas optimized via occlusion culling and print overdraw statistics" },
+  { "gpu-timing", GSK_DEBUG_GPU_TIMING, "Measure GPU time of render passes for the inspector recorder" },
+  { "render-thread", GSK_DEBUG_RENDER_THREAD, "Record and submit frames on a render thread (Vulkan only)" },
 };
 
 static guint gsk_debug_flags;
@@ -18,9 +18,11 @@ typedef enum {
   GSK_DEBUG_STAGING               = 1 <<  8,
   GSK_DEBUG_CAIRO                 = 1 <<  9,
   GSK_DEBUG_OCCLUSION             = 1 << 10,
+  GSK_DEBUG_GPU_TIMING            = 1 << 11,
+  GSK_DEBUG_RENDER_THREAD         = 1 << 12,
 } GskDebugFlags;
 
-#define GSK_DEBUG_ANY ((1 << 11) - 1)
+#define GSK_DEBUG_ANY ((1 << 13) - 1)
 
 GskDebugFlags gsk_get_debug_flags (void);
 void          gsk_set_debug_flags (GskDebugFlags flags);
@@ -33,6 +33,116 @@
 
 #include <graphene.h>
 
+/* Per-subsurface damage history, kept across frames to decide
+ * whether offloading pays off.
+ *
+ * A subsurface whose texture keeps changing saves us compositing it
+ * into the parent every frame, while a static one only costs the
+ * compositor a plane and gets drawn once when it is composited by
+ * us. So we start out offloading, demote subsurfaces whose texture
+ * didn't change for DEMOTE_FRAMES rendered frames, and promote them
+ * again once their texture changes PROMOTE_CHANGES times within the
+ * last PROMOTE_FRAMES frames.
+ */
+#define DEMOTE_FRAMES 32
+#define PROMOTE_FRAMES 8
+#define PROMOTE_CHANGES 2
+
+typedef struct
+{
+  GdkTexture *last_texture; /* weak */
+  guint32 changes; /* bit n is set if the texture changed n frames ago */
+  guint n_frames;
+  guint demoted : 1;
+
+  guint n_hits;
+  guint n_misses;
+  graphene_rect_t bounds;
+} OffloadHistory;
+
+static void
+offload_history_free (OffloadHistory *history)
+{
+  g_clear_weak_pointer (&history->last_texture);
+  g_free (history);
+}
+
+static OffloadHistory *
+get_offload_history (GdkSubsurface *subsurface,
+                     gboolean       create)
+{
+  static GQuark quark;
+  OffloadHistory *history;
+
+  if (G_UNLIKELY (quark == 0))
+    quark = g_quark_from_static_string ("gsk-offload-history");
+
+  history = g_object_get_qdata (G_OBJECT (subsurface), quark);
+  if (history == NULL && create)
+    {
+      history = g_new0 (OffloadHistory, 1);
+      g_object_set_qdata_full (G_OBJECT (subsurface), quark, history, (GDestroyNotify) offload_history_free);
+    }
+
+  return history;
+}
+
+static gboolean
+offload_history_update (GskOffload     *self,
+                        GskOffloadInfo *info)
+{
+  OffloadHistory *history = get_offload_history (info->subsurface, TRUE);
+  gboolean changed;
+
+  /* A weak pointer, so a new texture that happens to get the
+   * address of a freed one still counts as a change */
+  changed = info->texture != history->last_texture;
+  g_set_weak_pointer (&history->last_texture, info->texture);
+  history->changes = (history->changes << 1) | (changed ? 1 : 0);
+  history->n_frames = MIN (history->n_frames + 1, DEMOTE_FRAMES);
+
+  if (GDK_DISPLAY_DEBUG_CHECK (gdk_surface_get_display (self->surface), FORCE_OFFLOAD))
+    return TRUE;
+
+  if (history->demoted)
+    {
+      guint n_changes = 0;
+
+      for (guint i = 0; i < PROMOTE_FRAMES; i++)
+        n_changes += (history->changes >> i) & 1;
+
+      if (n_changes >= PROMOTE_CHANGES)
+        {
+          GDK_DISPLAY_DEBUG (gdk_surface_get_display (self->surface), OFFLOAD,
+                             "[%p] Promoting, texture changed %u times in %d frames",
+                             info->subsurface, n_changes, PROMOTE_FRAMES);
+          history->demoted = FALSE;
+        }
+    }
+  else if (history->n_frames >= DEMOTE_FRAMES && history->changes == 0)
+    {
+      GDK_DISPLAY_DEBUG (gdk_surface_get_display (self->surface), OFFLOAD,
+                         "[%p] Demoting, texture static for %d frames",
+                         info->subsurface, DEMOTE_FRAMES);
+      history->demoted = TRUE;
+    }
+
+  return !history->demoted;
+}
+
+static void
+offload_history_record (GskOffloadInfo *info)
+{
+  OffloadHistory *history = get_offload_history (info->subsurface, TRUE);
+
+  if (info->is_offloaded)
+    history->n_hits++;
+  else
+    history->n_misses++;
+
+  history->bounds = info->background_rect;
+}
+
 typedef struct
 {
   GskRoundedRect rect;
@@ -655,6 +765,12 @@ complex_clip:
 
         transform = self->transforms ? (GskTransform *) self->transforms->data : NULL;
 
+        if (info != NULL)
+          {
+            info->is_visible = TRUE;
+            transform_bounds (self, &node->bounds, &info->background_rect);
+          }
+
         if (info == NULL)
           {
             GDK_DISPLAY_DEBUG (gdk_surface_get_display (self->surface), OFFLOAD,
@@ -690,7 +806,6 @@ complex_clip:
                 info->can_raise = TRUE;
                 transform_bounds (self, &info->texture_rect, &info->texture_rect);
                 info->has_background = has_background;
-                transform_bounds (self, &node->bounds, &info->background_rect);
                 info->place_above = self->last_info ? self->last_info->subsurface : NULL;
                 self->last_info = info;
               }
@@ -756,6 +871,9 @@ gsk_offload_new (GdkSurface     *surface,
 
       gdk_subsurface_get_bounds (info->subsurface, &old_bounds);
 
+      if (info->can_offload && !offload_history_update (self, info))
+        info->can_offload = FALSE;
+
       if (info->can_offload)
         {
           if (info->can_raise)
@@ -785,6 +903,9 @@ gsk_offload_new (GdkSurface     *surface,
 
       info->is_above = info->is_offloaded && gdk_subsurface_is_above_parent (info->subsurface);
 
+      if (info->is_visible)
+        offload_history_record (info);
+
       gdk_subsurface_get_bounds (info->subsurface, &bounds);
 
       if (info->is_offloaded != info->was_offloaded ||
@@ -824,3 +945,32 @@ gsk_offload_get_subsurface_info (GskOffload    *self,
 {
   return find_subsurface_info (self, subsurface);
 }
+
+/*
+ * gsk_offload_get_stats:
+ * @subsurface: a subsurface
+ * @n_hits: (out): number of frames the subsurface was offloaded in
+ * @n_misses: (out): number of frames it was drawn by the renderer instead
+ * @bounds: (out): bounds of the subsurface node in the last frame
+ *
+ * Gets offload statistics for a subsurface, for the inspector.
+ *
+ * Returns: `FALSE` if the subsurface was never part of a rendered frame
+ */
+gboolean
+gsk_offload_get_stats (GdkSubsurface   *subsurface,
+                       guint           *n_hits,
+                       guint           *n_misses,
+                       graphene_rect_t *bounds)
+{
+  OffloadHistory *history = get_offload_history (subsurface, FALSE);
+
+  if (history == NULL)
+    return FALSE;
+
+  *n_hits = history->n_hits;
+  *n_misses = history->n_misses;
+  *bounds = history->bounds;
+
+  return TRUE;
+}
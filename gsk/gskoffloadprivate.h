@@ -46,6 +46,8 @@ typedef struct
 
   guint had_background : 1;
   guint has_background : 1;
+
+  guint is_visible    : 1;
 } GskOffloadInfo;
 
 GskOffload *        gsk_offload_new                      (GdkSurface       *surface,
@@ -55,3 +57,8 @@ void                gsk_offload_free                     (GskOffload       *self
 
 GskOffloadInfo    * gsk_offload_get_subsurface_info      (GskOffload       *self,
                                                           GdkSubsurface    *subsurface);
+
+gboolean            gsk_offload_get_stats                (GdkSubsurface    *subsurface,
+                                                          guint            *n_hits,
+                                                          guint            *n_misses,
+                                                          graphene_rect_t  *bounds);
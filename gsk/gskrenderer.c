@@ -52,6 +52,7 @@
 #include <cairo-gobject.h>
 #include <gdk/gdk.h>
 #include "gdk/gdkdebugprivate.h"
+#include "gdk/gdkprofilerprivate.h"
 
 #ifdef GDK_WINDOWING_WAYLAND
 #include <gdk/wayland/gdkwayland.h>
@@ -198,6 +199,8 @@ gsk_renderer_class_init (GskRendererClass *klass)
   g_object_class_install_properties (gobject_class, N_PROPS, gsk_renderer_properties);
 }
 
+static guint diff_time_counter;
+
 static void
 gsk_renderer_init (GskRenderer *self)
 {
@@ -205,6 +208,9 @@ gsk_renderer_init (GskRenderer *self)
 
   priv->profiler = gsk_profiler_new ();
   priv->debug_flags = gsk_get_debug_flags ();
+
+  if (diff_time_counter == 0)
+    diff_time_counter = gdk_profiler_define_int_counter ("diff time", "Microseconds spent computing the damage of a frame");
 }
 
 /**
@@ -460,6 +466,11 @@ gsk_renderer_render (GskRenderer          *renderer,
 
   clip = cairo_region_copy (region);
 
+  /* Offloading changes the subsurfaces, which must not happen while
+   * the previous frame is still waiting to be presented */
+  if (renderer_class->finish_render)
+    renderer_class->finish_render (renderer);
+
   if (renderer_class->supports_offload && gdk_has_feature (GDK_FEATURE_OFFLOAD))
     offload = gsk_offload_new (priv->surface, root, clip);
   else
@@ -476,7 +487,11 @@ gsk_renderer_render (GskRenderer          *renderer,
     }
   else
     {
+      G_GNUC_UNUSED gint64 begin_time = GDK_PROFILER_CURRENT_TIME;
+
       gsk_render_node_diff (priv->prev_node, root, &(GskDiffData) { clip, priv->surface });
+
+      gdk_profiler_set_int_counter (diff_time_counter, (GDK_PROFILER_CURRENT_TIME - begin_time) / 1000);
     }
 
   renderer_class->render (renderer, root, clip);
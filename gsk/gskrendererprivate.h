@@ -52,6 +52,9 @@ struct _GskRendererClass
   void                 (* render)                               (GskRenderer            *renderer,
                                                                  GskRenderNode          *root,
                                                                  const cairo_region_t   *invalid);
+  /* Optional, for renderers that present asynchronously: wait for the
+   * previous frame to be presented */
+  void                 (* finish_render)                        (GskRenderer            *renderer);
 };
 
 GskProfiler *           gsk_renderer_get_profiler               (GskRenderer    *renderer);
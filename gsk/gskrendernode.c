@@ -824,6 +824,15 @@ gsk_render_node_is_hdr (const GskRenderNode *node)
   return node->is_hdr;
 }
 
+/* Whether the node draws a GdkGLTexture somewhere. Uploading those
+ * needs a GL context, so they can't be handled off the main thread.
+ */
+gboolean
+gsk_render_node_uses_gl_texture (const GskRenderNode *node)
+{
+  return node->uses_gl_texture;
+}
+
 /* Whether we need an offscreen to handle opacity correctly for this node.
  * We don't if there is only one drawing node inside (could be child
  * node, or grandchild, or...).
@@ -41,6 +41,7 @@
 #include "gdk/gdksubsurfaceprivate.h"
 #include "gdk/gdktextureprivate.h"
 #include "gdk/gdktexturedownloaderprivate.h"
+#include "gdk/gdktiledtextureprivate.h"
 #include "gdk/gdkrgbaprivate.h"
 #include "gdk/gdkcolorstateprivate.h"
 
@@ -2714,6 +2715,16 @@ gsk_texture_node_finalize (GskRenderNode *node)
   parent_class->finalize (node);
 }
 
+/* Cairo can't draw parts of tiled textures, so it draws a smaller level */
+static GdkTexture *
+gsk_texture_get_cairo_texture (GdkTexture *texture)
+{
+  if (GDK_IS_TILED_TEXTURE (texture))
+    return gdk_tiled_texture_get_preview (GDK_TILED_TEXTURE (texture));
+
+  return texture;
+}
+
 static void
 gsk_texture_node_draw_oversized (GskRenderNode *node,
                                  cairo_t       *cr,
@@ -2784,20 +2795,25 @@ gsk_texture_node_draw (GskRenderNode *node,
                        GdkColorState *ccs)
 {
   GskTextureNode *self = (GskTextureNode *) node;
+  GdkTexture *texture;
   cairo_surface_t *surface;
   cairo_pattern_t *pattern;
   cairo_matrix_t matrix;
   int width, height;
 
-  width = gdk_texture_get_width (self->texture);
-  height = gdk_texture_get_height (self->texture);
+  texture = gsk_texture_get_cairo_texture (self->texture);
+  if (texture == NULL)
+    return;
+
+  width = gdk_texture_get_width (texture);
+  height = gdk_texture_get_height (texture);
   if (width > MAX_CAIRO_IMAGE_WIDTH || height > MAX_CAIRO_IMAGE_HEIGHT)
     {
       gsk_texture_node_draw_oversized (node, cr, ccs);
       return;
     }
 
-  surface = gdk_texture_download_surface (self->texture, ccs);
+  surface = gdk_texture_download_surface (texture, ccs);
   pattern = cairo_pattern_create_for_surface (surface);
   cairo_pattern_set_extend (pattern, CAIRO_EXTEND_PAD);
 
@@ -2906,6 +2922,7 @@ gsk_texture_node_new (GdkTexture            *texture,
   node->offscreen_for_opacity = FALSE;
   node->fully_opaque = gdk_memory_format_alpha (gdk_texture_get_format (texture)) == GDK_MEMORY_ALPHA_OPAQUE;
   node->is_hdr = color_state_is_hdr (gdk_texture_get_color_state (texture));
+  node->uses_gl_texture = GDK_IS_GL_TEXTURE (texture);
 
   self->texture = g_object_ref (texture);
   gsk_rect_init_from_rect (&node->bounds, bounds);
@@ -2962,6 +2979,7 @@ gsk_texture_scale_node_draw (GskRenderNode *node,
   cairo_t *cr2;
   cairo_surface_t *surface2;
   graphene_rect_t clip_rect;
+  GdkTexture *texture;
 
   /* Make sure we draw the minimum region by using the clip */
   gdk_cairo_rect (cr, &node->bounds);
@@ -2970,19 +2988,23 @@ gsk_texture_scale_node_draw (GskRenderNode *node,
   if (clip_rect.size.width <= 0 || clip_rect.size.height <= 0)
     return;
 
+  texture = gsk_texture_get_cairo_texture (self->texture);
+  if (texture == NULL)
+    return;
+
   surface2 = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
                                          (int) ceilf (clip_rect.size.width),
                                          (int) ceilf (clip_rect.size.height));
   cairo_surface_set_device_offset (surface2, -clip_rect.origin.x, -clip_rect.origin.y);
   cr2 = cairo_create (surface2);
 
-  surface = gdk_texture_download_surface (self->texture, ccs);
+  surface = gdk_texture_download_surface (texture, ccs);
   pattern = cairo_pattern_create_for_surface (surface);
   cairo_pattern_set_extend (pattern, CAIRO_EXTEND_PAD);
 
   cairo_matrix_init_scale (&matrix,
-                           gdk_texture_get_width (self->texture) / node->bounds.size.width,
-                           gdk_texture_get_height (self->texture) / node->bounds.size.height);
+                           gdk_texture_get_width (texture) / node->bounds.size.width,
+                           gdk_texture_get_height (texture) / node->bounds.size.height);
   cairo_matrix_translate (&matrix, -node->bounds.origin.x, -node->bounds.origin.y);
   cairo_pattern_set_matrix (pattern, &matrix);
   cairo_pattern_set_filter (pattern, filters[self->filter]);
@@ -3129,6 +3151,7 @@ gsk_texture_scale_node_new (GdkTexture            *texture,
     bounds->size.width == floor (bounds->size.width) &&
     bounds->size.height == floor (bounds->size.height);
   node->is_hdr = color_state_is_hdr (gdk_texture_get_color_state (texture));
+  node->uses_gl_texture = GDK_IS_GL_TEXTURE (texture);
 
   self->texture = g_object_ref (texture);
   gsk_rect_init_from_rect (&node->bounds, bounds);
@@ -4382,6 +4405,7 @@ struct _GskContainerNode
 
   gboolean disjoint;
   graphene_rect_t opaque; /* Can be 0 0 0 0 to mean no opacity */
+  guint hash; /* of the children, looking through containers, transforms and clips */
   guint n_children;
   GskRenderNode **children;
 };
@@ -4463,6 +4487,124 @@ gsk_container_node_get_diff_settings (void)
   return settings;
 }
 
+static inline guint
+float_hash (float f)
+{
+  union { float f; guint32 u; } v = { f };
+
+  return v.u;
+}
+
+/* Transform and clip nodes get recreated along with the containers,
+ * so they are hashed by their content. */
+static guint
+gsk_container_node_child_hash (GskRenderNode *child)
+{
+  guint hash;
+
+  switch (GSK_RENDER_NODE_TYPE (child))
+    {
+    case GSK_CONTAINER_NODE:
+      return ((GskContainerNode *) child)->hash;
+
+    case GSK_TRANSFORM_NODE:
+      {
+        GskTransform *transform = gsk_transform_node_get_transform (child);
+        GskTransformCategory category = gsk_transform_get_category (transform);
+
+        hash = gsk_container_node_child_hash (gsk_transform_node_get_child (child));
+        hash = hash * 31 + category;
+        if (category >= GSK_TRANSFORM_CATEGORY_2D_TRANSLATE)
+          {
+            float dx, dy;
+
+            gsk_transform_to_translate (transform, &dx, &dy);
+            hash = hash * 31 + float_hash (dx);
+            hash = hash * 31 + float_hash (dy);
+          }
+        return hash;
+      }
+
+    case GSK_CLIP_NODE:
+      {
+        const graphene_rect_t *clip = gsk_clip_node_get_clip (child);
+
+        hash = gsk_container_node_child_hash (gsk_clip_node_get_child (child));
+        hash = hash * 31 + float_hash (clip->origin.x);
+        hash = hash * 31 + float_hash (clip->origin.y);
+        hash = hash * 31 + float_hash (clip->size.width);
+        hash = hash * 31 + float_hash (clip->size.height);
+        return hash;
+      }
+
+    default:
+      return g_direct_hash (child);
+    }
+}
+
+/*
+ * gsk_render_node_is_unchanged:
+ * @node1: a node
+ * @node2: another node
+ *
+ * Checks if the two nodes are known to render the same, because they
+ * only differ in container, transform and clip nodes with the same
+ * content.
+ *
+ * Widgets often recreate those nodes without changing anything below
+ * them, so this is used to skip the expensive diff after a quick walk
+ * that mostly compares pointers.
+ *
+ * Returns: %TRUE if the nodes render the same, %FALSE if that is
+ *   unknown
+ */
+gboolean
+gsk_render_node_is_unchanged (GskRenderNode *node1,
+                              GskRenderNode *node2)
+{
+  if (node1 == node2)
+    return TRUE;
+
+  if (GSK_RENDER_NODE_TYPE (node1) != GSK_RENDER_NODE_TYPE (node2))
+    return FALSE;
+
+  switch (GSK_RENDER_NODE_TYPE (node1))
+    {
+    case GSK_CONTAINER_NODE:
+      {
+        GskContainerNode *self1 = (GskContainerNode *) node1;
+        GskContainerNode *self2 = (GskContainerNode *) node2;
+
+        if (self1->hash != self2->hash ||
+            self1->n_children != self2->n_children)
+          return FALSE;
+
+        for (guint i = 0; i < self1->n_children; i++)
+          {
+            if (!gsk_render_node_is_unchanged (self1->children[i], self2->children[i]))
+              return FALSE;
+          }
+
+        return TRUE;
+      }
+
+    case GSK_TRANSFORM_NODE:
+      return gsk_transform_equal (gsk_transform_node_get_transform (node1),
+                                  gsk_transform_node_get_transform (node2)) &&
+             gsk_render_node_is_unchanged (gsk_transform_node_get_child (node1),
+                                           gsk_transform_node_get_child (node2));
+
+    case GSK_CLIP_NODE:
+      return gsk_rect_equal (gsk_clip_node_get_clip (node1),
+                             gsk_clip_node_get_clip (node2)) &&
+             gsk_render_node_is_unchanged (gsk_clip_node_get_child (node1),
+                                           gsk_clip_node_get_child (node2));
+
+    default:
+      return FALSE;
+    }
+}
+
 static gboolean
 gsk_render_node_diff_multiple (GskRenderNode **nodes1,
                                gsize           n_nodes1,
@@ -4501,6 +4643,9 @@ gsk_container_node_diff (GskRenderNode *node1,
   GskContainerNode *self1 = (GskContainerNode *) node1;
   GskContainerNode *self2 = (GskContainerNode *) node2;
 
+  if (gsk_render_node_is_unchanged (node1, node2))
+    return;
+
   if (gsk_render_node_diff_multiple (self1->children,
                                      self1->n_children,
                                      self2->children,
@@ -4576,8 +4721,10 @@ gsk_container_node_new (GskRenderNode **children,
       self->children = g_malloc_n (n_children, sizeof (GskRenderNode *));
 
       self->children[0] = gsk_render_node_ref (children[0]);
+      self->hash = gsk_container_node_child_hash (children[0]);
       node->offscreen_for_opacity = children[0]->offscreen_for_opacity;
       node->preferred_depth = children[0]->preferred_depth;
+      node->uses_gl_texture = children[0]->uses_gl_texture;
       gsk_rect_init_from_rect (&node->bounds, &(children[0]->bounds));
       have_opaque = gsk_render_node_get_opaque_rect (self->children[0], &self->opaque);
       is_hdr = gsk_render_node_is_hdr (self->children[0]);
@@ -4585,10 +4732,12 @@ gsk_container_node_new (GskRenderNode **children,
       for (guint i = 1; i < n_children; i++)
         {
           self->children[i] = gsk_render_node_ref (children[i]);
+          self->hash = self->hash * 31 + gsk_container_node_child_hash (children[i]);
           self->disjoint = self->disjoint && !gsk_rect_intersects (&node->bounds, &(children[i]->bounds));
           graphene_rect_union (&node->bounds, &(children[i]->bounds), &node->bounds);
           node->preferred_depth = gdk_memory_depth_merge (node->preferred_depth, children[i]->preferred_depth);
           node->offscreen_for_opacity = node->offscreen_for_opacity || children[i]->offscreen_for_opacity;
+          node->uses_gl_texture = node->uses_gl_texture || children[i]->uses_gl_texture;
           if (gsk_render_node_get_opaque_rect (self->children[i], &child_opaque))
             {
               if (have_opaque)
@@ -4901,6 +5050,7 @@ gsk_transform_node_new (GskRenderNode *child,
 
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
+  node->uses_gl_texture = gsk_render_node_uses_gl_texture (child);
 
   return node;
 }
@@ -5054,6 +5204,7 @@ gsk_opacity_node_new (GskRenderNode *child,
 
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
+  node->uses_gl_texture = gsk_render_node_uses_gl_texture (child);
 
   return node;
 }
@@ -5288,6 +5439,7 @@ gsk_color_matrix_node_new (GskRenderNode           *child,
 
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
+  node->uses_gl_texture = gsk_render_node_uses_gl_texture (child);
 
   return node;
 }
@@ -5596,6 +5748,7 @@ gsk_repeat_node_new (const graphene_rect_t *bounds,
 
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
+  node->uses_gl_texture = gsk_render_node_uses_gl_texture (child);
   node->fully_opaque = child->fully_opaque &&
                        gsk_rect_contains_rect (&child->bounds, &self->child_bounds) &&
                        !gsk_rect_is_empty (&self->child_bounds);
@@ -5766,6 +5919,7 @@ gsk_clip_node_new (GskRenderNode         *child,
 
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
+  node->uses_gl_texture = gsk_render_node_uses_gl_texture (child);
 
   return node;
 }
@@ -5950,6 +6104,7 @@ gsk_rounded_clip_node_new (GskRenderNode         *child,
 
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
+  node->uses_gl_texture = gsk_render_node_uses_gl_texture (child);
 
   return node;
 }
@@ -6121,6 +6276,7 @@ gsk_fill_node_new (GskRenderNode *child,
   node->offscreen_for_opacity = child->offscreen_for_opacity;
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
+  node->uses_gl_texture = gsk_render_node_uses_gl_texture (child);
 
   self->child = gsk_render_node_ref (child);
   self->path = gsk_path_ref (path);
@@ -6332,6 +6488,7 @@ gsk_stroke_node_new (GskRenderNode   *child,
   node->offscreen_for_opacity = child->offscreen_for_opacity;
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
+  node->uses_gl_texture = gsk_render_node_uses_gl_texture (child);
 
   self->child = gsk_render_node_ref (child);
   self->path = gsk_path_ref (path);
@@ -6653,6 +6810,7 @@ gsk_shadow_node_new2 (GskRenderNode    *child,
   self->shadows = g_new (GskShadow2, n_shadows);
 
   is_hdr = gsk_render_node_is_hdr (child);
+  node->uses_gl_texture = gsk_render_node_uses_gl_texture (child);
 
   for (i = 0; i < n_shadows; i++)
     {
@@ -6925,6 +7083,8 @@ gsk_blend_node_new (GskRenderNode *bottom,
                                                   gsk_render_node_get_preferred_depth (top));
   node->is_hdr = gsk_render_node_is_hdr (bottom) ||
                  gsk_render_node_is_hdr (top);
+  node->uses_gl_texture = gsk_render_node_uses_gl_texture (bottom) ||
+                          gsk_render_node_uses_gl_texture (top);
 
   return node;
 }
@@ -7114,6 +7274,8 @@ gsk_cross_fade_node_new (GskRenderNode *start,
                                                   gsk_render_node_get_preferred_depth (end));
   node->is_hdr = gsk_render_node_is_hdr (start) ||
                  gsk_render_node_is_hdr (end);
+  node->uses_gl_texture = gsk_render_node_uses_gl_texture (start) ||
+                          gsk_render_node_uses_gl_texture (end);
 
   return node;
 }
@@ -7830,6 +7992,7 @@ gsk_blur_node_new (GskRenderNode *child,
 
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
+  node->uses_gl_texture = gsk_render_node_uses_gl_texture (child);
 
   return node;
 }
@@ -8068,6 +8231,8 @@ gsk_mask_node_new (GskRenderNode *source,
   self->render_node.preferred_depth = gsk_render_node_get_preferred_depth (source);
   self->render_node.is_hdr = gsk_render_node_is_hdr (source) ||
                              gsk_render_node_is_hdr (mask);
+  self->render_node.uses_gl_texture = gsk_render_node_uses_gl_texture (source) ||
+                                      gsk_render_node_uses_gl_texture (mask);
 
   return &self->render_node;
 }
@@ -8247,6 +8412,7 @@ gsk_debug_node_new (GskRenderNode *child,
 
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   self->render_node.is_hdr = gsk_render_node_is_hdr (child);
+  self->render_node.uses_gl_texture = gsk_render_node_uses_gl_texture (child);
 
   return node;
 }
@@ -8442,6 +8608,7 @@ gsk_gl_shader_node_new (GskGLShader           *shader,
           self->children[i] = gsk_render_node_ref (children[i]);
           node->preferred_depth = gdk_memory_depth_merge (node->preferred_depth,
                                                           gsk_render_node_get_preferred_depth (children[i]));
+          node->uses_gl_texture = node->uses_gl_texture || gsk_render_node_uses_gl_texture (children[i]);
         }
     }
 
@@ -8670,6 +8837,7 @@ gsk_subsurface_node_new (GskRenderNode *child,
 
   node->preferred_depth = gsk_render_node_get_preferred_depth (child);
   node->is_hdr = gsk_render_node_is_hdr (child);
+  node->uses_gl_texture = gsk_render_node_uses_gl_texture (child);
 
   return node;
 }
@@ -37,6 +37,7 @@ struct _GskRenderNode
   guint offscreen_for_opacity : 1;
   guint fully_opaque : 1;
   guint is_hdr : 1;
+  guint uses_gl_texture : 1;
 };
 
 typedef struct
@@ -82,6 +83,8 @@ void            gsk_render_node_diff                    (GskRenderNode
 void            gsk_render_node_diff_impossible         (GskRenderNode               *node1,
                                                          GskRenderNode               *node2,
                                                          GskDiffData                 *data);
+gboolean        gsk_render_node_is_unchanged            (GskRenderNode               *node1,
+                                                         GskRenderNode               *node2);
 void            gsk_container_node_diff_with            (GskRenderNode               *container,
                                                          GskRenderNode               *other,
                                                          GskDiffData                 *data);
@@ -111,6 +114,7 @@ void            gsk_transform_node_get_translate        (const GskRenderNode
                                                          float                       *dy);
 GdkMemoryDepth  gsk_render_node_get_preferred_depth     (const GskRenderNode         *node) G_GNUC_PURE;
 gboolean        gsk_render_node_is_hdr                  (const GskRenderNode         *node) G_GNUC_PURE;
+gboolean        gsk_render_node_uses_gl_texture         (const GskRenderNode         *node) G_GNUC_PURE;
 
 gboolean        gsk_container_node_is_disjoint          (const GskRenderNode         *node) G_GNUC_PURE;
 
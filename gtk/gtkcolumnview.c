@@ -2237,3 +2237,28 @@ gtk_column_view_scroll_to (GtkColumnView       *self,
     g_clear_pointer (&scroll, gtk_scroll_info_unref);
 }
 
+/**
+ * gtk_column_view_set_height_estimate_func:
+ * @self: a `GtkColumnView`
+ * @func: (nullable) (scope notified) (closure user_data) (destroy destroy): function
+ *   to estimate row heights
+ * @user_data: user data for @func
+ * @destroy: destroy notifier for @user_data
+ *
+ * Sets a function to estimate the height of rows that have not been
+ * realized yet.
+ *
+ * See [method@Gtk.ListView.set_height_estimate_func] for details.
+ *
+ * Since: 4.18
+ */
+void
+gtk_column_view_set_height_estimate_func (GtkColumnView                 *self,
+                                          GtkListViewHeightEstimateFunc  func,
+                                          gpointer                       user_data,
+                                          GDestroyNotify                 destroy)
+{
+  g_return_if_fail (GTK_IS_COLUMN_VIEW (self));
+
+  gtk_list_view_set_height_estimate_func (self->listview, func, user_data, destroy);
+}
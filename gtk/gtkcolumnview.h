@@ -24,6 +24,7 @@
 #endif
 
 #include <gtk/gtktypes.h>
+#include <gtk/gtklistview.h>
 #include <gtk/gtksortlistmodel.h>
 #include <gtk/gtkselectionmodel.h>
 #include <gtk/gtksorter.h>
@@ -136,5 +137,11 @@ void            gtk_column_view_scroll_to                       (GtkColumnView
                                                                  GtkListScrollFlags      flags,
                                                                  GtkScrollInfo          *scroll);
 
+GDK_AVAILABLE_IN_4_18
+void            gtk_column_view_set_height_estimate_func        (GtkColumnView          *self,
+                                                                 GtkListViewHeightEstimateFunc func,
+                                                                 gpointer                user_data,
+                                                                 GDestroyNotify          destroy);
+
 G_END_DECLS
 
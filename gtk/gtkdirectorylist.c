@@ -48,6 +48,11 @@
  * This means you do not need access to the `GtkDirectoryList`, but can access
  * the `GFile` directly from the `GFileInfo` when operating with a `GtkListView`
  * or similar.
+ *
+ * For very large directories, set [property@Gtk.DirectoryList:update-interval]
+ * to enumerate the directory on a worker thread and add the files in large
+ * batches instead of emitting [signal@Gio.ListModel::items-changed] for every
+ * few hundred files.
  */
 
 /* random number that everyone else seems to use, too */
@@ -63,6 +68,7 @@ enum {
   PROP_LOADING,
   PROP_MONITORED,
   PROP_N_ITEMS,
+  PROP_UPDATE_INTERVAL,
 
   NUM_PROPERTIES
 };
@@ -86,6 +92,48 @@ free_queued_event (gpointer data)
   g_free (event);
 }
 
+/* Shared between the main thread and the worker thread when
+ * loading with an update interval
+ */
+typedef struct _LoadData LoadData;
+struct _LoadData
+{
+  gatomicrefcount ref_count;
+
+  GtkDirectoryList *list; /* main thread only, valid while the update source exists */
+  GFile *file;
+  char *attributes;
+
+  GMutex lock;
+  GPtrArray *pending; /* GFileInfo, protected by lock */
+  GError *error; /* protected by lock */
+  gboolean done; /* protected by lock */
+};
+
+static LoadData *
+load_data_ref (LoadData *data)
+{
+  g_atomic_ref_count_inc (&data->ref_count);
+
+  return data;
+}
+
+static void
+load_data_unref (gpointer user_data)
+{
+  LoadData *data = user_data;
+
+  if (!g_atomic_ref_count_dec (&data->ref_count))
+    return;
+
+  g_object_unref (data->file);
+  g_free (data->attributes);
+  g_mutex_clear (&data->lock);
+  g_ptr_array_unref (data->pending);
+  g_clear_error (&data->error);
+  g_free (data);
+}
+
 struct _GtkDirectoryList
 {
   GObject parent_instance;
@@ -99,7 +147,12 @@ struct _GtkDirectoryList
   GCancellable *cancellable;
   GError *error; /* Error while loading */
   GSequence *items; /* Use GPtrArray or GListStore here? */
+  GHashTable *files; /* GFile => GSequenceIter in items */
   GQueue events;
+  guint events_source;
+
+  guint update_interval;
+  guint update_source;
 };
 
 struct _GtkDirectoryListClass
@@ -174,6 +227,10 @@ gtk_directory_list_set_property (GObject      *object,
       gtk_directory_list_set_monitored (self, g_value_get_boolean (value));
       break;
 
+    case PROP_UPDATE_INTERVAL:
+      gtk_directory_list_set_update_interval (self, g_value_get_uint (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -222,6 +279,10 @@ gtk_directory_list_get_property (GObject     *object,
       g_value_set_uint (value, g_sequence_get_length (self->items));
       break;
 
+    case PROP_UPDATE_INTERVAL:
+      g_value_set_uint (value, self->update_interval);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -234,6 +295,7 @@ gtk_directory_list_stop_loading (GtkDirectoryList *self)
   if (self->cancellable == NULL)
     return FALSE;
 
+  g_clear_handle_id (&self->update_source, g_source_remove);
   g_cancellable_cancel (self->cancellable);
   g_clear_object (&self->cancellable);
   return TRUE;
@@ -265,8 +327,10 @@ gtk_directory_list_dispose (GObject *object)
   g_clear_pointer (&self->attributes, g_free);
 
   g_clear_error (&self->error);
+  g_clear_pointer (&self->files, g_hash_table_unref);
   g_clear_pointer (&self->items, g_sequence_free);
 
+  g_clear_handle_id (&self->events_source, g_source_remove);
   g_queue_foreach (&self->events, (GFunc) free_queued_event, NULL);
   g_queue_clear (&self->events);
 
@@ -366,6 +430,22 @@ gtk_directory_list_class_init (GtkDirectoryListClass *class)
                        0, G_MAXUINT, 0,
                        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GtkDirectoryList:update-interval:
+   *
+   * The minimum time in milliseconds between updates while loading.
+   *
+   * If this is 0, files are added as soon as they are enumerated. Otherwise
+   * the directory is enumerated on a worker thread and the files are added
+   * in one batch per interval.
+   *
+   * Since: 4.18
+   */
+  properties[PROP_UPDATE_INTERVAL] =
+    g_param_spec_uint ("update-interval", NULL, NULL,
+                       0, G_MAXUINT, 0,
+                       GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (gobject_class, NUM_PROPERTIES, properties);
 }
 
@@ -373,6 +453,7 @@ static void
 gtk_directory_list_init (GtkDirectoryList *self)
 {
   self->items = g_sequence_new (g_object_unref);
+  self->files = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, NULL);
   self->io_priority = G_PRIORITY_DEFAULT;
   self->monitored = TRUE;
   g_queue_init (&self->events);
@@ -402,6 +483,35 @@ gtk_directory_list_new (const char *attributes,
                        NULL);
 }
 
+static GFile *
+get_file (GFileInfo *info)
+{
+  return G_FILE (g_file_info_get_attribute_object (info, "standard::file"));
+}
+
+/* takes ownership of info */
+static void
+gtk_directory_list_append_info (GtkDirectoryList *self,
+                                GFileInfo        *info)
+{
+  GSequenceIter *iter;
+
+  iter = g_sequence_append (self->items, info);
+  g_hash_table_replace (self->files, g_object_ref (get_file (info)), iter);
+}
+
+static void
+gtk_directory_list_remove_iter (GtkDirectoryList *self,
+                                GSequenceIter    *iter)
+{
+  GFile *file = get_file (g_sequence_get (iter));
+
+  if (g_hash_table_lookup (self->files, file) == iter)
+    g_hash_table_remove (self->files, file);
+
+  g_sequence_remove (iter);
+}
+
 static void
 gtk_directory_list_clear_items (GtkDirectoryList *self)
 {
@@ -410,6 +520,7 @@ gtk_directory_list_clear_items (GtkDirectoryList *self)
   n_items = g_sequence_get_length (self->items);
   if (n_items > 0)
     {
+      g_hash_table_remove_all (self->files);
       g_sequence_remove_range (g_sequence_get_begin_iter (self->items),
                                g_sequence_get_end_iter (self->items));
 
@@ -484,7 +595,7 @@ gtk_directory_list_got_files_cb (GObject      *source,
       file = g_file_enumerator_get_child (enumerator, info);
       g_file_info_set_attribute_object (info, "standard::file", G_OBJECT (file));
       g_object_unref (file);
-      g_sequence_append (self->items, info);
+      gtk_directory_list_append_info (self, info);
       n++;
     }
   g_list_free (files);
@@ -540,6 +651,142 @@ gtk_directory_list_got_enumerator_cb (GObject      *source,
   g_object_unref (enumerator);
 }
 
+static void
+gtk_directory_list_load_thread (GTask        *task,
+                                gpointer      source_object,
+                                gpointer      task_data,
+                                GCancellable *cancellable)
+{
+  LoadData *data = task_data;
+  GFileEnumerator *enumerator;
+  GError *error = NULL;
+
+  enumerator = g_file_enumerate_children (data->file,
+                                          data->attributes,
+                                          G_FILE_QUERY_INFO_NONE,
+                                          cancellable,
+                                          &error);
+  if (enumerator)
+    {
+      GPtrArray *infos = g_ptr_array_new_with_free_func (g_object_unref);
+      GFileInfo *info;
+
+      do
+        {
+          info = g_file_enumerator_next_file (enumerator, cancellable, &error);
+          if (info)
+            {
+              GFile *file = g_file_enumerator_get_child (enumerator, info);
+
+              g_file_info_set_attribute_object (info, "standard::file", G_OBJECT (file));
+              g_object_unref (file);
+              g_ptr_array_add (infos, info);
+            }
+
+          /* don't take the lock for every single file */
+          if (info == NULL || infos->len >= FILES_PER_QUERY)
+            {
+              g_mutex_lock (&data->lock);
+              g_ptr_array_extend_and_steal (data->pending, infos);
+              g_mutex_unlock (&data->lock);
+
+              infos = info ? g_ptr_array_new_with_free_func (g_object_unref) : NULL;
+            }
+        }
+      while (info);
+
+      g_file_enumerator_close (enumerator, NULL, NULL);
+      g_object_unref (enumerator);
+    }
+
+  g_mutex_lock (&data->lock);
+  data->error = error;
+  data->done = TRUE;
+  g_mutex_unlock (&data->lock);
+}
+
+static gboolean
+gtk_directory_list_update_cb (gpointer user_data)
+{
+  LoadData *data = user_data;
+  GtkDirectoryList *self = data->list;
+  GPtrArray *infos;
+  GError *error;
+  gboolean done;
+  guint i;
+
+  g_mutex_lock (&data->lock);
+  infos = data->pending;
+  data->pending = g_ptr_array_new_with_free_func (g_object_unref);
+  done = data->done;
+  error = g_steal_pointer (&data->error);
+  g_mutex_unlock (&data->lock);
+
+  g_object_freeze_notify (G_OBJECT (self));
+
+  if (infos->len > 0)
+    {
+      guint position = g_sequence_get_length (self->items);
+
+      for (i = 0; i < infos->len; i++)
+        gtk_directory_list_append_info (self, g_object_ref (g_ptr_array_index (infos, i)));
+
+      g_list_model_items_changed (G_LIST_MODEL (self), position, 0, infos->len);
+      g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_N_ITEMS]);
+    }
+  g_ptr_array_unref (infos);
+
+  if (done)
+    {
+      self->update_source = 0;
+      g_clear_object (&self->cancellable);
+      g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_LOADING]);
+
+      if (error)
+        {
+          self->error = error;
+          g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_ERROR]);
+        }
+    }
+
+  g_object_thaw_notify (G_OBJECT (self));
+
+  return done ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+}
+
+static void
+gtk_directory_list_start_loading_in_thread (GtkDirectoryList *self,
+                                            const char       *attributes)
+{
+  LoadData *data;
+  GSource *source;
+  GTask *task;
+
+  data = g_new0 (LoadData, 1);
+  g_atomic_ref_count_init (&data->ref_count);
+  data->list = self;
+  data->file = g_object_ref (self->file);
+  data->attributes = g_strdup (attributes);
+  g_mutex_init (&data->lock);
+  data->pending = g_ptr_array_new_with_free_func (g_object_unref);
+
+  /* The task does not reference @self, stop_loading() cancels it
+   * and removes the update source.
+   */
+  task = g_task_new (NULL, self->cancellable, NULL, NULL);
+  g_task_set_source_tag (task, gtk_directory_list_start_loading_in_thread);
+  g_task_set_task_data (task, load_data_ref (data), load_data_unref);
+  g_task_run_in_thread (task, gtk_directory_list_load_thread);
+  g_object_unref (task);
+
+  source = g_timeout_source_new (self->update_interval);
+  g_source_set_priority (source, self->io_priority);
+  g_source_set_callback (source, gtk_directory_list_update_cb, data, load_data_unref);
+  g_source_set_static_name (source, "[gtk] GtkDirectoryList update");
+  self->update_source = g_source_attach (source, NULL);
+  g_source_unref (source);
+}
+
 static void
 gtk_directory_list_start_loading (GtkDirectoryList *self)
 {
@@ -558,13 +805,16 @@ gtk_directory_list_start_loading (GtkDirectoryList *self)
 
   glib_apis_suck = g_strconcat ("standard::name,", self->attributes, NULL);
   self->cancellable = g_cancellable_new ();
-  g_file_enumerate_children_async (self->file,
-                                   glib_apis_suck,
-                                   G_FILE_QUERY_INFO_NONE,
-                                   self->io_priority,
-                                   self->cancellable,
-                                   gtk_directory_list_got_enumerator_cb,
-                                   self);
+  if (self->update_interval > 0)
+    gtk_directory_list_start_loading_in_thread (self, glib_apis_suck);
+  else
+    g_file_enumerate_children_async (self->file,
+                                     glib_apis_suck,
+                                     G_FILE_QUERY_INFO_NONE,
+                                     self->io_priority,
+                                     self->cancellable,
+                                     gtk_directory_list_got_enumerator_cb,
+                                     self);
   g_free (glib_apis_suck);
 
   if (!was_loading)
@@ -572,27 +822,50 @@ gtk_directory_list_start_loading (GtkDirectoryList *self)
 }
 
 static GSequenceIter *
-find_file (GSequence *sequence,
-           GFile     *file)
+find_file (GtkDirectoryList *self,
+           GFile            *file)
 {
-  GSequenceIter *iter;
+  return g_hash_table_lookup (self->files, file);
+}
 
-  for (iter = g_sequence_get_begin_iter (sequence);
-       !g_sequence_iter_is_end (iter);
-       iter = g_sequence_iter_next (iter))
-    {
-      GFileInfo *item = G_FILE_INFO (g_sequence_get (iter));
-      GFile *f = G_FILE (g_file_info_get_attribute_object (item, "standard::file"));
+/* The change to the items done by the monitor events handled in one
+ * go, relative to the items before the first of them */
+typedef struct
+{
+  guint position;
+  guint removed;
+  guint added;
+} Splice;
+
+/* Adds a change of @removed items at @position being replaced by
+ * @added ones, relative to the current items, to @splice */
+static void
+splice_merge (Splice *splice,
+              guint   position,
+              guint   removed,
+              guint   added)
+{
+  guint start, end;
 
-      if (g_file_equal (f, file))
-        return iter;
+  if (splice->removed == 0 && splice->added == 0)
+    {
+      splice->position = position;
+      splice->removed = removed;
+      splice->added = added;
+      return;
     }
 
-  return NULL;
+  start = MIN (splice->position, position);
+  end = MAX (splice->position + splice->added, position + removed);
+
+  splice->removed = end - start + splice->removed - splice->added;
+  splice->added = end - start + added - removed;
+  splice->position = start;
 }
 
 static gboolean
-handle_event (QueuedEvent *event)
+handle_event (QueuedEvent *event,
+              Splice      *splice)
 {
   GtkDirectoryList *self = event->list;
   GFile *file = event->file;
@@ -609,31 +882,29 @@ handle_event (QueuedEvent *event)
 
       g_file_info_set_attribute_object (info, "standard::file", G_OBJECT (file));
 
-      iter = find_file (self->items, file);
+      iter = find_file (self, file);
       if (iter)
         {
           position = g_sequence_iter_get_position (iter);
           g_sequence_set (iter, g_object_ref (info));
-          g_list_model_items_changed (G_LIST_MODEL (self), position, 1, 1);
+          splice_merge (splice, position, 1, 1);
         }
       else
         {
           position = g_sequence_get_length (self->items);
-          g_sequence_append (self->items, g_object_ref (info));
-          g_list_model_items_changed (G_LIST_MODEL (self), position, 0, 1);
-          g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_N_ITEMS]);
+          gtk_directory_list_append_info (self, g_object_ref (info));
+          splice_merge (splice, position, 0, 1);
         }
       break;
 
     case G_FILE_MONITOR_EVENT_MOVED_OUT:
     case G_FILE_MONITOR_EVENT_DELETED:
-      iter = find_file (self->items, file);
+      iter = find_file (self, file);
       if (iter)
         {
           position = g_sequence_iter_get_position (iter);
-          g_sequence_remove (iter);
-          g_list_model_items_changed (G_LIST_MODEL (self), position, 1, 0);
-          g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_N_ITEMS]);
+          gtk_directory_list_remove_iter (self, iter);
+          splice_merge (splice, position, 1, 0);
         }
       break;
 
@@ -643,12 +914,12 @@ handle_event (QueuedEvent *event)
 
       g_file_info_set_attribute_object (info, "standard::file", G_OBJECT (file));
 
-      iter = find_file (self->items, file);
+      iter = find_file (self, file);
       if (iter)
         {
           position = g_sequence_iter_get_position (iter);
           g_sequence_set (iter, g_object_ref (info));
-          g_list_model_items_changed (G_LIST_MODEL (self), position, 1, 1);
+          splice_merge (splice, position, 1, 1);
         }
       break;
 
@@ -659,24 +930,48 @@ handle_event (QueuedEvent *event)
   return TRUE;
 }
 
-static void
-handle_events (GtkDirectoryList *self)
+/* Handles all events that are ready, in the order they arrived, and
+ * emits a single ::items-changed for all of them. Monitors tend to
+ * send events in bursts, so this saves the views a lot of work.
+ */
+static gboolean
+handle_events_cb (gpointer data)
 {
+  GtkDirectoryList *self = data;
+  Splice splice = { 0, 0, 0 };
   QueuedEvent *event;
+  guint n_items;
 
-  do
-    {
-      event = g_queue_peek_tail (&self->events);
-      if (!event)
-        return;
+  self->events_source = 0;
+  n_items = g_sequence_get_length (self->items);
 
-      if (!handle_event (event))
-        return;
+  while ((event = g_queue_peek_tail (&self->events)))
+    {
+      if (!handle_event (event, &splice))
+        break;
 
       event = g_queue_pop_tail (&self->events);
       free_queued_event (event);
     }
-  while (TRUE);
+
+  if (splice.removed > 0 || splice.added > 0)
+    {
+      g_list_model_items_changed (G_LIST_MODEL (self), splice.position, splice.removed, splice.added);
+      if (n_items != g_sequence_get_length (self->items))
+        g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_N_ITEMS]);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+handle_events (GtkDirectoryList *self)
+{
+  if (self->events_source)
+    return;
+
+  self->events_source = g_idle_add_full (self->io_priority, handle_events_cb, self, NULL);
+  gdk_source_set_static_name_by_id (self->events_source, "[gtk] GtkDirectoryList events");
 }
 
 static void
@@ -1004,8 +1299,8 @@ gtk_directory_list_get_error (GtkDirectoryList *self)
  * for changes.
  *
  * If monitoring is enabled, the ::items-changed signal will
- * be emitted when the directory contents change.
- *
+ * be emitted when the directory contents change. Changes that
+ * arrive together are reported with a single emission.
  *
  * When monitoring is turned on after the initial creation
  * of the directory list, the directory is reloaded to avoid
@@ -1046,3 +1341,53 @@ gtk_directory_list_get_monitored (GtkDirectoryList *self)
 
   return self->monitored;
 }
+
+/**
+ * gtk_directory_list_set_update_interval:
+ * @self: a `GtkDirectoryList`
+ * @interval: minimum time between updates in milliseconds, or 0
+ *
+ * Sets the minimum time between updates while loading.
+ *
+ * If @interval is not 0, the directory is enumerated on a worker
+ * thread and the enumerated files are added in large batches, at
+ * most once per @interval. This greatly reduces the number of
+ * [signal@Gio.ListModel::items-changed] emissions for directories
+ * with many thousands of files, at the cost of some latency.
+ *
+ * Changing the interval while @self is loading takes effect the
+ * next time loading starts.
+ *
+ * Since: 4.18
+ */
+void
+gtk_directory_list_set_update_interval (GtkDirectoryList *self,
+                                        guint             interval)
+{
+  g_return_if_fail (GTK_IS_DIRECTORY_LIST (self));
+
+  if (self->update_interval == interval)
+    return;
+
+  self->update_interval = interval;
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_UPDATE_INTERVAL]);
+}
+
+/**
+ * gtk_directory_list_get_update_interval:
+ * @self: a `GtkDirectoryList`
+ *
+ * Gets the update interval set via gtk_directory_list_set_update_interval().
+ *
+ * Returns: the update interval in milliseconds
+ *
+ * Since: 4.18
+ */
+guint
+gtk_directory_list_get_update_interval (GtkDirectoryList *self)
+{
+  g_return_val_if_fail (GTK_IS_DIRECTORY_LIST (self), 0);
+
+  return self->update_interval;
+}
@@ -67,5 +67,11 @@ void                    gtk_directory_list_set_monitored        (GtkDirectoryLis
 GDK_AVAILABLE_IN_ALL
 gboolean                gtk_directory_list_get_monitored        (GtkDirectoryList       *self);
 
+GDK_AVAILABLE_IN_4_18
+void                    gtk_directory_list_set_update_interval  (GtkDirectoryList       *self,
+                                                                 guint                   interval);
+GDK_AVAILABLE_IN_4_18
+guint                   gtk_directory_list_get_update_interval  (GtkDirectoryList       *self);
+
 G_END_DECLS
 
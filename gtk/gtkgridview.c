@@ -280,6 +280,9 @@ gtk_grid_view_update_factories_with (GtkGridView        *self,
 {
   GtkListTile *tile;
 
+  /* pooled widgets were created for the old factory */
+  gtk_list_item_manager_clear_pool (self->item_manager);
+
   for (tile = gtk_list_item_manager_get_first (self->item_manager);
        tile != NULL;
        tile = gtk_rb_tree_node_get_next (tile))
@@ -1236,6 +1239,8 @@ gtk_grid_view_init (GtkGridView *self)
   gtk_list_base_set_anchor_max_widgets (GTK_LIST_BASE (self),
                                         self->max_columns * GTK_GRID_VIEW_MAX_VISIBLE_ROWS,
                                         self->max_columns);
+  gtk_list_item_manager_set_pool_size (self->item_manager,
+                                       self->max_columns * GTK_GRID_VIEW_MAX_VISIBLE_ROWS);
 
   gtk_widget_add_css_class (GTK_WIDGET (self), "view");
 }
@@ -1401,6 +1406,8 @@ gtk_grid_view_set_max_columns (GtkGridView *self,
   gtk_list_base_set_anchor_max_widgets (GTK_LIST_BASE (self),
                                         self->max_columns * GTK_GRID_VIEW_MAX_VISIBLE_ROWS,
                                         self->max_columns);
+  gtk_list_item_manager_set_pool_size (self->item_manager,
+                                       self->max_columns * GTK_GRID_VIEW_MAX_VISIBLE_ROWS);
 
   gtk_widget_queue_resize (GTK_WIDGET (self));
 
@@ -1473,6 +1480,9 @@ gtk_grid_view_set_single_click_activate (GtkGridView *self,
 
   self->single_click_activate = single_click_activate;
 
+  /* pooled widgets would come back with the old value */
+  gtk_list_item_manager_clear_pool (self->item_manager);
+
   for (tile = gtk_list_item_manager_get_first (self->item_manager);
        tile != NULL;
        tile = gtk_rb_tree_node_get_next (tile))
@@ -35,6 +35,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <string.h>
+#include <errno.h>
 
 
 #ifndef _O_BINARY
@@ -75,38 +76,95 @@ gtk_icon_cache_unref (GtkIconCache *cache)
     }
 }
 
-GtkIconCache *
-gtk_icon_cache_new_for_path (const char *path)
+/* Marks the list of directory mtimes we append to the caches
+ * we write, see serialize_cache()
+ */
+#define DIR_STAMPS_MAGIC 0x47746b44 /* "GtkD" */
+
+/* Adding an icon to a subdirectory doesn't change the mtime of the
+ * theme directory, so the caches we write record the mtimes of all
+ * directories, and we check them here.
+ */
+static gboolean
+icon_cache_directories_unchanged (const char *path,
+                                  char       *buffer,
+                                  gsize       size)
 {
-  GtkIconCache *cache = NULL;
-  GMappedFile *map;
+  guint32 offset, n_stamps, i;
 
-  char *cache_filename;
-  GStatBuf st;
-  GStatBuf path_st;
+  if (size < 12 || size % 4 != 0)
+    return FALSE;
 
-   /* Check if we have a cache file */
-  cache_filename = g_build_filename (path, "icon-theme.cache", NULL);
+  offset = GET_UINT32 (buffer, size - 4);
+  if (offset % 4 != 0 || offset > size - 12 ||
+      GET_UINT32 (buffer, offset) != DIR_STAMPS_MAGIC)
+    return FALSE;
 
-  GTK_DEBUG (ICONTHEME, "look for icon cache in %s", path);
+  n_stamps = GET_UINT32 (buffer, offset + 4);
+  if (n_stamps > (size - 12 - offset) / 12)
+    return FALSE;
 
-  if (g_stat (path, &path_st) < 0)
-    goto done;
+  for (i = 0; i < n_stamps; i++)
+    {
+      guint32 entry = offset + 8 + 12 * i;
+      gint64 mtime;
+      guint32 name_offset;
+      char *dir_path;
+      GStatBuf st;
+      gboolean unchanged;
+
+      mtime = (gint64) (((guint64) GET_UINT32 (buffer, entry) << 32) | GET_UINT32 (buffer, entry + 4));
+      name_offset = GET_UINT32 (buffer, entry + 8);
+      if (name_offset >= size ||
+          memchr (buffer + name_offset, '\0', size - name_offset) == NULL)
+        return FALSE;
+
+      dir_path = g_build_filename (path, buffer + name_offset, NULL);
+      unchanged = g_stat (dir_path, &st) == 0 && st.st_mtime == mtime;
+      if (!unchanged)
+        GTK_DEBUG (ICONTHEME, "icon cache for %s outdated, %s changed", path, dir_path);
+      g_free (dir_path);
+
+      if (!unchanged)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static GtkIconCache *
+icon_cache_new_for_file (const char     *path,
+                         const char     *cache_filename,
+                         const GStatBuf *path_st,
+                         gboolean        check_directories)
+{
+  GtkIconCache *cache;
+  GMappedFile *map;
+  GStatBuf st;
 
   if (g_stat (cache_filename, &st) < 0 || st.st_size < 4)
-    goto done;
+    return NULL;
 
   /* Verify cache is up-to-date */
-  if (st.st_mtime < path_st.st_mtime)
+  if (st.st_mtime < path_st->st_mtime)
     {
-      GTK_DEBUG (ICONTHEME, "icon cache outdated");
-      goto done;
+      GTK_DEBUG (ICONTHEME, "icon cache %s outdated", cache_filename);
+      return NULL;
     }
 
   map = g_mapped_file_new (cache_filename, FALSE, NULL);
 
   if (!map)
-    goto done;
+    return NULL;
+
+  if (check_directories &&
+      !icon_cache_directories_unchanged (path,
+                                         g_mapped_file_get_contents (map),
+                                         g_mapped_file_get_length (map)))
+    {
+      g_mapped_file_unref (map);
+      return NULL;
+    }
 
   if (GTK_DEBUG_CHECK (ICONTHEME))
     {
@@ -122,18 +180,45 @@ gtk_icon_cache_new_for_path (const char *path)
           g_mapped_file_unref (map);
           g_warning ("Icon cache '%s' is invalid", cache_filename);
 
-          goto done;
+          return NULL;
         }
     }
 
-  GTK_DEBUG (ICONTHEME, "found icon cache for %s", path);
+  GTK_DEBUG (ICONTHEME, "found icon cache %s for %s", cache_filename, path);
 
   cache = g_new0 (GtkIconCache, 1);
   cache->ref_count = 1;
   cache->map = map;
   cache->buffer = g_mapped_file_get_contents (map);
 
- done:
+  return cache;
+}
+
+GtkIconCache *
+gtk_icon_cache_new_for_path (const char *path)
+{
+  GtkIconCache *cache;
+  char *cache_filename;
+  GStatBuf path_st;
+
+  GTK_DEBUG (ICONTHEME, "look for icon cache in %s", path);
+
+  if (g_stat (path, &path_st) < 0)
+    return NULL;
+
+  /* Check if we have a cache file */
+  cache_filename = g_build_filename (path, "icon-theme.cache", NULL);
+  cache = icon_cache_new_for_file (path, cache_filename, &path_st, FALSE);
+  g_free (cache_filename);
+
+  if (cache)
+    return cache;
+
+  /* Fall back to an index we wrote ourselves, see
+   * gtk_icon_cache_write_user_cache()
+   */
+  cache_filename = gtk_icon_cache_get_user_cache_filename (path);
+  cache = icon_cache_new_for_file (path, cache_filename, &path_st, TRUE);
   g_free (cache_filename);
 
   return cache;
@@ -257,3 +342,493 @@ gtk_icon_cache_list_icons_in_directory (GtkIconCache *cache,
 
   return icons;
 }
+
+/* Writing caches
+ *
+ * Themes that are installed without running gtk4-update-icon-cache
+ * (or whose cache is outdated) make every process stat and enumerate
+ * all theme directories at startup. To avoid this, we write an index
+ * in the same on-disk format as gtk4-update-icon-cache --index-only
+ * to the user cache directory, where later processes find it via
+ * gtk_icon_cache_new_for_path() and mmap it.
+ */
+
+#define MAX_SCAN_DEPTH 8
+
+typedef struct
+{
+  guint16 dir_index;
+  guint16 flags;
+} CacheImage;
+
+typedef struct
+{
+  char *name;
+  gint64 mtime;
+} DirStamp;
+
+static void
+clear_dir_stamp (gpointer data)
+{
+  DirStamp *stamp = data;
+
+  g_free (stamp->name);
+}
+
+static void
+scan_directory (const char *base_path,
+                const char *subdir,
+                GPtrArray  *directories,
+                GArray     *stamps,
+                GHashTable *icons,
+                int         depth)
+{
+  char *dir_path;
+  GDir *dir;
+  const char *name;
+  GPtrArray *names;
+  GStatBuf st;
+  guint dir_index = G_MAXUINT;
+  guint i;
+
+  if (depth > MAX_SCAN_DEPTH)
+    return;
+
+  dir_path = g_build_filename (base_path, subdir, NULL);
+
+  /* Take the mtime before reading, so changes while we read
+   * make the cache look outdated.
+   */
+  if (g_stat (dir_path, &st) < 0)
+    {
+      g_free (dir_path);
+      return;
+    }
+
+  dir = g_dir_open (dir_path, 0, NULL);
+  if (!dir)
+    {
+      g_free (dir_path);
+      return;
+    }
+
+  g_array_append_val (stamps, ((DirStamp) { g_strdup (subdir ? subdir : ""), st.st_mtime }));
+
+  names = g_ptr_array_new_with_free_func (g_free);
+  while ((name = g_dir_read_name (dir)))
+    g_ptr_array_add (names, g_strdup (name));
+  g_dir_close (dir);
+
+  /* Sort, so that the written cache does not depend on readdir order */
+  g_ptr_array_sort_values (names, (GCompareFunc) strcmp);
+
+  for (i = 0; i < names->len; i++)
+    {
+      char *filename;
+      IconCacheFlag flag;
+      char *icon_name;
+      GArray *images;
+      CacheImage *image;
+
+      name = g_ptr_array_index (names, i);
+      filename = g_build_filename (dir_path, name, NULL);
+
+      if (g_file_test (filename, G_FILE_TEST_IS_DIR))
+        {
+          char *subsubdir;
+
+          if (subdir)
+            subsubdir = g_build_path ("/", subdir, name, NULL);
+          else
+            subsubdir = g_strdup (name);
+
+          scan_directory (base_path, subsubdir, directories, stamps, icons, depth + 1);
+
+          g_free (subsubdir);
+          g_free (filename);
+          continue;
+        }
+
+      g_free (filename);
+
+      /* Ignore images in the toplevel directory */
+      if (subdir == NULL)
+        continue;
+
+      if (g_str_has_suffix (name, ".png"))
+        flag = ICON_CACHE_FLAG_PNG_SUFFIX;
+      else if (g_str_has_suffix (name, ".svg"))
+        flag = ICON_CACHE_FLAG_SVG_SUFFIX;
+      else if (g_str_has_suffix (name, ".xpm"))
+        flag = ICON_CACHE_FLAG_XPM_SUFFIX;
+      else if (g_str_has_suffix (name, ".icon"))
+        flag = ICON_CACHE_FLAG_HAS_ICON_FILE;
+      else
+        continue;
+
+      if (dir_index == G_MAXUINT)
+        {
+          /* Directory indexes are 16 bit on disk */
+          if (directories->len >= G_MAXUINT16)
+            break;
+
+          dir_index = directories->len;
+          g_ptr_array_add (directories, g_strdup (subdir));
+        }
+
+      /* Like the on-disk format, this keeps the ".symbolic" in
+       * foo.symbolic.png, gtk_icon_cache_list_icons_in_directory()
+       * strips it when reading.
+       */
+      icon_name = g_strndup (name, strrchr (name, '.') - name);
+
+      images = g_hash_table_lookup (icons, icon_name);
+      if (images == NULL)
+        {
+          images = g_array_new (FALSE, FALSE, sizeof (CacheImage));
+          g_hash_table_insert (icons, icon_name, images);
+        }
+      else
+        g_free (icon_name);
+
+      image = NULL;
+      for (guint j = 0; j < images->len; j++)
+        {
+          if (g_array_index (images, CacheImage, j).dir_index == dir_index)
+            {
+              image = &g_array_index (images, CacheImage, j);
+              break;
+            }
+        }
+
+      if (image == NULL)
+        {
+          g_array_set_size (images, images->len + 1);
+          image = &g_array_index (images, CacheImage, images->len - 1);
+          image->dir_index = dir_index;
+          image->flags = 0;
+        }
+
+      image->flags |= flag;
+    }
+
+  g_ptr_array_unref (names);
+  g_free (dir_path);
+}
+
+static void
+append_uint16 (GByteArray *data,
+               guint16     value)
+{
+  value = GUINT16_TO_BE (value);
+  g_byte_array_append (data, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+append_uint32 (GByteArray *data,
+               guint32     value)
+{
+  value = GUINT32_TO_BE (value);
+  g_byte_array_append (data, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+set_uint32 (GByteArray *data,
+            guint32     offset,
+            guint32     value)
+{
+  value = GUINT32_TO_BE (value);
+  memcpy (data->data + offset, &value, sizeof (value));
+}
+
+static guint32
+append_string (GByteArray *data,
+               const char *string)
+{
+  static const guint8 padding[4] = { 0, };
+  guint32 offset = data->len;
+
+  g_byte_array_append (data, (const guint8 *) string, strlen (string) + 1);
+  /* Keep everything 4-byte aligned, like gtk4-update-icon-cache does */
+  g_byte_array_append (data, padding, (4 - data->len % 4) % 4);
+
+  return offset;
+}
+
+/* Must match icon_name_hash() in gtk4-update-icon-cache */
+static guint32
+icon_name_hash (const char *name)
+{
+  const signed char *p = (const signed char *) name;
+  guint32 h = *p;
+
+  if (h)
+    for (p += 1; *p != '\0'; p++)
+      h = (h << 5) - h + *p;
+
+  return h;
+}
+
+static int
+compare_names (gconstpointer a,
+               gconstpointer b)
+{
+  return strcmp (*(const char **) a, *(const char **) b);
+}
+
+static GBytes *
+serialize_cache (GPtrArray  *directories,
+                 GArray     *stamps,
+                 GHashTable *icons)
+{
+  GByteArray *data;
+  const char **names;
+  guint n_names, n_buckets;
+  guint32 hash_offset, dir_list_offset, stamps_offset;
+  guint i, j;
+
+  data = g_byte_array_new ();
+
+  /* Header, offsets are filled in below */
+  append_uint16 (data, 1);
+  append_uint16 (data, 0);
+  append_uint32 (data, 0);
+  append_uint32 (data, 0);
+
+  names = (const char **) g_hash_table_get_keys_as_array (icons, &n_names);
+  qsort (names, n_names, sizeof (char *), compare_names);
+  n_buckets = g_spaced_primes_closest (n_names / 3);
+
+  hash_offset = data->len;
+  set_uint32 (data, 4, hash_offset);
+  append_uint32 (data, n_buckets);
+  for (i = 0; i < n_buckets; i++)
+    append_uint32 (data, 0xffffffff);
+
+  for (i = 0; i < n_names; i++)
+    {
+      GArray *images = g_hash_table_lookup (icons, names[i]);
+      guint32 bucket_offset, icon_offset, image_list_offset;
+
+      bucket_offset = hash_offset + 4 + 4 * (icon_name_hash (names[i]) % n_buckets);
+
+      /* Prepend to the chain of the bucket */
+      icon_offset = data->len;
+      append_uint32 (data, GUINT32_FROM_BE (*(guint32 *) (data->data + bucket_offset)));
+      append_uint32 (data, 0);
+      append_uint32 (data, 0);
+      set_uint32 (data, bucket_offset, icon_offset);
+
+      image_list_offset = data->len;
+      set_uint32 (data, icon_offset + 8, image_list_offset);
+      append_uint32 (data, images->len);
+      for (j = 0; j < images->len; j++)
+        {
+          const CacheImage *image = &g_array_index (images, CacheImage, j);
+
+          append_uint16 (data, image->dir_index);
+          append_uint16 (data, image->flags);
+          append_uint32 (data, 0); /* no image data */
+        }
+
+      set_uint32 (data, icon_offset + 4, append_string (data, names[i]));
+    }
+
+  dir_list_offset = data->len;
+  set_uint32 (data, 8, dir_list_offset);
+  append_uint32 (data, directories->len);
+  for (i = 0; i < directories->len; i++)
+    append_uint32 (data, 0);
+  for (i = 0; i < directories->len; i++)
+    set_uint32 (data, dir_list_offset + 4 + 4 * i,
+                append_string (data, g_ptr_array_index (directories, i)));
+
+  g_free (names);
+
+  /* The mtimes of all directories we scanned, so that readers notice
+   * changes to subdirectories. Readers of the cache format ignore
+   * data after the directory list, so this goes at the end, with
+   * its offset in the last 4 bytes.
+   */
+  stamps_offset = data->len;
+  append_uint32 (data, DIR_STAMPS_MAGIC);
+  append_uint32 (data, stamps->len);
+  for (i = 0; i < stamps->len; i++)
+    {
+      const DirStamp *stamp = &g_array_index (stamps, DirStamp, i);
+
+      append_uint32 (data, (guint64) stamp->mtime >> 32);
+      append_uint32 (data, (guint64) stamp->mtime & 0xffffffff);
+      append_uint32 (data, 0);
+    }
+  for (i = 0; i < stamps->len; i++)
+    set_uint32 (data, stamps_offset + 8 + 12 * i + 8,
+                append_string (data, g_array_index (stamps, DirStamp, i).name));
+  append_uint32 (data, stamps_offset);
+
+  return g_byte_array_free_to_bytes (data);
+}
+
+/*
+ * gtk_icon_cache_write_for_path:
+ * @path: the theme directory to index
+ * @cache_filename: the file to write the index to
+ * @error: return location for an error
+ *
+ * Scans all subdirectories of @path and writes an icon cache
+ * for them to @cache_filename, in the format that is understood
+ * by gtk_icon_cache_new_for_path().
+ *
+ * Returns: %TRUE if the cache was written
+ */
+gboolean
+gtk_icon_cache_write_for_path (const char  *path,
+                               const char  *cache_filename,
+                               GError     **error)
+{
+  GPtrArray *directories;
+  GArray *stamps;
+  GHashTable *icons;
+  GBytes *bytes;
+  GStatBuf before, after;
+  char *cache_dir;
+  gboolean result = FALSE;
+
+  if (g_stat (path, &before) < 0)
+    {
+      int errsv = errno;
+
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (errsv),
+                   "Could not stat %s: %s", path, g_strerror (errsv));
+      return FALSE;
+    }
+
+  directories = g_ptr_array_new_with_free_func (g_free);
+  stamps = g_array_new (FALSE, FALSE, sizeof (DirStamp));
+  g_array_set_clear_func (stamps, clear_dir_stamp);
+  icons = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                 g_free, (GDestroyNotify) g_array_unref);
+
+  scan_directory (path, NULL, directories, stamps, icons, 0);
+
+  bytes = serialize_cache (directories, stamps, icons);
+
+  cache_dir = g_path_get_dirname (cache_filename);
+  g_mkdir_with_parents (cache_dir, 0700);
+  g_free (cache_dir);
+
+  if (!g_file_set_contents (cache_filename,
+                            g_bytes_get_data (bytes, NULL),
+                            g_bytes_get_size (bytes),
+                            error))
+    goto out;
+
+  /* If the directory changed while we were scanning, the cache may
+   * be missing files but would still look up-to-date, so drop it.
+   */
+  if (g_stat (path, &after) < 0 || after.st_mtime != before.st_mtime)
+    {
+      g_remove (cache_filename);
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_AGAIN,
+                   "%s changed while writing icon cache", path);
+      goto out;
+    }
+
+  GTK_DEBUG (ICONTHEME, "wrote icon cache %s for %s (%u directories, %u icons)",
+             cache_filename, path, directories->len, g_hash_table_size (icons));
+
+  result = TRUE;
+
+out:
+  g_bytes_unref (bytes);
+  g_hash_table_unref (icons);
+  g_array_unref (stamps);
+  g_ptr_array_unref (directories);
+
+  return result;
+}
+
+/*
+ * gtk_icon_cache_get_user_cache_filename:
+ * @path: a theme directory
+ *
+ * Returns: (transfer full): the location of the icon cache
+ *   for @path in the user cache directory
+ */
+char *
+gtk_icon_cache_get_user_cache_filename (const char *path)
+{
+  char *checksum;
+  char *basename;
+  char *filename;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA256, path, -1);
+  basename = g_strconcat (checksum, ".cache", NULL);
+  filename = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "icon-cache", basename, NULL);
+
+  g_free (basename);
+  g_free (checksum);
+
+  return filename;
+}
+
+G_LOCK_DEFINE_STATIC (pending_writes);
+static GHashTable *pending_writes; /* path -> path, protected by pending_writes lock */
+
+static void
+write_user_cache_thread (GTask        *task,
+                         gpointer      source_object,
+                         gpointer      task_data,
+                         GCancellable *cancellable)
+{
+  const char *path = task_data;
+  char *cache_filename;
+  GError *error = NULL;
+
+  cache_filename = gtk_icon_cache_get_user_cache_filename (path);
+
+  if (!gtk_icon_cache_write_for_path (path, cache_filename, &error))
+    {
+      GTK_DEBUG (ICONTHEME, "failed to write icon cache for %s: %s", path, error->message);
+      g_error_free (error);
+    }
+
+  g_free (cache_filename);
+
+  G_LOCK (pending_writes);
+  g_hash_table_remove (pending_writes, path);
+  G_UNLOCK (pending_writes);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+/*
+ * gtk_icon_cache_write_user_cache:
+ * @path: a theme directory without an up-to-date cache
+ *
+ * Writes an icon cache for @path to the user cache directory
+ * in a thread, so that later lookups can use it instead of
+ * enumerating the theme directories.
+ */
+void
+gtk_icon_cache_write_user_cache (const char *path)
+{
+  GTask *task;
+
+  G_LOCK (pending_writes);
+  if (pending_writes == NULL)
+    pending_writes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  if (g_hash_table_contains (pending_writes, path))
+    {
+      G_UNLOCK (pending_writes);
+      return;
+    }
+  g_hash_table_add (pending_writes, g_strdup (path));
+  G_UNLOCK (pending_writes);
+
+  task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_source_tag (task, gtk_icon_cache_write_user_cache);
+  g_task_set_task_data (task, g_strdup (path), g_free);
+  g_task_run_in_thread (task, write_user_cache_thread);
+  g_object_unref (task);
+}
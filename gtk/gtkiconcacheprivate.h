@@ -45,5 +45,11 @@ GHashTable   *gtk_icon_cache_list_icons_in_directory    (GtkIconCache *cache,
 GtkIconCache *gtk_icon_cache_ref                        (GtkIconCache *cache);
 void          gtk_icon_cache_unref                      (GtkIconCache *cache);
 
+gboolean      gtk_icon_cache_write_for_path             (const char   *path,
+                                                         const char   *cache_filename,
+                                                         GError      **error);
+char *        gtk_icon_cache_get_user_cache_filename    (const char   *path);
+void          gtk_icon_cache_write_user_cache           (const char   *path);
+
 G_END_DECLS
 
@@ -328,6 +328,7 @@ struct _GtkIconTheme
 
   GtkIconPaintable *lru_cache[LRU_CACHE_SIZE];  /* Protected by icon_cache lock */
   int lru_cache_current;                        /* Protected by icon_cache lock */
+  GHashTable *preloaded;                        /* Protected by icon_cache lock */
 
   GtkStringSet icons;
 
@@ -476,6 +477,7 @@ typedef struct
   time_t mtime;
   GtkIconCache *cache;
   gboolean exists;
+  gboolean scanned; /* had to be scanned because there was no cache */
 } IconThemeDirMtime;
 
 static void              gtk_icon_theme_finalize          (GObject          *object);
@@ -792,6 +794,7 @@ icon_cache_clear (GtkIconTheme *theme)
 {
   int i;
   GtkIconPaintable *old_icons[LRU_CACHE_SIZE];
+  GHashTable *old_preloaded;
 
   G_LOCK (icon_cache);
   g_hash_table_remove_all (theme->icon_cache);
@@ -800,9 +803,12 @@ icon_cache_clear (GtkIconTheme *theme)
       old_icons[i] = theme->lru_cache[i];
       theme->lru_cache[i] = NULL;
     }
+  old_preloaded = g_steal_pointer (&theme->preloaded);
+  theme->preloaded = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
   G_UNLOCK (icon_cache);
 
   /* Call potential finalizers outside the lock */
+  g_hash_table_unref (old_preloaded);
   for (i = 0; i < LRU_CACHE_SIZE; i ++)
     {
       if (old_icons[i] != NULL)
@@ -1274,6 +1280,7 @@ gtk_icon_theme_init (GtkIconTheme *self)
 
   self->icon_cache = g_hash_table_new_full (icon_key_hash, icon_key_equal, NULL,
                                             (GDestroyNotify)icon_uncached_cb);
+  self->preloaded = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
 
   self->custom_theme = FALSE;
   self->dir_mtimes = g_array_new (FALSE, TRUE, sizeof (IconThemeDirMtime));
@@ -1440,6 +1447,7 @@ gtk_icon_theme_finalize (GObject *object)
 
   blow_themes (self);
   g_array_free (self->dir_mtimes, TRUE);
+  g_hash_table_unref (self->preloaded);
 
   gtk_icon_theme_ref_unref (self->ref);
 
@@ -1756,6 +1764,7 @@ insert_theme (GtkIconTheme *self,
 
       path = g_build_filename (self->search_path[i], theme_name, NULL);
       dir_mtime.cache = NULL;
+      dir_mtime.scanned = FALSE;
       dir_mtime.dir = path;
       if (g_stat (path, &stat_buf) == 0 && S_ISDIR (stat_buf.st_mode))
         {
@@ -1978,6 +1987,7 @@ load_themes (GtkIconTheme *self)
       dir_mtime->mtime = 0;
       dir_mtime->exists = FALSE;
       dir_mtime->cache = NULL;
+      dir_mtime->scanned = FALSE;
 
       if (g_stat (dir, &stat_buf) != 0 || !S_ISDIR (stat_buf.st_mode))
         continue;
@@ -2014,6 +2024,15 @@ load_themes (GtkIconTheme *self)
       g_strfreev (children);
     }
 
+  /* Save the next process from scanning theme directories again */
+  for (guint i = 0; i < self->dir_mtimes->len; i++)
+    {
+      IconThemeDirMtime *dir_mtime = &g_array_index (self->dir_mtimes, IconThemeDirMtime, i);
+
+      if (dir_mtime->scanned)
+        gtk_icon_cache_write_user_cache (dir_mtime->dir);
+    }
+
   self->themes_valid = TRUE;
 
   self->last_stat_time = g_get_monotonic_time ();
@@ -2146,6 +2165,11 @@ real_choose_icon (GtkIconTheme      *self,
   if (!ensure_valid_themes (self, non_blocking))
     return NULL;
 
+  /* Preloading only affects when the texture gets loaded, not
+   * which icon is found, so don't let it split the cache.
+   */
+  flags &= ~GTK_ICON_LOOKUP_PRELOAD;
+
   key.icon_names = (char **)icon_names;
   key.size = size;
   key.scale = scale;
@@ -2526,6 +2550,274 @@ gtk_icon_theme_lookup_icon (GtkIconTheme       *self,
   return icon;
 }
 
+typedef struct
+{
+  gatomicrefcount ref_count;
+
+  char **icon_names;
+  int size;
+  int scale;
+  GtkTextDirection direction;
+  GtkIconLookupFlags flags;
+
+  /* Each worker only writes its own range of slots */
+  GtkIconPaintable **icons;
+  guint n_pending;
+} PreloadData;
+
+typedef struct
+{
+  PreloadData *data;
+  guint start;
+  guint end;
+} PreloadChunk;
+
+static PreloadData *
+preload_data_ref (PreloadData *data)
+{
+  g_atomic_ref_count_inc (&data->ref_count);
+  return data;
+}
+
+static void
+preload_data_unref (PreloadData *data)
+{
+  guint n, i;
+
+  if (!g_atomic_ref_count_dec (&data->ref_count))
+    return;
+
+  n = g_strv_length (data->icon_names);
+  for (i = 0; i < n; i++)
+    g_clear_object (&data->icons[i]);
+  g_free (data->icons);
+  g_strfreev (data->icon_names);
+  g_free (data);
+}
+
+static void
+preload_chunk_free (PreloadChunk *chunk)
+{
+  preload_data_unref (chunk->data);
+  g_free (chunk);
+}
+
+static void
+preload_icons_thread (GTask        *task,
+                      gpointer      source_object,
+                      gpointer      task_data,
+                      GCancellable *cancellable)
+{
+  GtkIconTheme *self = GTK_ICON_THEME (source_object);
+  PreloadChunk *chunk = task_data;
+  PreloadData *data = chunk->data;
+  guint i;
+
+  for (i = chunk->start; i < chunk->end; i++)
+    {
+      GIcon *gicon;
+      GtkIconPaintable *icon;
+
+      if (g_task_return_error_if_cancelled (task))
+        return;
+
+      /* Use the same names as a lookup of the GThemedIcon that
+       * GtkImage creates for the icon name, so that we end up
+       * with the same cache key.
+       */
+      gicon = g_themed_icon_new (data->icon_names[i]);
+      gtk_icon_theme_lock (self);
+      icon = choose_icon (self,
+                          (const char **) g_themed_icon_get_names (G_THEMED_ICON (gicon)),
+                          data->size, data->scale, data->direction, data->flags, FALSE);
+      gtk_icon_theme_unlock (self);
+      g_object_unref (gicon);
+
+      if (icon == NULL)
+        continue;
+
+      g_mutex_lock (&icon->texture_lock);
+      icon_ensure_texture__locked (icon, TRUE);
+      g_mutex_unlock (&icon->texture_lock);
+
+      data->icons[i] = icon;
+    }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+preload_chunk_done (GObject      *source,
+                    GAsyncResult *result,
+                    gpointer      user_data)
+{
+  GTask *task = user_data;
+  GtkIconTheme *self = g_task_get_source_object (task);
+  PreloadData *data = g_task_get_task_data (task);
+  GError *error = NULL;
+
+  if (!g_task_propagate_boolean (G_TASK (result), &error))
+    {
+      if (!g_task_had_error (task))
+        g_task_return_error (task, error);
+      else
+        g_error_free (error);
+    }
+
+  data->n_pending--;
+  if (data->n_pending == 0 && !g_task_had_error (task))
+    {
+      GListStore *store;
+      guint n, i;
+
+      store = g_list_store_new (GTK_TYPE_ICON_PAINTABLE);
+      n = g_strv_length (data->icon_names);
+
+      /* Keep the icons alive in the cache until the theme changes */
+      G_LOCK (icon_cache);
+      for (i = 0; i < n; i++)
+        {
+          if (data->icons[i] &&
+              !g_hash_table_contains (self->preloaded, data->icons[i]))
+            g_hash_table_add (self->preloaded, g_object_ref (data->icons[i]));
+        }
+      G_UNLOCK (icon_cache);
+
+      for (i = 0; i < n; i++)
+        {
+          if (data->icons[i])
+            g_list_store_append (store, data->icons[i]);
+        }
+
+      g_task_return_pointer (task, store, g_object_unref);
+    }
+
+  g_object_unref (task);
+}
+
+/**
+ * gtk_icon_theme_preload_icons:
+ * @self: a `GtkIconTheme`
+ * @icon_names: (array zero-terminated=1): the names of the icons to load
+ * @size: desired icon size, in application pixels
+ * @scale: the window scale the icons will be displayed on
+ * @direction: text direction the icons will be displayed in
+ * @flags: flags modifying the icon lookup
+ * @cancellable: (nullable): a `GCancellable` to cancel the operation
+ * @callback: (scope async) (closure user_data): a callback to call when
+ *   the icons are loaded
+ * @user_data: data to pass to @callback
+ *
+ * Looks up and loads a set of icons in worker threads.
+ *
+ * This is meant for views that are about to show many different
+ * icons at once, such as a `GtkGridView` of files. Resolving and
+ * decoding the icons ahead of time avoids doing it on the main
+ * thread while the first frame is drawn.
+ *
+ * Each icon is looked up like a `GThemedIcon` for its name would be
+ * by [method@Gtk.IconTheme.lookup_by_gicon] with the same parameters,
+ * which is how `GtkImage` looks up named icons, and its pixel data
+ * is loaded. The loaded paintables stay in the icon theme's cache
+ * until the theme changes, so later lookups of the same icons with
+ * the same size, scale, direction and flags return them, whether
+ * or not the returned list is still alive. %GTK_ICON_LOOKUP_PRELOAD
+ * does not matter for this.
+ *
+ * Since: 4.18
+ */
+void
+gtk_icon_theme_preload_icons (GtkIconTheme        *self,
+                              const char * const  *icon_names,
+                              int                  size,
+                              int                  scale,
+                              GtkTextDirection     direction,
+                              GtkIconLookupFlags   flags,
+                              GCancellable        *cancellable,
+                              GAsyncReadyCallback  callback,
+                              gpointer             user_data)
+{
+  PreloadData *data;
+  GTask *task;
+  guint n_names, n_chunks, chunk_size, i;
+
+  g_return_if_fail (GTK_IS_ICON_THEME (self));
+  g_return_if_fail (icon_names != NULL);
+  g_return_if_fail (scale >= 1);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  n_names = g_strv_length ((char **) icon_names);
+
+  data = g_new0 (PreloadData, 1);
+  g_atomic_ref_count_init (&data->ref_count);
+  data->icon_names = g_strdupv ((char **) icon_names);
+  data->size = size;
+  data->scale = scale;
+  data->direction = direction;
+  data->flags = flags & ~GTK_ICON_LOOKUP_PRELOAD;
+  data->icons = g_new0 (GtkIconPaintable *, MAX (n_names, 1));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtk_icon_theme_preload_icons);
+  g_task_set_task_data (task, data, (GDestroyNotify) preload_data_unref);
+
+  if (n_names == 0)
+    {
+      g_task_return_pointer (task, g_list_store_new (GTK_TYPE_ICON_PAINTABLE), g_object_unref);
+      g_object_unref (task);
+      return;
+    }
+
+  n_chunks = MIN (n_names, (guint) g_get_num_processors ());
+  chunk_size = (n_names + n_chunks - 1) / n_chunks;
+  n_chunks = (n_names + chunk_size - 1) / chunk_size;
+  data->n_pending = n_chunks;
+
+  for (i = 0; i < n_chunks; i++)
+    {
+      PreloadChunk *chunk;
+      GTask *chunk_task;
+
+      chunk = g_new (PreloadChunk, 1);
+      chunk->data = preload_data_ref (data);
+      chunk->start = i * chunk_size;
+      chunk->end = MIN (n_names, chunk->start + chunk_size);
+
+      chunk_task = g_task_new (self, cancellable, preload_chunk_done, g_object_ref (task));
+      g_task_set_source_tag (chunk_task, preload_icons_thread);
+      g_task_set_task_data (chunk_task, chunk, (GDestroyNotify) preload_chunk_free);
+      g_task_run_in_thread (chunk_task, preload_icons_thread);
+      g_object_unref (chunk_task);
+    }
+
+  g_object_unref (task);
+}
+
+/**
+ * gtk_icon_theme_preload_icons_finish:
+ * @self: a `GtkIconTheme`
+ * @result: a `GAsyncResult`
+ * @error: return location for an error
+ *
+ * Finishes an operation started with [method@Gtk.IconTheme.preload_icons].
+ *
+ * Returns: (transfer full) (nullable): a list of `GtkIconPaintable`
+ *   objects for the icons that were loaded, or %NULL on error
+ *
+ * Since: 4.18
+ */
+GListModel *
+gtk_icon_theme_preload_icons_finish (GtkIconTheme  *self,
+                                     GAsyncResult  *result,
+                                     GError       **error)
+{
+  g_return_val_if_fail (GTK_IS_ICON_THEME (self), NULL);
+  g_return_val_if_fail (g_task_is_valid (result, self), NULL);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == gtk_icon_theme_preload_icons, NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 /**
  * gtk_icon_theme_error_quark:
  *
@@ -3369,7 +3661,10 @@ theme_subdir_load (GtkIconTheme *self,
           if (dir_mtime->cache != NULL)
             icons = gtk_icon_cache_list_icons_in_directory (dir_mtime->cache, subdir, &self->icons);
           else
-            icons = scan_directory (self, str->str, &self->icons);
+            {
+              icons = scan_directory (self, str->str, &self->icons);
+              dir_mtime->scanned = TRUE;
+            }
 
           if (icons)
             {
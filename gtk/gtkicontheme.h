@@ -137,6 +137,20 @@ GtkIconPaintable *gtk_icon_theme_lookup_icon         (GtkIconTheme
                                                       int                          scale,
                                                       GtkTextDirection             direction,
                                                       GtkIconLookupFlags           flags);
+GDK_AVAILABLE_IN_4_18
+void              gtk_icon_theme_preload_icons       (GtkIconTheme                *self,
+                                                      const char * const          *icon_names,
+                                                      int                          size,
+                                                      int                          scale,
+                                                      GtkTextDirection             direction,
+                                                      GtkIconLookupFlags           flags,
+                                                      GCancellable                *cancellable,
+                                                      GAsyncReadyCallback          callback,
+                                                      gpointer                     user_data);
+GDK_AVAILABLE_IN_4_18
+GListModel *      gtk_icon_theme_preload_icons_finish (GtkIconTheme               *self,
+                                                      GAsyncResult                *result,
+                                                      GError                     **error);
 GDK_AVAILABLE_IN_ALL
 GtkIconPaintable *gtk_icon_theme_lookup_by_gicon     (GtkIconTheme                *self,
                                                       GIcon                       *icon,
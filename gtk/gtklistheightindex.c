@@ -0,0 +1,389 @@
+/*
+ * Copyright © 2025 GTK Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtklistheightindexprivate.h"
+
+#include "gtkrbtreeprivate.h"
+
+#include <string.h>
+
+/* The estimated item heights, in chunks kept in a GtkRbTree whose
+ * augment sums up item counts and heights.
+ *
+ * It answers "how high are items [a, b)" and "which item is at offset y"
+ * in O(log n) without realizing any rows, which keeps scrollbar sizes and
+ * scroll_to() targets stable for lists whose rows differ a lot in height.
+ * When the model changes, the chunks are spliced, so only the added items
+ * need to be estimated.
+ */
+
+#define CHUNK_SIZE 64
+
+typedef struct _HeightNode HeightNode;
+typedef struct _HeightAugment HeightAugment;
+
+struct _HeightNode
+{
+  guint n_items;
+  gint64 height;
+  int heights[CHUNK_SIZE];
+};
+
+struct _HeightAugment
+{
+  guint n_items;
+  gint64 height;
+};
+
+struct _GtkListHeightIndex
+{
+  GtkRbTree *chunks;
+  GtkListHeightIndexFunc func;
+  gpointer user_data;
+};
+
+static void
+height_node_augment (GtkRbTree *tree,
+                     gpointer   node_augment,
+                     gpointer   node,
+                     gpointer   left,
+                     gpointer   right)
+{
+  HeightNode *chunk = node;
+  HeightAugment *aug = node_augment;
+
+  aug->n_items = chunk->n_items;
+  aug->height = chunk->height;
+
+  if (left)
+    {
+      HeightAugment *left_aug = gtk_rb_tree_get_augment (tree, left);
+
+      aug->n_items += left_aug->n_items;
+      aug->height += left_aug->height;
+    }
+
+  if (right)
+    {
+      HeightAugment *right_aug = gtk_rb_tree_get_augment (tree, right);
+
+      aug->n_items += right_aug->n_items;
+      aug->height += right_aug->height;
+    }
+}
+
+static void
+height_node_update (GtkRbTree  *tree,
+                    HeightNode *chunk)
+{
+  guint i;
+
+  if (chunk->n_items == 0)
+    {
+      gtk_rb_tree_remove (tree, chunk);
+      return;
+    }
+
+  chunk->height = 0;
+  for (i = 0; i < chunk->n_items; i++)
+    chunk->height += chunk->heights[i];
+
+  gtk_rb_tree_node_mark_dirty (chunk);
+}
+
+/* Returns the chunk containing @position and sets @out_start_pos to the
+ * position of its first item, or returns %NULL if @position is past the
+ * end.
+ */
+static HeightNode *
+gtk_list_height_index_get_nth (GtkListHeightIndex *self,
+                               guint               position,
+                               guint              *out_start_pos)
+{
+  HeightNode *node, *tmp;
+  guint start_pos = position;
+
+  node = gtk_rb_tree_get_root (self->chunks);
+
+  while (node)
+    {
+      tmp = gtk_rb_tree_node_get_left (node);
+      if (tmp)
+        {
+          HeightAugment *aug = gtk_rb_tree_get_augment (self->chunks, tmp);
+          if (position < aug->n_items)
+            {
+              node = tmp;
+              continue;
+            }
+          position -= aug->n_items;
+        }
+
+      if (position < node->n_items)
+        {
+          start_pos -= position;
+          break;
+        }
+      position -= node->n_items;
+
+      node = gtk_rb_tree_node_get_right (node);
+    }
+
+  if (out_start_pos)
+    *out_start_pos = start_pos;
+
+  return node;
+}
+
+static void
+gtk_list_height_index_insert (GtkListHeightIndex *self,
+                              guint               position,
+                              guint               n_items)
+{
+  int tail[CHUNK_SIZE];
+  HeightNode *chunk;
+  guint i, idx, n_tail, start;
+
+  if (n_items == 0)
+    return;
+
+  chunk = gtk_list_height_index_get_nth (self, position, &start);
+  if (chunk)
+    {
+      idx = position - start;
+    }
+  else
+    {
+      chunk = gtk_rb_tree_get_last (self->chunks);
+      if (chunk == NULL || chunk->n_items == CHUNK_SIZE)
+        chunk = gtk_rb_tree_insert_after (self->chunks, chunk);
+      idx = chunk->n_items;
+    }
+
+  /* Take out the items after @position, append the new ones and put
+   * the others back, starting new chunks whenever one is full */
+  n_tail = chunk->n_items - idx;
+  memcpy (tail, chunk->heights + idx, n_tail * sizeof (int));
+  chunk->n_items = idx;
+
+  for (i = 0; i < n_items + n_tail; i++)
+    {
+      if (chunk->n_items == CHUNK_SIZE)
+        {
+          height_node_update (self->chunks, chunk);
+          chunk = gtk_rb_tree_insert_after (self->chunks, chunk);
+        }
+
+      if (i < n_items)
+        {
+          int height = self->func (position + i, self->user_data);
+          chunk->heights[chunk->n_items++] = MAX (0, height);
+        }
+      else
+        chunk->heights[chunk->n_items++] = tail[i - n_items];
+    }
+
+  height_node_update (self->chunks, chunk);
+}
+
+static void
+gtk_list_height_index_remove (GtkListHeightIndex *self,
+                              guint               position,
+                              guint               n_items)
+{
+  while (n_items > 0)
+    {
+      HeightNode *chunk;
+      guint start, idx, n;
+
+      chunk = gtk_list_height_index_get_nth (self, position, &start);
+      g_return_if_fail (chunk != NULL);
+
+      idx = position - start;
+      n = MIN (n_items, chunk->n_items - idx);
+      memmove (chunk->heights + idx,
+               chunk->heights + idx + n,
+               (chunk->n_items - idx - n) * sizeof (int));
+      chunk->n_items -= n;
+      height_node_update (self->chunks, chunk);
+
+      n_items -= n;
+    }
+}
+
+GtkListHeightIndex *
+gtk_list_height_index_new (guint                  n_items,
+                           GtkListHeightIndexFunc func,
+                           gpointer               user_data)
+{
+  GtkListHeightIndex *self;
+
+  self = g_new0 (GtkListHeightIndex, 1);
+  self->chunks = gtk_rb_tree_new (HeightNode,
+                                  HeightAugment,
+                                  height_node_augment,
+                                  NULL, NULL);
+  self->func = func;
+  self->user_data = user_data;
+
+  gtk_list_height_index_insert (self, 0, n_items);
+
+  return self;
+}
+
+void
+gtk_list_height_index_free (GtkListHeightIndex *self)
+{
+  gtk_rb_tree_unref (self->chunks);
+  g_free (self);
+}
+
+guint
+gtk_list_height_index_get_n_items (GtkListHeightIndex *self)
+{
+  HeightNode *root = gtk_rb_tree_get_root (self->chunks);
+  HeightAugment *aug;
+
+  if (root == NULL)
+    return 0;
+
+  aug = gtk_rb_tree_get_augment (self->chunks, root);
+
+  return aug->n_items;
+}
+
+/* Updates the index after the model emitted items-changed. Only the
+ * added items get estimated, the others keep their heights.
+ */
+void
+gtk_list_height_index_splice (GtkListHeightIndex *self,
+                              guint               position,
+                              guint               removed,
+                              guint               added)
+{
+  gtk_list_height_index_remove (self, position, removed);
+  gtk_list_height_index_insert (self, position, added);
+}
+
+static gint64
+gtk_list_height_index_get_prefix (GtkListHeightIndex *self,
+                                  guint               position)
+{
+  HeightNode *node, *tmp;
+  gint64 result = 0;
+  guint i;
+
+  node = gtk_rb_tree_get_root (self->chunks);
+
+  while (node)
+    {
+      tmp = gtk_rb_tree_node_get_left (node);
+      if (tmp)
+        {
+          HeightAugment *aug = gtk_rb_tree_get_augment (self->chunks, tmp);
+          if (position < aug->n_items)
+            {
+              node = tmp;
+              continue;
+            }
+          position -= aug->n_items;
+          result += aug->height;
+        }
+
+      if (position < node->n_items)
+        {
+          for (i = 0; i < position; i++)
+            result += node->heights[i];
+          break;
+        }
+      position -= node->n_items;
+      result += node->height;
+
+      node = gtk_rb_tree_node_get_right (node);
+    }
+
+  return result;
+}
+
+/* Returns the summed heights of items [position, position + n_items),
+ * without any spacing between them.
+ */
+gint64
+gtk_list_height_index_get_range (GtkListHeightIndex *self,
+                                 guint               position,
+                                 guint               n_items)
+{
+  if (n_items == 0)
+    return 0;
+
+  return gtk_list_height_index_get_prefix (self, position + n_items)
+         - gtk_list_height_index_get_prefix (self, position);
+}
+
+/* Returns the position of the item containing @offset when every
+ * item is followed by @spacing pixels. Offsets past the end return
+ * the last item.
+ */
+guint
+gtk_list_height_index_find (GtkListHeightIndex *self,
+                            gint64              offset,
+                            int                 spacing)
+{
+  HeightNode *node, *tmp;
+  guint pos, n_items, i;
+
+  n_items = gtk_list_height_index_get_n_items (self);
+  if (n_items == 0 || offset <= 0)
+    return 0;
+
+  pos = 0;
+  node = gtk_rb_tree_get_root (self->chunks);
+
+  while (node)
+    {
+      tmp = gtk_rb_tree_node_get_left (node);
+      if (tmp)
+        {
+          HeightAugment *aug = gtk_rb_tree_get_augment (self->chunks, tmp);
+          gint64 size = aug->height + (gint64) aug->n_items * spacing;
+
+          if (offset < size)
+            {
+              node = tmp;
+              continue;
+            }
+          offset -= size;
+          pos += aug->n_items;
+        }
+
+      for (i = 0; i < node->n_items; i++)
+        {
+          gint64 size = node->heights[i] + spacing;
+
+          if (offset < size)
+            return pos + i;
+          offset -= size;
+        }
+      pos += node->n_items;
+
+      node = gtk_rb_tree_node_get_right (node);
+    }
+
+  return n_items - 1;
+}
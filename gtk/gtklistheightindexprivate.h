@@ -0,0 +1,46 @@
+/*
+ * Copyright © 2025 GTK Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GtkListHeightIndex GtkListHeightIndex;
+
+typedef int (* GtkListHeightIndexFunc) (guint    position,
+                                        gpointer user_data);
+
+GtkListHeightIndex *    gtk_list_height_index_new               (guint                   n_items,
+                                                                 GtkListHeightIndexFunc  func,
+                                                                 gpointer                user_data);
+void                    gtk_list_height_index_free              (GtkListHeightIndex     *self);
+
+guint                   gtk_list_height_index_get_n_items       (GtkListHeightIndex     *self);
+void                    gtk_list_height_index_splice            (GtkListHeightIndex     *self,
+                                                                 guint                   position,
+                                                                 guint                   removed,
+                                                                 guint                   added);
+gint64                  gtk_list_height_index_get_range         (GtkListHeightIndex     *self,
+                                                                 guint                   position,
+                                                                 guint                   n_items);
+guint                   gtk_list_height_index_find              (GtkListHeightIndex     *self,
+                                                                 gint64                  offset,
+                                                                 int                     spacing);
+
+G_END_DECLS
@@ -43,6 +43,12 @@ struct _GtkListItemManager
   GtkListItemBase * (* create_widget) (GtkWidget *);
   void (* prepare_section) (GtkWidget *, GtkListTile *, guint);
   GtkListHeaderBase * (* create_header_widget) (GtkWidget *);
+
+  /* unparented item widgets that are kept around for reuse, see
+   * gtk_list_item_manager_set_pool_size()
+   */
+  GQueue pool;
+  guint pool_size;
 };
 
 struct _GtkListItemManagerClass
@@ -76,14 +82,43 @@ gtk_list_item_change_init (GtkListItemChange *change)
 }
 
 static void
-gtk_list_item_change_finish (GtkListItemChange *change)
+gtk_list_item_manager_release_widget (GtkListItemManager *self,
+                                      GtkWidget          *widget)
+{
+  if (self->pool.length >= self->pool_size)
+    {
+      gtk_widget_unparent (widget);
+      return;
+    }
+
+  /* Unbind, but keep the setup, which is the expensive part */
+  g_object_ref (widget);
+  gtk_list_item_base_update (GTK_LIST_ITEM_BASE (widget), GTK_INVALID_LIST_POSITION, NULL, FALSE);
+  gtk_widget_unparent (widget);
+  g_queue_push_tail (&self->pool, widget);
+}
+
+static void
+gtk_list_item_change_finish (GtkListItemManager *self,
+                             GtkListItemChange  *change)
 {
   GtkWidget *widget;
 
-  g_clear_pointer (&change->deleted_items, g_hash_table_destroy);
+  if (change->deleted_items)
+    {
+      GHashTableIter iter;
+
+      g_hash_table_iter_init (&iter, change->deleted_items);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &widget))
+        {
+          g_hash_table_iter_steal (&iter);
+          gtk_list_item_manager_release_widget (self, widget);
+        }
+      g_clear_pointer (&change->deleted_items, g_hash_table_destroy);
+    }
 
   while ((widget = g_queue_pop_head (&change->recycled_items)))
-    gtk_widget_unparent (widget);
+    gtk_list_item_manager_release_widget (self, widget);
   while ((widget = g_queue_pop_head (&change->recycled_headers)))
     gtk_widget_unparent (widget);
 }
@@ -111,13 +146,20 @@ static void
 gtk_list_item_change_release (GtkListItemChange *change,
                               GtkListItemBase   *widget)
 {
+  gpointer item = gtk_list_item_base_get_item (widget);
+  GtkWidget *old;
+
   if (change->deleted_items == NULL)
-    change->deleted_items = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) gtk_widget_unparent);
+    change->deleted_items = g_hash_table_new (g_direct_hash, g_direct_equal);
 
-  if (!g_hash_table_replace (change->deleted_items, gtk_list_item_base_get_item (GTK_LIST_ITEM_BASE (widget)), widget))
+  old = g_hash_table_lookup (change->deleted_items, item);
+  if (old)
     {
       g_warning ("Duplicate item detected in list. Picking one randomly.");
+      gtk_widget_unparent (old);
     }
+
+  g_hash_table_replace (change->deleted_items, item, widget);
 }
 
 static GtkListItemBase *
@@ -1369,7 +1411,13 @@ gtk_list_item_manager_ensure_items (GtkListItemManager *self,
               if (tile->widget == NULL)
                 {
                   gpointer item = g_list_model_get_item (G_LIST_MODEL (self->model), position + i);
+                  gboolean pooled = FALSE;
                   tile->widget = GTK_WIDGET (gtk_list_item_change_get (change, item));
+                  if (tile->widget == NULL)
+                    {
+                      tile->widget = g_queue_pop_head (&self->pool);
+                      pooled = tile->widget != NULL;
+                    }
                   if (tile->widget == NULL)
                     tile->widget = GTK_WIDGET (self->create_widget (self->widget));
                   gtk_list_item_base_update (GTK_LIST_ITEM_BASE (tile->widget),
@@ -1378,6 +1426,9 @@ gtk_list_item_manager_ensure_items (GtkListItemManager *self,
                                              gtk_selection_model_is_selected (self->model, position + i));
                   g_object_unref (item);
                   gtk_widget_insert_after (tile->widget, self->widget, insert_after);
+                  /* the parent holds a reference now */
+                  if (pooled)
+                    g_object_unref (tile->widget);
                 }
               else
                 {
@@ -1600,7 +1651,7 @@ gtk_list_item_manager_model_items_changed_cb (GListModel         *model,
       tracker->widget = GTK_LIST_ITEM_BASE (tile->widget);
     }
 
-  gtk_list_item_change_finish (&change);
+  gtk_list_item_change_finish (self, &change);
 
   gtk_widget_queue_resize (self->widget);
 }
@@ -1661,7 +1712,7 @@ gtk_list_item_manager_model_sections_changed_cb (GListModel         *model,
 
   gtk_list_item_manager_ensure_items (self, &change, G_MAXUINT, 0);
 
-  gtk_list_item_change_finish (&change);
+  gtk_list_item_change_finish (self, &change);
 
   gtk_widget_queue_resize (GTK_WIDGET (self->widget));
 }
@@ -1713,7 +1764,7 @@ gtk_list_item_manager_clear_model (GtkListItemManager *self)
 
   gtk_list_item_change_init (&change);
   gtk_list_item_manager_remove_items (self, &change, 0, g_list_model_get_n_items (G_LIST_MODEL (self->model)));
-  gtk_list_item_change_finish (&change);
+  gtk_list_item_change_finish (self, &change);
   for (l = self->trackers; l; l = l->next)
     {
       gtk_list_item_tracker_unset_position (self, l->data);
@@ -1741,6 +1792,7 @@ gtk_list_item_manager_dispose (GObject *object)
   GtkListItemManager *self = GTK_LIST_ITEM_MANAGER (object);
 
   gtk_list_item_manager_clear_model (self);
+  gtk_list_item_manager_clear_pool (self);
 
   g_clear_pointer (&self->items, gtk_rb_tree_unref);
 
@@ -1795,10 +1847,56 @@ gtk_list_item_manager_set_model (GtkListItemManager *self,
       gtk_list_item_change_init (&change);
       gtk_list_item_manager_add_items (self, &change, 0, g_list_model_get_n_items (G_LIST_MODEL (model)));
       gtk_list_item_manager_ensure_items (self, &change, G_MAXUINT, 0);
-      gtk_list_item_change_finish (&change);
+      gtk_list_item_change_finish (self, &change);
     }
 }
 
+/*
+ * gtk_list_item_manager_set_pool_size:
+ * @self: a `GtkListItemManager`
+ * @pool_size: the maximum number of widgets to keep
+ *
+ * Sets how many item widgets that are no longer needed are kept
+ * around for reuse instead of being destroyed.
+ *
+ * Pooled widgets are unbound but stay set up, so reusing them
+ * avoids creating widgets and running the factory's setup when
+ * a view gets repopulated, like when its model is replaced.
+ *
+ * Users must call gtk_list_item_manager_clear_pool() whenever
+ * the widgets created by their create_widget function would
+ * differ from existing ones, like when the factory changes.
+ *
+ * The default is 0, which disables the pool.
+ */
+void
+gtk_list_item_manager_set_pool_size (GtkListItemManager *self,
+                                     guint               pool_size)
+{
+  GtkWidget *widget;
+
+  g_return_if_fail (GTK_IS_LIST_ITEM_MANAGER (self));
+
+  self->pool_size = pool_size;
+
+  while (self->pool.length > pool_size)
+    {
+      widget = g_queue_pop_tail (&self->pool);
+      g_object_unref (widget);
+    }
+}
+
+void
+gtk_list_item_manager_clear_pool (GtkListItemManager *self)
+{
+  GtkWidget *widget;
+
+  g_return_if_fail (GTK_IS_LIST_ITEM_MANAGER (self));
+
+  while ((widget = g_queue_pop_head (&self->pool)))
+    g_object_unref (widget);
+}
+
 GtkSelectionModel *
 gtk_list_item_manager_get_model (GtkListItemManager *self)
 {
@@ -1864,7 +1962,7 @@ gtk_list_item_manager_set_has_sections (GtkListItemManager *self,
     }
 
   gtk_list_item_manager_ensure_items (self, &change, G_MAXUINT, 0);
-  gtk_list_item_change_finish (&change);
+  gtk_list_item_change_finish (self, &change);
 
   gtk_widget_queue_resize (self->widget);
 }
@@ -1905,7 +2003,7 @@ gtk_list_item_tracker_free (GtkListItemManager *self,
 
   gtk_list_item_change_init (&change);
   gtk_list_item_manager_ensure_items (self, &change, G_MAXUINT, 0);
-  gtk_list_item_change_finish (&change);
+  gtk_list_item_change_finish (self, &change);
 
   gtk_widget_queue_resize (self->widget);
 }
@@ -1936,7 +2034,7 @@ gtk_list_item_tracker_set_position (GtkListItemManager *self,
 
   gtk_list_item_change_init (&change);
   gtk_list_item_manager_ensure_items (self, &change, G_MAXUINT, 0);
-  gtk_list_item_change_finish (&change);
+  gtk_list_item_change_finish (self, &change);
 
   tile = gtk_list_item_manager_get_nth (self, position, NULL);
   if (tile)
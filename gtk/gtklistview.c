@@ -39,6 +39,11 @@
 /* Extra items to keep above + below every tracker */
 #define GTK_LIST_VIEW_EXTRA_ITEMS 2
 
+/* Maximum number of unused list items kept for reuse,
+ * enough to repopulate a full view after a model change.
+ */
+#define GTK_LIST_VIEW_POOL_SIZE GTK_LIST_VIEW_MAX_LIST_ITEMS
+
 /**
  * GtkListView:
  *
@@ -172,30 +177,134 @@ G_DEFINE_TYPE (GtkListView, gtk_list_view, GTK_TYPE_LIST_BASE)
 static GParamSpec *properties[N_PROPS] = { NULL, };
 static guint signals[LAST_SIGNAL] = { 0 };
 
+static GtkListHeightIndex *
+gtk_list_view_get_height_index (GtkListView *self)
+{
+  guint n_items;
+
+  if (self->estimate_func == NULL)
+    return NULL;
+
+  n_items = gtk_list_base_get_n_items (GTK_LIST_BASE (self));
+  if (self->height_index &&
+      gtk_list_height_index_get_n_items (self->height_index) != n_items)
+    g_clear_pointer (&self->height_index, gtk_list_height_index_free);
+
+  if (self->height_index == NULL)
+    self->height_index = gtk_list_height_index_new (n_items,
+                                                    self->estimate_func,
+                                                    self->estimate_data);
+
+  return self->height_index;
+}
+
+static void
+gtk_list_view_height_index_items_changed_cb (GListModel  *model,
+                                             guint        position,
+                                             guint        removed,
+                                             guint        added,
+                                             GtkListView *self)
+{
+  guint n_items;
+
+  if (self->height_index == NULL)
+    return;
+
+  /* Other handlers may have rebuilt the index for the new items already */
+  n_items = g_list_model_get_n_items (model);
+  if (gtk_list_height_index_get_n_items (self->height_index) == n_items - added + removed)
+    gtk_list_height_index_splice (self->height_index, position, removed, added);
+  else if (gtk_list_height_index_get_n_items (self->height_index) != n_items)
+    g_clear_pointer (&self->height_index, gtk_list_height_index_free);
+}
+
+static void
+gtk_list_view_set_height_index_model (GtkListView *self,
+                                      GListModel  *model)
+{
+  if (self->height_index_model)
+    {
+      g_signal_handlers_disconnect_by_func (self->height_index_model,
+                                            gtk_list_view_height_index_items_changed_cb,
+                                            self);
+      g_clear_object (&self->height_index_model);
+    }
+
+  g_clear_pointer (&self->height_index, gtk_list_height_index_free);
+
+  if (model)
+    {
+      self->height_index_model = g_object_ref (model);
+      g_signal_connect (model,
+                        "items-changed",
+                        G_CALLBACK (gtk_list_view_height_index_items_changed_cb),
+                        self);
+    }
+}
+
+/* Estimated height of @n_items unrealized rows starting at @position,
+ * including the spacing between them.
+ */
+static int
+gtk_list_view_get_estimated_height (GtkListView        *self,
+                                    GtkListHeightIndex *index,
+                                    guint               position,
+                                    guint               n_items,
+                                    int                 spacing)
+{
+  gint64 height;
+
+  if (n_items == 0)
+    return 0;
+
+  height = gtk_list_height_index_get_range (index, position, n_items)
+           + (gint64) spacing * (n_items - 1);
+
+  /* Widget sizes are ints */
+  return MIN (height, G_MAXINT);
+}
+
 static GtkListTile *
 gtk_list_view_split (GtkListBase *base,
                      GtkListTile *tile,
                      guint        n_items)
 {
   GtkListView *self = GTK_LIST_VIEW (base);
+  GtkListHeightIndex *index;
   GtkListTile *new_tile;
-  int spacing, row_height;
+  int spacing, row_height, first_height, second_height;
 
   gtk_list_base_get_border_spacing (GTK_LIST_BASE (self), NULL, &spacing);
-  row_height = (tile->area.height - (tile->n_items - 1) * spacing) / tile->n_items;
+  index = gtk_list_view_get_height_index (self);
+  if (index)
+    {
+      guint pos = gtk_list_tile_get_position (self->item_manager, tile);
+
+      first_height = gtk_list_view_get_estimated_height (self, index, pos, n_items, spacing);
+      second_height = gtk_list_view_get_estimated_height (self, index,
+                                                          pos + n_items,
+                                                          tile->n_items - n_items,
+                                                          spacing);
+    }
+  else
+    {
+      row_height = (tile->area.height - (tile->n_items - 1) * spacing) / tile->n_items;
+      first_height = row_height * n_items + spacing * ((int) n_items - 1);
+      second_height = row_height * (tile->n_items - n_items) + spacing * ((int) (tile->n_items - n_items) - 1);
+    }
 
   new_tile = gtk_list_tile_split (self->item_manager, tile, n_items);
   gtk_list_tile_set_area_size (self->item_manager,
                                tile,
                                tile->area.width,
-                               row_height * tile->n_items + spacing * (tile->n_items - 1));
+                               first_height);
   gtk_list_tile_set_area (self->item_manager,
                           new_tile,
                           &(GdkRectangle) {
                             tile->area.x,
                             tile->area.y + tile->area.height + spacing,
                             tile->area.width,
-                            row_height * new_tile->n_items + spacing * (new_tile->n_items - 1)
+                            second_height
                           });
 
   return new_tile;
@@ -225,6 +334,9 @@ gtk_list_view_update_factories_with (GtkListView        *self,
 {
   GtkListTile *tile;
 
+  /* pooled widgets were created for the old factory */
+  gtk_list_item_manager_clear_pool (self->item_manager);
+
   for (tile = gtk_list_item_manager_get_first (self->item_manager);
        tile != NULL;
        tile = gtk_rb_tree_node_get_next (tile))
@@ -317,10 +429,24 @@ gtk_list_view_get_allocation (GtkListBase  *base,
   *area = tile->area;
   if (area->width || area->height)
     {
-      if (tile->n_items)
-        area->height /= tile->n_items;
-      if (offset)
-        area->y += offset * area->height;
+      GtkListHeightIndex *index = gtk_list_view_get_height_index (self);
+
+      if (index && tile->n_items > 1)
+        {
+          int spacing;
+
+          gtk_list_base_get_border_spacing (GTK_LIST_BASE (self), NULL, &spacing);
+          area->y += gtk_list_height_index_get_range (index, pos - offset, offset)
+                     + offset * spacing;
+          area->height = gtk_list_height_index_get_range (index, pos, 1);
+        }
+      else
+        {
+          if (tile->n_items)
+            area->height /= tile->n_items;
+          if (offset)
+            area->y += offset * area->height;
+        }
     }
   else
     {
@@ -385,6 +511,7 @@ gtk_list_view_get_position_from_allocation (GtkListBase           *base,
                                             cairo_rectangle_int_t *area)
 {
   GtkListView *self = GTK_LIST_VIEW (base);
+  GtkListHeightIndex *index;
   GtkListTile *tile;
 
   tile = gtk_list_item_manager_get_nearest_tile (self->item_manager, x, y);
@@ -406,7 +533,33 @@ gtk_list_view_get_position_from_allocation (GtkListBase           *base,
   if (area)
     *area = tile->area;
 
-  if (tile->n_items > 1)
+  index = gtk_list_view_get_height_index (self);
+  if (tile->n_items > 1 && index)
+    {
+      gint64 tile_offset;
+      guint item_pos;
+      int spacing;
+
+      gtk_list_base_get_border_spacing (GTK_LIST_BASE (self), NULL, &spacing);
+      tile_offset = gtk_list_height_index_get_range (index, 0, *pos) + (gint64) *pos * spacing;
+      if (y >= tile->area.y + tile->area.height)
+        item_pos = *pos + tile->n_items - 1;
+      else
+        item_pos = gtk_list_height_index_find (index,
+                                               tile_offset + MAX (0, y - tile->area.y),
+                                               spacing);
+      item_pos = CLAMP (item_pos, *pos, *pos + tile->n_items - 1);
+
+      if (area)
+        {
+          area->y = tile->area.y
+                    + gtk_list_height_index_get_range (index, *pos, item_pos - *pos)
+                    + (item_pos - *pos) * spacing;
+          area->height = gtk_list_height_index_get_range (index, item_pos, 1);
+        }
+      *pos = item_pos;
+    }
+  else if (tile->n_items > 1)
     {
       int row_height, tile_pos, spacing;
 
@@ -531,7 +684,9 @@ gtk_list_view_measure_list (GtkWidget      *widget,
   GtkListTile *tile;
   int min, nat, child_min, child_nat, spacing;
   GArray *min_heights, *nat_heights;
-  guint n_unknown, n_items;
+  GtkListHeightIndex *index;
+  guint n_unknown, n_items, pos;
+  gint64 estimated;
 
   n_items = gtk_list_base_get_n_items (GTK_LIST_BASE (self));
   if (n_items == 0)
@@ -540,13 +695,16 @@ gtk_list_view_measure_list (GtkWidget      *widget,
 
   min_heights = g_array_new (FALSE, FALSE, sizeof (int));
   nat_heights = g_array_new (FALSE, FALSE, sizeof (int));
+  index = gtk_list_view_get_height_index (self);
   n_unknown = 0;
+  estimated = 0;
+  pos = 0;
   min = 0;
   nat = 0;
 
   for (tile = gtk_list_item_manager_get_first (self->item_manager);
        tile != NULL;
-       tile = gtk_rb_tree_node_get_next (tile))
+       pos += tile->n_items, tile = gtk_rb_tree_node_get_next (tile))
     {
       if (tile->widget)
         {
@@ -561,12 +719,18 @@ gtk_list_view_measure_list (GtkWidget      *widget,
           min += child_min;
           nat += child_nat;
         }
+      else if (index)
+        {
+          estimated += gtk_list_height_index_get_range (index, pos, tile->n_items);
+        }
       else
         {
           n_unknown += tile->n_items;
         }
     }
 
+  min = MIN (min + estimated, G_MAXINT);
+  nat = MIN (nat + estimated, G_MAXINT);
   if (n_unknown)
     {
       min += n_unknown * gtk_list_view_get_unknown_row_height (self, min_heights);
@@ -603,9 +767,11 @@ gtk_list_view_size_allocate (GtkWidget *widget,
                              int        baseline)
 {
   GtkListView *self = GTK_LIST_VIEW (widget);
+  GtkListHeightIndex *index;
   GtkListTile *tile;
   GArray *heights;
   int min, nat, row_height, y, list_width, spacing;
+  guint pos;
   GtkOrientation orientation, opposite_orientation;
   GtkScrollablePolicy scroll_policy, opposite_scroll_policy;
 
@@ -658,16 +824,30 @@ gtk_list_view_size_allocate (GtkWidget *widget,
     }
 
   /* step 3: determine height of unknown items and set the positions */
-  row_height = gtk_list_view_get_unknown_row_height (self, heights);
+  index = gtk_list_view_get_height_index (self);
+  if (index)
+    row_height = 0;
+  else
+    row_height = gtk_list_view_get_unknown_row_height (self, heights);
   g_array_free (heights, TRUE);
 
   y = 0;
+  pos = 0;
   for (tile = gtk_list_item_manager_get_first (self->item_manager);
        tile != NULL;
-       tile = gtk_rb_tree_node_get_next (tile))
+       pos += tile->n_items, tile = gtk_rb_tree_node_get_next (tile))
     {
       gtk_list_tile_set_area_position (self->item_manager, tile, 0, y);
-      if (tile->widget == NULL)
+      if (tile->widget == NULL && index)
+        {
+          gtk_list_tile_set_area_size (self->item_manager,
+                                       tile,
+                                       list_width,
+                                       gtk_list_view_get_estimated_height (self, index,
+                                                                           pos, tile->n_items,
+                                                                           spacing));
+        }
+      else if (tile->widget == NULL)
         {
           gtk_list_tile_set_area_size (self->item_manager,
                                        tile,
@@ -734,6 +914,13 @@ gtk_list_view_dispose (GObject *object)
 
   self->item_manager = NULL;
 
+  gtk_list_view_set_height_index_model (self, NULL);
+  if (self->estimate_destroy)
+    self->estimate_destroy (self->estimate_data);
+  self->estimate_func = NULL;
+  self->estimate_data = NULL;
+  self->estimate_destroy = NULL;
+
   g_clear_object (&self->factory);
   g_clear_object (&self->header_factory);
 
@@ -1004,6 +1191,7 @@ gtk_list_view_init (GtkListView *self)
   gtk_list_base_set_anchor_max_widgets (GTK_LIST_BASE (self),
                                         GTK_LIST_VIEW_MAX_LIST_ITEMS,
                                         GTK_LIST_VIEW_EXTRA_ITEMS);
+  gtk_list_item_manager_set_pool_size (self->item_manager, GTK_LIST_VIEW_POOL_SIZE);
 
   gtk_widget_add_css_class (GTK_WIDGET (self), "view");
 }
@@ -1078,9 +1266,15 @@ gtk_list_view_set_model (GtkListView       *self,
   g_return_if_fail (GTK_IS_LIST_VIEW (self));
   g_return_if_fail (model == NULL || GTK_IS_SELECTION_MODEL (model));
 
-  if (!gtk_list_base_set_model (GTK_LIST_BASE (self), model))
+  if (gtk_list_base_get_model (GTK_LIST_BASE (self)) == model)
     return;
 
+  /* Connect before the item manager, so the index is spliced
+   * before the item manager splits tiles and queries it */
+  gtk_list_view_set_height_index_model (self, G_LIST_MODEL (model));
+
+  gtk_list_base_set_model (GTK_LIST_BASE (self), model);
+
   gtk_accessible_update_property (GTK_ACCESSIBLE (self),
                                   GTK_ACCESSIBLE_PROPERTY_MULTI_SELECTABLE, GTK_IS_MULTI_SELECTION (model),
                                   -1);
@@ -1254,6 +1448,9 @@ gtk_list_view_set_single_click_activate (GtkListView *self,
 
   self->single_click_activate = single_click_activate;
 
+  /* pooled widgets would come back with the old value */
+  gtk_list_item_manager_clear_pool (self->item_manager);
+
   for (tile = gtk_list_item_manager_get_first (self->item_manager);
        tile != NULL;
        tile = gtk_rb_tree_node_get_next (tile))
@@ -1389,3 +1586,46 @@ gtk_list_view_scroll_to (GtkListView        *self,
   gtk_list_base_scroll_to (GTK_LIST_BASE (self), pos, flags, scroll);
 }
 
+/**
+ * gtk_list_view_set_height_estimate_func:
+ * @self: a `GtkListView`
+ * @func: (nullable) (scope notified) (closure user_data) (destroy destroy): function
+ *   to estimate row heights
+ * @user_data: user data for @func
+ * @destroy: destroy notifier for @user_data
+ *
+ * Sets a function to estimate the height of rows that have not been
+ * realized yet.
+ *
+ * By default, the listview assumes that all rows it hasn't created a
+ * widget for are as high as the median of the rows it has seen. For
+ * lists with very different row heights, this makes the scrollbar
+ * jump around and makes scrolling to far away items land in the
+ * wrong spot.
+ *
+ * With an estimate function, the listview keeps an index of the
+ * estimated heights so that it can compute the offset of any item in
+ * logarithmic time, without creating any rows. When the model changes,
+ * only the added items are estimated, the others keep their estimates.
+ * Call this function again if the estimates change for other reasons.
+ *
+ * Since: 4.18
+ */
+void
+gtk_list_view_set_height_estimate_func (GtkListView                   *self,
+                                        GtkListViewHeightEstimateFunc  func,
+                                        gpointer                       user_data,
+                                        GDestroyNotify                 destroy)
+{
+  g_return_if_fail (GTK_IS_LIST_VIEW (self));
+
+  if (self->estimate_destroy)
+    self->estimate_destroy (self->estimate_data);
+
+  self->estimate_func = func;
+  self->estimate_data = user_data;
+  self->estimate_destroy = destroy;
+  g_clear_pointer (&self->height_index, gtk_list_height_index_free);
+
+  gtk_widget_queue_resize (GTK_WIDGET (self));
+}
@@ -37,6 +37,21 @@ G_BEGIN_DECLS
 typedef struct _GtkListView GtkListView;
 typedef struct _GtkListViewClass GtkListViewClass;
 
+/**
+ * GtkListViewHeightEstimateFunc:
+ * @position: the position of the item
+ * @user_data: (closure): user data
+ *
+ * Estimates the height of the row for the item at @position
+ * before it has been realized.
+ *
+ * Returns: the estimated height in pixels
+ *
+ * Since: 4.18
+ */
+typedef int (* GtkListViewHeightEstimateFunc) (guint    position,
+                                               gpointer user_data);
+
 GDK_AVAILABLE_IN_ALL
 GType           gtk_list_view_get_type                          (void) G_GNUC_CONST;
 
@@ -95,6 +110,12 @@ void            gtk_list_view_scroll_to                         (GtkListView
                                                                  GtkListScrollFlags      flags,
                                                                  GtkScrollInfo          *scroll);
 
+GDK_AVAILABLE_IN_4_18
+void            gtk_list_view_set_height_estimate_func          (GtkListView            *self,
+                                                                 GtkListViewHeightEstimateFunc func,
+                                                                 gpointer                user_data,
+                                                                 GDestroyNotify          destroy);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GtkListView, g_object_unref)
 
 G_END_DECLS
@@ -21,6 +21,7 @@
 
 #include <gtk/gtklistview.h>
 #include <gtk/gtklistbaseprivate.h>
+#include <gtk/gtklistheightindexprivate.h>
 
 G_BEGIN_DECLS
 
@@ -33,6 +34,12 @@ struct _GtkListView
   GtkListItemFactory *header_factory;
   gboolean show_separators;
   gboolean single_click_activate;
+
+  GtkListViewHeightEstimateFunc estimate_func;
+  gpointer estimate_data;
+  GDestroyNotify estimate_destroy;
+  GtkListHeightIndex *height_index;
+  GListModel *height_index_model;
 };
 
 struct _GtkListViewClass
@@ -6,6 +6,7 @@
 #include "gdksurfaceprivate.h"
 #include "gdksubsurfaceprivate.h"
 #include "gdkrgbaprivate.h"
+#include <gsk/gskoffloadprivate.h>
 
 struct _GtkSubsurfaceOverlay
 {
@@ -42,17 +43,24 @@ gtk_subsurface_overlay_snapshot (GtkInspectorOverlay *overlay,
       GdkSubsurface *subsurface = gdk_surface_get_subsurface (surface, i);
       graphene_rect_t rect;
       GdkRGBA color;
+      guint n_hits, n_misses;
+      PangoLayout *layout;
+      char *text;
+      int height;
 
-      if (gdk_subsurface_get_texture (subsurface) == NULL)
+      if (!gsk_offload_get_stats (subsurface, &n_hits, &n_misses, &rect))
         continue;
 
-      gdk_subsurface_get_texture_rect (subsurface, &rect);
-
-      if (gdk_subsurface_is_above_parent (subsurface))
+      if (gdk_subsurface_get_texture (subsurface) == NULL)
+        color = GDK_RGBA ("808080"); /* gray */
+      else if (gdk_subsurface_is_above_parent (subsurface))
         color = GDK_RGBA ("DAA520"); /* goldenrod */
       else
         color = GDK_RGBA ("FF00FF"); /* magenta */
 
+      if (gdk_subsurface_get_texture (subsurface) != NULL)
+        gdk_subsurface_get_texture_rect (subsurface, &rect);
+
       /* Use 4 color nodes since a border node overlaps and prevents
        * the subsurface from being raised.
        */
@@ -60,6 +68,19 @@ gtk_subsurface_overlay_snapshot (GtkInspectorOverlay *overlay,
       gtk_snapshot_append_color (snapshot, &color, &GRAPHENE_RECT_INIT (rect.origin.x - 2, rect.origin.y - 2, rect.size.width + 4, 2));
       gtk_snapshot_append_color (snapshot, &color, &GRAPHENE_RECT_INIT (rect.origin.x - 2, rect.origin.y + rect.size.height, rect.size.width + 4, 2));
       gtk_snapshot_append_color (snapshot, &color, &GRAPHENE_RECT_INIT (rect.origin.x + rect.size.width, rect.origin.y - 2, 2, rect.size.height + 4));
+
+      /* The counters go above the frame, for the same reason */
+      text = g_strdup_printf ("%u offloaded, %u composited", n_hits, n_misses);
+      layout = gtk_widget_create_pango_layout (widget, text);
+      pango_layout_get_pixel_size (layout, NULL, &height);
+
+      gtk_snapshot_save (snapshot);
+      gtk_snapshot_translate (snapshot, &GRAPHENE_POINT_INIT (rect.origin.x - 2, rect.origin.y - 2 - height));
+      gtk_snapshot_append_layout (snapshot, layout, &color);
+      gtk_snapshot_restore (snapshot);
+
+      g_object_unref (layout);
+      g_free (text);
     }
 
   gtk_snapshot_restore (snapshot);
@@ -0,0 +1,159 @@
+/* Measures how long a GtkDirectoryList takes to load a huge
+ * directory and how many times it emits ::items-changed while
+ * doing so.
+ *
+ * Run it as
+ *
+ *   testdirectorylist [--interval=MS] [--files=N] [DIRECTORY]
+ *
+ * Without a directory, a temporary one with N empty files is
+ * created (and removed again afterwards).
+ */
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+
+static int interval = 0;
+static int n_files = 500000;
+
+static GOptionEntry options[] = {
+  { "interval", 'i', 0, G_OPTION_ARG_INT, &interval, "Update interval in milliseconds (default: 0)", "MS" },
+  { "files", 'n', 0, G_OPTION_ARG_INT, &n_files, "Number of files to create (default: 500000)", "N" },
+  { NULL }
+};
+
+static gint64 start_time;
+static gint64 last_tick;
+static gint64 longest_stall;
+static guint n_changes;
+
+/* Runs every millisecond, so the gap between two ticks tells us
+ * how long the main loop was blocked
+ */
+static gboolean
+tick (gpointer data)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  longest_stall = MAX (longest_stall, now - last_tick);
+  last_tick = now;
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+items_changed (GListModel *model,
+               guint       position,
+               guint       removed,
+               guint       added,
+               gpointer    data)
+{
+  n_changes++;
+}
+
+static void
+loading_changed (GtkDirectoryList *list,
+                 GParamSpec       *pspec,
+                 gboolean         *done)
+{
+  if (!gtk_directory_list_is_loading (list))
+    *done = TRUE;
+}
+
+static char *
+create_directory (void)
+{
+  GError *error = NULL;
+  char *dir;
+  int i;
+
+  dir = g_dir_make_tmp ("testdirectorylist-XXXXXX", &error);
+  if (dir == NULL)
+    g_error ("Failed to create directory: %s", error->message);
+
+  for (i = 0; i < n_files; i++)
+    {
+      char *name = g_strdup_printf ("%s/file-%08d", dir, i);
+
+      if (!g_file_set_contents (name, "", 0, &error))
+        g_error ("Failed to create file: %s", error->message);
+      g_free (name);
+    }
+
+  return dir;
+}
+
+static void
+remove_directory (const char *dir)
+{
+  int i;
+
+  for (i = 0; i < n_files; i++)
+    {
+      char *name = g_strdup_printf ("%s/file-%08d", dir, i);
+      g_remove (name);
+      g_free (name);
+    }
+
+  g_rmdir (dir);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GtkDirectoryList *list;
+  GError *error = NULL;
+  gboolean done = FALSE;
+  char *dir;
+  GFile *file;
+
+  context = g_option_context_new ("[DIRECTORY]");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+  g_option_context_free (context);
+
+  gtk_init ();
+
+  if (argc > 1)
+    dir = g_strdup (argv[1]);
+  else
+    dir = create_directory ();
+
+  list = gtk_directory_list_new (G_FILE_ATTRIBUTE_STANDARD_TYPE "," G_FILE_ATTRIBUTE_STANDARD_SIZE, NULL);
+  gtk_directory_list_set_monitored (list, FALSE);
+  gtk_directory_list_set_update_interval (list, interval);
+  g_signal_connect (list, "items-changed", G_CALLBACK (items_changed), NULL);
+  g_signal_connect (list, "notify::loading", G_CALLBACK (loading_changed), &done);
+
+  file = g_file_new_for_path (dir);
+  start_time = last_tick = g_get_monotonic_time ();
+  g_timeout_add (1, tick, NULL);
+  gtk_directory_list_set_file (list, file);
+
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_print ("loaded %u files in %.2f ms with interval %d ms\n",
+           g_list_model_get_n_items (G_LIST_MODEL (list)),
+           (g_get_monotonic_time () - start_time) / 1000.,
+           interval);
+  g_print ("%u items-changed emissions, main loop blocked for up to %.2f ms\n",
+           n_changes, longest_stall / 1000.);
+
+  if (gtk_directory_list_get_error (list))
+    g_print ("error: %s\n", gtk_directory_list_get_error (list)->message);
+
+  g_object_unref (list);
+  g_object_unref (file);
+
+  if (argc <= 1)
+    remove_directory (dir);
+  g_free (dir);
+
+  return 0;
+}
@@ -0,0 +1,180 @@
+/* Measures the time to the first frame of a GtkGridView full of
+ * different themed icons, with and without preloading the icons
+ * via gtk_icon_theme_preload_icons().
+ *
+ * Run it as
+ *
+ *   testiconpreload [--preload] [--size=SIZE] [--count=COUNT]
+ */
+
+#include <gtk/gtk.h>
+
+static gboolean preload = FALSE;
+static int icon_size = 48;
+static int n_icons = 0;
+
+static GOptionEntry options[] = {
+  { "preload", 'p', 0, G_OPTION_ARG_NONE, &preload, "Preload icons before showing the window", NULL },
+  { "size", 's', 0, G_OPTION_ARG_INT, &icon_size, "Icon size", "SIZE" },
+  { "count", 'c', 0, G_OPTION_ARG_INT, &n_icons, "Number of icons to show (default: all)", "COUNT" },
+  { NULL }
+};
+
+static gint64 start_time;
+static gboolean done;
+
+static void
+setup_item (GtkSignalListItemFactory *factory,
+            GtkListItem              *item)
+{
+  GtkWidget *image;
+
+  image = gtk_image_new ();
+  gtk_image_set_pixel_size (GTK_IMAGE (image), icon_size);
+  gtk_list_item_set_child (item, image);
+}
+
+static void
+bind_item (GtkSignalListItemFactory *factory,
+           GtkListItem              *item)
+{
+  GtkStringObject *name = gtk_list_item_get_item (item);
+  GtkWidget *image = gtk_list_item_get_child (item);
+
+  gtk_image_set_from_icon_name (GTK_IMAGE (image), gtk_string_object_get_string (name));
+}
+
+static void
+after_paint (GdkFrameClock *clock,
+             gpointer       data)
+{
+  static gboolean first = TRUE;
+
+  if (!first)
+    return;
+
+  first = FALSE;
+  g_print ("first frame after %.2f ms%s\n",
+           (g_get_monotonic_time () - start_time) / 1000.,
+           preload ? " (preloaded)" : "");
+}
+
+static void
+quit_cb (GtkWidget *widget,
+         gpointer   data)
+{
+  done = TRUE;
+  g_main_context_wakeup (NULL);
+}
+
+static void
+window_mapped (GtkWidget *window)
+{
+  g_signal_connect (gtk_widget_get_frame_clock (window), "after-paint",
+                    G_CALLBACK (after_paint), NULL);
+}
+
+static void
+show_window (char **names)
+{
+  GtkWidget *window, *sw, *grid;
+  GtkListItemFactory *factory;
+  GtkStringList *list;
+
+  window = gtk_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 1024, 768);
+  g_signal_connect (window, "map", G_CALLBACK (window_mapped), NULL);
+  g_signal_connect (window, "destroy", G_CALLBACK (quit_cb), NULL);
+
+  sw = gtk_scrolled_window_new ();
+  gtk_window_set_child (GTK_WINDOW (window), sw);
+
+  factory = gtk_signal_list_item_factory_new ();
+  g_signal_connect (factory, "setup", G_CALLBACK (setup_item), NULL);
+  g_signal_connect (factory, "bind", G_CALLBACK (bind_item), NULL);
+
+  list = gtk_string_list_new ((const char * const *) names);
+  grid = gtk_grid_view_new (GTK_SELECTION_MODEL (gtk_no_selection_new (G_LIST_MODEL (list))), factory);
+  gtk_grid_view_set_max_columns (GTK_GRID_VIEW (grid), 100);
+  gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (sw), grid);
+
+  gtk_window_present (GTK_WINDOW (window));
+}
+
+static void
+preload_done (GObject      *source,
+              GAsyncResult *result,
+              gpointer      data)
+{
+  char **names = data;
+  GListModel *preloaded;
+  GError *error = NULL;
+
+  preloaded = gtk_icon_theme_preload_icons_finish (GTK_ICON_THEME (source), result, &error);
+  if (preloaded == NULL)
+    g_error ("Failed to preload icons: %s", error->message);
+
+  g_print ("preloaded %u icons after %.2f ms\n",
+           g_list_model_get_n_items (preloaded),
+           (g_get_monotonic_time () - start_time) / 1000.);
+
+  /* The icon theme keeps the icons loaded, we don't need the list */
+  g_object_unref (preloaded);
+
+  show_window (names);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GtkIconTheme *theme;
+  GdkMonitor *monitor;
+  int scale;
+  GError *error = NULL;
+  char **names;
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+  g_option_context_free (context);
+
+  gtk_init ();
+
+  theme = gtk_icon_theme_get_for_display (gdk_display_get_default ());
+  names = gtk_icon_theme_get_icon_names (theme);
+  if (n_icons > 0 && (guint) n_icons < g_strv_length (names))
+    {
+      for (int i = n_icons; names[i]; i++)
+        g_clear_pointer (&names[i], g_free);
+    }
+
+  g_print ("showing %u icons at size %d\n", g_strv_length (names), icon_size);
+
+  start_time = g_get_monotonic_time ();
+
+  /* Match the lookups that the GtkImages in the grid will do,
+   * assuming the window ends up on the first monitor
+   */
+  monitor = g_list_model_get_item (gdk_display_get_monitors (gdk_display_get_default ()), 0);
+  scale = monitor ? gdk_monitor_get_scale_factor (monitor) : 1;
+  g_clear_object (&monitor);
+
+  if (preload)
+    gtk_icon_theme_preload_icons (theme, (const char * const *) names,
+                                  icon_size, scale, gtk_widget_get_default_direction (), 0,
+                                  NULL, preload_done, names);
+  else
+    show_window (names);
+
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_strfreev (names);
+
+  return 0;
+}
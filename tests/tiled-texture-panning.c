@@ -0,0 +1,219 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+#include <gtk/gtk.h>
+#include <math.h>
+
+#include "frame-stats.h"
+
+/* Pans and zooms across a 100000x100000 GdkTiledTexture and reports
+ * how many tiles get loaded. The pixels are generated on demand, so
+ * this measures the renderer, not the disk.
+ */
+
+#define IMAGE_SIZE 100000
+#define N_LEVELS 8
+#define CHECKER_SIZE 512
+
+static int n_loads;
+
+static GdkTexture *
+load_tile (GdkTiledTexture    *texture,
+           guint               level,
+           const GdkRectangle *area,
+           gpointer            user_data)
+{
+  static const guchar colors[N_LEVELS][3] = {
+    { 0xe0, 0x1b, 0x24 }, { 0xff, 0x78, 0x00 }, { 0xf6, 0xd3, 0x2d }, { 0x33, 0xd1, 0x7a },
+    { 0x35, 0x84, 0xe4 }, { 0x91, 0x41, 0xac }, { 0x98, 0x6a, 0x44 }, { 0x77, 0x76, 0x7b },
+  };
+  GdkTexture *tile;
+  GBytes *bytes;
+  guchar *data;
+  gsize stride;
+  int x, y;
+
+  stride = area->width * 3;
+  data = g_malloc (stride * area->height);
+
+  /* A checkerboard in the color of the level, so it is visible
+   * which level got picked */
+  for (y = 0; y < area->height; y++)
+    {
+      guchar *row = data + y * stride;
+      gsize cy = (gsize) (area->y + y) << level;
+
+      for (x = 0; x < area->width; x++)
+        {
+          gsize cx = (gsize) (area->x + x) << level;
+          guchar shade = ((cx / CHECKER_SIZE) + (cy / CHECKER_SIZE)) % 2 ? 0xff : 0x80;
+
+          row[3 * x + 0] = colors[level][0] * shade / 0xff;
+          row[3 * x + 1] = colors[level][1] * shade / 0xff;
+          row[3 * x + 2] = colors[level][2] * shade / 0xff;
+        }
+    }
+
+  bytes = g_bytes_new_take (data, stride * area->height);
+  tile = gdk_memory_texture_new (area->width, area->height,
+                                 GDK_MEMORY_R8G8B8,
+                                 bytes,
+                                 stride);
+  g_bytes_unref (bytes);
+
+  g_atomic_int_inc (&n_loads);
+
+  return tile;
+}
+
+typedef struct
+{
+  GtkWidget parent_instance;
+
+  GdkTexture *texture;
+  double center_x;
+  double center_y;
+  double zoom;
+} TiledView;
+
+typedef GtkWidgetClass TiledViewClass;
+
+static GType tiled_view_get_type (void);
+G_DEFINE_TYPE (TiledView, tiled_view, GTK_TYPE_WIDGET)
+
+static void
+tiled_view_snapshot (GtkWidget   *widget,
+                     GtkSnapshot *snapshot)
+{
+  TiledView *self = (TiledView *) widget;
+  int width = gtk_widget_get_width (widget);
+  int height = gtk_widget_get_height (widget);
+
+  gtk_snapshot_push_clip (snapshot, &GRAPHENE_RECT_INIT (0, 0, width, height));
+  gtk_snapshot_translate (snapshot, &GRAPHENE_POINT_INIT (width / 2.0, height / 2.0));
+  gtk_snapshot_scale (snapshot, self->zoom, self->zoom);
+  gtk_snapshot_translate (snapshot, &GRAPHENE_POINT_INIT (- self->center_x, - self->center_y));
+  gtk_snapshot_append_texture (snapshot,
+                               self->texture,
+                               &GRAPHENE_RECT_INIT (0, 0, IMAGE_SIZE, IMAGE_SIZE));
+  gtk_snapshot_pop (snapshot);
+}
+
+static void
+tiled_view_dispose (GObject *object)
+{
+  TiledView *self = (TiledView *) object;
+
+  g_clear_object (&self->texture);
+
+  G_OBJECT_CLASS (tiled_view_parent_class)->dispose (object);
+}
+
+static void
+tiled_view_init (TiledView *self)
+{
+  self->texture = gdk_tiled_texture_new (IMAGE_SIZE, IMAGE_SIZE,
+                                         GDK_MEMORY_R8G8B8,
+                                         N_LEVELS,
+                                         load_tile,
+                                         NULL, NULL);
+  self->center_x = IMAGE_SIZE / 2.0;
+  self->center_y = IMAGE_SIZE / 2.0;
+  self->zoom = 1.0;
+}
+
+static void
+tiled_view_class_init (TiledViewClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  object_class->dispose = tiled_view_dispose;
+
+  widget_class->snapshot = tiled_view_snapshot;
+}
+
+static gboolean
+pan_view (GtkWidget     *widget,
+          GdkFrameClock *frame_clock,
+          gpointer       user_data)
+{
+  static gint64 start_time, report_time;
+  TiledView *self = (TiledView *) widget;
+  gint64 now = gdk_frame_clock_get_frame_time (frame_clock);
+  double elapsed;
+
+  if (start_time == 0)
+    start_time = report_time = now;
+
+  elapsed = (now - start_time) / 1000000.;
+
+  /* Zoom between 1:1 and 1:256 while moving across the whole image */
+  self->zoom = pow (2, -4 - 4 * cos (elapsed / 4));
+  self->center_x = IMAGE_SIZE * (0.5 + 0.45 * sin (elapsed / 3));
+  self->center_y = IMAGE_SIZE * (0.5 + 0.45 * sin (elapsed / 5));
+  gtk_widget_queue_draw (widget);
+
+  if (now - report_time >= G_USEC_PER_SEC)
+    {
+      g_print ("zoom 1:%-4.0f %4u tiles loaded\n",
+               1 / self->zoom,
+               g_atomic_int_and (&n_loads, 0));
+      report_time = now;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static GOptionEntry options[] = {
+  { NULL }
+};
+
+static void
+quit_cb (GtkWidget *widget,
+         gpointer   data)
+{
+  gboolean *done = data;
+
+  *done = TRUE;
+
+  g_main_context_wakeup (NULL);
+}
+
+int
+main (int argc, char **argv)
+{
+  GtkWidget *window;
+  GtkWidget *view;
+  GError *error = NULL;
+  gboolean done = FALSE;
+
+  GOptionContext *context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, options, NULL);
+  frame_stats_add_options (g_option_context_get_main_group (context));
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+
+  gtk_init ();
+
+  window = gtk_window_new ();
+  frame_stats_ensure (GTK_WINDOW (window));
+  gtk_window_set_default_size (GTK_WINDOW (window), 800, 600);
+
+  view = g_object_new (tiled_view_get_type (), NULL);
+  gtk_window_set_child (GTK_WINDOW (window), view);
+
+  gtk_widget_add_tick_callback (view, pan_view, NULL, NULL);
+
+  gtk_window_present (GTK_WINDOW (window));
+  g_signal_connect (window, "destroy",
+                    G_CALLBACK (quit_cb), &done);
+
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  return 0;
+}
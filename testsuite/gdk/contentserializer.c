@@ -475,6 +475,9 @@ main (int argc, char *argv[])
   g_test_add_func ("/content/color", test_content_color);
   g_test_add_data_func ("/content/texture/png", "image/png", test_content_texture);
   g_test_add_data_func ("/content/texture/tiff", "image/tiff", test_content_texture);
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+  g_test_add_data_func ("/content/texture/raw", "application/x-gtk-texture", test_content_texture);
+#endif
   g_test_add_func ("/content/file", test_content_file);
   g_test_add_func ("/content/files", test_content_files);
   g_test_add_func ("/content/custom", test_custom_format);
@@ -56,12 +56,154 @@ test_dmabuf_no_gpu (void)
   g_object_unref (texture);
 }
 
+static GBytes *
+download_rgb (GdkTexture *texture,
+              gsize      *stride)
+{
+  GdkTextureDownloader *downloader;
+  GBytes *bytes;
+
+  downloader = gdk_texture_downloader_new (texture);
+  gdk_texture_downloader_set_format (downloader, GDK_MEMORY_R8G8B8);
+  gdk_texture_downloader_set_color_state (downloader, gdk_texture_get_color_state (texture));
+
+  bytes = gdk_texture_downloader_download_bytes (downloader, stride);
+
+  gdk_texture_downloader_free (downloader);
+
+  return bytes;
+}
+
+static void
+test_dmabuf_nv12 (void)
+{
+  /* 4x2 luma plane, followed by a 2x1 interleaved chroma plane */
+  const guchar buffer[] = {
+     16, 235,  81,  81,
+    145, 235,  81,  81,
+    128, 128,  90, 240,
+  };
+  const guchar expected[] = {
+      0,   0,   0,  255, 255, 255,  255,   0,   0,  255,   0,   0,
+    150, 150, 150,  255, 255, 255,  255,   0,   0,  255,   0,   0,
+  };
+  GdkTexture *texture;
+  GError *error = NULL;
+  gsize stride, x, y;
+  GBytes *bytes;
+  const guchar *data;
+
+  if (!udmabuf_initialize (&error))
+    {
+      g_test_fail_printf ("%s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  bytes = g_bytes_new_static (buffer, sizeof (buffer));
+  texture = udmabuf_texture_new_planes (4, 2,
+                                        DRM_FORMAT_NV12,
+                                        gdk_color_state_get_srgb (),
+                                        FALSE,
+                                        bytes,
+                                        2,
+                                        (gsize[2]) { 4, 4 },
+                                        (gsize[2]) { 0, 8 },
+                                        &error);
+  g_assert_no_error (error);
+  g_bytes_unref (bytes);
+
+  bytes = download_rgb (texture, &stride);
+  data = g_bytes_get_data (bytes, NULL);
+
+  for (y = 0; y < 2; y++)
+    for (x = 0; x < 4 * 3; x++)
+      g_assert_cmpint (ABS ((int) data[y * stride + x] - (int) expected[y * 4 * 3 + x]), <=, 2);
+
+  g_bytes_unref (bytes);
+  g_object_unref (texture);
+}
+
+static void
+benchmark_yuv_download (guint32     fourcc,
+                        const char *name,
+                        gsize       bpp)
+{
+  const gsize width = 3840, height = 2160;
+  const guint N = 20;
+  GdkTexture *texture;
+  GError *error = NULL;
+  GBytes *bytes;
+  guchar *data;
+  gsize stride, size, i;
+  gint64 start, end;
+
+  stride = width * bpp;
+  size = stride * height + stride * height / 2;
+  data = g_malloc (size);
+  for (i = 0; i < size; i++)
+    data[i] = g_test_rand_int_range (0, 256);
+
+  bytes = g_bytes_new_take (data, size);
+  texture = udmabuf_texture_new_planes (width, height,
+                                        fourcc,
+                                        gdk_color_state_get_srgb (),
+                                        FALSE,
+                                        bytes,
+                                        2,
+                                        (gsize[2]) { stride, stride },
+                                        (gsize[2]) { 0, stride * height },
+                                        &error);
+  g_assert_no_error (error);
+  g_bytes_unref (bytes);
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < N; i++)
+    {
+      GdkTextureDownloader *downloader;
+
+      downloader = gdk_texture_downloader_new (texture);
+      gdk_texture_downloader_set_format (downloader, gdk_texture_get_format (texture));
+      gdk_texture_downloader_set_color_state (downloader, gdk_texture_get_color_state (texture));
+      bytes = gdk_texture_downloader_download_bytes (downloader, &stride);
+      gdk_texture_downloader_free (downloader);
+      g_bytes_unref (bytes);
+    }
+  end = g_get_monotonic_time ();
+
+  g_test_minimized_result ((double) (end - start) / N / G_USEC_PER_SEC,
+                           "%s %" G_GSIZE_FORMAT "x%" G_GSIZE_FORMAT " download: %.2f ms",
+                           name, width, height,
+                           (double) (end - start) / N / 1000);
+
+  g_object_unref (texture);
+}
+
+static void
+test_dmabuf_yuv_benchmark (void)
+{
+  GError *error = NULL;
+
+  if (!udmabuf_initialize (&error))
+    {
+      g_test_fail_printf ("%s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  benchmark_yuv_download (DRM_FORMAT_NV12, "NV12", 1);
+  benchmark_yuv_download (DRM_FORMAT_P010, "P010", 2);
+}
+
 int
 main (int argc, char *argv[])
 {
   gtk_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/dmabuf/no-gpu", test_dmabuf_no_gpu);
+  g_test_add_func ("/dmabuf/nv12", test_dmabuf_nv12);
+  if (g_test_perf ())
+    g_test_add_func ("/dmabuf/yuv-benchmark", test_dmabuf_yuv_benchmark);
 
   return g_test_run ();
 }
@@ -0,0 +1,260 @@
+#include <gtk/gtk.h>
+#include "gdk/gdkdisplayprivate.h"
+#include "gdk/gdkeventsprivate.h"
+#include "gdk/gdksurfaceprivate.h"
+
+static GdkDevice *
+get_pointer (void)
+{
+  return gdk_seat_get_pointer (gdk_display_get_default_seat (gdk_display_get_default ()));
+}
+
+static void
+queue_event (GdkEvent *event)
+{
+  _gdk_event_queue_append (gdk_event_get_display (event), event);
+}
+
+static void
+clear_queue (GdkDisplay *display,
+             guint       n_before)
+{
+  while (g_queue_get_length (&display->queued_events) > n_before)
+    gdk_event_unref (g_queue_pop_tail (&display->queued_events));
+}
+
+static void
+test_compression_motion (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkSurface *surface;
+  GdkTimeCoord *history;
+  GdkEvent *event;
+  guint n_before, n_history, i;
+
+  surface = gdk_surface_new_toplevel (display);
+  n_before = g_queue_get_length (&display->queued_events);
+
+  /* no button is held, we still want every sample */
+  for (i = 0; i < 5; i++)
+    {
+      queue_event (gdk_motion_event_new (surface, get_pointer (), NULL, 100 + i, 0, i, 2 * i, NULL));
+      _gdk_event_queue_handle_motion_compression (display);
+    }
+
+  g_assert_cmpuint (g_queue_get_length (&display->queued_events), ==, n_before + 1);
+
+  event = g_queue_peek_tail (&display->queued_events);
+  g_assert_cmpuint (gdk_event_get_time (event), ==, 104);
+
+  history = gdk_event_get_history (event, &n_history);
+  g_assert_cmpuint (n_history, ==, 4);
+  for (i = 0; i < n_history; i++)
+    {
+      g_assert_cmpuint (history[i].time, ==, 100 + i);
+      g_assert_cmpfloat (history[i].axes[GDK_AXIS_X], ==, i);
+      g_assert_cmpfloat (history[i].axes[GDK_AXIS_Y], ==, 2 * i);
+    }
+  g_free (history);
+
+  clear_queue (display, n_before);
+  gdk_surface_destroy (surface);
+}
+
+static void
+test_compression_touch (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkEventSequence *seq1 = GUINT_TO_POINTER (1);
+  GdkEventSequence *seq2 = GUINT_TO_POINTER (2);
+  GdkSurface *surface;
+  GdkTimeCoord *history;
+  GList *l;
+  guint n_before, n_history, i;
+
+  surface = gdk_surface_new_toplevel (display);
+  n_before = g_queue_get_length (&display->queued_events);
+
+  /* two interleaved touch sequences */
+  for (i = 0; i < 6; i++)
+    {
+      queue_event (gdk_touch_event_new (GDK_TOUCH_UPDATE, i % 2 ? seq2 : seq1,
+                                        surface, get_pointer (), 200 + i, 0,
+                                        i, i, NULL, FALSE));
+      gdk_event_queue_handle_touch_compression (display);
+    }
+
+  g_assert_cmpuint (g_queue_get_length (&display->queued_events), ==, n_before + 2);
+
+  for (l = g_queue_peek_nth_link (&display->queued_events, n_before), i = 0; l; l = l->next, i++)
+    {
+      GdkEvent *event = l->data;
+
+      g_assert_true (gdk_event_get_event_sequence (event) == (i ? seq2 : seq1));
+      g_assert_cmpuint (gdk_event_get_time (event), ==, 204 + i);
+
+      history = gdk_event_get_history (event, &n_history);
+      g_assert_cmpuint (n_history, ==, 2);
+      g_assert_cmpuint (history[0].time, ==, 200 + i);
+      g_assert_cmpuint (history[1].time, ==, 202 + i);
+      g_free (history);
+    }
+
+  clear_queue (display, n_before);
+  gdk_surface_destroy (surface);
+}
+
+static void
+test_compression_disabled (void)
+{
+  GdkDisplay *display = gdk_display_get_default ();
+  GdkSurface *surface;
+  guint n_before, i;
+
+  surface = gdk_surface_new_toplevel (display);
+  g_assert_true (gdk_surface_get_event_compression (surface));
+  gdk_surface_set_event_compression (surface, FALSE);
+  g_assert_false (gdk_surface_get_event_compression (surface));
+
+  n_before = g_queue_get_length (&display->queued_events);
+
+  for (i = 0; i < 5; i++)
+    {
+      queue_event (gdk_motion_event_new (surface, get_pointer (), NULL, 100 + i, 0, i, i, NULL));
+      _gdk_event_queue_handle_motion_compression (display);
+    }
+
+  g_assert_cmpuint (g_queue_get_length (&display->queued_events), ==, n_before + 5);
+
+  clear_queue (display, n_before);
+  gdk_surface_destroy (surface);
+}
+
+/* Feeds motion events at 1 kHz and flushes the queue at 60 Hz, like
+ * a fast mouse or stylus and the frame clock would, and reports how
+ * long samples wait before they reach the surface.
+ */
+typedef struct {
+  GdkSurface *surface;
+  GArray *created; /* gint64, indexed by event time */
+  guint n_delivered;
+  gint64 total_latency;
+  gint64 max_latency;
+  gboolean done;
+} Benchmark;
+
+static void
+record_latency (Benchmark *bench,
+                guint32    time,
+                gint64     now)
+{
+  gint64 latency = now - g_array_index (bench->created, gint64, time);
+
+  bench->n_delivered++;
+  bench->total_latency += latency;
+  bench->max_latency = MAX (bench->max_latency, latency);
+}
+
+static gboolean
+benchmark_event_cb (GdkSurface *surface,
+                    GdkEvent   *event,
+                    Benchmark  *bench)
+{
+  gint64 now = g_get_monotonic_time ();
+  GdkTimeCoord *history;
+  guint n_history, i;
+
+  if (gdk_event_get_event_type (event) != GDK_MOTION_NOTIFY)
+    return FALSE;
+
+  history = gdk_event_get_history (event, &n_history);
+  for (i = 0; i < n_history; i++)
+    record_latency (bench, history[i].time, now);
+  g_free (history);
+
+  record_latency (bench, gdk_event_get_time (event), now);
+
+  return TRUE;
+}
+
+static gboolean
+benchmark_produce (gpointer data)
+{
+  Benchmark *bench = data;
+  GdkDisplay *display = gdk_surface_get_display (bench->surface);
+  gint64 now = g_get_monotonic_time ();
+  guint32 time = bench->created->len;
+  GdkEvent *event;
+
+  g_array_append_val (bench->created, now);
+
+  event = gdk_motion_event_new (bench->surface, get_pointer (), NULL,
+                                time, 0, time % 100, time % 100, NULL);
+  _gdk_windowing_got_event (display, _gdk_event_queue_append (display, event), event, 0);
+
+  return bench->created->len < 1000 ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+static gboolean
+benchmark_flush (gpointer data)
+{
+  Benchmark *bench = data;
+
+  _gdk_event_queue_flush (gdk_surface_get_display (bench->surface));
+
+  if (bench->created->len >= 1000)
+    {
+      bench->done = TRUE;
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+test_compression_latency (void)
+{
+  Benchmark bench = { 0, };
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Not a performance test");
+      return;
+    }
+
+  bench.surface = gdk_surface_new_toplevel (gdk_display_get_default ());
+  bench.created = g_array_new (FALSE, FALSE, sizeof (gint64));
+  g_signal_connect (bench.surface, "event", G_CALLBACK (benchmark_event_cb), &bench);
+
+  g_timeout_add (1, benchmark_produce, &bench);
+  g_timeout_add (16, benchmark_flush, &bench);
+
+  while (!bench.done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_cmpuint (bench.n_delivered, ==, bench.created->len);
+
+  g_test_message ("%u samples, average latency %.2f ms, max %.2f ms",
+                  bench.n_delivered,
+                  bench.total_latency / (1000. * bench.n_delivered),
+                  bench.max_latency / 1000.);
+  g_test_minimized_result (bench.total_latency / (1000. * bench.n_delivered),
+                           "average latency %.2f ms",
+                           bench.total_latency / (1000. * bench.n_delivered));
+
+  g_array_unref (bench.created);
+  gdk_surface_destroy (bench.surface);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/event-compression/motion", test_compression_motion);
+  g_test_add_func ("/event-compression/touch", test_compression_touch);
+  g_test_add_func ("/event-compression/disabled", test_compression_disabled);
+  g_test_add_func ("/event-compression/latency", test_compression_latency);
+
+  return g_test_run ();
+}
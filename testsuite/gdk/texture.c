@@ -1,7 +1,19 @@
 #include <gtk.h>
+#include <glib/gstdio.h>
+#ifdef G_OS_WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
 
 #include "gdk/gdkmemorytextureprivate.h"
 #include "gdk/gdktextureprivate.h"
+#include "gdk/gdktiledtextureprivate.h"
 
 
 #define assert_texture_diff_equal(a, b, expected) G_STMT_START { \
@@ -448,6 +460,246 @@ test_texture_downloader (void)
   g_object_unref (texture);
 }
 
+static void
+test_texture_from_fd (void)
+{
+  GdkMemoryTextureBuilder *builder;
+  GdkTexture *texture;
+  GError *error = NULL;
+  char *path, *contents;
+  guchar data[16 * 4 * 16];
+  gsize offset = 100;
+  gsize i, written;
+  int fd;
+
+  fd = g_file_open_tmp ("gtk-texture-XXXXXX", &path, &error);
+  g_assert_no_error (error);
+
+  /* put the pixels at an offset that isn't page aligned */
+  contents = g_malloc (offset + sizeof (data));
+  for (i = 0; i < offset + sizeof (data); i++)
+    contents[i] = i * 7;
+  /* write through the fd, so it refers to the file with the data */
+  for (written = 0; written < offset + sizeof (data); )
+    {
+      gssize n = write (fd, contents + written, offset + sizeof (data) - written);
+      g_assert_cmpint (n, >, 0);
+      written += n;
+    }
+
+  builder = gdk_memory_texture_builder_new ();
+  gdk_memory_texture_builder_set_width (builder, 16);
+  gdk_memory_texture_builder_set_height (builder, 16);
+  gdk_memory_texture_builder_set_stride (builder, 16 * 4);
+  /* the format gdk_texture_download() uses, so no conversion happens */
+  gdk_memory_texture_builder_set_format (builder, GDK_MEMORY_DEFAULT);
+
+  /* an offset past the end is an error and leaves the builder alone */
+  g_assert_false (gdk_memory_texture_builder_set_fd (builder, fd, offset + sizeof (data), &error));
+  g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL);
+  g_clear_error (&error);
+  g_assert_cmpuint (gdk_memory_texture_builder_get_offset (builder), ==, 0);
+
+  g_assert_true (gdk_memory_texture_builder_set_fd (builder, fd, offset, &error));
+  g_assert_no_error (error);
+  g_assert_cmpuint (gdk_memory_texture_builder_get_offset (builder), ==, offset);
+
+  /* the builder must not need the fd anymore */
+  g_close (fd, NULL);
+  g_unlink (path);
+
+  texture = gdk_memory_texture_builder_build (builder);
+  g_assert_nonnull (texture);
+
+  gdk_texture_download (texture, data, 16 * 4);
+  g_assert_true (memcmp (data, contents + offset, sizeof (data)) == 0);
+
+  /* dropping the pages must not lose the data */
+  gdk_memory_texture_release_pages (GDK_MEMORY_TEXTURE (texture));
+  memset (data, 0, sizeof (data));
+  gdk_texture_download (texture, data, 16 * 4);
+  g_assert_true (memcmp (data, contents + offset, sizeof (data)) == 0);
+
+  g_object_unref (texture);
+  g_object_unref (builder);
+  g_free (contents);
+  g_free (path);
+}
+
+/* Memfds can be truncated while they are mapped, which would
+ * crash, so they need to be sealed */
+static void
+test_texture_from_memfd (void)
+{
+#if defined (__linux__) && defined (MFD_ALLOW_SEALING) && defined (F_ADD_SEALS)
+  GdkMemoryTextureBuilder *builder;
+  GdkTexture *texture;
+  GError *error = NULL;
+  guchar data[16 * 4 * 16], downloaded[16 * 4 * 16];
+  gsize i;
+  int fd;
+
+  fd = memfd_create ("gtk-texture", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0)
+    {
+      g_test_skip ("memfd_create() is not supported");
+      return;
+    }
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = i * 7;
+  g_assert_cmpint (write (fd, data, sizeof (data)), ==, sizeof (data));
+
+  builder = gdk_memory_texture_builder_new ();
+  gdk_memory_texture_builder_set_width (builder, 16);
+  gdk_memory_texture_builder_set_height (builder, 16);
+  gdk_memory_texture_builder_set_stride (builder, 16 * 4);
+  gdk_memory_texture_builder_set_format (builder, GDK_MEMORY_DEFAULT);
+
+  g_assert_false (gdk_memory_texture_builder_set_fd (builder, fd, 0, &error));
+  g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_PERM);
+  g_clear_error (&error);
+
+  g_assert_cmpint (fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_WRITE), ==, 0);
+
+  g_assert_true (gdk_memory_texture_builder_set_fd (builder, fd, 0, &error));
+  g_assert_no_error (error);
+  g_close (fd, NULL);
+
+  texture = gdk_memory_texture_builder_build (builder);
+  gdk_texture_download (texture, downloaded, 16 * 4);
+  g_assert_true (memcmp (data, downloaded, sizeof (data)) == 0);
+
+  g_object_unref (texture);
+  g_object_unref (builder);
+#else
+  g_test_skip ("Memfds are not supported");
+#endif
+}
+
+typedef struct {
+  guint n_loads;
+  guint levels;
+  gboolean destroyed;
+} TiledData;
+
+static GdkTexture *
+load_tile (GdkTiledTexture    *texture,
+           guint               level,
+           const GdkRectangle *area,
+           gpointer            user_data)
+{
+  TiledData *tiled = user_data;
+  GdkTexture *tile;
+  GBytes *bytes;
+  guchar *data;
+  int x, y;
+
+  tiled->levels |= 1 << level;
+  tiled->n_loads++;
+
+  /* encode the position in the image in every pixel */
+  data = g_malloc (area->width * area->height * 4);
+  for (y = 0; y < area->height; y++)
+    for (x = 0; x < area->width; x++)
+      {
+        guchar *pixel = data + (y * area->width + x) * 4;
+
+        pixel[0] = area->x + x;
+        pixel[1] = area->y + y;
+        pixel[2] = ((area->x + x) >> 8) ^ ((area->y + y) >> 8);
+        pixel[3] = 0xff;
+      }
+
+  bytes = g_bytes_new_take (data, area->width * area->height * 4);
+  tile = gdk_memory_texture_new (area->width, area->height, GDK_MEMORY_DEFAULT, bytes, area->width * 4);
+  g_bytes_unref (bytes);
+
+  return tile;
+}
+
+static void
+tiled_data_destroy (gpointer data)
+{
+  TiledData *tiled = data;
+
+  tiled->destroyed = TRUE;
+}
+
+static void
+test_texture_tiled (void)
+{
+  TiledData tiled = { 0, 0, FALSE };
+  GdkTexture *texture;
+  guchar *data;
+  int x, y;
+
+  texture = gdk_tiled_texture_new (2100, 1100, GDK_MEMORY_DEFAULT, 4, load_tile, &tiled, tiled_data_destroy);
+  g_assert_true (GDK_IS_TILED_TEXTURE (texture));
+  g_assert_cmpint (gdk_texture_get_width (texture), ==, 2100);
+  g_assert_cmpint (gdk_texture_get_height (texture), ==, 1100);
+  g_assert_cmpuint (gdk_tiled_texture_get_n_levels (GDK_TILED_TEXTURE (texture)), ==, 4);
+  g_assert_cmpuint (tiled.n_loads, ==, 0);
+
+  data = g_malloc (2100 * 1100 * 4);
+  gdk_texture_download (texture, data, 2100 * 4);
+
+  /* downloading loads the full image, in pieces */
+  g_assert_cmpuint (tiled.n_loads, >, 1);
+  g_assert_cmpuint (tiled.levels, ==, 1 << 0);
+  for (y = 0; y < 1100; y++)
+    for (x = 0; x < 2100; x++)
+      {
+        guchar *pixel = data + (y * 2100 + x) * 4;
+
+        g_assert_cmpuint (pixel[0], ==, x & 0xff);
+        g_assert_cmpuint (pixel[1], ==, y & 0xff);
+        g_assert_cmpuint (pixel[2], ==, ((x >> 8) ^ (y >> 8)) & 0xff);
+        g_assert_cmpuint (pixel[3], ==, 0xff);
+      }
+
+  g_free (data);
+  g_assert_false (tiled.destroyed);
+  g_object_unref (texture);
+  g_assert_true (tiled.destroyed);
+}
+
+/* Renderers that can't draw tiles get the largest level that is
+ * small enough, and nothing if there is none */
+static void
+test_texture_tiled_preview (void)
+{
+  TiledData tiled = { 0, 0, FALSE };
+  GdkTexture *texture, *preview;
+  guint n_loads;
+
+  /* levels are 20000x10000, 10000x5000, 5000x2500 and 2500x1250 */
+  texture = gdk_tiled_texture_new (20000, 10000, GDK_MEMORY_DEFAULT, 4, load_tile, &tiled, NULL);
+
+  preview = gdk_tiled_texture_get_preview (GDK_TILED_TEXTURE (texture));
+  g_assert_nonnull (preview);
+  g_assert_cmpint (gdk_texture_get_width (preview), ==, 2500);
+  g_assert_cmpint (gdk_texture_get_height (preview), ==, 1250);
+  g_assert_cmpuint (tiled.levels, ==, 1 << 3);
+
+  /* the preview is only loaded once */
+  n_loads = tiled.n_loads;
+  g_assert_true (gdk_tiled_texture_get_preview (GDK_TILED_TEXTURE (texture)) == preview);
+  g_assert_cmpuint (tiled.n_loads, ==, n_loads);
+
+  g_object_unref (texture);
+
+  tiled.levels = 0;
+  texture = gdk_tiled_texture_new (20000, 10000, GDK_MEMORY_DEFAULT, 1, load_tile, &tiled, NULL);
+
+  g_test_expect_message ("Gdk", G_LOG_LEVEL_WARNING, "*only be drawn by the GPU renderers*");
+  g_assert_null (gdk_tiled_texture_get_preview (GDK_TILED_TEXTURE (texture)));
+  g_test_assert_expected_messages ();
+  g_assert_cmpuint (tiled.levels, ==, 0);
+
+  g_object_unref (texture);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -464,6 +716,10 @@ main (int argc, char *argv[])
   g_test_add_func ("/texture/icon/serialize", test_texture_icon_serialize);
   g_test_add_func ("/texture/diff", test_texture_diff);
   g_test_add_func ("/texture/downloader", test_texture_downloader);
+  g_test_add_func ("/texture/from-fd", test_texture_from_fd);
+  g_test_add_func ("/texture/from-memfd", test_texture_from_memfd);
+  g_test_add_func ("/texture/tiled", test_texture_tiled);
+  g_test_add_func ("/texture/tiled/preview", test_texture_tiled_preview);
 
   return g_test_run ();
 }
@@ -165,20 +165,22 @@ fail:
 
 
 GdkTexture *
-udmabuf_texture_new (gsize           width,
-                     gsize           height,
-                     guint           fourcc,
-                     GdkColorState  *color_state,
-                     gboolean        premultiplied,
-                     GBytes         *bytes,
-                     gsize           stride,
-                     GError        **error)
+udmabuf_texture_new_planes (gsize           width,
+                            gsize           height,
+                            guint           fourcc,
+                            GdkColorState  *color_state,
+                            gboolean        premultiplied,
+                            GBytes         *bytes,
+                            gsize           n_planes,
+                            const gsize    *strides,
+                            const gsize    *offsets,
+                            GError        **error)
 {
   GdkDmabufTextureBuilder *builder;
   GdkTexture *texture;
   UDmabuf *udmabuf;
   gconstpointer data;
-  gsize size;
+  gsize size, i;
 
   data = g_bytes_get_data (bytes, &size);
 
@@ -197,10 +199,13 @@ udmabuf_texture_new (gsize           width,
   gdk_dmabuf_texture_builder_set_modifier (builder, 0);
   gdk_dmabuf_texture_builder_set_color_state (builder, color_state);
   gdk_dmabuf_texture_builder_set_premultiplied (builder, premultiplied);
-  gdk_dmabuf_texture_builder_set_n_planes (builder, 1);
-  gdk_dmabuf_texture_builder_set_fd (builder, 0, udmabuf->dmabuf_fd);
-  gdk_dmabuf_texture_builder_set_stride (builder, 0, stride);
-  gdk_dmabuf_texture_builder_set_offset (builder, 0, 0);
+  gdk_dmabuf_texture_builder_set_n_planes (builder, n_planes);
+  for (i = 0; i < n_planes; i++)
+    {
+      gdk_dmabuf_texture_builder_set_fd (builder, i, udmabuf->dmabuf_fd);
+      gdk_dmabuf_texture_builder_set_stride (builder, i, strides[i]);
+      gdk_dmabuf_texture_builder_set_offset (builder, i, offsets[i]);
+    }
 
   texture = gdk_dmabuf_texture_builder_build (builder, udmabuf_free, udmabuf, error);
 
@@ -211,6 +216,26 @@ udmabuf_texture_new (gsize           width,
 
 #else
 
+GdkTexture *
+udmabuf_texture_new_planes (gsize           width,
+                            gsize           height,
+                            guint           fourcc,
+                            GdkColorState  *color_state,
+                            gboolean        premultiplied,
+                            GBytes         *bytes,
+                            gsize           n_planes,
+                            const gsize    *strides,
+                            const gsize    *offsets,
+                            GError        **error)
+{
+  g_set_error (error,
+               G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+               "Dmabufs are not supported");
+  return NULL;
+}
+
+#endif
+
 GdkTexture *
 udmabuf_texture_new (gsize           width,
                      gsize           height,
@@ -221,14 +246,17 @@ udmabuf_texture_new (gsize           width,
                      gsize           stride,
                      GError        **error)
 {
-  g_set_error (error,
-               G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
-               "Dmabufs are not supported");
-  return NULL;
+  return udmabuf_texture_new_planes (width, height,
+                                     fourcc,
+                                     color_state,
+                                     premultiplied,
+                                     bytes,
+                                     1,
+                                     (gsize[1]) { stride },
+                                     (gsize[1]) { 0 },
+                                     error);
 }
 
-#endif
-
 GdkTexture *
 udmabuf_texture_from_texture (GdkTexture  *texture,
                               GError     **error)
@@ -13,5 +13,16 @@ GdkTexture *    udmabuf_texture_new             (gsize           width,
                                                  gsize           stride,
                                                  GError        **error);
 
+GdkTexture *    udmabuf_texture_new_planes      (gsize           width,
+                                                 gsize           height,
+                                                 guint           fourcc,
+                                                 GdkColorState  *color_state,
+                                                 gboolean        premultiplied,
+                                                 GBytes         *bytes,
+                                                 gsize           n_planes,
+                                                 const gsize    *strides,
+                                                 const gsize    *offsets,
+                                                 GError        **error);
+
 GdkTexture *    udmabuf_texture_from_texture    (GdkTexture     *texture,
                                                  GError        **error);
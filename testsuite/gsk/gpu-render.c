@@ -0,0 +1,473 @@
+#include <gtk/gtk.h>
+
+/* Renders nodes with the GPU renderers and compares the result with
+ * the cairo renderer. The GPU renderers antialias differently, so the
+ * comparison allows small differences per pixel, but the overall
+ * coverage must match closely.
+ */
+
+static GskRenderer *
+create_gpu_renderer (gconstpointer data)
+{
+  GskRenderer *(* create_func) (void) = (GskRenderer *(*) (void)) data;
+  GskRenderer *renderer;
+  GError *error = NULL;
+
+  renderer = create_func ();
+  if (!gsk_renderer_realize_for_display (renderer, gdk_display_get_default (), &error))
+    {
+      g_test_skip_printf ("Could not realize renderer: %s", error->message);
+      g_clear_error (&error);
+      g_object_unref (renderer);
+      return NULL;
+    }
+
+  return renderer;
+}
+
+static void
+destroy_renderer (GskRenderer *renderer)
+{
+  gsk_renderer_unrealize (renderer);
+  g_object_unref (renderer);
+}
+
+static guchar *
+download_texture (GdkTexture *texture)
+{
+  GdkTextureDownloader *downloader;
+  guchar *data;
+
+  data = g_malloc (gdk_texture_get_width (texture) * gdk_texture_get_height (texture) * 4);
+  downloader = gdk_texture_downloader_new (texture);
+  gdk_texture_downloader_set_format (downloader, GDK_MEMORY_R8G8B8A8_PREMULTIPLIED);
+  gdk_texture_downloader_download_into (downloader, data, gdk_texture_get_width (texture) * 4);
+  gdk_texture_downloader_free (downloader);
+
+  return data;
+}
+
+static void
+assert_textures_similar (GdkTexture *expected,
+                         GdkTexture *rendered,
+                         guint       max_pixel_diff,
+                         double      max_coverage_diff)
+{
+  guchar *expected_data, *rendered_data;
+  guint64 expected_sum, rendered_sum;
+  guint max_diff;
+  gsize i, n;
+
+  g_assert_cmpint (gdk_texture_get_width (expected), ==, gdk_texture_get_width (rendered));
+  g_assert_cmpint (gdk_texture_get_height (expected), ==, gdk_texture_get_height (rendered));
+
+  expected_data = download_texture (expected);
+  rendered_data = download_texture (rendered);
+  n = gdk_texture_get_width (expected) * gdk_texture_get_height (expected) * 4;
+
+  max_diff = 0;
+  expected_sum = 0;
+  rendered_sum = 0;
+  for (i = 0; i < n; i++)
+    {
+      max_diff = MAX (max_diff, ABS ((int) expected_data[i] - (int) rendered_data[i]));
+      expected_sum += expected_data[i];
+      rendered_sum += rendered_data[i];
+    }
+
+  g_test_message ("max pixel difference %u, coverage %.1f%% of expected",
+                  max_diff, 100.0 * rendered_sum / MAX (expected_sum, 1));
+  g_assert_cmpuint (max_diff, <=, max_pixel_diff);
+  g_assert_cmpfloat (ABS ((double) rendered_sum - (double) expected_sum), <=, max_coverage_diff * expected_sum);
+
+  g_free (expected_data);
+  g_free (rendered_data);
+}
+
+static void
+assert_renders_like_cairo (GskRenderer   *renderer,
+                           GskRenderNode *node,
+                           guint          max_pixel_diff,
+                           double         max_coverage_diff)
+{
+  GskRenderer *cairo_renderer;
+  GdkTexture *expected, *rendered;
+
+  cairo_renderer = gsk_cairo_renderer_new ();
+  gsk_renderer_realize_for_display (cairo_renderer, gdk_display_get_default (), NULL);
+
+  expected = gsk_renderer_render_texture (cairo_renderer, node, NULL);
+  rendered = gsk_renderer_render_texture (renderer, node, NULL);
+  assert_textures_similar (expected, rendered, max_pixel_diff, max_coverage_diff);
+
+  g_object_unref (expected);
+  g_object_unref (rendered);
+  destroy_renderer (cairo_renderer);
+}
+
+static GskRenderNode *
+create_stroke_node (const char *path_string,
+                    const float *dash,
+                    gsize        n_dash)
+{
+  GskRenderNode *color, *node;
+  GskStroke *stroke;
+  GskPath *path;
+
+  path = gsk_path_parse (path_string);
+  stroke = gsk_stroke_new (2);
+  gsk_stroke_set_line_cap (stroke, GSK_LINE_CAP_ROUND);
+  gsk_stroke_set_line_join (stroke, GSK_LINE_JOIN_ROUND);
+  gsk_stroke_set_dash (stroke, dash, n_dash);
+  gsk_stroke_set_dash_offset (stroke, 3);
+
+  color = gsk_color_node_new (&(GdkRGBA) { 0, 0, 0, 1 }, &GRAPHENE_RECT_INIT (0, 0, 200, 200));
+  node = gsk_stroke_node_new (color, path, stroke);
+
+  gsk_render_node_unref (color);
+  gsk_stroke_free (stroke);
+  gsk_path_unref (path);
+
+  return node;
+}
+
+#define CURVES "M 10 100 C 40 0, 80 200, 110 100 Q 150 20, 190 100 " \
+               "M 100 150 C 150 150, 150 190, 100 190 C 50 190, 50 150, 100 150 Z"
+
+static void
+test_stroke_curves (gconstpointer data)
+{
+  GskRenderer *renderer;
+  GskRenderNode *node;
+
+  renderer = create_gpu_renderer (data);
+  if (renderer == NULL)
+    return;
+
+  node = create_stroke_node (CURVES, NULL, 0);
+  assert_renders_like_cairo (renderer, node, 64, 0.02);
+
+  gsk_render_node_unref (node);
+  destroy_renderer (renderer);
+}
+
+static void
+test_stroke_dashed (gconstpointer data)
+{
+  const float dash[] = { 8, 4, 0, 4 };
+  const float odd_dash[] = { 5 };
+  GskRenderer *renderer;
+  GskRenderNode *node;
+
+  renderer = create_gpu_renderer (data);
+  if (renderer == NULL)
+    return;
+
+  node = create_stroke_node (CURVES, dash, G_N_ELEMENTS (dash));
+  assert_renders_like_cairo (renderer, node, 64, 0.02);
+  gsk_render_node_unref (node);
+
+  node = create_stroke_node (CURVES, odd_dash, G_N_ELEMENTS (odd_dash));
+  assert_renders_like_cairo (renderer, node, 64, 0.02);
+  gsk_render_node_unref (node);
+
+  destroy_renderer (renderer);
+}
+
+/* Contains edges that are almost, but not quite horizontal */
+#define SHALLOW "M 10 20 L 190 20.3 L 180 60 L 20 59.8 Z " \
+                "M 30 120 L 170 119.9 L 170 180 L 30 180.2 Z"
+
+static void
+test_fill (gconstpointer data)
+{
+  const char *paths[] = { CURVES, SHALLOW };
+  const GskFillRule rules[] = { GSK_FILL_RULE_WINDING, GSK_FILL_RULE_EVEN_ODD };
+  GskRenderer *renderer;
+  GskRenderNode *color, *node;
+  GskPath *path;
+  gsize i, j;
+
+  renderer = create_gpu_renderer (data);
+  if (renderer == NULL)
+    return;
+
+  color = gsk_color_node_new (&(GdkRGBA) { 0, 0, 0, 1 }, &GRAPHENE_RECT_INIT (0, 0, 200, 200));
+
+  for (i = 0; i < G_N_ELEMENTS (paths); i++)
+    {
+      path = gsk_path_parse (paths[i]);
+
+      for (j = 0; j < G_N_ELEMENTS (rules); j++)
+        {
+          node = gsk_fill_node_new (color, path, rules[j]);
+          assert_renders_like_cairo (renderer, node, 32, 0.01);
+          gsk_render_node_unref (node);
+        }
+
+      gsk_path_unref (path);
+    }
+
+  gsk_render_node_unref (color);
+  destroy_renderer (renderer);
+}
+
+static GskRenderNode *
+create_text_node (const char *font,
+                  float       scale)
+{
+  PangoContext *context;
+  PangoLayout *layout;
+  PangoFontDescription *desc;
+  GtkSnapshot *snapshot;
+
+  context = pango_font_map_create_context (pango_cairo_font_map_get_default ());
+  layout = pango_layout_new (context);
+  desc = pango_font_description_from_string (font);
+  pango_layout_set_font_description (layout, desc);
+  pango_layout_set_text (layout, "Ag&@", -1);
+
+  snapshot = gtk_snapshot_new ();
+  gtk_snapshot_scale (snapshot, scale, scale);
+  gtk_snapshot_append_layout (snapshot, layout, &(GdkRGBA) { 0, 0, 0, 1 });
+
+  pango_font_description_free (desc);
+  g_object_unref (layout);
+  g_object_unref (context);
+
+  return gtk_snapshot_free_to_node (snapshot);
+}
+
+/* Large glyphs are drawn from distance fields. They must look like
+ * the glyphs rasterized by cairo, which the glyph atlas uses. */
+static void
+test_text_sdf (gconstpointer data)
+{
+  GskRenderer *renderer;
+  GskRenderNode *node;
+
+  renderer = create_gpu_renderer (data);
+  if (renderer == NULL)
+    return;
+
+  node = create_text_node ("Sans 64px", 1);
+  assert_renders_like_cairo (renderer, node, 128, 0.03);
+  gsk_render_node_unref (node);
+
+  node = create_text_node ("Sans 64px", 1.7);
+  assert_renders_like_cairo (renderer, node, 128, 0.03);
+  gsk_render_node_unref (node);
+
+  destroy_renderer (renderer);
+}
+
+static GdkTexture *
+load_counted_tile (GdkTiledTexture    *texture,
+                   guint               level,
+                   const GdkRectangle *area,
+                   gpointer            user_data)
+{
+  guint *n_loads = user_data;
+  GdkTexture *tile;
+  GBytes *bytes;
+  guchar *data;
+  gsize size;
+
+  size = (gsize) area->width * area->height * 4;
+  data = g_malloc (size);
+  /* opaque green */
+  for (gsize i = 0; i < size; i += 4)
+    {
+      data[i + 0] = 0;
+      data[i + 1] = 0xff;
+      data[i + 2] = 0;
+      data[i + 3] = 0xff;
+    }
+  bytes = g_bytes_new_take (data, size);
+  tile = gdk_memory_texture_new (area->width, area->height,
+                                 GDK_MEMORY_R8G8B8A8_PREMULTIPLIED,
+                                 bytes,
+                                 area->width * 4);
+  g_bytes_unref (bytes);
+
+  (*n_loads)++;
+
+  return tile;
+}
+
+/* Children that are covered by later opaque children must not be
+ * drawn, children that are only partially covered must still be drawn.
+ * Tiled textures only load tiles they draw, so they count for us. */
+static void
+test_occlusion_culling (gconstpointer data)
+{
+  GskRenderer *renderer;
+  GdkTexture *hidden_texture, *partial_texture, *rendered;
+  GskRenderNode *nodes[3], *container;
+  guint hidden_loads = 0, partial_loads = 0;
+  guchar *pixels;
+
+  renderer = create_gpu_renderer (data);
+  if (renderer == NULL)
+    return;
+
+  hidden_texture = gdk_tiled_texture_new (100, 100, GDK_MEMORY_R8G8B8A8_PREMULTIPLIED, 1,
+                                          load_counted_tile, &hidden_loads, NULL);
+  partial_texture = gdk_tiled_texture_new (100, 100, GDK_MEMORY_R8G8B8A8_PREMULTIPLIED, 1,
+                                           load_counted_tile, &partial_loads, NULL);
+
+  nodes[0] = gsk_texture_node_new (hidden_texture, &GRAPHENE_RECT_INIT (0, 0, 100, 100));
+  nodes[1] = gsk_texture_node_new (partial_texture, &GRAPHENE_RECT_INIT (100, 0, 100, 100));
+  nodes[2] = gsk_color_node_new (&(GdkRGBA) { 0, 0, 1, 1 }, &GRAPHENE_RECT_INIT (0, 0, 150, 100));
+  container = gsk_container_node_new (nodes, G_N_ELEMENTS (nodes));
+
+  rendered = gsk_renderer_render_texture (renderer, container, &GRAPHENE_RECT_INIT (0, 0, 300, 100));
+  pixels = download_texture (rendered);
+
+  g_assert_cmpuint (hidden_loads, ==, 0);
+  g_assert_cmpuint (partial_loads, >, 0);
+
+  /* blue where the color covers the texture, green right of it */
+  g_assert_cmphex (pixels[(50 * 300 + 120) * 4 + 2], ==, 0xff);
+  g_assert_cmphex (pixels[(50 * 300 + 180) * 4 + 1], ==, 0xff);
+
+  g_free (pixels);
+  g_object_unref (rendered);
+  gsk_render_node_unref (container);
+  for (gsize i = 0; i < G_N_ELEMENTS (nodes); i++)
+    gsk_render_node_unref (nodes[i]);
+  g_object_unref (hidden_texture);
+  g_object_unref (partial_texture);
+  destroy_renderer (renderer);
+}
+
+typedef struct {
+  guint n_loads;
+  guint levels;
+  gboolean outside;
+} LevelLoads;
+
+#define LARGE_SIZE 65536
+#define LARGE_SCALE (1.f / 16)
+#define LARGE_VIEWPORT 512
+
+static GdkTexture *
+load_level_tile (GdkTiledTexture    *texture,
+                 guint               level,
+                 const GdkRectangle *area,
+                 gpointer            user_data)
+{
+  LevelLoads *loads = user_data;
+
+  loads->levels |= 1 << level;
+  /* the visible part of the image, in the coordinates of the level */
+  if (area->x >= (LARGE_VIEWPORT / LARGE_SCALE) / (1 << level) ||
+      area->y >= (LARGE_VIEWPORT / LARGE_SCALE) / (1 << level))
+    loads->outside = TRUE;
+
+  return load_counted_tile (texture, level, area, &loads->n_loads);
+}
+
+/* Tiled textures drawn at a reduced scale must only load the visible
+ * tiles, from the level that matches the scale */
+static void
+test_tiled_level (gconstpointer data)
+{
+  GskRenderer *renderer;
+  GdkTexture *texture, *rendered;
+  GskRenderNode *node, *transform;
+  LevelLoads loads = { 0, 0, FALSE };
+  guchar *pixels;
+
+  renderer = create_gpu_renderer (data);
+  if (renderer == NULL)
+    return;
+
+  /* 16GB at full resolution, but the 8192x8192 pixels in view
+   * fit into a single tile of level 4 */
+  texture = gdk_tiled_texture_new (LARGE_SIZE, LARGE_SIZE, GDK_MEMORY_R8G8B8A8_PREMULTIPLIED, 8,
+                                   load_level_tile, &loads, NULL);
+  node = gsk_texture_node_new (texture, &GRAPHENE_RECT_INIT (0, 0, LARGE_SIZE, LARGE_SIZE));
+  transform = gsk_transform_node_new (node, gsk_transform_scale (NULL, LARGE_SCALE, LARGE_SCALE));
+
+  rendered = gsk_renderer_render_texture (renderer, transform,
+                                          &GRAPHENE_RECT_INIT (0, 0, LARGE_VIEWPORT, LARGE_VIEWPORT));
+  pixels = download_texture (rendered);
+
+  g_assert_cmpuint (loads.n_loads, >, 0);
+  g_assert_cmphex (loads.levels, ==, 1 << 4);
+  g_assert_false (loads.outside);
+
+  /* green everywhere */
+  g_assert_cmphex (pixels[(10 * LARGE_VIEWPORT + 10) * 4 + 1], ==, 0xff);
+  g_assert_cmphex (pixels[((LARGE_VIEWPORT - 10) * LARGE_VIEWPORT + LARGE_VIEWPORT - 10) * 4 + 1], ==, 0xff);
+
+  g_free (pixels);
+  g_object_unref (rendered);
+  gsk_render_node_unref (transform);
+  gsk_render_node_unref (node);
+  g_object_unref (texture);
+  destroy_renderer (renderer);
+}
+
+/* Paths are cached once they are reused, the cached mask must
+ * look like the one drawn the first time */
+static void
+test_path_cache_reuse (gconstpointer data)
+{
+  GskRenderer *renderer;
+  GskRenderNode *color, *node;
+  GdkTexture *first, *cached;
+  GskPath *path;
+
+  renderer = create_gpu_renderer (data);
+  if (renderer == NULL)
+    return;
+
+  path = gsk_path_parse (CURVES);
+  color = gsk_color_node_new (&(GdkRGBA) { 0, 0, 0, 1 }, &GRAPHENE_RECT_INIT (0, 0, 200, 200));
+  node = gsk_fill_node_new (color, path, GSK_FILL_RULE_EVEN_ODD);
+
+  first = gsk_renderer_render_texture (renderer, node, NULL);
+  g_object_unref (gsk_renderer_render_texture (renderer, node, NULL));
+  cached = gsk_renderer_render_texture (renderer, node, NULL);
+  assert_textures_similar (first, cached, 2, 0.001);
+
+  g_object_unref (first);
+  g_object_unref (cached);
+  gsk_render_node_unref (node);
+  gsk_render_node_unref (color);
+  gsk_path_unref (path);
+  destroy_renderer (renderer);
+}
+
+static void
+add_test (const char    *name,
+          GTestDataFunc  func)
+{
+  char *path;
+
+  path = g_strdup_printf ("/gpu-render/gl/%s", name);
+  g_test_add_data_func (path, (gconstpointer) gsk_gl_renderer_new, func);
+  g_free (path);
+
+  path = g_strdup_printf ("/gpu-render/vulkan/%s", name);
+  g_test_add_data_func (path, (gconstpointer) gsk_vulkan_renderer_new, func);
+  g_free (path);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  add_test ("stroke/curves", test_stroke_curves);
+  add_test ("stroke/dashed", test_stroke_dashed);
+  add_test ("fill", test_fill);
+  add_test ("path-cache/reuse", test_path_cache_reuse);
+  add_test ("text/sdf", test_text_sdf);
+  add_test ("occlusion/culling", test_occlusion_culling);
+  add_test ("tiled/level", test_tiled_level);
+
+  return g_test_run ();
+}
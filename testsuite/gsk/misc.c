@@ -149,6 +149,72 @@ test_container_disjoint (void)
   gsk_render_node_unref (nodes[1]);
 }
 
+/* Recreates the containers, transforms and clips around the leaves,
+ * like widgets do every frame */
+static GskRenderNode *
+create_nested_container (GskRenderNode **leaves)
+{
+  GskRenderNode *inner, *clip, *transform, *outer, *nodes[2];
+  GskTransform *translate;
+
+  inner = gsk_container_node_new (leaves, 2);
+  clip = gsk_clip_node_new (inner, &GRAPHENE_RECT_INIT (0, 0, 100, 50));
+  translate = gsk_transform_translate (NULL, &GRAPHENE_POINT_INIT (10, 20));
+  transform = gsk_transform_node_new (clip, translate);
+  nodes[0] = transform;
+  nodes[1] = leaves[2];
+  outer = gsk_container_node_new (nodes, 2);
+  gsk_transform_unref (translate);
+  gsk_render_node_unref (transform);
+  gsk_render_node_unref (clip);
+  gsk_render_node_unref (inner);
+
+  return outer;
+}
+
+static void
+test_container_diff_unchanged (void)
+{
+  GskRenderNode *leaves[3], *node1, *node2, *node3, *changed;
+  cairo_region_t *region;
+
+  leaves[0] = gsk_color_node_new (&(GdkRGBA){0,1,1,1}, &GRAPHENE_RECT_INIT (0, 0, 50, 50));
+  leaves[1] = gsk_color_node_new (&(GdkRGBA){1,0,1,1}, &GRAPHENE_RECT_INIT (50, 0, 50, 50));
+  leaves[2] = gsk_color_node_new (&(GdkRGBA){1,1,0,1}, &GRAPHENE_RECT_INIT (100, 0, 50, 50));
+
+  /* new containers, transforms and clips around the same nodes */
+  node1 = create_nested_container (leaves);
+  node2 = create_nested_container (leaves);
+
+  /* the diff takes the fast path */
+  g_assert_true (gsk_render_node_is_unchanged (node1, node2));
+
+  region = cairo_region_create ();
+  gsk_render_node_diff (node1, node2, &(GskDiffData) { region, NULL });
+  g_assert_true (cairo_region_is_empty (region));
+  cairo_region_destroy (region);
+
+  /* a changed node deep inside */
+  changed = leaves[1];
+  leaves[1] = gsk_color_node_new (&(GdkRGBA){1,0,0,1}, &GRAPHENE_RECT_INIT (50, 0, 50, 50));
+  node3 = create_nested_container (leaves);
+
+  g_assert_false (gsk_render_node_is_unchanged (node1, node3));
+
+  region = cairo_region_create ();
+  gsk_render_node_diff (node1, node3, &(GskDiffData) { region, NULL });
+  g_assert_cmpint (cairo_region_contains_rectangle (region, &(cairo_rectangle_int_t) { 60, 20, 40, 50 }), ==, CAIRO_REGION_OVERLAP_IN);
+  g_assert_cmpint (cairo_region_contains_rectangle (region, &(cairo_rectangle_int_t) { 10, 20, 50, 50 }), ==, CAIRO_REGION_OVERLAP_OUT);
+  cairo_region_destroy (region);
+
+  gsk_render_node_unref (node1);
+  gsk_render_node_unref (node2);
+  gsk_render_node_unref (node3);
+  gsk_render_node_unref (changed);
+  for (guint i = 0; i < 3; i++)
+    gsk_render_node_unref (leaves[i]);
+}
+
 static void
 test_renderer (GskRenderer *renderer)
 {
@@ -246,6 +312,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/rendernode/border/uniform", test_bordernode_uniform);
   g_test_add_func ("/rendernode/conic-gradient/angle", test_conic_gradient_angle);
   g_test_add_func ("/rendernode/container/disjoint", test_container_disjoint);
+  g_test_add_func ("/rendernode/container/diff-unchanged", test_container_diff_unchanged);
   g_test_add_func ("/renderer/cairo", test_cairo_renderer);
   g_test_add_func ("/renderer/ngl", test_ngl_renderer);
   g_test_add_func ("/renderer/vulkan", test_vulkan_renderer);
@@ -0,0 +1,189 @@
+#include "config.h"
+
+#include <string.h>
+
+#include <gtk/gtk.h>
+#include <gdk/gdksurfaceprivate.h>
+#include <gdk/gdksubsurfaceprivate.h>
+#include <gdk/gdkdebugprivate.h>
+#include <gsk/gskoffloadprivate.h>
+
+/* Tests that subsurfaces with static textures get demoted and that
+ * they get promoted again once their texture changes. These must
+ * run without GDK_DEBUG=force-offload, which disables demotion.
+ */
+
+/* Keep these in sync with gskoffload.c */
+#define DEMOTE_FRAMES 32
+#define PROMOTE_FRAMES 8
+
+static void
+notify_width (GdkSurface *surface,
+              GParamSpec *pspec,
+              gpointer    data)
+{
+  gboolean *done = data;
+
+  *done = TRUE;
+}
+
+static void
+compute_size (GdkToplevel     *toplevel,
+              GdkToplevelSize *size,
+              gpointer         data)
+{
+  g_signal_connect (toplevel, "notify::width",
+                    G_CALLBACK (notify_width), data);
+  gdk_toplevel_size_set_size (size, 800, 600);
+}
+
+static GdkSurface *
+make_toplevel (GdkSubsurface **subsurface)
+{
+  GdkSurface *surface;
+  GdkToplevelLayout *layout;
+  gboolean done;
+
+  if (GDK_DISPLAY_DEBUG_CHECK (gdk_display_get_default (), FORCE_OFFLOAD))
+    {
+      g_test_skip ("Demotion is disabled with GDK_DEBUG=force-offload");
+      return NULL;
+    }
+
+  surface = gdk_surface_new_toplevel (gdk_display_get_default ());
+
+  done = FALSE;
+  g_signal_connect (surface, "compute-size", G_CALLBACK (compute_size), &done);
+
+  layout = gdk_toplevel_layout_new ();
+  gdk_toplevel_present (GDK_TOPLEVEL (surface), layout);
+  gdk_toplevel_layout_unref (layout);
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  *subsurface = gdk_surface_create_subsurface (surface);
+  if (*subsurface == NULL)
+    {
+      g_test_skip ("Subsurfaces are not supported");
+      gdk_surface_destroy (surface);
+      return NULL;
+    }
+
+  return surface;
+}
+
+static GdkTexture *
+make_texture (guchar value)
+{
+  guchar data[16 * 16 * 4];
+  GBytes *bytes;
+  GdkTexture *texture;
+
+  memset (data, value, sizeof (data));
+  bytes = g_bytes_new (data, sizeof (data));
+  texture = gdk_memory_texture_new (16, 16, GDK_MEMORY_DEFAULT, bytes, 16 * 4);
+  g_bytes_unref (bytes);
+
+  return texture;
+}
+
+/* Runs the offload pass for a frame showing @texture in the
+ * subsurface and returns whether offloading it was considered */
+static gboolean
+offload_frame (GdkSurface    *surface,
+               GdkSubsurface *subsurface,
+               GdkTexture    *texture)
+{
+  GskRenderNode *child, *node;
+  cairo_region_t *region;
+  GskOffload *offload;
+  GskOffloadInfo *info;
+  gboolean result;
+
+  child = gsk_texture_node_new (texture, &GRAPHENE_RECT_INIT (10, 10, 16, 16));
+  node = gsk_subsurface_node_new (child, subsurface);
+
+  region = cairo_region_create ();
+  offload = gsk_offload_new (surface, node, region);
+  info = gsk_offload_get_subsurface_info (offload, subsurface);
+  result = info->can_offload;
+
+  gsk_offload_free (offload);
+  cairo_region_destroy (region);
+  gsk_render_node_unref (node);
+  gsk_render_node_unref (child);
+
+  return result;
+}
+
+static void
+test_demote_promote (void)
+{
+  GdkSurface *surface;
+  GdkSubsurface *subsurface;
+  GdkTexture *textures[2];
+  guint i;
+
+  surface = make_toplevel (&subsurface);
+  if (surface == NULL)
+    return;
+
+  textures[0] = make_texture (0x40);
+  textures[1] = make_texture (0x80);
+
+  /* A static texture gets demoted */
+  for (i = 0; i < DEMOTE_FRAMES; i++)
+    g_assert_true (offload_frame (surface, subsurface, textures[0]));
+  g_assert_false (offload_frame (surface, subsurface, textures[0]));
+
+  /* A single change isn't enough to promote it again */
+  g_assert_false (offload_frame (surface, subsurface, textures[1]));
+  for (i = 0; i < PROMOTE_FRAMES; i++)
+    g_assert_false (offload_frame (surface, subsurface, textures[1]));
+
+  /* but a texture that keeps changing is */
+  g_assert_false (offload_frame (surface, subsurface, textures[0]));
+  g_assert_true (offload_frame (surface, subsurface, textures[1]));
+  g_assert_true (offload_frame (surface, subsurface, textures[0]));
+
+  g_object_unref (textures[0]);
+  g_object_unref (textures[1]);
+  g_object_unref (subsurface);
+  gdk_surface_destroy (surface);
+}
+
+/* A new texture every frame is a changing texture, even if the
+ * allocator hands out the address of the previous one again */
+static void
+test_new_textures (void)
+{
+  GdkSurface *surface;
+  GdkSubsurface *subsurface;
+  guint i;
+
+  surface = make_toplevel (&subsurface);
+  if (surface == NULL)
+    return;
+
+  for (i = 0; i < 2 * DEMOTE_FRAMES; i++)
+    {
+      GdkTexture *texture = make_texture (i);
+
+      g_assert_true (offload_frame (surface, subsurface, texture));
+      g_object_unref (texture);
+    }
+
+  g_object_unref (subsurface);
+  gdk_surface_destroy (surface);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/offload/history/demote-promote", test_demote_promote);
+  g_test_add_func ("/offload/history/new-textures", test_new_textures);
+
+  return g_test_run ();
+}
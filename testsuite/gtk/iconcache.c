@@ -0,0 +1,137 @@
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include <utime.h>
+
+#include "gtk/gtkiconcacheprivate.h"
+#include "gtk/gtkiconcachevalidatorprivate.h"
+
+static void
+touch (const char *dir,
+       const char *subdir,
+       const char *name)
+{
+  char *path;
+  char *filename;
+
+  path = g_build_filename (dir, subdir, NULL);
+  g_mkdir_with_parents (path, 0700);
+  filename = g_build_filename (path, name, NULL);
+  g_assert_true (g_file_set_contents (filename, "", 0, NULL));
+
+  g_free (filename);
+  g_free (path);
+}
+
+static void
+test_write (void)
+{
+  char *dir;
+  char *cache_filename;
+  char *contents;
+  gsize length;
+  CacheInfo info;
+  GError *error = NULL;
+
+  dir = g_dir_make_tmp ("iconcache-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  touch (dir, "16x16/apps", "a.png");
+  touch (dir, "16x16/apps", "a.svg");
+  touch (dir, "scalable/apps", "b.svg");
+  touch (dir, "scalable/apps", "b.symbolic.png");
+  touch (dir, "scalable/apps", "README");
+  touch (dir, "empty", "README");
+
+  cache_filename = g_build_filename (dir, "out", "test.cache", NULL);
+
+  g_assert_true (gtk_icon_cache_write_for_path (dir, cache_filename, &error));
+  g_assert_no_error (error);
+
+  g_assert_true (g_file_get_contents (cache_filename, &contents, &length, &error));
+  g_assert_no_error (error);
+
+  info.cache = contents;
+  info.cache_size = length;
+  info.n_directories = 0;
+  info.flags = CHECK_OFFSETS | CHECK_STRINGS;
+
+  g_assert_true (gtk_icon_cache_validate (&info));
+  /* Only directories with icons are recorded */
+  g_assert_cmpuint (info.n_directories, ==, 2);
+
+  g_free (contents);
+  g_free (cache_filename);
+  g_free (dir);
+}
+
+static void
+test_user_cache_filename (void)
+{
+  char *a, *b, *c;
+
+  a = gtk_icon_cache_get_user_cache_filename ("/usr/share/icons/hicolor");
+  b = gtk_icon_cache_get_user_cache_filename ("/usr/share/icons/hicolor");
+  c = gtk_icon_cache_get_user_cache_filename ("/usr/share/icons/Adwaita");
+
+  g_assert_true (g_str_has_prefix (a, g_get_user_cache_dir ()));
+  g_assert_cmpstr (a, ==, b);
+  g_assert_cmpstr (a, !=, c);
+
+  g_free (a);
+  g_free (b);
+  g_free (c);
+}
+
+/* Adding an icon to a subdirectory doesn't change the mtime of the
+ * theme directory, the user cache must still notice it */
+static void
+test_user_cache_outdated (void)
+{
+  GtkIconCache *cache;
+  char *dir, *subdir;
+  char *cache_filename;
+  struct utimbuf times;
+  GStatBuf st;
+  GError *error = NULL;
+
+  dir = g_dir_make_tmp ("iconcache-XXXXXX", &error);
+  g_assert_no_error (error);
+
+  touch (dir, "48x48/apps", "a.png");
+  touch (dir, "48x48/mimetypes", "README");
+
+  cache_filename = gtk_icon_cache_get_user_cache_filename (dir);
+  g_assert_true (gtk_icon_cache_write_for_path (dir, cache_filename, &error));
+  g_assert_no_error (error);
+
+  cache = gtk_icon_cache_new_for_path (dir);
+  g_assert_nonnull (cache);
+  gtk_icon_cache_unref (cache);
+
+  /* An icon in a directory that had none before */
+  subdir = g_build_filename (dir, "48x48", "mimetypes", NULL);
+  touch (dir, "48x48/mimetypes", "b.png");
+  g_assert_cmpint (g_stat (subdir, &st), ==, 0);
+  times.actime = st.st_atime;
+  times.modtime = st.st_mtime + 10;
+  g_assert_cmpint (g_utime (subdir, &times), ==, 0);
+
+  cache = gtk_icon_cache_new_for_path (dir);
+  g_assert_null (cache);
+
+  g_free (subdir);
+  g_free (cache_filename);
+  g_free (dir);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, G_TEST_OPTION_ISOLATE_DIRS, NULL);
+
+  g_test_add_func ("/iconcache/write", test_write);
+  g_test_add_func ("/iconcache/user-cache-filename", test_user_cache_filename);
+  g_test_add_func ("/iconcache/user-cache-outdated", test_user_cache_outdated);
+
+  return g_test_run ();
+}
@@ -644,6 +644,68 @@ test_list (void)
   g_strfreev (icons);
 }
 
+static void
+preload_done (GObject      *source,
+              GAsyncResult *result,
+              gpointer      data)
+{
+  GListModel **icons = data;
+  GError *error = NULL;
+
+  *icons = gtk_icon_theme_preload_icons_finish (GTK_ICON_THEME (source), result, &error);
+  g_assert_no_error (error);
+
+  g_main_context_wakeup (NULL);
+}
+
+static void
+test_preload (void)
+{
+  const char *names[] = { "simple", "twosize", "everything", "only32-symbolic", NULL };
+  GtkIconTheme *theme;
+  GListModel *icons = NULL;
+  GtkIconPaintable *preloaded[G_N_ELEMENTS (names)];
+  GtkIconPaintable *lookup;
+  guint i;
+
+  theme = get_test_icontheme (TRUE);
+
+  gtk_icon_theme_preload_icons (theme, names, 16, 1, GTK_TEXT_DIR_NONE, 0,
+                                NULL, preload_done, &icons);
+
+  while (icons == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_cmpuint (g_list_model_get_n_items (icons), ==, G_N_ELEMENTS (names) - 1);
+
+  for (i = 0; names[i]; i++)
+    {
+      preloaded[i] = g_list_model_get_item (icons, i);
+      g_assert_cmpstr (gtk_icon_paintable_get_icon_name (preloaded[i]), ==, names[i]);
+      g_object_unref (preloaded[i]);
+    }
+
+  /* The icon theme keeps the icons alive without the list */
+  g_object_unref (icons);
+
+  for (i = 0; names[i]; i++)
+    {
+      GIcon *gicon;
+
+      /* Lookups the way GtkImage does them find the preloaded icon */
+      gicon = g_themed_icon_new (names[i]);
+      lookup = gtk_icon_theme_lookup_by_gicon (theme, gicon, 16, 1, GTK_TEXT_DIR_NONE, GTK_ICON_LOOKUP_PRELOAD);
+      g_assert_true (lookup == preloaded[i]);
+      g_object_unref (lookup);
+
+      lookup = gtk_icon_theme_lookup_by_gicon (theme, gicon, 16, 1, GTK_TEXT_DIR_NONE, 0);
+      g_assert_true (lookup == preloaded[i]);
+      g_object_unref (lookup);
+
+      g_object_unref (gicon);
+    }
+}
+
 static void
 test_inherit (void)
 {
@@ -766,6 +828,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/icontheme/svg-size", test_svg_size);
   g_test_add_func ("/icontheme/size", test_size);
   g_test_add_func ("/icontheme/list", test_list);
+  g_test_add_func ("/icontheme/preload", test_preload);
   g_test_add_func ("/icontheme/inherit", test_inherit);
   g_test_add_func ("/icontheme/nonsquare-symbolic", test_nonsquare_symbolic);
   g_test_add_func ("/icontheme/lookup_order0", test_lookup_order0);
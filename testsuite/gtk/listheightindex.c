@@ -0,0 +1,226 @@
+#include <gtk/gtk.h>
+
+#include "gtk/gtklistheightindexprivate.h"
+
+static int
+estimate_height (guint    position,
+                 gpointer user_data)
+{
+  /* every tenth row is a tall header */
+  return position % 10 == 0 ? 50 : 20;
+}
+
+static gint64
+naive_range (guint position,
+             guint n_items)
+{
+  gint64 result = 0;
+  guint i;
+
+  for (i = position; i < position + n_items; i++)
+    result += estimate_height (i, NULL);
+
+  return result;
+}
+
+static void
+test_range (void)
+{
+  GtkListHeightIndex *index;
+  guint i, n;
+
+  for (n = 0; n < 70; n += 7)
+    {
+      index = gtk_list_height_index_new (n, estimate_height, NULL);
+      g_assert_cmpuint (gtk_list_height_index_get_n_items (index), ==, n);
+
+      for (i = 0; i <= n; i++)
+        {
+          g_assert_cmpint (gtk_list_height_index_get_range (index, 0, i), ==, naive_range (0, i));
+          g_assert_cmpint (gtk_list_height_index_get_range (index, i, n - i), ==, naive_range (i, n - i));
+        }
+
+      gtk_list_height_index_free (index);
+    }
+}
+
+static void
+test_find (void)
+{
+  GtkListHeightIndex *index;
+  const guint n = 1000;
+  const int spacing = 3;
+  gint64 start;
+  guint i;
+
+  index = gtk_list_height_index_new (n, estimate_height, NULL);
+
+  start = 0;
+  for (i = 0; i < n; i++)
+    {
+      int height = estimate_height (i, NULL);
+
+      g_assert_cmpuint (gtk_list_height_index_find (index, start, spacing), ==, i);
+      g_assert_cmpuint (gtk_list_height_index_find (index, start + height - 1, spacing), ==, i);
+      /* the spacing after an item belongs to that item */
+      g_assert_cmpuint (gtk_list_height_index_find (index, start + height + spacing - 1, spacing), ==, i);
+
+      start += height + spacing;
+    }
+
+  g_assert_cmpuint (gtk_list_height_index_find (index, -10, spacing), ==, 0);
+  g_assert_cmpuint (gtk_list_height_index_find (index, start + 1000, spacing), ==, n - 1);
+
+  gtk_list_height_index_free (index);
+}
+
+typedef struct {
+  GArray *heights;
+  guint n_calls;
+} SpliceData;
+
+static int
+estimate_from_array (guint    position,
+                     gpointer user_data)
+{
+  SpliceData *data = user_data;
+
+  data->n_calls++;
+
+  return g_array_index (data->heights, int, position);
+}
+
+static void
+test_splice (void)
+{
+  SpliceData data;
+  GtkListHeightIndex *index;
+  guint run, i;
+
+  data.heights = g_array_new (FALSE, FALSE, sizeof (int));
+  for (i = 0; i < 500; i++)
+    {
+      int height = g_test_rand_int_range (1, 100);
+      g_array_append_val (data.heights, height);
+    }
+  data.n_calls = 0;
+
+  index = gtk_list_height_index_new (data.heights->len, estimate_from_array, &data);
+  g_assert_cmpuint (data.n_calls, ==, data.heights->len);
+
+  for (run = 0; run < 200; run++)
+    {
+      guint position, removed, added;
+      gint64 total;
+
+      position = g_test_rand_int_range (0, data.heights->len + 1);
+      removed = g_test_rand_int_range (0, MIN (data.heights->len - position, 150) + 1);
+      added = g_test_rand_int_range (0, 150);
+
+      g_array_remove_range (data.heights, position, removed);
+      for (i = 0; i < added; i++)
+        {
+          int height = g_test_rand_int_range (1, 100);
+          g_array_insert_val (data.heights, position + i, height);
+        }
+
+      /* only the new items get estimated */
+      data.n_calls = 0;
+      gtk_list_height_index_splice (index, position, removed, added);
+      g_assert_cmpuint (data.n_calls, ==, added);
+      g_assert_cmpuint (gtk_list_height_index_get_n_items (index), ==, data.heights->len);
+
+      total = 0;
+      for (i = 0; i < data.heights->len; i++)
+        {
+          g_assert_cmpint (gtk_list_height_index_get_range (index, i, 1), ==, g_array_index (data.heights, int, i));
+          g_assert_cmpuint (gtk_list_height_index_find (index, total, 0), ==, i);
+          total += g_array_index (data.heights, int, i);
+        }
+      g_assert_cmpint (gtk_list_height_index_get_range (index, 0, data.heights->len), ==, total);
+    }
+
+  gtk_list_height_index_free (index);
+  g_array_unref (data.heights);
+}
+
+static int
+count_estimates (guint    position,
+                 gpointer user_data)
+{
+  guint *n_calls = user_data;
+
+  (*n_calls)++;
+
+  return estimate_height (position, NULL);
+}
+
+static void
+setup_label (GtkSignalListItemFactory *factory,
+             GtkListItem              *item)
+{
+  gtk_list_item_set_child (item, gtk_label_new ("row"));
+}
+
+/* Changing the model of a listview must splice its index,
+ * not rebuild it */
+static void
+test_listview_items_changed (void)
+{
+  const guint n = 100000;
+  const char *added[] = { "added", NULL };
+  GtkStringList *list;
+  GtkListItemFactory *factory;
+  GtkWidget *window, *sw, *view;
+  const char **strings;
+  guint n_calls, i;
+
+  strings = g_new (const char *, n + 1);
+  for (i = 0; i < n; i++)
+    strings[i] = "row";
+  strings[n] = NULL;
+  list = gtk_string_list_new (strings);
+  g_free (strings);
+
+  factory = gtk_signal_list_item_factory_new ();
+  g_signal_connect (factory, "setup", G_CALLBACK (setup_label), NULL);
+  view = gtk_list_view_new (GTK_SELECTION_MODEL (gtk_no_selection_new (G_LIST_MODEL (list))), factory);
+  n_calls = 0;
+  gtk_list_view_set_height_estimate_func (GTK_LIST_VIEW (view), count_estimates, &n_calls, NULL);
+
+  sw = gtk_scrolled_window_new ();
+  gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (sw), view);
+  window = gtk_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 200, 400);
+  gtk_window_set_child (GTK_WINDOW (window), sw);
+  gtk_window_present (GTK_WINDOW (window));
+  gtk_test_widget_wait_for_draw (window);
+
+  g_assert_cmpuint (n_calls, ==, n);
+
+  /* in the visible range and far outside of it */
+  for (i = 0; i < 2; i++)
+    {
+      n_calls = 0;
+      gtk_string_list_splice (list, i == 0 ? 1 : n / 2, 0, added);
+      gtk_widget_queue_resize (view);
+      gtk_test_widget_wait_for_draw (window);
+
+      g_assert_cmpuint (n_calls, ==, 1);
+    }
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/listheightindex/range", test_range);
+  g_test_add_func ("/listheightindex/find", test_find);
+  g_test_add_func ("/listheightindex/splice", test_splice);
+  g_test_add_func ("/listheightindex/listview-items-changed", test_listview_items_changed);
+
+  return g_test_run ();
+}
@@ -20,6 +20,8 @@
 #include <gtk/gtk.h>
 #include "gtk/gtklistitemmanagerprivate.h"
 #include "gtk/gtklistbaseprivate.h"
+#include "gtk/gtklistfactorywidgetprivate.h"
+#include "gtk/gtklistitemwidgetprivate.h"
 
 static GListModel *
 create_source_model (guint min_size, guint max_size)
@@ -378,6 +380,131 @@ test_create_with_items (void)
   gtk_window_destroy (GTK_WINDOW (widget));
 }
 
+static guint n_created_items;
+
+static GtkListItemBase *
+create_counted_item (GtkWidget *widget)
+{
+  n_created_items++;
+
+  return create_simple_item (widget);
+}
+
+static void
+test_pool (void)
+{
+  GListModel *source;
+  GtkNoSelection *selection;
+  GtkListItemManager *items;
+  GtkListItemTracker *tracker;
+  GtkWidget *widget;
+
+  n_created_items = 0;
+
+  widget = gtk_window_new ();
+  items = gtk_list_item_manager_new (widget,
+                                     split_simple,
+                                     create_counted_item,
+                                     prepare_simple,
+                                     create_simple_header);
+  g_object_set_data_full (G_OBJECT (widget), "the-items", items, g_object_unref);
+  gtk_list_item_manager_set_pool_size (items, 10);
+  tracker = gtk_list_item_tracker_new (items);
+
+  source = create_source_model (20, 50);
+  selection = gtk_no_selection_new (source);
+  gtk_list_item_manager_set_model (items, GTK_SELECTION_MODEL (selection));
+  gtk_list_item_tracker_set_position (items, tracker, 0, 0, 4);
+  check_list_item_manager (items, widget, &tracker, 1);
+  g_assert_cmpuint (n_created_items, ==, 5);
+  g_object_unref (selection);
+
+  /* Swapping the model reuses the widgets */
+  source = create_source_model (20, 50);
+  selection = gtk_no_selection_new (source);
+  gtk_list_item_manager_set_model (items, GTK_SELECTION_MODEL (selection));
+  gtk_list_item_tracker_set_position (items, tracker, 10, 0, 4);
+  check_list_item_manager (items, widget, &tracker, 1);
+  g_assert_cmpuint (n_created_items, ==, 5);
+
+  /* ...unless the pool was cleared */
+  gtk_list_item_manager_set_model (items, NULL);
+  gtk_list_item_manager_clear_pool (items);
+  gtk_list_item_manager_set_model (items, GTK_SELECTION_MODEL (selection));
+  gtk_list_item_tracker_set_position (items, tracker, 0, 0, 4);
+  check_list_item_manager (items, widget, &tracker, 1);
+  g_assert_cmpuint (n_created_items, ==, 10);
+  g_object_unref (selection);
+
+  gtk_list_item_tracker_free (items, tracker);
+  gtk_window_destroy (GTK_WINDOW (widget));
+}
+
+static guint
+count_item_widgets (GtkWidget *view,
+                    gboolean   single_click_activate)
+{
+  GtkWidget *child;
+  guint n = 0;
+
+  for (child = gtk_widget_get_first_child (view);
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    {
+      if (!GTK_IS_LIST_ITEM_WIDGET (child))
+        continue;
+
+      g_assert_true (gtk_list_factory_widget_get_single_click_activate (GTK_LIST_FACTORY_WIDGET (child)) == single_click_activate);
+      n++;
+    }
+
+  return n;
+}
+
+static void
+test_pool_single_click_activate (gconstpointer data)
+{
+  gboolean grid = GPOINTER_TO_UINT (data);
+  GtkSelectionModel *selection;
+  GtkListItemFactory *factory;
+  GtkWidget *window, *view;
+
+  selection = GTK_SELECTION_MODEL (gtk_no_selection_new (create_source_model (20, 50)));
+  factory = gtk_signal_list_item_factory_new ();
+  if (grid)
+    view = gtk_grid_view_new (g_object_ref (selection), factory);
+  else
+    view = gtk_list_view_new (g_object_ref (selection), factory);
+  window = gtk_window_new ();
+  gtk_window_set_child (GTK_WINDOW (window), view);
+  gtk_window_present (GTK_WINDOW (window));
+
+  while (count_item_widgets (view, FALSE) == 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  /* Park the widgets in the pool and change them while they are there */
+  if (grid)
+    {
+      gtk_grid_view_set_model (GTK_GRID_VIEW (view), NULL);
+      g_assert_cmpuint (count_item_widgets (view, FALSE), ==, 0);
+      gtk_grid_view_set_single_click_activate (GTK_GRID_VIEW (view), TRUE);
+      gtk_grid_view_set_model (GTK_GRID_VIEW (view), selection);
+    }
+  else
+    {
+      gtk_list_view_set_model (GTK_LIST_VIEW (view), NULL);
+      g_assert_cmpuint (count_item_widgets (view, FALSE), ==, 0);
+      gtk_list_view_set_single_click_activate (GTK_LIST_VIEW (view), TRUE);
+      gtk_list_view_set_model (GTK_LIST_VIEW (view), selection);
+    }
+
+  while (count_item_widgets (view, TRUE) == 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_object_unref (selection);
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
 #define N_TRACKERS 3
 #define N_WIDGETS_PER_TRACKER 10
 #define N_RUNS 500
@@ -560,6 +687,9 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/listitemmanager/create", test_create);
   g_test_add_func ("/listitemmanager/create_with_items", test_create_with_items);
+  g_test_add_func ("/listitemmanager/pool", test_pool);
+  g_test_add_data_func ("/listitemmanager/pool/listview-single-click-activate", GUINT_TO_POINTER (FALSE), test_pool_single_click_activate);
+  g_test_add_data_func ("/listitemmanager/pool/gridview-single-click-activate", GUINT_TO_POINTER (TRUE), test_pool_single_click_activate);
   g_test_add_func ("/listitemmanager/exhaustive", test_exhaustive);
 
   return g_test_run ();
@@ -29,6 +29,116 @@
 #include <gtk/gtk.h>
 #include "gtk-rendernode-tool.h"
 
+#include "gsk/gpu/gskgpurendererprivate.h"
+
+#define PATH_NODE_WIDTH 1024
+#define PATH_NODE_HEIGHT 768
+#define PATH_NODE_POINTS 64
+
+static GskPath *
+create_random_path (GRand    *rand,
+                    gboolean  closed)
+{
+  GskPathBuilder *builder;
+  float x, y, step;
+  guint i;
+
+  builder = gsk_path_builder_new ();
+
+  step = (float) PATH_NODE_WIDTH / PATH_NODE_POINTS;
+  x = 0;
+  y = g_rand_double_range (rand, 0, PATH_NODE_HEIGHT);
+  gsk_path_builder_move_to (builder, x, y);
+
+  for (i = 0; i < PATH_NODE_POINTS; i++)
+    {
+      float nx, ny;
+
+      nx = x + step;
+      ny = CLAMP (y + g_rand_double_range (rand, -step, step), 0, PATH_NODE_HEIGHT);
+      gsk_path_builder_quad_to (builder, x + step / 2, y, nx, ny);
+      x = nx;
+      y = ny;
+    }
+
+  if (closed)
+    {
+      gsk_path_builder_line_to (builder, PATH_NODE_WIDTH, PATH_NODE_HEIGHT);
+      gsk_path_builder_line_to (builder, 0, PATH_NODE_HEIGHT);
+      gsk_path_builder_close (builder);
+    }
+
+  return gsk_path_builder_free_to_path (builder);
+}
+
+/* Creates a chart-like node with n_paths filled areas and
+ * n_paths stroked lines, for benchmarking path rendering
+ */
+static GskRenderNode *
+create_path_node (guint    n_paths,
+                  gboolean dashed)
+{
+  GskRenderNode **children;
+  GskStroke *stroke;
+  GRand *rand;
+  GskRenderNode *node;
+  graphene_rect_t bounds;
+  guint i;
+
+  rand = g_rand_new_with_seed (0);
+  stroke = gsk_stroke_new (2);
+  if (dashed)
+    {
+      /* The GPU only draws round joins and caps, so these
+       * get rasterized with cairo on worker threads */
+      gsk_stroke_set_line_join (stroke, GSK_LINE_JOIN_MITER);
+      gsk_stroke_set_line_cap (stroke, GSK_LINE_CAP_BUTT);
+      gsk_stroke_set_dash (stroke, (const float[]) { 8, 4 }, 2);
+    }
+  else
+    {
+      gsk_stroke_set_line_join (stroke, GSK_LINE_JOIN_ROUND);
+      gsk_stroke_set_line_cap (stroke, GSK_LINE_CAP_ROUND);
+    }
+  graphene_rect_init (&bounds, 0, 0, PATH_NODE_WIDTH, PATH_NODE_HEIGHT);
+  children = g_new (GskRenderNode *, 2 * n_paths);
+
+  for (i = 0; i < n_paths; i++)
+    {
+      GskRenderNode *color;
+      GskPath *path;
+      GdkRGBA rgba = {
+        g_rand_double (rand),
+        g_rand_double (rand),
+        g_rand_double (rand),
+        0.25
+      };
+
+      path = create_random_path (rand, TRUE);
+      color = gsk_color_node_new (&rgba, &bounds);
+      children[2 * i] = gsk_fill_node_new (color, path, GSK_FILL_RULE_WINDING);
+      gsk_render_node_unref (color);
+      gsk_path_unref (path);
+
+      rgba.alpha = 1.0;
+      path = create_random_path (rand, FALSE);
+      color = gsk_color_node_new (&rgba, &bounds);
+      children[2 * i + 1] = gsk_stroke_node_new (color, path, stroke);
+      gsk_render_node_unref (color);
+      gsk_path_unref (path);
+    }
+
+  node = gsk_container_node_new (children, 2 * n_paths);
+
+  for (i = 0; i < 2 * n_paths; i++)
+    gsk_render_node_unref (children[i]);
+  g_free (children);
+  gsk_stroke_free (stroke);
+  g_rand_free (rand);
+
+  return node;
+}
+
 static void
 benchmark_node (GskRenderNode *node,
                 const char    *renderer_name,
@@ -72,10 +182,19 @@ benchmark_node (GskRenderNode *node,
       end_time = g_get_monotonic_time ();
 
       duration = end_time - start_time;
-      g_print ("%s\t%lld.%03ds\n",
+      g_print ("%s\t%lld.%03ds",
                renderer_name,
                (long long) duration / G_USEC_PER_SEC,
                (int) ((duration * 1000 / G_USEC_PER_SEC) % 1000)); 
+      /* Only the GPU renderers count their draws */
+      if (GSK_IS_GPU_RENDERER (renderer))
+        {
+          guint n_draws, n_unmerged;
+
+          n_draws = gsk_gpu_renderer_get_n_draws (GSK_GPU_RENDERER (renderer), &n_unmerged);
+          g_print ("\t%u draws (%u before merging)", n_draws, n_unmerged);
+        }
+      g_print ("\n");
       g_object_unref (texture);
     }
 
@@ -92,10 +211,14 @@ do_benchmark (int          *argc,
   char **renderers = NULL;
   gboolean nodownload = FALSE;
   int runs = 3;
+  int paths = 0;
+  gboolean dashed = FALSE;
   const GOptionEntry entries[] = {
     { "renderer", 0, 0, G_OPTION_ARG_STRING_ARRAY, &renderers, N_("Add renderer to benchmark"), N_("RENDERER") },
     { "runs", 0, 0, G_OPTION_ARG_INT, &runs, N_("Number of runs with each renderer"), N_("RUNS") },
     { "no-download", 0, 0, G_OPTION_ARG_NONE, &nodownload, N_("Don’t download result/wait for GPU to finish"), NULL },
+    { "paths", 0, 0, G_OPTION_ARG_INT, &paths, N_("Benchmark a generated node with the given number of fills and strokes"), N_("COUNT") },
+    { "dashed", 0, 0, G_OPTION_ARG_NONE, &dashed, N_("Use dashed strokes that get rasterized with cairo for generated paths"), NULL },
     { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL, N_("FILE…") },
     { NULL, }
   };
@@ -124,13 +247,25 @@ do_benchmark (int          *argc,
 
   g_option_context_free (context);
 
-  if (filenames == NULL)
+  if (paths < 0)
+    {
+      g_printerr (_("Number of paths must not be negative\n"));
+      exit (1);
+    }
+
+  if (filenames == NULL && paths == 0)
     {
       g_printerr (_("No .node file specified\n"));
       exit (1);
     }
 
-  if (g_strv_length (filenames) > 1)
+  if (filenames != NULL && paths > 0)
+    {
+      g_printerr (_("Can’t benchmark a .node file and generated paths at the same time\n"));
+      exit (1);
+    }
+
+  if (filenames != NULL && g_strv_length (filenames) > 1)
     {
       g_printerr (_("Can only benchmark a single .node file\n"));
       exit (1);
@@ -139,7 +274,10 @@ do_benchmark (int          *argc,
   if (renderers == NULL || renderers[0] == NULL)
     renderers = g_strdupv ((char **) (const char *[]) { "gl", "ngl", "vulkan", "cairo", NULL });
   
-  node = load_node_file (filenames[0]);
+  if (paths > 0)
+    node = create_path_node (paths, dashed);
+  else
+    node = load_node_file (filenames[0]);
 
   for (i = 0; renderers[i] != NULL; i++)
     {